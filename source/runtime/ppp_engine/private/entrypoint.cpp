@@ -11,11 +11,14 @@
 #include "camera/camera_manager.h"
 
 #include "resources/texture_pool.h"
+#include "resources/texture_atlas.h"
 #include "resources/font_pool.h"
 #include "resources/shader_pool.h"
 #include "resources/material_pool.h"
 #include "resources/geometry_pool.h"
 #include "resources/framebuffer_pool.h"
+#include "resources/picking_pool.h"
+#include "resources/texture_residency.h"
 
 #include "fileio/vfs.h"
 
@@ -23,10 +26,13 @@
 #include "util/types.h"
 #include "util/steady_clock.h"
 #include "util/profiler.h"
+#include "util/async_loader.h"
+#include "util/thread_pool.h"
 
 #include <GLFW/glfw3.h>
 
 #include <sstream>
+#include <thread>
 
 namespace ppp
 {
@@ -181,6 +187,11 @@ namespace ppp
         if (!shader_pool::initialize()) { log::error("Failed to initialize shader pool");    return -1; }
         if (!material_pool::initialize()) { log::error("Failed to initialize material pool");  return -1; }
         if (!geometry_pool::initialize()) { log::error("Failed to initialize geometry pool");  return -1; }
+        if (!picking_pool::initialize()) { log::error("Failed to initialize picking pool");   return -1; }
+
+        // Keep one core for the main thread
+        const u32 loader_threads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        if (!async_loader::initialize(std::max(1u, loader_threads))) { log::error("Failed to initialize async loader"); return -1; }
 
         if (render::draw_mode() == render::render_draw_mode::BATCHED)
         {
@@ -208,6 +219,9 @@ namespace ppp
         {
             event_bus::instance().broadcast(event_type::BEGIN_FRAME);
 
+            // resources that finished loading in the background are created before anything is drawn
+            async_loader::process_completed();
+
             // poll new window events
             // ----
             {
@@ -243,6 +257,14 @@ namespace ppp
                 render::render(&context);
 
                 render::end();
+
+                // geometry edits of this frame have been picked up by every render path
+                geometry_pool::clear_dirty_geometry();
+                // items submitted during this frame can now be picked
+                picking_pool::end_frame();
+                // textures that were not used recently are evicted when the pool is over its budget
+                texture_residency::end_frame();
+
                 event_bus::instance().broadcast(event_type::POST_RENDER);
 
                 // swap front/back buffers
@@ -274,10 +296,14 @@ namespace ppp
     {
         event_bus::instance().broadcast(event_type::SHUTDOWN);
 
+        async_loader::terminate();
+        thread_pool::terminate();
+        picking_pool::terminate();
         geometry_pool::terminate();
         material_pool::terminate();
         shader_pool::terminate();
         font_pool::terminate();
+        texture_atlas::terminate();
         texture_pool::terminate();
         framebuffer_pool::terminate();
         camera_manager::terminate();
@@ -0,0 +1,140 @@
+#include "fileio/file_stamp.h"
+#include "fileio/fileio.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+namespace ppp
+{
+    namespace fileio
+    {
+        namespace internal
+        {
+            // Files are hashed in pieces of this size
+            constexpr u64 hash_chunk_size = 4ull * 1024 * 1024;
+
+            //-------------------------------------------------------------------------
+            u64 rotl(u64 value, s32 shift)
+            {
+                return (value << shift) | (value >> (64 - shift));
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        file_stamp read_file_stamp(std::string_view path)
+        {
+            std::error_code error;
+
+            const std::filesystem::path fs_path(path);
+
+            const auto size = std::filesystem::file_size(fs_path, error);
+            if (error)
+            {
+                return {};
+            }
+
+            const auto write_time = std::filesystem::last_write_time(fs_path, error);
+            if (error)
+            {
+                return {};
+            }
+
+            return { static_cast<u64>(size), static_cast<s64>(write_time.time_since_epoch().count()) };
+        }
+
+        //-------------------------------------------------------------------------
+        u64 content_hash(const void* data, u64 size)
+        {
+            content_hasher hasher;
+            hasher.update(data, size);
+            return hasher.finish();
+        }
+
+        //-------------------------------------------------------------------------
+        void content_hasher::update(const void* data, u64 size)
+        {
+            const u8* bytes = static_cast<const u8*>(data);
+
+            m_size += size;
+
+            // Complete the word that was started by the previous update
+            if (m_pending_size > 0)
+            {
+                const u64 count = std::min(size, sizeof(u64) - m_pending_size);
+                std::memcpy(m_pending + m_pending_size, bytes, count);
+
+                m_pending_size += count;
+                bytes += count;
+                size -= count;
+
+                if (m_pending_size < sizeof(u64))
+                {
+                    return;
+                }
+
+                u64 word;
+                std::memcpy(&word, m_pending, sizeof(u64));
+                mix(word);
+
+                m_pending_size = 0;
+            }
+
+            const u64 word_count = size / sizeof(u64);
+            for (u64 i = 0; i < word_count; ++i)
+            {
+                u64 word;
+                std::memcpy(&word, bytes + i * sizeof(u64), sizeof(u64));
+                mix(word);
+            }
+
+            m_pending_size = size - word_count * sizeof(u64);
+            std::memcpy(m_pending, bytes + word_count * sizeof(u64), m_pending_size);
+        }
+
+        //-------------------------------------------------------------------------
+        u64 content_hasher::finish() const
+        {
+            u64 tail = 0;
+            std::memcpy(&tail, m_pending, m_pending_size);
+
+            u64 h = m_hash;
+            h ^= tail * 0x87c37b91114253d5ULL;
+            h ^= m_size;
+
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+
+            return h;
+        }
+
+        //-------------------------------------------------------------------------
+        void content_hasher::mix(u64 word)
+        {
+            // 64 bit words mixed as in MurmurHash3, only used to detect edits so no seed is required
+            word *= 0x87c37b91114253d5ULL;
+            word = internal::rotl(word, 31);
+            word *= 0x4cf5ad432745937fULL;
+
+            m_hash ^= word;
+            m_hash = internal::rotl(m_hash, 27) * 5 + 0x52dce729;
+        }
+
+        //-------------------------------------------------------------------------
+        u64 hash_resolved_file(const std::string& path)
+        {
+            content_hasher hasher;
+
+            read_resolved_file_chunked(path, internal::hash_chunk_size, [&hasher](std::string_view chunk)
+            {
+                hasher.update(chunk.data(), chunk.size());
+            });
+
+            return hasher.finish();
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "util/types.h"
+
+#include <string>
+#include <string_view>
+
+namespace ppp
+{
+    namespace fileio
+    {
+        //-------------------------------------------------------------------------
+        // Cheap description of the state of a file on disk, used to detect edits without reading the file
+        struct file_stamp
+        {
+            u64 size = 0;
+            s64 write_time = 0;
+
+            bool valid() const { return size != 0; }
+
+            bool operator==(const file_stamp& other) const { return size == other.size && write_time == other.write_time; }
+            bool operator!=(const file_stamp& other) const { return !(*this == other); }
+        };
+
+        // Size and last write time of a file on disk, invalid when the file does not exist
+        file_stamp read_file_stamp(std::string_view path);
+
+        // Hash used to detect changes to a file when its size matches but its write time does not
+        u64 content_hash(const void* data, u64 size);
+
+        // `content_hash` of a file at an already resolved path, the file is read in chunks so it does not have to fit in memory
+        u64 hash_resolved_file(const std::string& path);
+
+        //-------------------------------------------------------------------------
+        // Computes `content_hash` over data that arrives in pieces of any size
+        class content_hasher
+        {
+        public:
+            void update(const void* data, u64 size);
+            u64 finish() const;
+
+        private:
+            void mix(u64 word);
+
+            u64 m_hash = 0x9e3779b97f4a7c15ULL;
+            u64 m_size = 0;
+
+            // Bytes that do not fill a complete word yet
+            u8 m_pending[8] = {};
+            u64 m_pending_size = 0;
+        };
+    }
+}
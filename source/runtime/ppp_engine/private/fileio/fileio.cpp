@@ -1,9 +1,41 @@
 #include "fileio/fileio.h"
 
+#include <memory>
+
 namespace ppp
 {
     namespace fileio
     {
-        // Nothing to implement
+        //-------------------------------------------------------------------------
+        bool read_resolved_file_chunked(const std::string& path, u64 chunk_size, const chunk_fn& fn)
+        {
+            std::ifstream file(path.c_str(), std::ios::binary);
+            if (!file.is_open())
+            {
+                log::error("File with full path {} was not found!", path);
+                return false;
+            }
+
+            std::unique_ptr<char[]> chunk = std::make_unique<char[]>(chunk_size);
+
+            while (file)
+            {
+                file.read(chunk.get(), static_cast<std::streamsize>(chunk_size));
+
+                const u64 read_size = static_cast<u64>(file.gcount());
+                if (read_size > 0)
+                {
+                    fn(std::string_view(chunk.get(), read_size));
+                }
+            }
+
+            if (!file.eof())
+            {
+                log::error("An I/O error occurred while reading file with full path {}", path);
+                return false;
+            }
+
+            return true;
+        }
     }
 }
\ No newline at end of file
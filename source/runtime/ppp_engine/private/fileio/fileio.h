@@ -8,6 +8,7 @@
 
 #include <string>
 #include <fstream>
+#include <functional>
 
 #include <assert.h>
 
@@ -15,17 +16,22 @@ namespace ppp
 {
     namespace fileio
     {
+		using chunk_fn = std::function<void(std::string_view chunk)>;
+
+		//-------------------------------------------------------------------------
+		// Reads a file at an already resolved path in chunks of `chunk_size` bytes ( the last one can be smaller ).
+		// Only one chunk is in memory at a time, returns false when the file could not be read completely.
+		bool read_resolved_file_chunked(const std::string& path, u64 chunk_size, const chunk_fn& fn);
+
 		//-------------------------------------------------------------------------
+		// Reads a file at an already resolved path, the vfs is not used so this is safe to call from worker threads
 		template<typename TAlloc = std::allocator<std::byte>>
-		std::vector<std::byte, TAlloc> read_binary_file(std::string_view filename)
+		std::vector<std::byte, TAlloc> read_resolved_binary_file(const std::string& path)
 		{
-			// Load file from disk
-			const std::string path = vfs::resolve_path(filename);
-
 			std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
 			if (!file.is_open())
 			{
-				log::error("File {} with full path {} was not found!", filename, path);
+				log::error("File with full path {} was not found!", path);
 				return {};
 			}
 			else
@@ -47,16 +53,22 @@ namespace ppp
 		}
 
 		//-------------------------------------------------------------------------
-		template<typename TAlloc = std::allocator<char>>
-		std::basic_string<char, std::char_traits<char>, TAlloc> read_text_file(std::string_view filename)
+		template<typename TAlloc = std::allocator<std::byte>>
+		std::vector<std::byte, TAlloc> read_binary_file(std::string_view filename)
 		{
 			// Load file from disk
-			const std::string path = vfs::resolve_path(filename);
+			return read_resolved_binary_file<TAlloc>(vfs::resolve_path(filename));
+		}
 
+		//-------------------------------------------------------------------------
+		// Reads a file at an already resolved path, the vfs is not used so this is safe to call from worker threads
+		template<typename TAlloc = std::allocator<char>>
+		std::basic_string<char, std::char_traits<char>, TAlloc> read_resolved_text_file(const std::string& path)
+		{
 			std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
 			if (!file.is_open())
 			{
-				log::error("File {} with full path {} was not found!", filename, path);
+				log::error("File with full path {} was not found!", path);
 				return {};
 			}
 
@@ -73,20 +85,28 @@ namespace ppp
 			#ifdef _DEBUG
 			if (file.eof())
 			{
-				log::error("Reached end of file unexpectedly while reading file {} with full path {}", filename, path);
+				log::error("Reached end of file unexpectedly while reading file with full path {}", path);
 			}
 			else if (file.bad())
 			{
-				log::error("A serious I/O error occurred while reading file {} with full path {}", filename, path);
+				log::error("A serious I/O error occurred while reading file with full path {}", path);
 			}
 			else if (file.fail())
 			{
-				log::error("Failed to read file {} with full path {} due to a formatting or conversion issue", filename, path);
+				log::error("Failed to read file with full path {} due to a formatting or conversion issue", path);
 			}
 			#endif
 
 			assert(false);
 			return {};
 		}
+
+		//-------------------------------------------------------------------------
+		template<typename TAlloc = std::allocator<char>>
+		std::basic_string<char, std::char_traits<char>, TAlloc> read_text_file(std::string_view filename)
+		{
+			// Load file from disk
+			return read_resolved_text_file<TAlloc>(vfs::resolve_path(filename));
+		}
     }
 }
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "util/types.h"
+
+#include <string_view>
+
+namespace ppp
+{
+    namespace fileio
+    {
+        //-------------------------------------------------------------------------
+        // Read only memory mapping of a file, the contents are paged in on first access
+        class mapped_file
+        {
+        public:
+            mapped_file() = default;
+            ~mapped_file();
+
+            mapped_file(const mapped_file&) = delete;
+            mapped_file& operator=(const mapped_file&) = delete;
+
+            mapped_file(mapped_file&& other) noexcept;
+            mapped_file& operator=(mapped_file&& other) noexcept;
+
+            // Maps a file ( the path is expected to be resolved already ), returns false when the file can not be opened or is empty
+            bool open(std::string_view path);
+            void close();
+
+            bool is_open() const { return m_data != nullptr; }
+
+            const std::byte* data() const { return m_data; }
+            u64 size() const { return m_size; }
+
+        private:
+            const std::byte* m_data = nullptr;
+            u64 m_size = 0;
+
+            void* m_file_handle = nullptr;
+            void* m_mapping_handle = nullptr;
+        };
+    }
+}
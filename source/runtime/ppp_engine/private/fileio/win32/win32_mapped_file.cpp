@@ -0,0 +1,113 @@
+#include "fileio/mapped_file.h"
+
+#include "util/log.h"
+
+#include <windows.h>
+
+#include <string>
+#include <utility>
+
+namespace ppp
+{
+    namespace fileio
+    {
+        //-------------------------------------------------------------------------
+        mapped_file::~mapped_file()
+        {
+            close();
+        }
+
+        //-------------------------------------------------------------------------
+        mapped_file::mapped_file(mapped_file&& other) noexcept
+            : m_data(std::exchange(other.m_data, nullptr))
+            , m_size(std::exchange(other.m_size, 0))
+            , m_file_handle(std::exchange(other.m_file_handle, nullptr))
+            , m_mapping_handle(std::exchange(other.m_mapping_handle, nullptr))
+        {}
+
+        //-------------------------------------------------------------------------
+        mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+        {
+            if (this != &other)
+            {
+                close();
+
+                m_data = std::exchange(other.m_data, nullptr);
+                m_size = std::exchange(other.m_size, 0);
+                m_file_handle = std::exchange(other.m_file_handle, nullptr);
+                m_mapping_handle = std::exchange(other.m_mapping_handle, nullptr);
+            }
+
+            return *this;
+        }
+
+        //-------------------------------------------------------------------------
+        bool mapped_file::open(std::string_view path)
+        {
+            close();
+
+            const std::string path_string(path);
+
+            HANDLE file = CreateFileA(path_string.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+            {
+                return false;
+            }
+
+            LARGE_INTEGER file_size = {};
+            if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+            {
+                CloseHandle(file);
+                return false;
+            }
+
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping == nullptr)
+            {
+                log::warn("Failed to create a file mapping for {}", path);
+
+                CloseHandle(file);
+                return false;
+            }
+
+            const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (view == nullptr)
+            {
+                log::warn("Failed to map a view of {}", path);
+
+                CloseHandle(mapping);
+                CloseHandle(file);
+                return false;
+            }
+
+            m_data = static_cast<const std::byte*>(view);
+            m_size = static_cast<u64>(file_size.QuadPart);
+            m_file_handle = file;
+            m_mapping_handle = mapping;
+
+            return true;
+        }
+
+        //-------------------------------------------------------------------------
+        void mapped_file::close()
+        {
+            if (m_data != nullptr)
+            {
+                UnmapViewOfFile(m_data);
+            }
+            if (m_mapping_handle != nullptr)
+            {
+                CloseHandle(m_mapping_handle);
+            }
+            if (m_file_handle != nullptr)
+            {
+                CloseHandle(m_file_handle);
+            }
+
+            m_data = nullptr;
+            m_size = 0;
+            m_file_handle = nullptr;
+            m_mapping_handle = nullptr;
+        }
+    }
+}
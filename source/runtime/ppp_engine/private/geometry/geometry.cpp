@@ -6,6 +6,7 @@
 
 #include <glm/gtc/epsilon.hpp>
 
+#include <algorithm>
 #include <string>
 #include <sstream>
 
@@ -47,6 +48,41 @@ namespace ppp
                 : n;
         }
 
+        //-------------------------------------------------------------------------
+        static bounding_box compute_bounding_box(const std::vector<glm::vec3>& vertex_positions)
+        {
+            glm::vec3 min_vertex(
+                std::numeric_limits<float>::max(),
+                std::numeric_limits<float>::max(),
+                std::numeric_limits<float>::max());
+            glm::vec3 max_vertex(
+                std::numeric_limits<float>::lowest(),
+                std::numeric_limits<float>::lowest(),
+                std::numeric_limits<float>::lowest());
+
+            for (const auto& vertex : vertex_positions)
+            {
+                min_vertex.x = std::min(min_vertex.x, vertex.x);
+                min_vertex.y = std::min(min_vertex.y, vertex.y);
+                min_vertex.z = std::min(min_vertex.z, vertex.z);
+
+                max_vertex.x = std::max(max_vertex.x, vertex.x);
+                max_vertex.y = std::max(max_vertex.y, vertex.y);
+                max_vertex.z = std::max(max_vertex.z, vertex.z);
+            }
+
+            glm::vec3 size(
+                max_vertex.x - min_vertex.x,
+                max_vertex.y - min_vertex.y,
+                max_vertex.z - min_vertex.z);
+            glm::vec3 offset(
+                (min_vertex.x + max_vertex.x) / 2.0f,
+                (min_vertex.y + max_vertex.y) / 2.0f,
+                (min_vertex.z + max_vertex.z) / 2.0f);
+
+            return { min_vertex, max_vertex, size, offset };
+        }
+
         //-------------------------------------------------------------------------
         geometry::geometry(std::string_view geometry_id, bool smooth_normals, const geometry_creation_fn& creation_fn)
             :m_smooth_normals(smooth_normals)
@@ -153,46 +189,67 @@ namespace ppp
         //-------------------------------------------------------------------------
         void geometry::compute_aabb()
         {
-            glm::vec3 min_vertex(
-                std::numeric_limits<float>::max(),
-                std::numeric_limits<float>::max(),
-                std::numeric_limits<float>::max());
-            glm::vec3 max_vertex(
-                std::numeric_limits<float>::lowest(),
-                std::numeric_limits<float>::lowest(),
-                std::numeric_limits<float>::lowest());
-
-            for (const auto& vertex : m_vertex_positions)
-            {
-                min_vertex.x = std::min(min_vertex.x, vertex.x);
-                min_vertex.y = std::min(min_vertex.y, vertex.y);
-                min_vertex.z = std::min(min_vertex.z, vertex.z);
-
-                max_vertex.x = std::max(max_vertex.x, vertex.x);
-                max_vertex.y = std::max(max_vertex.y, vertex.y);
-                max_vertex.z = std::max(max_vertex.z, vertex.z);
-            }
-
-            glm::vec3 size(
-                max_vertex.x - min_vertex.x,
-                max_vertex.y - min_vertex.y,
-                max_vertex.z - min_vertex.z);
-            glm::vec3 offset(
-                (min_vertex.x + max_vertex.x) / 2.0f,
-                (min_vertex.y + max_vertex.y) / 2.0f,
-                (min_vertex.z + max_vertex.z) / 2.0f);
+            m_bounding_box = compute_bounding_box(m_vertex_positions);
+        }
 
-            m_bounding_box = { min_vertex, max_vertex, size, offset };
+        //-------------------------------------------------------------------------
+        void geometry::assign_aabb(const glm::vec3& min, const glm::vec3& max)
+        {
+            m_bounding_box = { min, max, max - min, (min + max) / 2.0f };
         }
 
-        const bounding_box& geometry::aabb()
+        //-------------------------------------------------------------------------
+        const bounding_box& geometry::aabb() const
         { 
             if (!m_bounding_box)
             {
-                compute_aabb();
+                m_bounding_box = compute_bounding_box(m_vertex_positions);
             }
             
             return m_bounding_box;
         }
+
+        //-------------------------------------------------------------------------
+        void geometry::mark_dirty()
+        {
+            mark_dirty(0, vertex_count());
+        }
+
+        //-------------------------------------------------------------------------
+        void geometry::mark_dirty(u64 first_vertex, u64 vertex_count)
+        {
+            const u64 total_vertex_count = this->vertex_count();
+
+            if (first_vertex >= total_vertex_count || vertex_count == 0)
+            {
+                return;
+            }
+
+            const u64 last_vertex = std::min(first_vertex + vertex_count, total_vertex_count);
+
+            if (m_dirty_range.empty())
+            {
+                m_dirty_range = { first_vertex, last_vertex - first_vertex };
+            }
+            else
+            {
+                const u64 first = std::min(m_dirty_range.first, first_vertex);
+                const u64 last = std::max(m_dirty_range.first + m_dirty_range.count, last_vertex);
+
+                m_dirty_range = { first, last - first };
+            }
+
+            ++m_revision;
+
+            // Positions might have moved, the bounding box is recomputed on the next request
+            m_bounding_box = {};
+        }
+
+        //-------------------------------------------------------------------------
+        void geometry::clear_dirty()
+        {
+            m_dirty_range = {};
+            m_base_revision = m_revision;
+        }
     }
 }
\ No newline at end of file
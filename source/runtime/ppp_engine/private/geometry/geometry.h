@@ -17,6 +17,27 @@ namespace ppp
     {
         using geometry_creation_fn = std::function<void(class geometry*)>;
 
+        //-------------------------------------------------------------------------
+        struct vertex_range
+        {
+            u64 first = 0;
+            u64 count = 0;
+
+            bool empty() const { return count == 0; }
+        };
+
+        //-------------------------------------------------------------------------
+        // Faces that share a material and a group ( e.g. "usemtl" / "g" in an OBJ file ).
+        // Submeshes are ranges of the index buffer of their geometry, the vertices and faces are not duplicated.
+        struct submesh
+        {
+            std::string material;
+            std::string group;
+
+            u64 first_index = 0;
+            u64 index_count = 0;
+        };
+
         class geometry
         {
         public:
@@ -29,12 +50,16 @@ namespace ppp
 
             void compute_normals(s32 round_to_precision = 3);
             void compute_aabb();
+            // Sets a bounding box that is already known ( e.g. from a cooked mesh ) instead of computing it from the positions
+            void assign_aabb(const glm::vec3& min, const glm::vec3& max);
 
             const std::vector<glm::vec3>& vertex_positions() const { return m_vertex_positions; }
             const std::vector<glm::vec3>& vertex_normals() const { return m_vertex_normals; }
             const std::vector<glm::vec2>& vertex_uvs() const { return m_vertex_uvs; }
 
             const std::vector<render::face>& faces() const { return m_faces; }
+            // Empty for geometry that was not loaded from a file, the whole index buffer is then a single submesh
+            const std::vector<submesh>& submeshes() const { return m_submeshes; }
 
             const u64 id() const { return m_id; }
             
@@ -43,8 +68,22 @@ namespace ppp
             std::vector<glm::vec2>& vertex_uvs() { return m_vertex_uvs; }
 
             std::vector<render::face>& faces() { return m_faces; }
+            std::vector<submesh>& submeshes() { return m_submeshes; }
+
+            const bounding_box& aabb() const;
+
+            // Mutation tracking
+            // Every edit bumps the revision, the dirty range collects the vertices touched since the last `clear_dirty`.
+            void mark_dirty();
+            void mark_dirty(u64 first_vertex, u64 vertex_count);
+            void clear_dirty();
 
-            const bounding_box& aabb();
+            bool is_dirty() const { return !m_dirty_range.empty(); }
+
+            u64 revision() const { return m_revision; }
+            u64 base_revision() const { return m_base_revision; }
+
+            const vertex_range& dirty_range() const { return m_dirty_range; }
 
         private:
             std::vector<glm::vec3> m_vertex_positions;
@@ -53,8 +92,13 @@ namespace ppp
             std::vector<glm::vec4> m_vertex_colors;
             
             std::vector<render::face> m_faces;
+            std::vector<submesh> m_submeshes;
+
+            mutable bounding_box m_bounding_box;
 
-            bounding_box m_bounding_box;
+            vertex_range m_dirty_range;
+            u64 m_revision = 0;
+            u64 m_base_revision = 0;
 
         private:
             bool m_smooth_normals; 
@@ -0,0 +1,377 @@
+#include "geometry/geometry_bvh.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <numeric>
+
+namespace ppp
+{
+    namespace geometry
+    {
+        constexpr s32 sah_bin_count = 16;
+        // Nodes deeper than this are kept as leaves, which bounds the traversal stack
+        constexpr s32 max_tree_depth = 64;
+
+        constexpr f32 no_intersection = std::numeric_limits<f32>::max();
+
+        //-------------------------------------------------------------------------
+        struct sah_bin
+        {
+            glm::vec3 min = glm::vec3(std::numeric_limits<f32>::max());
+            glm::vec3 max = glm::vec3(std::numeric_limits<f32>::lowest());
+            u32 count = 0;
+
+            void grow(const glm::vec3& point_min, const glm::vec3& point_max)
+            {
+                min = glm::min(min, point_min);
+                max = glm::max(max, point_max);
+            }
+        };
+
+        //-------------------------------------------------------------------------
+        static f32 half_surface_area(const glm::vec3& min, const glm::vec3& max)
+        {
+            const glm::vec3 extents = max - min;
+
+            return extents.x * extents.y + extents.y * extents.z + extents.z * extents.x;
+        }
+
+        //-------------------------------------------------------------------------
+        static f32 intersect_node(const bvh_node& node, const glm::vec3& ray_origin, const glm::vec3& inv_ray_dir, f32 closest_t)
+        {
+            const glm::vec3 t1 = (node.min - ray_origin) * inv_ray_dir;
+            const glm::vec3 t2 = (node.max - ray_origin) * inv_ray_dir;
+
+            const glm::vec3 t_near = glm::min(t1, t2);
+            const glm::vec3 t_far = glm::max(t1, t2);
+
+            const f32 t_min = std::max(std::max(t_near.x, t_near.y), t_near.z);
+            const f32 t_max = std::min(std::min(t_far.x, t_far.y), t_far.z);
+
+            if (t_max >= std::max(t_min, 0.0f) && t_min < closest_t)
+            {
+                return t_min;
+            }
+
+            return no_intersection;
+        }
+
+        //-------------------------------------------------------------------------
+        void bvh::build(const bounding_box* primitive_bounds, u32 primitive_count)
+        {
+            clear();
+
+            if (primitive_count == 0)
+            {
+                return;
+            }
+
+            std::vector<glm::vec3> centroids(primitive_count);
+            for (u32 i = 0; i < primitive_count; ++i)
+            {
+                centroids[i] = (primitive_bounds[i].min + primitive_bounds[i].max) * 0.5f;
+            }
+
+            m_primitive_indices.resize(primitive_count);
+            std::iota(std::begin(m_primitive_indices), std::end(m_primitive_indices), 0);
+
+            // A binary tree over n leaves never holds more than 2n - 1 nodes
+            m_nodes.reserve(primitive_count * 2 - 1);
+
+            bvh_node root;
+            root.left_first = 0;
+            root.count = primitive_count;
+            m_nodes.push_back(root);
+
+            update_node_bounds(0, primitive_bounds);
+            subdivide(0, 0, primitive_bounds, centroids);
+
+            m_nodes.shrink_to_fit();
+        }
+
+        //-------------------------------------------------------------------------
+        void bvh::refit(const bounding_box* primitive_bounds)
+        {
+            // Children are always stored after their parent, walking backwards visits them first
+            for (s64 i = static_cast<s64>(m_nodes.size()) - 1; i >= 0; --i)
+            {
+                bvh_node& node = m_nodes[i];
+
+                if (node.is_leaf())
+                {
+                    update_node_bounds(static_cast<u32>(i), primitive_bounds);
+                    continue;
+                }
+
+                const bvh_node& left = m_nodes[node.left_first];
+                const bvh_node& right = m_nodes[node.left_first + 1];
+
+                node.min = glm::min(left.min, right.min);
+                node.max = glm::max(left.max, right.max);
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        void bvh::clear()
+        {
+            m_nodes.clear();
+            m_primitive_indices.clear();
+        }
+
+        //-------------------------------------------------------------------------
+        bool bvh::intersect(const glm::vec3& ray_origin, const glm::vec3& ray_dir, f32& closest_t, const bvh_intersect_fn& intersect_fn) const
+        {
+            if (m_nodes.empty())
+            {
+                return false;
+            }
+
+            const glm::vec3 inv_ray_dir = 1.0f / ray_dir;
+
+            if (intersect_node(m_nodes[0], ray_origin, inv_ray_dir, closest_t) == no_intersection)
+            {
+                return false;
+            }
+
+            bool hit = false;
+
+            std::array<u32, max_tree_depth> stack;
+            s32 stack_size = 0;
+
+            u32 node_index = 0;
+            while (true)
+            {
+                const bvh_node& node = m_nodes[node_index];
+
+                if (node.is_leaf())
+                {
+                    for (u32 i = 0; i < node.count; ++i)
+                    {
+                        hit |= intersect_fn(m_primitive_indices[node.left_first + i], closest_t);
+                    }
+
+                    if (stack_size == 0)
+                    {
+                        break;
+                    }
+
+                    node_index = stack[--stack_size];
+                    continue;
+                }
+
+                u32 near_index = node.left_first;
+                u32 far_index = node.left_first + 1;
+
+                f32 near_t = intersect_node(m_nodes[near_index], ray_origin, inv_ray_dir, closest_t);
+                f32 far_t = intersect_node(m_nodes[far_index], ray_origin, inv_ray_dir, closest_t);
+
+                if (near_t > far_t)
+                {
+                    std::swap(near_t, far_t);
+                    std::swap(near_index, far_index);
+                }
+
+                if (near_t == no_intersection)
+                {
+                    if (stack_size == 0)
+                    {
+                        break;
+                    }
+
+                    node_index = stack[--stack_size];
+                    continue;
+                }
+
+                node_index = near_index;
+                if (far_t != no_intersection)
+                {
+                    stack[stack_size++] = far_index;
+                }
+            }
+
+            return hit;
+        }
+
+        //-------------------------------------------------------------------------
+        void bvh::update_node_bounds(u32 node_index, const bounding_box* primitive_bounds)
+        {
+            bvh_node& node = m_nodes[node_index];
+
+            node.min = glm::vec3(std::numeric_limits<f32>::max());
+            node.max = glm::vec3(std::numeric_limits<f32>::lowest());
+
+            for (u32 i = 0; i < node.count; ++i)
+            {
+                const bounding_box& bounds = primitive_bounds[m_primitive_indices[node.left_first + i]];
+
+                node.min = glm::min(node.min, bounds.min);
+                node.max = glm::max(node.max, bounds.max);
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        void bvh::subdivide(u32 node_index, s32 depth, const bounding_box* primitive_bounds, const std::vector<glm::vec3>& centroids)
+        {
+            const u32 first = m_nodes[node_index].left_first;
+            const u32 count = m_nodes[node_index].count;
+
+            if (count <= 1 || depth >= max_tree_depth - 1)
+            {
+                return;
+            }
+
+            glm::vec3 centroid_min = glm::vec3(std::numeric_limits<f32>::max());
+            glm::vec3 centroid_max = glm::vec3(std::numeric_limits<f32>::lowest());
+            for (u32 i = 0; i < count; ++i)
+            {
+                centroid_min = glm::min(centroid_min, centroids[m_primitive_indices[first + i]]);
+                centroid_max = glm::max(centroid_max, centroids[m_primitive_indices[first + i]]);
+            }
+
+            // Find the cheapest split plane among the bin boundaries of every axis
+            s32 best_axis = -1;
+            s32 best_split = 0;
+            f32 best_cost = no_intersection;
+
+            for (s32 axis = 0; axis < 3; ++axis)
+            {
+                const f32 extent = centroid_max[axis] - centroid_min[axis];
+                if (extent <= 0.0f)
+                {
+                    continue;
+                }
+
+                const f32 scale = sah_bin_count / extent;
+
+                std::array<sah_bin, sah_bin_count> bins;
+                for (u32 i = 0; i < count; ++i)
+                {
+                    const u32 primitive = m_primitive_indices[first + i];
+                    const s32 bin_index = std::min(sah_bin_count - 1, static_cast<s32>((centroids[primitive][axis] - centroid_min[axis]) * scale));
+
+                    bins[bin_index].grow(primitive_bounds[primitive].min, primitive_bounds[primitive].max);
+                    bins[bin_index].count++;
+                }
+
+                // Sweep from both sides to gather the cost of every split
+                std::array<f32, sah_bin_count - 1> left_area, right_area;
+                std::array<u32, sah_bin_count - 1> left_count, right_count;
+
+                sah_bin left_box, right_box;
+                u32 left_sum = 0, right_sum = 0;
+                for (s32 i = 0; i < sah_bin_count - 1; ++i)
+                {
+                    left_sum += bins[i].count;
+                    left_count[i] = left_sum;
+                    left_box.grow(bins[i].min, bins[i].max);
+                    left_area[i] = left_sum > 0 ? half_surface_area(left_box.min, left_box.max) : 0.0f;
+
+                    const s32 j = sah_bin_count - 1 - i;
+                    right_sum += bins[j].count;
+                    right_count[j - 1] = right_sum;
+                    right_box.grow(bins[j].min, bins[j].max);
+                    right_area[j - 1] = right_sum > 0 ? half_surface_area(right_box.min, right_box.max) : 0.0f;
+                }
+
+                for (s32 i = 0; i < sah_bin_count - 1; ++i)
+                {
+                    const f32 cost = left_count[i] * left_area[i] + right_count[i] * right_area[i];
+                    if (cost < best_cost)
+                    {
+                        best_cost = cost;
+                        best_axis = axis;
+                        best_split = i;
+                    }
+                }
+            }
+
+            // Splitting only pays off when it is cheaper than testing every primitive in this node
+            const f32 leaf_cost = count * half_surface_area(m_nodes[node_index].min, m_nodes[node_index].max);
+            if (best_axis == -1 || best_cost >= leaf_cost)
+            {
+                return;
+            }
+
+            const f32 scale = sah_bin_count / (centroid_max[best_axis] - centroid_min[best_axis]);
+            auto split_it = std::partition(
+                std::begin(m_primitive_indices) + first,
+                std::begin(m_primitive_indices) + first + count,
+                [&](u32 primitive)
+            {
+                const s32 bin_index = std::min(sah_bin_count - 1, static_cast<s32>((centroids[primitive][best_axis] - centroid_min[best_axis]) * scale));
+                return bin_index <= best_split;
+            });
+
+            const u32 left_count = static_cast<u32>(std::distance(std::begin(m_primitive_indices) + first, split_it));
+            if (left_count == 0 || left_count == count)
+            {
+                return;
+            }
+
+            const u32 left_index = static_cast<u32>(m_nodes.size());
+
+            bvh_node left;
+            left.left_first = first;
+            left.count = left_count;
+
+            bvh_node right;
+            right.left_first = first + left_count;
+            right.count = count - left_count;
+
+            m_nodes.push_back(left);
+            m_nodes.push_back(right);
+
+            m_nodes[node_index].left_first = left_index;
+            m_nodes[node_index].count = 0;
+
+            update_node_bounds(left_index, primitive_bounds);
+            update_node_bounds(left_index + 1, primitive_bounds);
+
+            subdivide(left_index, depth + 1, primitive_bounds, centroids);
+            subdivide(left_index + 1, depth + 1, primitive_bounds, centroids);
+        }
+
+        //-------------------------------------------------------------------------
+        bool ray_intersects_triangle(const glm::vec3& ray_origin, const glm::vec3& ray_dir, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, f32& t_out)
+        {
+            constexpr f32 epsilon = 1e-7f;
+
+            const glm::vec3 edge_1 = v1 - v0;
+            const glm::vec3 edge_2 = v2 - v0;
+
+            const glm::vec3 p = glm::cross(ray_dir, edge_2);
+            const f32 det = glm::dot(edge_1, p);
+            if (std::abs(det) < epsilon)
+            {
+                // Ray runs parallel to the triangle
+                return false;
+            }
+
+            const f32 inv_det = 1.0f / det;
+
+            const glm::vec3 s = ray_origin - v0;
+            const f32 u = glm::dot(s, p) * inv_det;
+            if (u < 0.0f || u > 1.0f)
+            {
+                return false;
+            }
+
+            const glm::vec3 q = glm::cross(s, edge_1);
+            const f32 v = glm::dot(ray_dir, q) * inv_det;
+            if (v < 0.0f || u + v > 1.0f)
+            {
+                return false;
+            }
+
+            const f32 t = glm::dot(edge_2, q) * inv_det;
+            if (t < 0.0f)
+            {
+                return false;
+            }
+
+            t_out = t;
+            return true;
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "geometry/geometry_bounding_box.h"
+
+#include "util/types.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <functional>
+
+namespace ppp
+{
+    namespace geometry
+    {
+        //-------------------------------------------------------------------------
+        // Interior nodes store the index of their left child in `left_first`, the right child follows directly after it.
+        // Leaf nodes store the first entry in the primitive index list and the amount of primitives they hold.
+        struct bvh_node
+        {
+            glm::vec3 min = {};
+            u32 left_first = 0;
+            glm::vec3 max = {};
+            u32 count = 0;
+
+            bool is_leaf() const { return count > 0; }
+        };
+
+        //-------------------------------------------------------------------------
+        // Tests the primitive against the ray, on a hit `closest_t` is lowered and true is returned
+        using bvh_intersect_fn = std::function<bool(u32 primitive, f32& closest_t)>;
+
+        //-------------------------------------------------------------------------
+        // Bounding volume hierarchy over a set of primitive bounds, split with a binned surface area heuristic.
+        class bvh
+        {
+        public:
+            void build(const bounding_box* primitive_bounds, u32 primitive_count);
+            // Keeps the tree layout and only recomputes the node bounds, cheaper than a build when primitives moved a little.
+            // The primitives have to be passed in the same order as during the build.
+            void refit(const bounding_box* primitive_bounds);
+            void clear();
+
+            // Visits the nodes front to back and skips every node further away than the closest hit found so far.
+            // Returns true when `intersect_fn` reported at least one hit, `closest_t` then holds the distance along the ray.
+            bool intersect(const glm::vec3& ray_origin, const glm::vec3& ray_dir, f32& closest_t, const bvh_intersect_fn& intersect_fn) const;
+
+            bool empty() const { return m_nodes.empty(); }
+
+            u32 primitive_count() const { return static_cast<u32>(m_primitive_indices.size()); }
+
+            const std::vector<bvh_node>& nodes() const { return m_nodes; }
+            const std::vector<u32>& primitive_indices() const { return m_primitive_indices; }
+
+        private:
+            void update_node_bounds(u32 node_index, const bounding_box* primitive_bounds);
+            void subdivide(u32 node_index, s32 depth, const bounding_box* primitive_bounds, const std::vector<glm::vec3>& centroids);
+
+            std::vector<bvh_node> m_nodes;
+            std::vector<u32> m_primitive_indices;
+        };
+
+        //-------------------------------------------------------------------------
+        // Two sided Moller-Trumbore test, `t_out` is expressed in units of `ray_dir`
+        bool ray_intersects_triangle(const glm::vec3& ray_origin, const glm::vec3& ray_dir, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, f32& t_out);
+    }
+}
@@ -0,0 +1,71 @@
+#include "geometry/geometry_frustum.h"
+
+#include <cmath>
+
+namespace ppp
+{
+    namespace geometry
+    {
+        //-------------------------------------------------------------------------
+        static void set_plane(frustum& f, s32 index, const glm::vec4& plane)
+        {
+            f.normal_x[index] = plane.x;
+            f.normal_y[index] = plane.y;
+            f.normal_z[index] = plane.z;
+            f.distance[index] = plane.w;
+        }
+
+        //-------------------------------------------------------------------------
+        frustum make_frustum(const glm::mat4& view_proj)
+        {
+            // Gribb/Hartmann plane extraction, glm matrices are column major so we gather the rows first
+            const glm::vec4 row_0(view_proj[0][0], view_proj[1][0], view_proj[2][0], view_proj[3][0]);
+            const glm::vec4 row_1(view_proj[0][1], view_proj[1][1], view_proj[2][1], view_proj[3][1]);
+            const glm::vec4 row_2(view_proj[0][2], view_proj[1][2], view_proj[2][2], view_proj[3][2]);
+            const glm::vec4 row_3(view_proj[0][3], view_proj[1][3], view_proj[2][3], view_proj[3][3]);
+
+            frustum f;
+
+            set_plane(f, 0, row_3 + row_0);     // left
+            set_plane(f, 1, row_3 - row_0);     // right
+            set_plane(f, 2, row_3 + row_1);     // bottom
+            set_plane(f, 3, row_3 - row_1);     // top
+            set_plane(f, 4, row_3 + row_2);     // near
+            set_plane(f, 5, row_3 - row_2);     // far
+
+            // Padding planes accept everything
+            for (s32 i = frustum_plane_count; i < frustum_plane_padded_count; ++i)
+            {
+                set_plane(f, i, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+            }
+
+            return f;
+        }
+
+        //-------------------------------------------------------------------------
+        bool frustum_intersects_aabb(const frustum& f, const bounding_box& local_aabb, const glm::mat4& world)
+        {
+            const glm::vec3 local_center = (local_aabb.min + local_aabb.max) * 0.5f;
+            const glm::vec3 local_extents = (local_aabb.max - local_aabb.min) * 0.5f;
+
+            // Box that encloses the transformed local box (Arvo)
+            const glm::vec3 center = glm::vec3(world * glm::vec4(local_center, 1.0f));
+            const glm::vec3 extents =
+                glm::abs(glm::vec3(world[0])) * local_extents.x +
+                glm::abs(glm::vec3(world[1])) * local_extents.y +
+                glm::abs(glm::vec3(world[2])) * local_extents.z;
+
+            // Planes are not normalized, distance and radius scale by the same factor so the sign test stays valid
+            s32 outside = 0;
+            for (s32 i = 0; i < frustum_plane_padded_count; ++i)
+            {
+                const f32 distance = f.normal_x[i] * center.x + f.normal_y[i] * center.y + f.normal_z[i] * center.z + f.distance[i];
+                const f32 radius = std::abs(f.normal_x[i]) * extents.x + std::abs(f.normal_y[i]) * extents.y + std::abs(f.normal_z[i]) * extents.z;
+
+                outside |= (distance + radius) < 0.0f;
+            }
+
+            return outside == 0;
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "geometry/geometry_bounding_box.h"
+
+#include "util/types.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+namespace ppp
+{
+    namespace geometry
+    {
+        // Padding planes accept every box, the plane loop always runs over full groups of 4
+        constexpr s32 frustum_plane_count = 6;
+        constexpr s32 frustum_plane_padded_count = 8;
+
+        //-------------------------------------------------------------------------
+        // Clipping planes of a view projection matrix.
+        // Components are stored per plane (structure of arrays), the box is tested against every plane in a single loop.
+        struct frustum
+        {
+            alignas(32) std::array<f32, frustum_plane_padded_count> normal_x = {};
+            alignas(32) std::array<f32, frustum_plane_padded_count> normal_y = {};
+            alignas(32) std::array<f32, frustum_plane_padded_count> normal_z = {};
+            alignas(32) std::array<f32, frustum_plane_padded_count> distance = {};
+        };
+
+        //-------------------------------------------------------------------------
+        frustum make_frustum(const glm::mat4& view_proj);
+
+        //-------------------------------------------------------------------------
+        // Transforms the local bounding box by the world matrix and tests the resulting box against the planes.
+        // Returns true when the box is inside or intersects the frustum.
+        bool frustum_intersects_aabb(const frustum& f, const bounding_box& local_aabb, const glm::mat4& world);
+    }
+}
@@ -0,0 +1,261 @@
+#include "geometry/geometry_occlusion_buffer.h"
+#include "geometry/geometry_projection.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace ppp
+{
+    namespace geometry
+    {
+        // Vertices closer to the camera than this (in clip space w) are treated as crossing the near plane
+        constexpr f32 min_clip_w = 1e-5f;
+        // Items are tested against at most this many texels per axis, the hierarchy level is picked accordingly
+        constexpr s32 max_test_texels = 4;
+
+        //-------------------------------------------------------------------------
+        struct screen_vertex
+        {
+            glm::vec3 position;
+            bool valid;
+        };
+
+        //-------------------------------------------------------------------------
+        // Vertices in front of the near plane have no depth in [0, 1], triangles using them are not rasterized
+        static screen_vertex to_screen(const glm::vec4& clip, s32 width, s32 height)
+        {
+            if (clip.w <= min_clip_w || clip.z < -clip.w)
+            {
+                return { glm::vec3(0.0f), false };
+            }
+
+            const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+
+            return { glm::vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f), true };
+        }
+
+        //-------------------------------------------------------------------------
+        occlusion_buffer::occlusion_buffer(s32 width, s32 height)
+            : m_width(width)
+            , m_height(height)
+        {
+            s32 level_width = width;
+            s32 level_height = height;
+
+            while (true)
+            {
+                m_level_sizes.push_back({ level_width, level_height });
+                m_levels.emplace_back(static_cast<u64>(level_width) * level_height, 1.0f);
+
+                if (level_width == 1 && level_height == 1)
+                {
+                    break;
+                }
+
+                level_width = std::max(1, (level_width + 1) / 2);
+                level_height = std::max(1, (level_height + 1) / 2);
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        void occlusion_buffer::clear()
+        {
+            if (m_empty)
+            {
+                return;
+            }
+
+            for (auto& level : m_levels)
+            {
+                std::fill(std::begin(level), std::end(level), 1.0f);
+            }
+
+            m_empty = true;
+            m_hierarchy_dirty = false;
+        }
+
+        //-------------------------------------------------------------------------
+        void occlusion_buffer::rasterize(const glm::vec3* positions, const render::face* faces, u64 face_count, const glm::mat4& model_view_proj)
+        {
+            for (u64 i = 0; i < face_count; ++i)
+            {
+                const render::face& face = faces[i];
+
+                const screen_vertex v0 = to_screen(model_view_proj * glm::vec4(positions[face[0]], 1.0f), m_width, m_height);
+                const screen_vertex v1 = to_screen(model_view_proj * glm::vec4(positions[face[1]], 1.0f), m_width, m_height);
+                const screen_vertex v2 = to_screen(model_view_proj * glm::vec4(positions[face[2]], 1.0f), m_width, m_height);
+
+                if (!v0.valid || !v1.valid || !v2.valid)
+                {
+                    continue;
+                }
+
+                rasterize_triangle(v0.position, v1.position, v2.position);
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        bool occlusion_buffer::is_occluded(const bounding_box& local_bounds, const glm::mat4& model_view_proj)
+        {
+            if (m_empty)
+            {
+                return false;
+            }
+
+            if (m_hierarchy_dirty)
+            {
+                build_hierarchy();
+            }
+
+            const projected_bounds projected = project_bounds(local_bounds, model_view_proj, glm::vec2(m_width, m_height));
+            if (!projected.valid || projected.nearest_depth <= 0.0f)
+            {
+                // Box reaches behind the camera
+                return false;
+            }
+
+            const glm::vec2& screen_min = projected.min;
+            const glm::vec2& screen_max = projected.max;
+            const f32 nearest_depth = projected.nearest_depth;
+
+            if (screen_max.x < 0.0f || screen_max.y < 0.0f || screen_min.x >= m_width || screen_min.y >= m_height)
+            {
+                // Off-screen items are left to the frustum test
+                return false;
+            }
+
+            // Occluders cover pixels by their center, growing the rectangle by a pixel keeps items peeking past an edge visible
+            s32 x0 = std::max(0, static_cast<s32>(std::floor(screen_min.x)) - 1);
+            s32 y0 = std::max(0, static_cast<s32>(std::floor(screen_min.y)) - 1);
+            s32 x1 = std::min(m_width - 1, static_cast<s32>(std::floor(screen_max.x)) + 1);
+            s32 y1 = std::min(m_height - 1, static_cast<s32>(std::floor(screen_max.y)) + 1);
+
+            s32 level = 0;
+            while ((x1 - x0 + 1 > max_test_texels || y1 - y0 + 1 > max_test_texels) && level + 1 < static_cast<s32>(m_levels.size()))
+            {
+                ++level;
+
+                x0 >>= 1; y0 >>= 1;
+                x1 >>= 1; y1 >>= 1;
+            }
+
+            const std::vector<f32>& depths = m_levels[level];
+            const s32 level_width = m_level_sizes[level].width;
+
+            for (s32 y = y0; y <= y1; ++y)
+            {
+                for (s32 x = x0; x <= x1; ++x)
+                {
+                    if (nearest_depth <= depths[y * level_width + x])
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        //-------------------------------------------------------------------------
+        void occlusion_buffer::rasterize_triangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2)
+        {
+            // Edge i is opposite of vertex i, E(x, y) = a * x + b * y + c
+            std::array<glm::vec3, 3> edges =
+            {
+                glm::vec3(v1.y - v2.y, v2.x - v1.x, v1.x * v2.y - v2.x * v1.y),
+                glm::vec3(v2.y - v0.y, v0.x - v2.x, v2.x * v0.y - v0.x * v2.y),
+                glm::vec3(v0.y - v1.y, v1.x - v0.x, v0.x * v1.y - v1.x * v0.y)
+            };
+
+            f32 area = edges[0].z + edges[1].z + edges[2].z;
+            if (std::abs(area) < 1e-6f)
+            {
+                return;
+            }
+
+            // Occluders are two sided, flip the edges of clockwise triangles so the inside is always positive
+            if (area < 0.0f)
+            {
+                for (glm::vec3& edge : edges)
+                {
+                    edge = -edge;
+                }
+
+                area = -area;
+            }
+
+            const f32 inv_area = 1.0f / area;
+
+            // Depth plane and the offset to the farthest corner of a pixel
+            const f32 depth_dx = (edges[0].x * v0.z + edges[1].x * v1.z + edges[2].x * v2.z) * inv_area;
+            const f32 depth_dy = (edges[0].y * v0.z + edges[1].y * v1.z + edges[2].y * v2.z) * inv_area;
+            const f32 depth_corner_offset = 0.5f * (std::abs(depth_dx) + std::abs(depth_dy));
+            const f32 max_depth = std::max(v0.z, std::max(v1.z, v2.z));
+
+            const s32 x_begin = std::max(0, static_cast<s32>(std::floor(std::min(v0.x, std::min(v1.x, v2.x)))));
+            const s32 y_begin = std::max(0, static_cast<s32>(std::floor(std::min(v0.y, std::min(v1.y, v2.y)))));
+            const s32 x_end = std::min(m_width, static_cast<s32>(std::ceil(std::max(v0.x, std::max(v1.x, v2.x)))));
+            const s32 y_end = std::min(m_height, static_cast<s32>(std::ceil(std::max(v0.y, std::max(v1.y, v2.y)))));
+
+            std::vector<f32>& depths = m_levels[0];
+
+            for (s32 y = y_begin; y < y_end; ++y)
+            {
+                const f32 center_y = y + 0.5f;
+
+                f32* row = depths.data() + static_cast<u64>(y) * m_width;
+
+                for (s32 x = x_begin; x < x_end; ++x)
+                {
+                    const f32 center_x = x + 0.5f;
+
+                    const f32 e0 = edges[0].x * center_x + edges[0].y * center_y + edges[0].z;
+                    const f32 e1 = edges[1].x * center_x + edges[1].y * center_y + edges[1].z;
+                    const f32 e2 = edges[2].x * center_x + edges[2].y * center_y + edges[2].z;
+
+                    // Pixels on a shared edge are written by both triangles, which keeps closed meshes free of cracks
+                    const bool covered = e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f;
+
+                    const f32 depth = std::min(max_depth, (e0 * v0.z + e1 * v1.z + e2 * v2.z) * inv_area + depth_corner_offset);
+
+                    row[x] = covered ? std::min(row[x], depth) : row[x];
+                }
+            }
+
+            m_empty = false;
+            m_hierarchy_dirty = true;
+        }
+
+        //-------------------------------------------------------------------------
+        void occlusion_buffer::build_hierarchy()
+        {
+            for (u64 level = 1; level < m_levels.size(); ++level)
+            {
+                const level_size& src_size = m_level_sizes[level - 1];
+                const level_size& dst_size = m_level_sizes[level];
+
+                const std::vector<f32>& src = m_levels[level - 1];
+                std::vector<f32>& dst = m_levels[level];
+
+                for (s32 y = 0; y < dst_size.height; ++y)
+                {
+                    const s32 src_y0 = y * 2;
+                    const s32 src_y1 = std::min(src_y0 + 1, src_size.height - 1);
+
+                    for (s32 x = 0; x < dst_size.width; ++x)
+                    {
+                        const s32 src_x0 = x * 2;
+                        const s32 src_x1 = std::min(src_x0 + 1, src_size.width - 1);
+
+                        dst[y * dst_size.width + x] = std::max(
+                            std::max(src[src_y0 * src_size.width + src_x0], src[src_y0 * src_size.width + src_x1]),
+                            std::max(src[src_y1 * src_size.width + src_x0], src[src_y1 * src_size.width + src_x1]));
+                    }
+                }
+            }
+
+            m_hierarchy_dirty = false;
+        }
+    }
+}
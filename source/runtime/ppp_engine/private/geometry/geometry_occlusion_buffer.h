@@ -0,0 +1,61 @@
+#pragma once
+
+#include "geometry/geometry_bounding_box.h"
+
+#include "util/types.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace ppp
+{
+    namespace geometry
+    {
+        //-------------------------------------------------------------------------
+        // Low resolution depth buffer that is filled on the CPU with a few large occluders.
+        // Depth is stored in [0, 1], 1 being the far plane. A hierarchy keeps the farthest depth of every 2x2 block
+        // so the bounds of an item can be tested against a handful of texels regardless of its size on screen.
+        class occlusion_buffer
+        {
+        public:
+            occlusion_buffer(s32 width = 256, s32 height = 128);
+
+            void clear();
+
+            // Pixels with their center inside of a triangle are written, at the farthest depth of the triangle within the pixel.
+            // Triangles crossing the near plane are skipped, which keeps the buffer conservative.
+            void rasterize(const glm::vec3* positions, const render::face* faces, u64 face_count, const glm::mat4& model_view_proj);
+
+            // True when the box is guaranteed to be hidden behind the rasterized occluders.
+            // The hierarchy is rebuilt on the first test after new occluders have been rasterized.
+            bool is_occluded(const bounding_box& local_bounds, const glm::mat4& model_view_proj);
+
+            bool empty() const { return m_empty; }
+
+            s32 width() const { return m_width; }
+            s32 height() const { return m_height; }
+
+            f32 depth(s32 x, s32 y) const { return m_levels[0][y * m_width + x]; }
+
+        private:
+            struct level_size
+            {
+                s32 width;
+                s32 height;
+            };
+
+            void rasterize_triangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
+            void build_hierarchy();
+
+            s32 m_width;
+            s32 m_height;
+
+            std::vector<std::vector<f32>> m_levels;
+            std::vector<level_size> m_level_sizes;
+
+            bool m_empty = true;
+            bool m_hierarchy_dirty = false;
+        };
+    }
+}
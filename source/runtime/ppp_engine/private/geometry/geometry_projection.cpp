@@ -0,0 +1,65 @@
+#include "geometry/geometry_projection.h"
+
+#include <limits>
+#include <algorithm>
+
+namespace ppp
+{
+    namespace geometry
+    {
+        // Corners closer to the camera than this (in clip space w) are treated as crossing the near plane
+        constexpr f32 min_clip_w = 1e-5f;
+
+        //-------------------------------------------------------------------------
+        projected_bounds project_bounds(const bounding_box& local_bounds, const glm::mat4& model_view_proj, const glm::vec2& viewport_size)
+        {
+            projected_bounds result;
+            result.min = glm::vec2(std::numeric_limits<f32>::max());
+            result.max = glm::vec2(std::numeric_limits<f32>::lowest());
+            result.nearest_depth = std::numeric_limits<f32>::max();
+
+            for (s32 corner = 0; corner < 8; ++corner)
+            {
+                const glm::vec3 position(
+                    corner & 1 ? local_bounds.max.x : local_bounds.min.x,
+                    corner & 2 ? local_bounds.max.y : local_bounds.min.y,
+                    corner & 4 ? local_bounds.max.z : local_bounds.min.z);
+
+                const glm::vec4 clip = model_view_proj * glm::vec4(position, 1.0f);
+                if (clip.w <= min_clip_w)
+                {
+                    return {};
+                }
+
+                const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+                const glm::vec2 screen = (glm::vec2(ndc) * 0.5f + 0.5f) * viewport_size;
+
+                result.min = glm::min(result.min, screen);
+                result.max = glm::max(result.max, screen);
+                result.nearest_depth = std::min(result.nearest_depth, ndc.z * 0.5f + 0.5f);
+            }
+
+            result.valid = true;
+            return result;
+        }
+
+        //-------------------------------------------------------------------------
+        bool is_small_on_screen(const bounding_box& local_bounds, const glm::mat4& model_view_proj, const glm::vec2& viewport_size, f32 threshold_in_pixels)
+        {
+            if (glm::all(glm::equal(local_bounds.min, local_bounds.max)))
+            {
+                return false;
+            }
+
+            const projected_bounds projected = project_bounds(local_bounds, model_view_proj, viewport_size);
+            if (!projected.valid)
+            {
+                return false;
+            }
+
+            // The largest extent is used so long and thin items are kept
+            const glm::vec2 size = projected.size();
+            return std::max(size.x, size.y) < threshold_in_pixels;
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "geometry/geometry_bounding_box.h"
+
+#include "util/types.h"
+
+#include <glm/glm.hpp>
+
+namespace ppp
+{
+    namespace geometry
+    {
+        //-------------------------------------------------------------------------
+        // Screen space rectangle around a projected bounding box, in pixels with the origin at the bottom left.
+        // Depth is mapped to [0, 1], 1 being the far plane.
+        struct projected_bounds
+        {
+            glm::vec2 min = glm::vec2(0.0f);
+            glm::vec2 max = glm::vec2(0.0f);
+
+            f32 nearest_depth = 0.0f;
+
+            // false when the box reaches behind the camera, the rectangle is meaningless in that case
+            bool valid = false;
+
+            glm::vec2 size() const { return max - min; }
+        };
+
+        //-------------------------------------------------------------------------
+        projected_bounds project_bounds(const bounding_box& local_bounds, const glm::mat4& model_view_proj, const glm::vec2& viewport_size);
+
+        //-------------------------------------------------------------------------
+        // True when the largest screen extent of the box is below the threshold, in pixels.
+        // Bounds without any extent ( a single point ) have no meaningful size on screen and are never small.
+        bool is_small_on_screen(const bounding_box& local_bounds, const glm::mat4& model_view_proj, const glm::vec2& viewport_size, f32 threshold_in_pixels);
+    }
+}
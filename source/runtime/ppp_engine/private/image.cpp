@@ -2,11 +2,21 @@
 #include "material.h"
 
 #include "render/render.h"
+#include "render/render_readback.h"
+#include "render/helpers/render_event_dispatcher.h"
 
 #include "fileio/fileio.h"
 #include "fileio/vfs.h"
+#include "fileio/file_stamp.h"
+
+#include "device/device.h"
 
 #include "resources/texture_pool.h"
+#include "resources/texture_atlas.h"
+#include "resources/image_decoder.h"
+#include "resources/texture_compression.h"
+#include "resources/texture_cache.h"
+#include "resources/texture_residency.h"
 #include "resources/geometry_pool.h"
 #include "resources/material_pool.h"
 #include "resources/shader_pool.h"
@@ -17,8 +27,13 @@
 #include "geometry/2d/geometry_2d_helpers.h"
 
 #include "util/log.h"
+#include "util/async_loader.h"
 #include "util/transform_stack.h"
 #include "util/brush.h"
+#include "util/image_filter.h"
+#include "util/image_kernel.h"
+#include "util/sprite_frames.h"
+#include "util/frame_capture.h"
 
 #include <stb/stb_image_write.h>
 #include <stb/stb_image.h>
@@ -26,7 +41,9 @@
 #include <glad/glad.h>
 
 #include <unordered_map>
+#include <unordered_set>
 #include <algorithm>
+#include <memory>
 #include <assert.h>
 #include <sstream>
 
@@ -38,12 +55,130 @@ namespace ppp
     {
         auto _image_mode = image_mode_type::CENTER;
 
+        // Mips of compressed images stay sharper with a Kaiser filter than with a box filter
+        constexpr auto _compressed_mip_filter = texture_compression::mip_filter_type::KAISER;
+
+        //-------------------------------------------------------------------------
+        struct async_image
+        {
+            bool loaded = false;
+            image img = {};
+        };
+
+        // Requests of `load_async`, indexed by handle - 1
+        std::vector<async_image> _async_images;
+
+        // Pixels of asynchronous canvas reads without a callback, until they are polled
+        std::unordered_map<pixels_handle, std::vector<u8>> _polled_pixels;
+
+        // The canvas is handed to the frame capture at the end of every frame while this is set
+        bool _capture_canvas = false;
+        bool _capture_listener_registered = false;
+
+        //-------------------------------------------------------------------------
+        image to_image(const texture_pool::image* img)
+        {
+            return { (image_id)img->image_id, img->width, img->height, img->channels };
+        }
+
+        //-------------------------------------------------------------------------
+        // Creates the texture of a decoded image and hands the image to the texture pool
+        image upload_image(texture_pool::image& img)
+        {
+            img.texture_id = render::create_image_item(img.width, img.height, img.channels, img.data);
+            img.image_id = texture_pool::add_new_image(img);
+
+            texture_atlas::add_image(img);
+
+            return { (image_id)img.image_id, img.width, img.height, img.channels };
+        }
+
+        //-------------------------------------------------------------------------
+        render::image_compression_type to_render_compression(image_compression_type compression)
+        {
+            switch (compression)
+            {
+            case image_compression_type::BC1: return render::image_compression_type::BC1;
+            case image_compression_type::BC3: return render::image_compression_type::BC3;
+            case image_compression_type::BC5: return render::image_compression_type::BC5;
+            case image_compression_type::BC7: return render::image_compression_type::BC7;
+            }
+
+            assert(false);
+            return render::image_compression_type::BC7;
+        }
+
+        //-------------------------------------------------------------------------
+        image_filter::filter_type to_image_filter(filter_type type)
+        {
+            switch (type)
+            {
+            case filter_type::THRESHOLD: return image_filter::filter_type::THRESHOLD;
+            case filter_type::GRAY: return image_filter::filter_type::GRAY;
+            case filter_type::OPAQUE: return image_filter::filter_type::OPAQUE;
+            case filter_type::INVERT: return image_filter::filter_type::INVERT;
+            case filter_type::POSTERIZE: return image_filter::filter_type::POSTERIZE;
+            case filter_type::BLUR: return image_filter::filter_type::BLUR;
+            case filter_type::ERODE: return image_filter::filter_type::ERODE;
+            case filter_type::DILATE: return image_filter::filter_type::DILATE;
+            }
+
+            assert(false);
+            return image_filter::filter_type::INVERT;
+        }
+
+        //-------------------------------------------------------------------------
+        // Images with fewer than 4 channels keep red, 2 channel images keep red and alpha
+        void store_color(const color& c, s32 channels, u8* pixel)
+        {
+            const auto to_u8 = [](int value) { return static_cast<u8>(std::clamp(value, 0, 255)); };
+
+            switch (channels)
+            {
+            case 1: pixel[0] = to_u8(c.red); break;
+            case 2: pixel[0] = to_u8(c.red); pixel[1] = to_u8(c.alpha); break;
+            case 3: pixel[0] = to_u8(c.red); pixel[1] = to_u8(c.green); pixel[2] = to_u8(c.blue); break;
+            default: pixel[0] = to_u8(c.red); pixel[1] = to_u8(c.green); pixel[2] = to_u8(c.blue); pixel[3] = to_u8(c.alpha); break;
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        // Runs the kernel over the pixels of the image and uploads them once
+        void generate(image_id id, const image_kernel::row_kernel& kernel, u32 seed)
+        {
+            texture_residency::touch(id);
+
+            const texture_pool::image* img = texture_pool::image_at_id(id);
+            if (img == nullptr || img->data == nullptr)
+            {
+                return;
+            }
+
+            image_kernel::run(img->data, img->width, img->height, img->channels, kernel, seed);
+            texture_pool::mark_edited(id);
+
+            render::update_image_item(img->texture_id, 0, 0, img->width, img->height, img->channels, img->data);
+            texture_atlas::update_image(*img);
+        }
+
+        //-------------------------------------------------------------------------
+        s32 compressed_channels(image_compression_type compression)
+        {
+            switch (compression)
+            {
+            case image_compression_type::BC1: return 3;
+            case image_compression_type::BC5: return 2;
+            default: return 4;
+            }
+        }
+
         class image_item : public render::irender_item
         {
         public:
-            image_item(const geometry::geometry* geom, const resources::imaterial* material)
+            image_item(const geometry::geometry* geom, const resources::imaterial* material, const glm::vec4& uv_rect = render::full_uv_rect())
                 : m_geometry(geom)
                 , m_material(material)
+                , m_uv_rect(uv_rect)
             {}
 
             ~image_item() override = default;
@@ -102,9 +237,20 @@ namespace ppp
                 return m_material;
             }
 
+            const geometry::bounding_box* local_bounds() const override
+            {
+                return &m_geometry->aabb();
+            }
+
+            glm::vec4 uv_rect() const override
+            {
+                return m_uv_rect;
+            }
+
         private:
             const geometry::geometry* m_geometry;
             const resources::imaterial* m_material;
+            glm::vec4 m_uv_rect;
         };
 
         //-------------------------------------------------------------------------
@@ -114,24 +260,38 @@ namespace ppp
         }
 
         //-------------------------------------------------------------------------
-        geometry::geometry* make_image(u32 image_id)
+        // Images that live in an atlas page get a quad with the uvs of their area in the page
+        geometry::geometry* make_image(u32 image_id, const texture_atlas::atlas_entry* atlas_entry)
         {
             std::stringstream stream;
 
             stream << "image|";
             stream << image_id;
 
+            if (atlas_entry != nullptr)
+            {
+                stream << "|atlas|" << atlas_entry->page_index << "|" << atlas_entry->rect.x << "|" << atlas_entry->rect.y << "|" << atlas_entry->rect.width << "|" << atlas_entry->rect.height;
+            }
+
             const std::string gid = stream.str();
 
             if (!geometry_pool::has_geometry(gid))
             {
-                auto create_geom_fn = [](geometry::geometry* geom)
+                auto create_geom_fn = [atlas_entry](geometry::geometry* geom)
                 {
                     geometry::compute_quad_faces(geom);
 
                     geometry::compute_quad_vertex_positions(geom);
                     geometry::compute_quad_vertex_uvs(geom);
                     geometry::compute_quad_vertex_normals(geom);
+
+                    if (atlas_entry != nullptr)
+                    {
+                        for (glm::vec2& uv : geom->vertex_uvs())
+                        {
+                            uv = atlas_entry->uv_min + uv * (atlas_entry->uv_max - atlas_entry->uv_min);
+                        }
+                    }
                 };
 
                 return geometry_pool::add_new_geometry(geometry::geometry(gid, false, create_geom_fn));
@@ -139,6 +299,86 @@ namespace ppp
 
             return geometry_pool::get_geometry(gid);
         }
+
+        //-------------------------------------------------------------------------
+        // Draws the part of the image in `source` ( 0 to 1 ), every part of an image shares the quad of the image and only changes its uvs
+        void draw_image(u32 image_id, f32 x, f32 y, f32 width, f32 height, const glm::vec4& source)
+        {
+            auto prev_shader = render::active_shader();
+            auto curr_shader = render::unlit::tags::texture::batched();
+
+            shader(string::restore_sid(curr_shader));
+
+            // Small images are drawn from their atlas page so sprites share a texture slot
+            const texture_atlas::atlas_entry* atlas_entry = texture_atlas::find(static_cast<s32>(image_id));
+
+            reset_textures();
+            if (atlas_entry != nullptr)
+            {
+                // The page is not an image of the pool, only the image itself is kept resident
+                texture_residency::touch(static_cast<s32>(image_id));
+                material_pool::texture_cache::add_image(render::active_shader(), atlas_entry->page_texture_id);
+            }
+            else
+            {
+                texture(image_id);
+            }
+
+            geometry::geometry* image_geom = make_image(image_id, atlas_entry);
+            resources::imaterial* mat_unlit_tex = material_pool::get_or_create_material_instance(render::active_shader());
+
+            const glm::vec4 uv_rect = atlas_entry != nullptr
+                ? sprite_frames::uv_rect(atlas_entry->uv_min, atlas_entry->uv_max, source)
+                : sprite_frames::uv_rect(glm::vec2(0.0f), glm::vec2(1.0f), source);
+
+            image_item image_render_item = image_item(image_geom, mat_unlit_tex, uv_rect);
+
+            transform_stack::push();
+            transform_stack::translate(glm::vec2(x, y));
+
+            if (_image_mode == image_mode_type::CORNER)
+            {
+                glm::vec2 center = geometry::rectanglular_center_translation(x, y, width, height);
+
+                transform_stack::translate(glm::vec2(center.x, center.y));
+            }
+
+            transform_stack::scale(glm::vec2(width, height));
+
+            render::submit_render_item(render::topology_type::TRIANGLES, &image_render_item);
+
+            glm::mat4 world = transform_stack::active_world();
+
+            transform_stack::pop();
+
+            curr_shader = render::unlit::tags::color::batched();
+
+            shader(string::restore_sid(curr_shader));
+
+            resources::imaterial* mat_unlit_col = material_pool::get_or_create_material_instance(render::active_shader());
+
+            if (render::brush::stroke_enabled())
+            {
+                constexpr bool outer_stroke = true;
+
+                geometry::geometry* stroke_geom = extrude_image(world, image_geom, render::brush::stroke_width());
+                image_item stroke_item = image_item(stroke_geom, mat_unlit_col);
+
+                render::submit_stroke_render_item(render::topology_type::TRIANGLES, &stroke_item, outer_stroke);
+            }
+
+            if (render::brush::inner_stroke_enabled())
+            {
+                constexpr bool outer_stroke = false;
+
+                geometry::geometry* stroke_geom = extrude_image(world, image_geom, -render::brush::stroke_width());
+                image_item stroke_item = image_item(stroke_geom, mat_unlit_col);
+
+                render::submit_stroke_render_item(render::topology_type::TRIANGLES, &stroke_item, outer_stroke);
+            }
+
+            shader(string::restore_sid(prev_shader));
+        }
     }
 
     //-------------------------------------------------------------------------
@@ -157,16 +397,142 @@ namespace ppp
         return active_pixels;
     }
 
+    //-------------------------------------------------------------------------
+    pixels_handle load_pixels_async(int x, int y, int width, int height, pixels_callback callback)
+    {
+        return render::readback::request(x, y, width, height, std::move(callback));
+    }
+
+    //-------------------------------------------------------------------------
+    pixels_handle load_pixels_async(int x, int y, int width, int height)
+    {
+        // The callback runs frames after the request returned, the handle is known by then
+        auto handle = std::make_shared<pixels_handle>(0);
+
+        *handle = render::readback::request(x, y, width, height, [handle](const u8* pixels, s32 w, s32 h)
+        {
+            internal::_polled_pixels[*handle].assign(pixels, pixels + static_cast<u64>(w) * h * 4);
+        });
+
+        return *handle;
+    }
+
+    //-------------------------------------------------------------------------
+    bool poll_pixels(pixels_handle handle, std::vector<unsigned char>& pixels)
+    {
+        auto it = internal::_polled_pixels.find(handle);
+        if (it == internal::_polled_pixels.end())
+        {
+            return false;
+        }
+
+        pixels = std::move(it->second);
+        internal::_polled_pixels.erase(it);
+
+        return true;
+    }
+
     //-------------------------------------------------------------------------
     unsigned char* load_pixels(image_id id)
     {
+        texture_residency::touch(id);
+
         return texture_pool::load_active_pixels(id);
     }
 
+    //-------------------------------------------------------------------------
+    void mark_pixels_dirty(int x, int y, int w, int h)
+    {
+        texture_pool::mark_active_pixels_dirty(x, y, w, h);
+    }
+
     //-------------------------------------------------------------------------
     void update_pixels(image_id id)
     {
+        texture_residency::touch(id);
+
         texture_pool::update_active_pixels(id);
+
+        const texture_pool::image* img = texture_pool::image_at_id(id);
+        if (img != nullptr)
+        {
+            texture_atlas::update_image(*img);
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    void update_pixels(image_id id, int x, int y, int w, int h)
+    {
+        texture_residency::touch(id);
+
+        texture_pool::update_active_pixels(id, x, y, w, h);
+
+        const texture_pool::image* img = texture_pool::image_at_id(id);
+        if (img != nullptr)
+        {
+            texture_atlas::update_image(*img);
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    void filter(image_id id, filter_type type)
+    {
+        filter(id, type, image_filter::default_param(internal::to_image_filter(type)));
+    }
+
+    //-------------------------------------------------------------------------
+    void filter(image_id id, filter_type type, float param)
+    {
+        texture_residency::touch(id);
+
+        const texture_pool::image* img = texture_pool::image_at_id(id);
+        if (img == nullptr || img->data == nullptr)
+        {
+            return;
+        }
+
+        image_filter::apply(img->data, img->width, img->height, img->channels, internal::to_image_filter(type), param);
+        texture_pool::mark_edited(id);
+
+        render::update_image_item(img->texture_id, 0, 0, img->width, img->height, img->channels, img->data);
+        texture_atlas::update_image(*img);
+    }
+
+    //-------------------------------------------------------------------------
+    void filter(pixels_u8_ptr pixels, int w, int h, int c, filter_type type, float param)
+    {
+        image_filter::apply(pixels, w, h, c, internal::to_image_filter(type), param);
+    }
+
+    //-------------------------------------------------------------------------
+    void generate_pixels(image_id id, const pixel_kernel& kernel, unsigned int seed)
+    {
+        if (!kernel)
+        {
+            return;
+        }
+
+        const texture_pool::image* img = texture_pool::image_at_id(id);
+        const s32 channels = img != nullptr ? img->channels : 4;
+
+        internal::generate(id, [&kernel, channels](s32 x, s32 y, s32 count, u32 tile_seed, u8* pixels)
+        {
+            for (s32 i = 0; i < count; ++i)
+            {
+                internal::store_color(kernel(x + i, y, tile_seed), channels, pixels + i * channels);
+            }
+        }, seed);
+    }
+
+    //-------------------------------------------------------------------------
+    void generate_pixel_rows(image_id id, const pixel_row_kernel& kernel, unsigned int seed)
+    {
+        if (!kernel)
+        {
+            return;
+        }
+
+        internal::generate(id, kernel, seed);
     }
 
     //-------------------------------------------------------------------------
@@ -194,9 +560,16 @@ namespace ppp
     //-------------------------------------------------------------------------
     void save_pixels(std::string_view output_name, image_id id)
     {
+        texture_residency::touch(id);
+
         auto path = vfs::resolve_path(output_name);
 
         const texture_pool::image* img = texture_pool::image_at_id(id);
+        if (img == nullptr || img->data == nullptr)
+        {
+            log::warn("image {} has no pixels to write to path: {}", id, output_name);
+            return;
+        }
 
         if (stbi_write_png(path.c_str(), img->width, img->height, img->channels, img->data, img->width * img->channels) == 0)
         {
@@ -204,6 +577,85 @@ namespace ppp
         }
     }
 
+    //-------------------------------------------------------------------------
+    bool begin_capture(const capture_settings& settings)
+    {
+        frame_capture::capture_settings capture;
+
+        // The vfs is not thread safe, the encoders receive a resolved path
+        capture.path = vfs::resolve_path(settings.path);
+        capture.format = static_cast<frame_capture::capture_format>(settings.format);
+        capture.backpressure = static_cast<frame_capture::backpressure_type>(settings.backpressure);
+        capture.queue_size = settings.queue_size;
+        capture.encoder_count = settings.encoder_count;
+        capture.frame_rate = settings.frame_rate;
+
+        if (!frame_capture::begin(capture))
+        {
+            return false;
+        }
+
+        internal::_capture_canvas = settings.capture_canvas;
+
+        if (!internal::_capture_listener_registered)
+        {
+            internal::_capture_listener_registered = true;
+
+            render::register_on_draw_end([]()
+            {
+                if (!internal::_capture_canvas || !frame_capture::is_capturing())
+                {
+                    return;
+                }
+
+                s32 width = 0;
+                s32 height = 0;
+                device::framebuffer_size(&width, &height);
+
+                // Framebuffer rows are bottom-up, the encoders write top-down images
+                render::readback::request(0, 0, width, height, [](const u8* pixels, s32 w, s32 h)
+                {
+                    frame_capture::submit(pixels, w, h, true);
+                });
+            });
+        }
+
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    bool capture_frame(const unsigned char* pixels, int w, int h)
+    {
+        return frame_capture::submit(pixels, w, h);
+    }
+
+    //-------------------------------------------------------------------------
+    capture_statistics end_capture()
+    {
+        if (!frame_capture::is_capturing())
+        {
+            return {};
+        }
+
+        // The frames that are still on their way back from the GPU belong to the capture
+        if (internal::_capture_canvas)
+        {
+            render::readback::finish();
+        }
+
+        internal::_capture_canvas = false;
+
+        const frame_capture::capture_statistics statistics = frame_capture::end();
+
+        return { statistics.captured, statistics.dropped, statistics.written, statistics.failed };
+    }
+
+    //-------------------------------------------------------------------------
+    bool is_capturing()
+    {
+        return frame_capture::is_capturing();
+    }
+
     //-------------------------------------------------------------------------
     pixels_u8_ptr pixels_as_u8()
     {
@@ -224,122 +676,386 @@ namespace ppp
         // Find image first
         if (texture_pool::has_image(sid))
         {
-            const texture_pool::image* img = texture_pool::image_at_path(sid);
-            return { (image_id)img->image_id, img->width, img->height, img->channels };
+            return internal::to_image(texture_pool::image_at_path(sid));
         }
 
-        auto buffer = fileio::read_binary_file(file_path);
-
-        texture_pool::image img;
-        img.file_path = sid;
-        img.data = stbi_load_from_memory(
-            reinterpret_cast<pixels_u8_ptr>(buffer.data()),
-            static_cast<int>(buffer.size()),
-            &img.width,
-            &img.height,
-            &img.channels,
-            0);
-
+        texture_pool::image img = image_decoder::decode(vfs::resolve_path(file_path));
         if (img.data == nullptr)
         {
             log::error("Image {} could not be loaded!", file_path);
             return {};
         }
 
-        img.image_id = render::create_image_item(img.width, img.height, img.channels, img.data);
+        img.file_path = sid;
 
-        texture_pool::add_new_image(img);
+        return internal::upload_image(img);
+    }
 
-        return { (image_id)img.image_id, img.width, img.height, img.channels };
+    //-------------------------------------------------------------------------
+    std::vector<image> load_images(const std::vector<std::string_view>& file_paths)
+    {
+        std::vector<image> images(file_paths.size());
+
+        // Everything that touches the vfs or the pools happens on this thread, only decoding is spread over the workers
+        std::vector<string::string_id> sids(file_paths.size());
+        std::unordered_set<string::string_id> requested;
+        std::vector<std::string> decode_paths;
+        std::vector<u64> decode_indices;
+
+        for (u64 i = 0; i < file_paths.size(); ++i)
+        {
+            sids[i] = string::store_sid(file_paths[i]);
+
+            if (texture_pool::has_image(sids[i]) || !requested.insert(sids[i]).second)
+            {
+                continue;
+            }
+
+            decode_paths.push_back(vfs::resolve_path(file_paths[i]));
+            decode_indices.push_back(i);
+        }
+
+        std::vector<texture_pool::image> decoded = image_decoder::decode_all(decode_paths);
+
+        // Textures are created in the order of the paths, ids do not depend on which decode finished first
+        for (u64 d = 0; d < decoded.size(); ++d)
+        {
+            const u64 i = decode_indices[d];
+
+            if (decoded[d].data == nullptr)
+            {
+                log::error("Image {} could not be loaded!", file_paths[i]);
+                continue;
+            }
+
+            decoded[d].file_path = sids[i];
+
+            images[i] = internal::upload_image(decoded[d]);
+        }
+
+        // Images that were already loaded, or requested more than once
+        for (u64 i = 0; i < file_paths.size(); ++i)
+        {
+            const texture_pool::image* img = texture_pool::image_at_path(sids[i]);
+            if (img != nullptr)
+            {
+                images[i] = internal::to_image(img);
+            }
+        }
+
+        return images;
     }
 
     //-------------------------------------------------------------------------
-    image create(float width, float height, int channels, pixels_u8_ptr data)
+    image load_compressed(std::string_view file_path, image_compression_type compression)
     {
-        texture_pool::image img;
+        auto sid = string::store_sid(file_path);
 
-        img.width = width;
-        img.height = height;
-        img.channels = channels;
+        // Find image first
+        if (texture_pool::has_image(sid))
+        {
+            return internal::to_image(texture_pool::image_at_path(sid));
+        }
 
-        img.data = (u8*)malloc(width * height * channels);
-        memset(img.data, 0, width * height * channels);
+        const render::image_compression_type render_compression = internal::to_render_compression(compression);
 
-        if (data != nullptr)
+        const std::string source_path = vfs::resolve_path(file_path);
+        const std::string cache_path = texture_cache::cache_path(source_path, render_compression);
+
+        const fileio::file_stamp stamp = fileio::read_file_stamp(source_path);
+
+        auto hash_source = [&source_path]()
         {
-            //assert(width * height * channels == std::strlen((const char*)data));
+            return fileio::hash_resolved_file(source_path);
+        };
+
+        texture_compression::compressed_texture compressed;
+        u64 source_hash = 0;
+
+        if (!stamp.valid() || !texture_cache::read(cache_path, render_compression, internal::_compressed_mip_filter, stamp, hash_source, &compressed, &source_hash))
+        {
+            texture_pool::image decoded = image_decoder::decode(source_path);
+            if (decoded.data == nullptr)
+            {
+                log::error("Image {} could not be loaded!", file_path);
+                return {};
+            }
 
-            memcpy(img.data, data, width * height * channels);
+            const texture_compression::rgba_image rgba = texture_compression::to_rgba(decoded.data, decoded.width, decoded.height, decoded.channels);
+
+            free(decoded.data);
+
+            compressed = texture_compression::compress(rgba, render_compression, internal::_compressed_mip_filter);
+            source_hash = decoded.content_hash;
+
+            texture_cache::write(cache_path, compressed, internal::_compressed_mip_filter, stamp, source_hash);
+        }
+
+        std::vector<render::compressed_image_level> levels(compressed.levels.size());
+        for (u64 i = 0; i < levels.size(); ++i)
+        {
+            levels[i].width = std::max(1, compressed.width >> i);
+            levels[i].height = std::max(1, compressed.height >> i);
+            levels[i].data = compressed.levels[i].data();
+            levels[i].size = compressed.levels[i].size();
         }
 
-        img.image_id = render::create_image_item(img.width, img.height, img.channels, data);
+        texture_pool::image img;
 
-        texture_pool::add_new_image(img);
+        img.file_path = sid;
+        img.width = compressed.width;
+        img.height = compressed.height;
+        img.channels = internal::compressed_channels(compression);
+        img.stamp = stamp;
+        img.content_hash = source_hash;
+        for (const render::compressed_image_level& level : levels)
+        {
+            img.gpu_bytes += level.size;
+        }
+        img.texture_id = render::create_compressed_image_item(render_compression, levels, render::image_filter_type::NEAREST, render::image_wrap_type::REPEAT);
+        img.image_id = texture_pool::add_new_image(img);
 
-        return { (image_id)img.image_id, img.width, img.height, img.channels };
+        return internal::to_image(&img);
     }
 
     //-------------------------------------------------------------------------
-    void draw(image_id image_id, float x, float y, float width, float height)
+    image_handle load_async(std::string_view file_path)
     {
-        auto prev_shader = render::active_shader();
-        auto curr_shader = render::unlit::tags::texture::batched();
+        const image_handle handle = static_cast<image_handle>(internal::_async_images.size() + 1);
+
+        internal::async_image& request = internal::_async_images.emplace_back();
 
-        shader(string::restore_sid(curr_shader));
+        auto sid = string::store_sid(file_path);
+
+        if (texture_pool::has_image(sid))
+        {
+            request.loaded = true;
+            request.img = internal::to_image(texture_pool::image_at_path(sid));
+
+            return handle;
+        }
 
-        reset_textures();
-        texture(image_id);
+        // Resolved on the main thread, the vfs is not safe to use from the workers
+        auto decoded = std::make_shared<texture_pool::image>();
 
-        geometry::geometry* image_geom = internal::make_image(image_id);
-        resources::imaterial* mat_unlit_tex = material_pool::get_or_create_material_instance(render::active_shader());
+        async_loader::submit(
+            [decoded, path = vfs::resolve_path(file_path)]()
+            {
+                *decoded = image_decoder::decode(path);
+            },
+            [decoded, sid, handle]()
+            {
+                internal::async_image& request = internal::_async_images[handle - 1];
+
+                request.loaded = true;
 
-        internal::image_item image_render_item = internal::image_item(image_geom, mat_unlit_tex);
+                if (texture_pool::has_image(sid))
+                {
+                    // Loaded by another request in the meantime
+                    free(decoded->data);
 
-        transform_stack::push();
-        transform_stack::translate(glm::vec2(x, y));
+                    request.img = internal::to_image(texture_pool::image_at_path(sid));
+                    return;
+                }
 
-        if (internal::_image_mode == image_mode_type::CORNER)
+                if (decoded->data == nullptr)
+                {
+                    log::error("Image {} could not be loaded!", string::restore_sid(sid));
+
+                    request.img = internal::to_image(texture_pool::image_solid_white());
+                    return;
+                }
+
+                decoded->file_path = sid;
+
+                request.img = internal::upload_image(*decoded);
+            });
+
+        return handle;
+    }
+
+    //-------------------------------------------------------------------------
+    bool is_image_loaded(image_handle handle)
+    {
+        return handle > 0 && handle <= internal::_async_images.size() && internal::_async_images[handle - 1].loaded;
+    }
+
+    //-------------------------------------------------------------------------
+    image get_image(image_handle handle)
+    {
+        if (is_image_loaded(handle))
         {
-            glm::vec2 center = geometry::rectanglular_center_translation(x, y, width, height);
+            return internal::_async_images[handle - 1].img;
+        }
+
+        // Drawn in place of the image until it is loaded
+        return internal::to_image(texture_pool::image_solid_white());
+    }
+
+    //-------------------------------------------------------------------------
+    void unload_image(image_id id)
+    {
+        if (!texture_pool::has_image(static_cast<s32>(id)))
+        {
+            log::warn("Trying to unload unknown image: {}", id);
+            return;
+        }
 
-            transform_stack::translate(glm::vec2(center.x, center.y));
+        if (static_cast<s32>(id) == texture_pool::image_solid_white()->image_id || static_cast<s32>(id) == texture_pool::image_solid_black()->image_id)
+        {
+            log::warn("Default images cannot be unloaded");
+            return;
         }
 
-        transform_stack::scale(glm::vec2(width, height));
+        const u32 texture_id = texture_pool::image_at_id(static_cast<s32>(id))->texture_id;
+
+        texture_atlas::remove_image(static_cast<s32>(id));
+        texture_pool::remove_image(static_cast<s32>(id));
+
+        render::delete_image_item(texture_id);
+    }
+
+    //-------------------------------------------------------------------------
+    void texture_memory_budget(unsigned long long cpu_bytes, unsigned long long gpu_bytes)
+    {
+        texture_residency::set_budget({ cpu_bytes, gpu_bytes });
+    }
+
+    //-------------------------------------------------------------------------
+    texture_memory_statistics texture_memory()
+    {
+        const texture_residency::residency_statistics stats = texture_residency::statistics();
+
+        return { stats.cpu_bytes, stats.gpu_bytes, stats.budget.cpu_bytes, stats.budget.gpu_bytes, stats.resident, stats.evicted, stats.evictions, stats.reloads };
+    }
+
+    //-------------------------------------------------------------------------
+    image_atlas_region atlas_region(image_id id)
+    {
+        const texture_atlas::atlas_entry* entry = texture_atlas::find(static_cast<s32>(id));
+        if (entry == nullptr)
+        {
+            return { false, 0, 0, 0, 0, 0 };
+        }
+
+        return { true, static_cast<atlas_page_handle>(entry->page_index), entry->rect.x, entry->rect.y, entry->rect.width, entry->rect.height };
+    }
+
+    //-------------------------------------------------------------------------
+    image create(float width, float height, int channels, pixels_u8_ptr data)
+    {
+        texture_pool::image img;
+
+        img.width = width;
+        img.height = height;
+        img.channels = channels;
+
+        const u64 size = static_cast<u64>(img.width) * img.height * img.channels;
 
-        render::submit_render_item(render::topology_type::TRIANGLES, &image_render_item);
+        // The copy is needed here, the caller keeps ownership of `data`
+        if (data != nullptr)
+        {
+            img.data = (u8*)malloc(size);
+            memcpy(img.data, data, size);
+        }
+        else
+        {
+            img.data = (u8*)calloc(size, 1);
+        }
 
-        glm::mat4 world = transform_stack::active_world();
+        return internal::upload_image(img);
+    }
 
-        transform_stack::pop();
+    //-------------------------------------------------------------------------
+    image create(float width, float height, int channels, pixels_u8_ptr data, pixels_deleter deleter)
+    {
+        if (data == nullptr)
+        {
+            log::warn("Trying to create an image without pixels to adopt");
+            return create(width, height, channels, nullptr);
+        }
 
-        curr_shader = render::unlit::tags::color::batched();
+        texture_pool::image img;
 
-        shader(string::restore_sid(curr_shader));
+        img.width = width;
+        img.height = height;
+        img.channels = channels;
+        img.data = data;
+        img.ownership = texture_pool::pixel_ownership::ADOPTED;
+        img.deleter = std::move(deleter);
 
-        resources::imaterial* mat_unlit_col = material_pool::get_or_create_material_instance(render::active_shader());
+        return internal::upload_image(img);
+    }
 
-        if (render::brush::stroke_enabled())
+    //-------------------------------------------------------------------------
+    image create_borrowed(float width, float height, int channels, pixels_u8_ptr data)
+    {
+        if (data == nullptr)
         {
-            constexpr bool outer_stroke = true;
+            log::warn("Trying to create an image without pixels to borrow");
+            return create(width, height, channels, nullptr);
+        }
+
+        texture_pool::image img;
 
-            geometry::geometry* stroke_geom = internal::extrude_image(world, image_geom, render::brush::stroke_width());
-            internal::image_item stroke_item = internal::image_item(stroke_geom, mat_unlit_col);
+        img.width = width;
+        img.height = height;
+        img.channels = channels;
+        img.data = data;
+        img.ownership = texture_pool::pixel_ownership::BORROWED;
 
-            render::submit_stroke_render_item(render::topology_type::TRIANGLES, &stroke_item, outer_stroke);
+        return internal::upload_image(img);
+    }
+
+    //-------------------------------------------------------------------------
+    void draw(image_id image_id, float x, float y, float width, float height)
+    {
+        internal::draw_image(image_id, x, y, width, height, render::full_uv_rect());
+    }
+
+    //-------------------------------------------------------------------------
+    void draw(image_id image_id, float x, float y, float width, float height, float sx, float sy, float sw, float sh)
+    {
+        const texture_pool::image* img = texture_pool::image_at_id(image_id);
+        if (img == nullptr)
+        {
+            return;
         }
 
-        if (render::brush::inner_stroke_enabled())
+        internal::draw_image(image_id, x, y, width, height, sprite_frames::source_rect(img->width, img->height, sx, sy, sw, sh));
+    }
+
+    //-------------------------------------------------------------------------
+    sprite_sheet create_sprite_sheet(image_id id, int frame_width, int frame_height, int frame_count)
+    {
+        const texture_pool::image* img = texture_pool::image_at_id(id);
+        if (img == nullptr)
         {
-            constexpr bool outer_stroke = false;
+            log::warn("sprite sheet requested for an unknown image: {}", id);
+            return { id, frame_width, frame_height, 0 };
+        }
+
+        const s32 available = sprite_frames::frame_count(img->width, img->height, frame_width, frame_height);
+
+        return { id, frame_width, frame_height, frame_count > 0 ? std::min(frame_count, available) : available };
+    }
 
-            geometry::geometry* stroke_geom = internal::extrude_image(world, image_geom, -render::brush::stroke_width());
-            internal::image_item stroke_item = internal::image_item(stroke_geom, mat_unlit_col);
+    //-------------------------------------------------------------------------
+    void draw_sprite(const sprite_sheet& sheet, int frame, float x, float y, float width, float height)
+    {
+        const texture_pool::image* img = texture_pool::image_at_id(sheet.image);
+        if (img == nullptr)
+        {
+            return;
+        }
 
-            render::submit_stroke_render_item(render::topology_type::TRIANGLES, &stroke_item, outer_stroke);
+        const sprite_frames::frame_rect rect = sprite_frames::frame(img->width, sheet.frame_width, sheet.frame_height, sheet.frame_count, frame);
+        if (rect.width == 0)
+        {
+            return;
         }
 
-        shader(string::restore_sid(prev_shader));
+        internal::draw_image(sheet.image, x, y, width, height, sprite_frames::source_rect(img->width, img->height, rect.x, rect.y, rect.width, rect.height));
     }
 
     //-------------------------------------------------------------------------
@@ -5,6 +5,8 @@
 #include "render/render.h"
 #include "resources/shader_pool.h"
 #include "resources/material_pool.h"
+#include "resources/texture_pool.h"
+#include "resources/texture_residency.h"
 #include "util/log.h"
 
 #include "string/string_id.h"
@@ -203,7 +205,16 @@ namespace ppp
     {
         assert(!g_ctx.active_shader_tag.is_none());
 
-        material_pool::texture_cache::add_image(g_ctx.active_shader_tag, image_id);
+        // An evicted texture is loaded again before it is drawn
+        texture_residency::touch(static_cast<s32>(image_id));
+
+        const texture_pool::image* img = texture_pool::image_at_id(static_cast<s32>(image_id));
+        if (img == nullptr)
+        {
+            return;
+        }
+
+        material_pool::texture_cache::add_image(g_ctx.active_shader_tag, img->texture_id);
     }
 
     //-------------------------------------------------------------------------
@@ -2,14 +2,17 @@
 #include "material.h"
 
 #include "model/parse_obj.h"
+#include "model/mesh_cache.h"
 
 #include "fileio/fileio.h"
+#include "fileio/vfs.h"
 
 #include "render/render.h"
 #include "render/render_item.h"
 #include "render/render_features.h"
 
 #include "geometry/geometry.h"
+#include "geometry/3d/box.h"
 
 #include "resources/geometry_pool.h"
 #include "resources/material_pool.h"
@@ -17,8 +20,13 @@
 #include "string/string_conversions.h"
 
 #include "util/log.h"
+#include "util/async_loader.h"
 
+#include <filesystem>
+#include <memory>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace ppp
 {
@@ -40,6 +48,216 @@ namespace ppp
         }
     }
 
+    namespace internal
+    {
+        //-------------------------------------------------------------------------
+        std::string make_geometry_id(model_file_type file_type)
+        {
+            static int s_model_counter = 0;
+
+            std::stringstream stream;
+
+            stream << conversions::to_string(file_type);
+            stream << "|";
+            stream << string::to_string<std::string>(s_model_counter++);
+
+            return stream.str();
+        }
+
+        //-------------------------------------------------------------------------
+        // Files larger than this are never read as a whole, they are hashed and parsed one chunk at a time
+        constexpr u64 stream_size_threshold = 256ull * 1024 * 1024;
+        constexpr u64 stream_chunk_size = 4ull * 1024 * 1024;
+
+        //-------------------------------------------------------------------------
+        // Parses an OBJ file from disk, the cooked mesh next to the file is used instead when it is up to date.
+        // Returns true when the cooked mesh is up to date afterwards, `source_hash` receives the content hash of the source.
+        // The path has to be resolved already, the vfs is not used so this can run on a worker thread.
+        bool load_obj(geometry::geometry* geom, const std::string& source_path, bool force_cook, u64* source_hash)
+        {
+            const std::string cache_path = mesh_cache::cache_path(source_path);
+
+            const fileio::file_stamp stamp = fileio::read_file_stamp(source_path);
+
+            const bool stream = stamp.size > stream_size_threshold;
+
+            // The source is only read when the cache is stale, or when its write time changed and the content hash has to be compared
+            std::string source;
+            auto read_source = [&source, &source_path]() -> const std::string&
+            {
+                if (source.empty())
+                {
+                    source = fileio::read_resolved_text_file(source_path);
+                }
+
+                return source;
+            };
+
+            auto hash_source = [&read_source, &source_path, stream]()
+            {
+                if (stream)
+                {
+                    return fileio::hash_resolved_file(source_path);
+                }
+
+                const std::string& buffer = read_source();
+
+                return fileio::content_hash(buffer.data(), buffer.size());
+            };
+
+            if (!force_cook && stamp.valid() && mesh_cache::read(cache_path, stamp, hash_source, geom, source_hash))
+            {
+                return true;
+            }
+
+            u64 hash = 0;
+
+            if (stream)
+            {
+                fileio::content_hasher hasher;
+                obj_stream_parser parser(geom);
+
+                fileio::read_resolved_file_chunked(source_path, stream_chunk_size, [&hasher, &parser](std::string_view chunk)
+                {
+                    hasher.update(chunk.data(), chunk.size());
+                    parser.append(chunk);
+                });
+
+                parser.finish();
+
+                hash = hasher.finish();
+            }
+            else
+            {
+                const std::string& buffer = read_source();
+
+                assert(!buffer.empty() && "Was unable to load buffer for model");
+
+                parse_obj(geom, buffer);
+
+                hash = fileio::content_hash(buffer.data(), buffer.size());
+            }
+
+            if (source_hash != nullptr)
+            {
+                *source_hash = hash;
+            }
+
+            return stamp.valid() && mesh_cache::write(cache_path, *geom, stamp, hash);
+        }
+
+        //-------------------------------------------------------------------------
+        // Loaded models are shared, repeated loads of the same file ( or string ) hand out the same model
+        struct shared_model
+        {
+            std::string key;
+
+            fileio::file_stamp stamp;
+            u64 content_hash = 0;
+
+            u32 ref_count = 0;
+        };
+
+        //-------------------------------------------------------------------------
+        struct async_model
+        {
+            bool loaded = false;
+            bool failed = false;
+            model_id id = 0;
+        };
+
+        //-------------------------------------------------------------------------
+        struct context
+        {
+            // Normalized path ( or content hash for in-memory models ) to the latest model loaded from it
+            std::unordered_map<std::string, model_id> model_ids;
+
+            std::unordered_map<model_id, shared_model> models;
+
+            // Requests of `load_model_async`, indexed by handle - 1
+            std::vector<async_model> async_models;
+            // Files that are loading on a worker thread, with the handles waiting for them
+            std::unordered_map<std::string, std::vector<model_handle>> in_flight_models;
+
+            // Models that were used after they were unloaded, only the first use is reported
+            std::unordered_set<model_id> reported_missing_models;
+        } g_ctx;
+
+        //-------------------------------------------------------------------------
+        std::string normalize_path(std::string_view path)
+        {
+            return std::filesystem::path(path).lexically_normal().generic_string();
+        }
+
+        //-------------------------------------------------------------------------
+        mesh_cache::hash_source_fn make_hash_source_fn(const std::string& source_path)
+        {
+            return [source_path]()
+            {
+                return fileio::hash_resolved_file(source_path);
+            };
+        }
+
+        //-------------------------------------------------------------------------
+        // Returns the model that was previously loaded for the key when its source is unchanged, 0 otherwise
+        model_id acquire_shared_model(const std::string& key, const fileio::file_stamp& stamp, const mesh_cache::hash_source_fn& hash_fn)
+        {
+            auto it = g_ctx.model_ids.find(key);
+            if (it == std::cend(g_ctx.model_ids))
+            {
+                return 0;
+            }
+
+            shared_model& model = g_ctx.models.at(it->second);
+
+            if (model.stamp.size != stamp.size)
+            {
+                return 0;
+            }
+
+            if (model.stamp.write_time != stamp.write_time)
+            {
+                // Touched but possibly unchanged, compare the contents
+                if (hash_fn() != model.content_hash)
+                {
+                    return 0;
+                }
+
+                model.stamp = stamp;
+            }
+
+            ++model.ref_count;
+
+            return it->second;
+        }
+
+        //-------------------------------------------------------------------------
+        void register_shared_model(model_id id, const std::string& key, const fileio::file_stamp& stamp, u64 content_hash)
+        {
+            // A changed source replaces the previous model for this key, that model stays alive until it is unloaded
+            g_ctx.model_ids[key] = id;
+
+            g_ctx.models[id] = { key, stamp, content_hash, 1 };
+        }
+
+        //-------------------------------------------------------------------------
+        // Sketches keep drawing a model after unloading it every frame, that is reported once instead of every frame
+        geometry::geometry* find_model_geometry(model_id id)
+        {
+            if (geometry_pool::has_geometry(id))
+            {
+                return geometry_pool::get_geometry(id);
+            }
+
+            if (g_ctx.reported_missing_models.insert(id).second)
+            {
+                log::warn("Trying to use unknown or unloaded model: {}", id);
+            }
+
+            return nullptr;
+        }
+    }
+
     //-------------------------------------------------------------------------
     class model : public render::irender_item
     {
@@ -47,6 +265,15 @@ namespace ppp
         model(const geometry::geometry* geom, const resources::imaterial* material, bool cast_shadows)
             : m_geometry(geom)
             , m_material(material)
+            , m_first_index(0)
+            , m_index_count(static_cast<u32>(geom->index_count()))
+            , m_cast_shadows(cast_shadows)
+        {}
+        model(const geometry::geometry* geom, const geometry::submesh& submesh, const resources::imaterial* material, bool cast_shadows)
+            : m_geometry(geom)
+            , m_material(material)
+            , m_first_index(static_cast<u32>(submesh.first_index))
+            , m_index_count(static_cast<u32>(submesh.index_count))
             , m_cast_shadows(cast_shadows)
         {}
 
@@ -69,7 +296,11 @@ namespace ppp
         }
         u32 index_count() const override
         {
-            return m_geometry->index_count();
+            return m_index_count;
+        }
+        u32 first_index() const override
+        {
+            return m_first_index;
         }
 
         const std::vector<glm::vec3>& vertex_positions() const override
@@ -104,10 +335,25 @@ namespace ppp
             return m_material;
         }
 
+        const geometry::bounding_box* local_bounds() const override
+        {
+            return &m_geometry->aabb();
+        }
+
+        render::dirty_vertex_range dirty_vertices() const override
+        {
+            const geometry::vertex_range& range = m_geometry->dirty_range();
+
+            return { m_geometry->revision(), m_geometry->base_revision(), static_cast<u32>(range.first), static_cast<u32>(range.count) };
+        }
+
     private:
         const geometry::geometry* m_geometry;
         const resources::imaterial* m_material;
 
+        u32 m_first_index;
+        u32 m_index_count;
+
         bool m_cast_shadows;
     };
 
@@ -116,78 +362,359 @@ namespace ppp
     {
         return model(geom, material_pool::get_or_create_material_instance(render::active_shader()), render::shadows_enabled());
     }
+    //-------------------------------------------------------------------------
+    model create_model(const geometry::geometry* geom, const geometry::submesh& submesh)
+    {
+        return model(geom, submesh, material_pool::get_or_create_material_instance(render::active_shader()), render::shadows_enabled());
+    }
 
     //-------------------------------------------------------------------------
     model_id load_model(std::string_view model_path)
     {
-        auto buffer = fileio::read_text_file(model_path);
+        const std::string source_path = internal::normalize_path(vfs::resolve_path(model_path));
+        const fileio::file_stamp stamp = fileio::read_file_stamp(source_path);
+
+        const model_id shared_id = internal::acquire_shared_model(source_path, stamp, internal::make_hash_source_fn(source_path));
+        if (shared_id != 0)
+        {
+            return shared_id;
+        }
+
+        const std::string gid = internal::make_geometry_id(model_file_type::OBJ);
 
-        assert(!buffer.empty() && "Was unable to load buffer for model");
+        u64 content_hash = 0;
+
+        geometry::geometry* geom = geometry_pool::add_new_geometry(geometry::geometry(gid, false, [&source_path, &content_hash](geometry::geometry* self)
+        {
+            internal::load_obj(self, source_path, false, &content_hash);
+        }));
 
-        return create_model(buffer, model_file_type::OBJ);
+        internal::register_shared_model(geom->id(), source_path, stamp, content_hash);
+
+        return geom->id();
     }
 
     //-------------------------------------------------------------------------
-    model_id create_model(std::string_view model_string, model_file_type file_type)
+    model_handle load_model_async(std::string_view model_path)
     {
-        static int s_model_counter = 0;
+        const model_handle handle = static_cast<model_handle>(internal::g_ctx.async_models.size() + 1);
 
-        std::stringstream stream;
+        internal::async_model& request = internal::g_ctx.async_models.emplace_back();
 
-        stream << conversions::to_string(file_type);
-        stream << "|";
-        stream << string::to_string<std::string>(s_model_counter++);
+        // Everything that touches the vfs or the pools happens here, on the main thread
+        std::string source_path = internal::normalize_path(vfs::resolve_path(model_path));
+        const fileio::file_stamp stamp = fileio::read_file_stamp(source_path);
 
-        const std::string gid = stream.str();
+        const model_id shared_id = internal::acquire_shared_model(source_path, stamp, internal::make_hash_source_fn(source_path));
+        if (shared_id != 0)
+        {
+            request.loaded = true;
+            request.id = shared_id;
 
-        if (!geometry_pool::has_geometry(gid))
+            return handle;
+        }
+
+        // Another request for the same file is still in flight, complete together with that one
+        auto in_flight = internal::g_ctx.in_flight_models.find(source_path);
+        if (in_flight != std::cend(internal::g_ctx.in_flight_models))
         {
-            std::function<void(geometry::geometry* self)> create_geom_fn = nullptr;
+            in_flight->second.push_back(handle);
 
-            switch (file_type)
+            return handle;
+        }
+
+        internal::g_ctx.in_flight_models[source_path].push_back(handle);
+
+        struct loaded_geometry
+        {
+            std::unique_ptr<geometry::geometry> geom;
+            u64 content_hash = 0;
+        };
+
+        auto result = std::make_shared<loaded_geometry>();
+        auto gid = internal::make_geometry_id(model_file_type::OBJ);
+
+        async_loader::submit(
+            [result, gid, source_path, stamp]()
             {
-            case model_file_type::OBJ:
-                create_geom_fn = [model_string](geometry::geometry* self)
+                // A missing or unreadable file leaves the geometry empty, the completion reports the failure
+                if (!stamp.valid())
                 {
-                    std::vector<std::string_view> lines;
+                    return;
+                }
 
-                    size_t pos = 0, prev = 0;
-                    while ((pos = model_string.find('\n', prev)) != std::string::npos)
-                    {
-                        lines.emplace_back(model_string.substr(prev, pos - prev));
-                        prev = pos + 1;
-                    }
+                result->geom = std::make_unique<geometry::geometry>(gid, false, [&source_path, &result](geometry::geometry* self)
+                {
+                    internal::load_obj(self, source_path, false, &result->content_hash);
+                });
+            },
+            [result, source_path, stamp]()
+            {
+                auto waiting = internal::g_ctx.in_flight_models.find(source_path);
 
-                    if (prev < model_string.size())
+                if (result->geom == nullptr || result->geom->vertex_count() == 0)
+                {
+                    log::error("Unable to load model: {}", source_path);
+
+                    for (model_handle waiting_handle : waiting->second)
                     {
-                        lines.emplace_back(model_string.substr(prev));
+                        internal::g_ctx.async_models[waiting_handle - 1].failed = true;
                     }
 
-                    parse_obj(self, lines);
-                };
-                break;
-            default:
-                log::error("Trying to parse unknown type, exiting program");
-                exit(EXIT_FAILURE);
-            }
+                    // A later request for this file tries again
+                    internal::g_ctx.in_flight_models.erase(waiting);
+                    return;
+                }
+
+                geometry::geometry* geom = geometry_pool::add_new_geometry(std::move(*result->geom));
+
+                internal::register_shared_model(geom->id(), source_path, stamp, result->content_hash);
+
+                // Every request that waited on this file holds a reference
+                internal::g_ctx.models.at(geom->id()).ref_count = static_cast<u32>(waiting->second.size());
+
+                for (model_handle waiting_handle : waiting->second)
+                {
+                    internal::async_model& waiting_request = internal::g_ctx.async_models[waiting_handle - 1];
+
+                    waiting_request.loaded = true;
+                    waiting_request.id = geom->id();
+                }
 
-            geometry::geometry* geom = geometry_pool::add_new_geometry(geometry::geometry(stream.str(), false, create_geom_fn));
+                internal::g_ctx.in_flight_models.erase(waiting);
+            });
 
-            return geom->id();
+        return handle;
+    }
+
+    //-------------------------------------------------------------------------
+    bool is_model_loaded(model_handle handle)
+    {
+        return handle > 0 && handle <= internal::g_ctx.async_models.size() && internal::g_ctx.async_models[handle - 1].loaded;
+    }
+
+    //-------------------------------------------------------------------------
+    bool is_model_failed(model_handle handle)
+    {
+        return handle > 0 && handle <= internal::g_ctx.async_models.size() && internal::g_ctx.async_models[handle - 1].failed;
+    }
+
+    //-------------------------------------------------------------------------
+    model_id get_model(model_handle handle)
+    {
+        if (is_model_loaded(handle))
+        {
+            return internal::g_ctx.async_models[handle - 1].id;
         }
-        else
+
+        // Drawn in place of the model until it is loaded
+        return geometry::make_box(false)->id();
+    }
+
+    //-------------------------------------------------------------------------
+    bool cook_model(std::string_view model_path)
+    {
+        const std::string source_path = internal::normalize_path(vfs::resolve_path(model_path));
+
+        bool cooked = false;
+
+        geometry::geometry geom("cook", false, [&source_path, &cooked](geometry::geometry* self)
         {
-            geometry::geometry* geom = geometry_pool::get_geometry(stream.str());
+            cooked = internal::load_obj(self, source_path, true, nullptr);
+        });
+
+        return cooked;
+    }
+
+    //-------------------------------------------------------------------------
+    model_id create_model(std::string_view model_string, model_file_type file_type)
+    {
+        // In-memory models are shared by contents, the key already contains the content hash
+        const u64 content_hash = fileio::content_hash(model_string.data(), model_string.size());
+        const fileio::file_stamp stamp = { model_string.size(), 0 };
 
-            return geom->id();
+        std::stringstream key_stream;
+
+        key_stream << conversions::to_string(file_type);
+        key_stream << "#";
+        key_stream << std::hex << content_hash;
+
+        const std::string key = key_stream.str();
+
+        const model_id shared_id = internal::acquire_shared_model(key, stamp, [content_hash]() { return content_hash; });
+        if (shared_id != 0)
+        {
+            return shared_id;
+        }
+
+        std::function<void(geometry::geometry* self)> create_geom_fn = nullptr;
+
+        switch (file_type)
+        {
+        case model_file_type::OBJ:
+            create_geom_fn = [model_string](geometry::geometry* self)
+            {
+                parse_obj(self, model_string);
+            };
+            break;
+        default:
+            log::error("Trying to parse unknown type, exiting program");
+            exit(EXIT_FAILURE);
         }
+
+        geometry::geometry* geom = geometry_pool::add_new_geometry(geometry::geometry(internal::make_geometry_id(file_type), false, create_geom_fn));
+
+        internal::register_shared_model(geom->id(), key, stamp, content_hash);
+
+        return geom->id();
+    }
+
+    //-------------------------------------------------------------------------
+    void unload_model(model_id model_id)
+    {
+        auto it = internal::g_ctx.models.find(model_id);
+        if (it == std::cend(internal::g_ctx.models))
+        {
+            log::warn("Trying to unload unknown model: {}", model_id);
+            return;
+        }
+
+        if (--it->second.ref_count > 0)
+        {
+            return;
+        }
+
+        auto key_it = internal::g_ctx.model_ids.find(it->second.key);
+        if (key_it != std::cend(internal::g_ctx.model_ids) && key_it->second == model_id)
+        {
+            internal::g_ctx.model_ids.erase(key_it);
+        }
+
+        internal::g_ctx.models.erase(it);
+
+        geometry_pool::remove_geometry(model_id);
+    }
+
+    //-------------------------------------------------------------------------
+    model_vertices edit_model(model_id model_id)
+    {
+        geometry::geometry* geom = internal::find_model_geometry(model_id);
+        if (geom == nullptr)
+        {
+            return {};
+        }
+
+        model_vertices vertices;
+
+        vertices.vertex_count = geom->vertex_count();
+        vertices.positions = geom->vertex_positions().data();
+        vertices.normals = geom->vertex_normals().empty() ? nullptr : geom->vertex_normals().data();
+        vertices.uvs = geom->vertex_uvs().empty() ? nullptr : geom->vertex_uvs().data();
+
+        return vertices;
+    }
+
+    //-------------------------------------------------------------------------
+    void mark_model_dirty(model_id model_id)
+    {
+        if (internal::find_model_geometry(model_id) == nullptr)
+        {
+            return;
+        }
+
+        geometry_pool::mark_geometry_dirty(model_id);
+    }
+
+    //-------------------------------------------------------------------------
+    void mark_model_dirty(model_id model_id, std::size_t first_vertex, std::size_t vertex_count)
+    {
+        if (internal::find_model_geometry(model_id) == nullptr)
+        {
+            return;
+        }
+
+        geometry_pool::mark_geometry_dirty(model_id, first_vertex, vertex_count);
     }
 
     //-------------------------------------------------------------------------
     void draw(model_id model_id)
     {
-        model m = create_model(geometry_pool::get_geometry(model_id));
+        const geometry::geometry* geom = internal::find_model_geometry(model_id);
+        if (geom == nullptr)
+        {
+            return;
+        }
+
+        // The submeshes tile the index buffer in order and all of them use the active material,
+        //  so they are submitted as a single range that keeps the model in one batch/instance
+        model m = create_model(geom);
+
+        render::submit_render_item(render::topology_type::TRIANGLES, &m);
+    }
+
+    //-------------------------------------------------------------------------
+    std::size_t model_submesh_count(model_id model_id)
+    {
+        const geometry::geometry* geom = internal::find_model_geometry(model_id);
+        if (geom == nullptr)
+        {
+            return 0;
+        }
+
+        // Geometry that was not split is a single submesh
+        if (geom->submeshes().empty())
+        {
+            return geom->index_count() != 0 ? 1 : 0;
+        }
+
+        return geom->submeshes().size();
+    }
+
+    //-------------------------------------------------------------------------
+    model_submesh get_model_submesh(model_id model_id, std::size_t submesh)
+    {
+        const geometry::geometry* geom = internal::find_model_geometry(model_id);
+        if (geom == nullptr || submesh >= model_submesh_count(model_id))
+        {
+            return {};
+        }
+
+        if (geom->submeshes().empty())
+        {
+            return { {}, {}, 0, static_cast<std::size_t>(geom->index_count()) };
+        }
+
+        const geometry::submesh& range = geom->submeshes()[submesh];
+
+        return { range.material, range.group, static_cast<std::size_t>(range.first_index), static_cast<std::size_t>(range.index_count) };
+    }
+
+    //-------------------------------------------------------------------------
+    void draw_submesh(model_id model_id, std::size_t submesh)
+    {
+        const geometry::geometry* geom = internal::find_model_geometry(model_id);
+        if (geom == nullptr)
+        {
+            return;
+        }
+
+        if (geom->submeshes().empty())
+        {
+            if (submesh == 0)
+            {
+                draw(model_id);
+            }
+            return;
+        }
+
+        if (submesh >= geom->submeshes().size())
+        {
+            log::warn("Model {} has no submesh {}", model_id, submesh);
+            return;
+        }
+
+        model m = create_model(geom, geom->submeshes()[submesh]);
 
         render::submit_render_item(render::topology_type::TRIANGLES, &m);
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,344 @@
+#include "model/mesh_cache.h"
+
+#include "fileio/mapped_file.h"
+
+#include "geometry/geometry.h"
+
+#include "util/log.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+namespace ppp
+{
+    namespace mesh_cache
+    {
+        namespace internal
+        {
+            constexpr u32 magic = 0x484d5050; // "PPMH"
+            constexpr u32 version = 3;
+
+            constexpr u64 stream_alignment = 16;
+
+            //-------------------------------------------------------------------------
+            struct header
+            {
+                u32 magic = 0;
+                u32 version = 0;
+
+                u64 source_size = 0;
+                s64 source_write_time = 0;
+                u64 source_hash = 0;
+
+                u64 vertex_count = 0;
+                u64 face_count = 0;
+                u64 submesh_count = 0;
+                u64 names_size = 0;
+
+                f32 aabb_min[3] = {};
+                f32 aabb_max[3] = {};
+
+                // Byte offsets of the streams from the start of the file
+                u64 positions_offset = 0;
+                u64 normals_offset = 0;
+                u64 uvs_offset = 0;
+                u64 faces_offset = 0;
+                u64 submeshes_offset = 0;
+                u64 names_offset = 0;
+            };
+
+            //-------------------------------------------------------------------------
+            // Material and group names are stored back to back in the names stream
+            struct submesh_record
+            {
+                u64 first_index = 0;
+                u64 index_count = 0;
+
+                u64 material_offset = 0;
+                u64 material_size = 0;
+                u64 group_offset = 0;
+                u64 group_size = 0;
+            };
+
+            static_assert(std::is_trivially_copyable_v<header>, "mesh cache header is written as is");
+            static_assert(std::is_trivially_copyable_v<submesh_record>, "submeshes are written as is");
+            static_assert(std::is_trivially_copyable_v<render::face>, "faces are written as is");
+
+            //-------------------------------------------------------------------------
+            u64 align_up(u64 value)
+            {
+                return (value + stream_alignment - 1) & ~(stream_alignment - 1);
+            }
+
+            //-------------------------------------------------------------------------
+            // Every writer gets a temporary file of its own, concurrent cooks of the same mesh ( threads or processes ) never write to the same file.
+            // The last rename wins, which is fine as every writer produces the same cache.
+            std::string make_temp_path(std::string_view cache_path)
+            {
+                static std::atomic<u64> s_temp_counter = 0;
+
+                const u64 writer = std::hash<std::thread::id>{}(std::this_thread::get_id())
+                    ^ static_cast<u64>(std::chrono::steady_clock::now().time_since_epoch().count());
+
+                std::stringstream stream;
+
+                stream << cache_path << "." << std::hex << writer << "." << s_temp_counter++ << ".tmp";
+
+                return stream.str();
+            }
+
+            //-------------------------------------------------------------------------
+            // Checks if a stream of `count` elements lies within the file
+            bool stream_in_bounds(u64 offset, u64 count, u64 element_size, u64 file_size)
+            {
+                return offset % stream_alignment == 0 
+                    && offset <= file_size 
+                    && count <= (file_size - offset) / element_size;
+            }
+
+            //-------------------------------------------------------------------------
+            template<typename T>
+            void write_stream(std::ofstream& file, u64 offset, const std::vector<T>& stream)
+            {
+                file.seekp(static_cast<std::streamoff>(offset));
+                file.write(reinterpret_cast<const char*>(stream.data()), static_cast<std::streamsize>(stream.size() * sizeof(T)));
+            }
+
+            //-------------------------------------------------------------------------
+            template<typename T>
+            void write_stream(std::ofstream& file, u64 offset, const std::basic_string<T>& stream)
+            {
+                file.seekp(static_cast<std::streamoff>(offset));
+                file.write(reinterpret_cast<const char*>(stream.data()), static_cast<std::streamsize>(stream.size() * sizeof(T)));
+            }
+
+            //-------------------------------------------------------------------------
+            template<typename T>
+            void read_stream(const std::byte* data, u64 offset, u64 count, std::vector<T>& stream)
+            {
+                stream.resize(count);
+                std::memcpy(stream.data(), data + offset, count * sizeof(T));
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        std::string cache_path(std::string_view source_path)
+        {
+            return std::string(source_path) + ".ppmesh";
+        }
+
+        //-------------------------------------------------------------------------
+        bool write(std::string_view cache_path, const geometry::geometry& geom, const fileio::file_stamp& stamp, u64 source_hash)
+        {
+            const auto& positions = geom.vertex_positions();
+            const auto& normals = geom.vertex_normals();
+            const auto& uvs = geom.vertex_uvs();
+            const auto& faces = geom.faces();
+
+            std::vector<internal::submesh_record> submeshes;
+            std::string names;
+
+            submeshes.reserve(geom.submeshes().size());
+            for (const geometry::submesh& range : geom.submeshes())
+            {
+                internal::submesh_record& record = submeshes.emplace_back();
+
+                record.first_index = range.first_index;
+                record.index_count = range.index_count;
+                record.material_offset = names.size();
+                record.material_size = range.material.size();
+                names += range.material;
+                record.group_offset = names.size();
+                record.group_size = range.group.size();
+                names += range.group;
+            }
+
+            if (normals.size() != positions.size() || uvs.size() != positions.size())
+            {
+                log::warn("Unable to cook {}, every vertex requires a normal and a uv", cache_path);
+                return false;
+            }
+
+            internal::header header;
+            header.magic = internal::magic;
+            header.version = internal::version;
+            header.source_size = stamp.size;
+            header.source_write_time = stamp.write_time;
+            header.source_hash = source_hash;
+            header.vertex_count = positions.size();
+            header.face_count = faces.size();
+            header.submesh_count = submeshes.size();
+            header.names_size = names.size();
+            for (s32 axis = 0; axis < 3; ++axis)
+            {
+                header.aabb_min[axis] = geom.aabb().min[axis];
+                header.aabb_max[axis] = geom.aabb().max[axis];
+            }
+            header.positions_offset = internal::align_up(sizeof(internal::header));
+            header.normals_offset = internal::align_up(header.positions_offset + positions.size() * sizeof(glm::vec3));
+            header.uvs_offset = internal::align_up(header.normals_offset + normals.size() * sizeof(glm::vec3));
+            header.faces_offset = internal::align_up(header.uvs_offset + uvs.size() * sizeof(glm::vec2));
+            header.submeshes_offset = internal::align_up(header.faces_offset + faces.size() * sizeof(render::face));
+            header.names_offset = internal::align_up(header.submeshes_offset + submeshes.size() * sizeof(internal::submesh_record));
+
+            // Write to a temporary file first, a reader never observes a partially written cache
+            const std::string temp_path = internal::make_temp_path(cache_path);
+            {
+                std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+                if (!file.is_open())
+                {
+                    log::warn("Unable to open {} to write the mesh cache", temp_path);
+                    return false;
+                }
+
+                file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+                internal::write_stream(file, header.positions_offset, positions);
+                internal::write_stream(file, header.normals_offset, normals);
+                internal::write_stream(file, header.uvs_offset, uvs);
+                internal::write_stream(file, header.faces_offset, faces);
+                internal::write_stream(file, header.submeshes_offset, submeshes);
+                internal::write_stream(file, header.names_offset, names);
+
+                if (!file.good())
+                {
+                    log::warn("Failed to write the mesh cache {}", temp_path);
+
+                    file.close();
+                    std::filesystem::remove(temp_path);
+                    return false;
+                }
+            }
+
+            std::error_code error;
+            std::filesystem::rename(temp_path, std::filesystem::path(cache_path), error);
+            if (error)
+            {
+                log::warn("Failed to move the mesh cache into place at {}: {}", cache_path, error.message());
+
+                std::filesystem::remove(temp_path, error);
+                return false;
+            }
+
+            return true;
+        }
+
+        //-------------------------------------------------------------------------
+        bool read(std::string_view cache_path, const fileio::file_stamp& stamp, const hash_source_fn& hash_fn, geometry::geometry* geom, u64* source_hash)
+        {
+            internal::header header;
+            bool refresh_write_time = false;
+
+            {
+                fileio::mapped_file file;
+                if (!file.open(cache_path) || file.size() < sizeof(internal::header))
+                {
+                    return false;
+                }
+
+                std::memcpy(&header, file.data(), sizeof(header));
+
+                if (header.magic != internal::magic || header.version != internal::version)
+                {
+                    log::info("Mesh cache {} was cooked with a different version", cache_path);
+                    return false;
+                }
+
+                if (header.source_size != stamp.size)
+                {
+                    return false;
+                }
+
+                if (header.source_write_time != stamp.write_time)
+                {
+                    // Touched or copied, only stale when the contents changed
+                    if (!hash_fn || hash_fn() != header.source_hash)
+                    {
+                        return false;
+                    }
+
+                    refresh_write_time = true;
+                }
+
+                const bool in_bounds = 
+                    internal::stream_in_bounds(header.positions_offset, header.vertex_count, sizeof(glm::vec3), file.size()) &&
+                    internal::stream_in_bounds(header.normals_offset, header.vertex_count, sizeof(glm::vec3), file.size()) &&
+                    internal::stream_in_bounds(header.uvs_offset, header.vertex_count, sizeof(glm::vec2), file.size()) &&
+                    internal::stream_in_bounds(header.faces_offset, header.face_count, sizeof(render::face), file.size()) &&
+                    internal::stream_in_bounds(header.submeshes_offset, header.submesh_count, sizeof(internal::submesh_record), file.size()) &&
+                    internal::stream_in_bounds(header.names_offset, header.names_size, sizeof(char), file.size());
+
+                if (!in_bounds)
+                {
+                    log::warn("Mesh cache {} is corrupt", cache_path);
+                    return false;
+                }
+
+                std::vector<internal::submesh_record> submeshes;
+                internal::read_stream(file.data(), header.submeshes_offset, header.submesh_count, submeshes);
+
+                const u64 index_count = header.face_count * 3;
+
+                const bool valid_submeshes = std::all_of(submeshes.cbegin(), submeshes.cend(), [&header, index_count](const internal::submesh_record& record)
+                {
+                    return record.index_count <= index_count && record.first_index <= index_count - record.index_count
+                        && record.material_size <= header.names_size && record.material_offset <= header.names_size - record.material_size
+                        && record.group_size <= header.names_size && record.group_offset <= header.names_size - record.group_size;
+                });
+
+                if (!valid_submeshes)
+                {
+                    log::warn("Mesh cache {} is corrupt", cache_path);
+                    return false;
+                }
+
+                internal::read_stream(file.data(), header.positions_offset, header.vertex_count, geom->vertex_positions());
+                internal::read_stream(file.data(), header.normals_offset, header.vertex_count, geom->vertex_normals());
+                internal::read_stream(file.data(), header.uvs_offset, header.vertex_count, geom->vertex_uvs());
+                internal::read_stream(file.data(), header.faces_offset, header.face_count, geom->faces());
+
+                const char* names = reinterpret_cast<const char*>(file.data() + header.names_offset);
+
+                geom->submeshes().clear();
+                for (const internal::submesh_record& record : submeshes)
+                {
+                    geometry::submesh& range = geom->submeshes().emplace_back();
+
+                    range.material.assign(names + record.material_offset, record.material_size);
+                    range.group.assign(names + record.group_offset, record.group_size);
+                    range.first_index = record.first_index;
+                    range.index_count = record.index_count;
+                }
+            }
+
+            geom->assign_aabb(
+                glm::vec3(header.aabb_min[0], header.aabb_min[1], header.aabb_min[2]), 
+                glm::vec3(header.aabb_max[0], header.aabb_max[1], header.aabb_max[2]));
+
+            if (source_hash != nullptr)
+            {
+                *source_hash = header.source_hash;
+            }
+
+            if (refresh_write_time)
+            {
+                // Next launches can skip hashing the source again
+                header.source_write_time = stamp.write_time;
+
+                std::fstream file(std::string(cache_path), std::ios::binary | std::ios::in | std::ios::out);
+                file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            }
+
+            return true;
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "fileio/file_stamp.h"
+
+#include "util/types.h"
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace ppp
+{
+    namespace geometry
+    {
+        class geometry;
+    }
+
+    // Cooked binary representation of a parsed model.
+    // A header ( describing the source file it was cooked from ) is followed by 16 byte aligned position, normal, uv and index streams.
+    namespace mesh_cache
+    {
+        using hash_source_fn = std::function<u64()>;
+
+        // Location of the cooked mesh for a ( resolved ) source path
+        std::string cache_path(std::string_view source_path);
+
+        bool write(std::string_view cache_path, const geometry::geometry& geom, const fileio::file_stamp& stamp, u64 source_hash);
+
+        // Loads a cooked mesh into the geometry, fails when the cache is missing, corrupt or stale.
+        // The source size has to match, when only the write time differs the content hash of the source is compared ( `hash_fn` is only invoked in that case ).
+        // `source_hash` receives the content hash of the source the cache was cooked from.
+        bool read(std::string_view cache_path, const fileio::file_stamp& stamp, const hash_source_fn& hash_fn, geometry::geometry* geom, u64* source_hash = nullptr);
+    }
+}
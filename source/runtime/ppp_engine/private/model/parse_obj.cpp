@@ -1,124 +1,655 @@
 #include "model/parse_obj.h"
+#include "model/parse_obj_tokens.h"
 
-#include "render/render.h"
+#include "geometry/geometry.h"
 
-#include "image.h"
+#include "util/parallel_for.h"
 
-#include "geometry/geometry.h"
+#include <glm/glm.hpp>
 
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
+namespace ppp
+{
+    namespace internal
+    {
+        //-------------------------------------------------------------------------
+        // Index of a face vertex, 0 when the attribute is not specified
+        struct obj_vertex_key
+        {
+            u32 position = 0;
+            u32 uv = 0;
+            u32 normal = 0;
+            u32 material = 0;
 
+            u64 packed_low() const { return static_cast<u64>(position) | (static_cast<u64>(uv) << 32); }
+            u64 packed_high() const { return static_cast<u64>(normal) | (static_cast<u64>(material) << 32); }
+        };
 
+        //-------------------------------------------------------------------------
+        // Open addressing hash map from a packed vertex key to the index of the vertex in the geometry.
+        // Entries are stored inline, a key with a low half of 0 marks an empty slot ( positions are never 0 ).
+        class obj_vertex_map
+        {
+        public:
+            obj_vertex_map()
+            {
+                m_slots.resize(1024);
+            }
 
-#include "string/string_ops.h"
-#include "string/string_conversions.h"
+            //-------------------------------------------------------------------------
+            // Returns the stored vertex or inserts `new_vertex` when the key is not present yet
+            u32 find_or_insert(const obj_vertex_key& key, u32 new_vertex, bool& inserted)
+            {
+                if ((m_count + 1) * 2 > m_slots.size())
+                {
+                    grow();
+                }
 
-#include <fstream>
-#include <sstream>
+                const u64 low = key.packed_low();
+                const u64 high = key.packed_high();
 
-namespace ppp
-{
-    //-------------------------------------------------------------------------
-    geometry::geometry* parse_obj(geometry::geometry* geom, const std::vector<std::string_view>& buffer)
-    {
-        std::unordered_map<std::string, std::unordered_map<std::string, s32>> used_verts;
+                const u64 mask = m_slots.size() - 1;
+                for (u64 index = hash(low, high) & mask;; index = (index + 1) & mask)
+                {
+                    slot& s = m_slots[index];
+
+                    if (s.low == 0)
+                    {
+                        s.low = low;
+                        s.high = high;
+                        s.vertex = new_vertex;
+
+                        ++m_count;
+
+                        inserted = true;
+                        return new_vertex;
+                    }
+
+                    if (s.low == low && s.high == high)
+                    {
+                        inserted = false;
+                        return s.vertex;
+                    }
+                }
+            }
+
+        private:
+            struct slot
+            {
+                u64 low = 0;
+                u64 high = 0;
+                u32 vertex = 0;
+            };
+
+            //-------------------------------------------------------------------------
+            static u64 hash(u64 low, u64 high)
+            {
+                // 64 bit finalizer of MurmurHash3 over both halves
+                u64 h = low ^ (high * 0x9e3779b97f4a7c15ULL);
+                h ^= h >> 33;
+                h *= 0xff51afd7ed558ccdULL;
+                h ^= h >> 33;
+                h *= 0xc4ceb9fe1a85ec53ULL;
+                h ^= h >> 33;
+                return h;
+            }
+
+            //-------------------------------------------------------------------------
+            void grow()
+            {
+                std::vector<slot> old_slots(m_slots.size() * 2);
+                std::swap(old_slots, m_slots);
+
+                const u64 mask = m_slots.size() - 1;
+                for (const slot& s : old_slots)
+                {
+                    if (s.low == 0)
+                    {
+                        continue;
+                    }
+
+                    u64 index = hash(s.low, s.high) & mask;
+                    while (m_slots[index].low != 0)
+                    {
+                        index = (index + 1) & mask;
+                    }
+
+                    m_slots[index] = s;
+                }
+            }
+
+            std::vector<slot> m_slots;
+            u64 m_count = 0;
+        };
+
+        //-------------------------------------------------------------------------
+        // Converts a 1 based ( or negative, relative ) OBJ index into a 1 based absolute index, 0 when invalid
+        inline u32 parse_index(std::string_view token, u64 element_count)
+        {
+            s64 value = 0;
+            if (token.empty() || std::from_chars(token.data(), token.data() + token.size(), value).ec != std::errc())
+            {
+                return 0;
+            }
+
+            if (value < 0)
+            {
+                value += static_cast<s64>(element_count) + 1;
+            }
+
+            return value > 0 && static_cast<u64>(value) <= element_count 
+                ? static_cast<u32>(value) 
+                : 0;
+        }
+
+        //-------------------------------------------------------------------------
+        // Splits "p", "p/t", "p/t/n" or "p//n" into its indices
+        inline obj_vertex_key parse_face_vertex(std::string_view token, u64 position_count, u64 uv_count, u64 normal_count)
+        {
+            obj_vertex_key key;
+
+            const u64 first_slash = token.find('/');
+            key.position = parse_index(token.substr(0, first_slash), position_count);
+
+            if (first_slash != std::string_view::npos)
+            {
+                const std::string_view rest = token.substr(first_slash + 1);
+                const u64 second_slash = rest.find('/');
 
-        std::unordered_map<std::string, std::vector<glm::vec3>> loaded_verts;
-        std::unordered_map<std::string, std::vector<glm::vec2>> loaded_tex;
+                key.uv = parse_index(rest.substr(0, second_slash), uv_count);
 
-        std::string current_material;
+                if (second_slash != std::string_view::npos)
+                {
+                    key.normal = parse_index(rest.substr(second_slash + 1), normal_count);
+                }
+            }
+
+            return key;
+        }
 
-        for (std::string_view line : buffer)
+        //-------------------------------------------------------------------------
+        // Appends the faces of an OBJ file to a geometry, vertices are deduplicated per position/uv/normal/material combination.
+        // Faces are grouped into submeshes by the active "usemtl" and "g" statements.
+        // Polygons have to be added in file order, that keeps the output identical no matter how the file was parsed.
+        class obj_geometry_builder
         {
-            auto tokens = string::split_string<std::string>(line, " \t\n\r\f\v");
+        public:
+            obj_geometry_builder(geometry::geometry* geom, const std::vector<glm::vec3>& loaded_positions, const std::vector<glm::vec2>& loaded_uvs, const std::vector<glm::vec3>& loaded_normals)
+                : m_positions(geom->vertex_positions())
+                , m_normals(geom->vertex_normals())
+                , m_uvs(geom->vertex_uvs())
+                , m_faces(geom->faces())
+                , m_submeshes(geom->submeshes())
+                , m_loaded_positions(loaded_positions)
+                , m_loaded_uvs(loaded_uvs)
+                , m_loaded_normals(loaded_normals)
+            {
+                // Material ids are only used to keep vertices of different materials apart
+                m_material_ids.emplace(std::string(), 0);
+            }
 
-            if (tokens.empty())
+            //-------------------------------------------------------------------------
+            void use_material(std::string_view name)
             {
-                continue;
+                m_material = m_material_ids.emplace(std::string(name), static_cast<u32>(m_material_ids.size())).first->second;
+                m_material_name = name;
             }
 
-            if (tokens[0] == "usemtl")
+            //-------------------------------------------------------------------------
+            void use_group(std::string_view name)
             {
-                current_material = tokens[1];
+                m_group_name = name;
             }
-            else if (tokens[0] == "v" || tokens[0] == "vn")
+
+            //-------------------------------------------------------------------------
+            // Resolves every corner once, the polygon is triangulated as a fan: (1, 2, 3), (1, 3, 4), ...
+            void add_polygon(const obj_vertex_key* corners, u32 corner_count)
             {
-                f32 x = string::stof(tokens[1]);
-                f32 y = string::stof(tokens[2]);
-                f32 z = string::stof(tokens[3]);
+                m_polygon.clear();
+
+                for (u32 i = 0; i < corner_count; ++i)
+                {
+                    obj_vertex_key key = corners[i];
+                    key.material = m_material;
+
+                    if (key.position == 0)
+                    {
+                        m_polygon.push_back(invalid_vertex);
+                        continue;
+                    }
+
+                    bool inserted = false;
+                    m_polygon.push_back(m_used_vertices.find_or_insert(key, static_cast<u32>(m_positions.size()), inserted));
+
+                    if (inserted)
+                    {
+                        m_positions.push_back(m_loaded_positions[key.position - 1]);
+                        m_uvs.push_back(key.uv != 0 ? m_loaded_uvs[key.uv - 1] : glm::vec2(0.0f, 0.0f));
+                        m_normals.push_back(key.normal != 0 ? m_loaded_normals[key.normal - 1] : glm::vec3(0.0f, 0.0f, 0.0f));
+                    }
+                }
+
+                for (u64 i = 2; i < m_polygon.size(); ++i)
+                {
+                    const u32 v0 = m_polygon[0];
+                    const u32 v1 = m_polygon[i - 1];
+                    const u32 v2 = m_polygon[i];
+
+                    const bool valid = v0 != invalid_vertex && v1 != invalid_vertex && v2 != invalid_vertex;
 
-                loaded_verts[tokens[0]].emplace_back(x, y, z);
+                    if (valid && v0 != v1 && v0 != v2 && v1 != v2)
+                    {
+                        add_face({ v0, v1, v2 });
+                    }
+                }
             }
-            else if (tokens[0] == "vt")
+
+        private:
+            //-------------------------------------------------------------------------
+            void add_face(const render::face& face)
+            {
+                // Consecutive faces with the same material and group extend the last submesh
+                if (m_submeshes.empty() || m_submeshes.back().material != m_material_name || m_submeshes.back().group != m_group_name)
+                {
+                    geometry::submesh& range = m_submeshes.emplace_back();
+
+                    range.material = m_material_name;
+                    range.group = m_group_name;
+                    range.first_index = m_faces.size() * face.size();
+                }
+
+                m_submeshes.back().index_count += face.size();
+
+                m_faces.push_back(face);
+            }
+
+            static constexpr u32 invalid_vertex = std::numeric_limits<u32>::max();
+
+            std::vector<glm::vec3>& m_positions;
+            std::vector<glm::vec3>& m_normals;
+            std::vector<glm::vec2>& m_uvs;
+            std::vector<render::face>& m_faces;
+            std::vector<geometry::submesh>& m_submeshes;
+
+            const std::vector<glm::vec3>& m_loaded_positions;
+            const std::vector<glm::vec2>& m_loaded_uvs;
+            const std::vector<glm::vec3>& m_loaded_normals;
+
+            std::unordered_map<std::string, u32> m_material_ids;
+
+            u32 m_material = 0;
+            std::string m_material_name;
+            std::string m_group_name;
+
+            obj_vertex_map m_used_vertices;
+
+            // Reused for every polygon so building does not allocate per face
+            std::vector<u32> m_polygon;
+        };
+
+        //-------------------------------------------------------------------------
+        // Chunks smaller than this are not worth a thread of their own
+        constexpr u64 min_chunk_size = 256 * 1024;
+
+        //-------------------------------------------------------------------------
+        // A "usemtl" or "g" statement of a chunk, it applies to the polygons starting at `first_polygon`
+        struct obj_statement
+        {
+            enum class type : u8
+            {
+                MATERIAL,
+                GROUP
+            };
+
+            type kind;
+            u32 first_polygon;
+            std::string_view name;
+        };
+
+        //-------------------------------------------------------------------------
+        // A newline aligned slice of the file, parsed independently of the other chunks
+        struct obj_chunk
+        {
+            std::string_view text;
+
+            // Elements declared in this chunk
+            u64 position_count = 0;
+            u64 uv_count = 0;
+            u64 normal_count = 0;
+
+            // Elements declared in all previous chunks ( exclusive prefix sum of the counts above )
+            u64 first_position = 0;
+            u64 first_uv = 0;
+            u64 first_normal = 0;
+
+            // Resolved face corners, the material is assigned when the chunks are merged
+            std::vector<obj_vertex_key> corners;
+            std::vector<u32> polygon_sizes;
+            // "usemtl" and "g" statements, in file order
+            std::vector<obj_statement> statements;
+        };
+
+        //-------------------------------------------------------------------------
+        // Splits the buffer into `chunk_count` slices that never cut a line in half
+        std::vector<obj_chunk> split_chunks(std::string_view buffer, u64 chunk_count)
+        {
+            std::vector<obj_chunk> chunks;
+            chunks.reserve(chunk_count);
+
+            u64 begin = 0;
+            for (u64 i = 1; i <= chunk_count && begin < buffer.size(); ++i)
+            {
+                u64 end = i == chunk_count ? buffer.size() : std::max(begin, (buffer.size() * i) / chunk_count);
+                if (end < buffer.size())
+                {
+                    end = buffer.find('\n', end);
+                    end = end == std::string_view::npos ? buffer.size() : end + 1;
+                }
+
+                obj_chunk chunk;
+                chunk.text = buffer.substr(begin, end - begin);
+                chunks.push_back(std::move(chunk));
+
+                begin = end;
+            }
+
+            return chunks;
+        }
+
+        //-------------------------------------------------------------------------
+        // Calls `fn(keyword, line)` for every line of the text, the keyword is already popped from the line
+        template<typename TFunction>
+        void for_each_line(std::string_view text, const TFunction& fn)
+        {
+            while (!text.empty())
             {
-                f32 u = string::stof(tokens[1]);
-                f32 v = 1.0f - string::stof(tokens[2]);
+                const u64 line_end = text.find('\n');
+
+                std::string_view line = text.substr(0, line_end);
+                text.remove_prefix(line_end == std::string_view::npos ? text.size() : line_end + 1);
 
-                loaded_tex[tokens[0]].emplace_back(u, v);
+                const std::string_view keyword = next_token(line);
+
+                fn(keyword, line);
             }
-            else if (tokens[0] == "f")
+        }
+
+        //-------------------------------------------------------------------------
+        // First pass, only counts the elements so every chunk knows where its elements land in the merged arrays
+        void count_chunk(obj_chunk& chunk)
+        {
+            for_each_line(chunk.text, [&chunk](std::string_view keyword, std::string_view)
+            {
+                switch (element_type(keyword))
+                {
+                case obj_element::POSITION: ++chunk.position_count; break;
+                case obj_element::UV: ++chunk.uv_count; break;
+                case obj_element::NORMAL: ++chunk.normal_count; break;
+                case obj_element::NONE: break;
+                }
+            });
+        }
+
+        //-------------------------------------------------------------------------
+        // Second pass, parses the elements straight into the merged arrays and resolves the face corners against the global element counts
+        void parse_chunk(obj_chunk& chunk, std::vector<glm::vec3>& loaded_positions, std::vector<glm::vec2>& loaded_uvs, std::vector<glm::vec3>& loaded_normals)
+        {
+            u64 position_count = chunk.first_position;
+            u64 uv_count = chunk.first_uv;
+            u64 normal_count = chunk.first_normal;
+
+            for_each_line(chunk.text, [&](std::string_view keyword, std::string_view line)
             {
-                for (u64 tri = 3; tri < tokens.size(); ++tri)
+                const obj_element element = element_type(keyword);
+                if (element != obj_element::NONE)
                 {
-                    std::vector<u32> face;
-                    std::vector<u64> vertex_tokens = { 1, tri - 1, tri };
+                    const glm::vec3 value = parse_element(element, line);
 
-                    for (const auto& token_index : vertex_tokens)
+                    switch (element)
                     {
-                        std::string vert_string = tokens[token_index];
-
-                        auto vert_parts_s = string::split_string<std::string>(vert_string, "/");
-                        auto vert_parts = std::vector<s32>{};
-
-                        for (const auto& part_s : vert_parts_s)
-                        {
-                            vert_parts.push_back(part_s.empty() ? 0 : string::stoi(part_s) - 1);
-                        }
-
-                        if (used_verts[vert_string].find(current_material) == used_verts[vert_string].end())
-                        {
-                            s32 vert_index = geom->vertex_positions().size();
-
-                            geom->vertex_positions().push_back(loaded_verts["v"][vert_parts[0]]);
-
-                            if (!loaded_tex["vt"].empty() && loaded_tex["vt"].size() >= vert_parts[1])
-                            {
-                                geom->vertex_uvs().push_back(loaded_tex["vt"][vert_parts[1]]);
-                            }
-                            else
-                            {
-                                geom->vertex_uvs().emplace_back(0.0f, 0.0f);
-                            }
-
-                            if (!loaded_verts["vn"].empty() && loaded_verts["vn"].size() >= vert_parts[2])
-                            {
-                                geom->vertex_normals().push_back(loaded_verts["vn"][vert_parts[2]]);
-                            }
-                            else
-                            {
-                                geom->vertex_normals().emplace_back(0.0f, 0.0f, 0.0f);
-                            }
-
-                            used_verts[vert_string][current_material] = vert_index;
-
-                            face.push_back(vert_index);
-                        }
-                        else
-                        {
-                            face.push_back(used_verts[vert_string][current_material]);
-                        }
+                    case obj_element::POSITION: loaded_positions[position_count++] = value; break;
+                    case obj_element::UV: loaded_uvs[uv_count++] = glm::vec2(value); break;
+                    case obj_element::NORMAL: loaded_normals[normal_count++] = value; break;
+                    case obj_element::NONE: break;
                     }
+                }
+                else if (keyword == "f")
+                {
+                    u32 polygon_size = 0;
 
-                    if (face[0] != face[1] && face[0] != face[2] && face[1] != face[2])
+                    for (std::string_view token = next_token(line); !token.empty(); token = next_token(line))
                     {
-                        render::face f = { face[0],face[1],face[2] };
+                        chunk.corners.push_back(parse_face_vertex(token, position_count, uv_count, normal_count));
+                        ++polygon_size;
+                    }
 
-                        geom->faces().push_back(f);
+                    chunk.polygon_sizes.push_back(polygon_size);
+                }
+                else if (keyword == "usemtl")
+                {
+                    chunk.statements.push_back({ obj_statement::type::MATERIAL, static_cast<u32>(chunk.polygon_sizes.size()), next_token(line) });
+                }
+                else if (keyword == "g")
+                {
+                    chunk.statements.push_back({ obj_statement::type::GROUP, static_cast<u32>(chunk.polygon_sizes.size()), next_token(line) });
+                }
+            });
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    geometry::geometry* parse_obj(geometry::geometry* geom, std::string_view buffer, u32 thread_count)
+    {
+        u64 chunk_count = thread_count;
+        if (chunk_count == 0)
+        {
+            chunk_count = std::clamp<u64>(buffer.size() / internal::min_chunk_size, 1, std::max(1u, std::thread::hardware_concurrency()));
+        }
+
+        std::vector<internal::obj_chunk> chunks = internal::split_chunks(buffer, chunk_count);
+
+        // One thread per chunk
+        const u32 parse_thread_count = static_cast<u32>(chunks.size());
+
+        parallel_for(chunks.size(), [&chunks](u64 i) { internal::count_chunk(chunks[i]); }, parse_thread_count);
+
+        // Exclusive prefix sum, gives every chunk the global offset of its first position/uv/normal
+        u64 position_count = 0;
+        u64 uv_count = 0;
+        u64 normal_count = 0;
+
+        for (internal::obj_chunk& chunk : chunks)
+        {
+            chunk.first_position = position_count;
+            chunk.first_uv = uv_count;
+            chunk.first_normal = normal_count;
+
+            position_count += chunk.position_count;
+            uv_count += chunk.uv_count;
+            normal_count += chunk.normal_count;
+        }
+
+        std::vector<glm::vec3> loaded_positions(position_count);
+        std::vector<glm::vec3> loaded_normals(normal_count);
+        std::vector<glm::vec2> loaded_uvs(uv_count);
+
+        parallel_for(chunks.size(), [&](u64 i) { internal::parse_chunk(chunks[i], loaded_positions, loaded_uvs, loaded_normals); }, parse_thread_count);
+
+        // Merge the chunks in file order, this keeps the vertex and face order identical to a sequential parse
+        internal::obj_geometry_builder builder(geom, loaded_positions, loaded_uvs, loaded_normals);
+
+        for (internal::obj_chunk& chunk : chunks)
+        {
+            // Polygons before the first statement of a chunk keep the material and group of the previous chunk
+            auto statement = chunk.statements.cbegin();
+            auto apply_statements = [&](u32 polygon)
+            {
+                for (; statement != chunk.statements.cend() && statement->first_polygon == polygon; ++statement)
+                {
+                    if (statement->kind == internal::obj_statement::type::MATERIAL)
+                    {
+                        builder.use_material(statement->name);
+                    }
+                    else
+                    {
+                        builder.use_group(statement->name);
                     }
                 }
+            };
+
+            const internal::obj_vertex_key* corner = chunk.corners.data();
+
+            for (u32 polygon = 0; polygon < chunk.polygon_sizes.size(); ++polygon)
+            {
+                apply_statements(polygon);
+
+                builder.add_polygon(corner, chunk.polygon_sizes[polygon]);
+
+                corner += chunk.polygon_sizes[polygon];
+            }
+
+            // Statements after the last polygon carry over to the next chunk
+            apply_statements(static_cast<u32>(chunk.polygon_sizes.size()));
+
+            // Release the corners of this chunk early, they are no longer needed
+            std::vector<internal::obj_vertex_key>().swap(chunk.corners);
+        }
+
+        if (geom->vertex_normals().empty())
+        {
+            geom->compute_normals();
+        }
+
+        return geom;
+    }
+
+    //-------------------------------------------------------------------------
+    struct obj_stream_parser::impl
+    {
+        impl(geometry::geometry* geom)
+            : geom(geom)
+            , builder(geom, loaded_positions, loaded_uvs, loaded_normals)
+        {}
+
+        //-------------------------------------------------------------------------
+        void parse_line(std::string_view line)
+        {
+            const std::string_view keyword = internal::next_token(line);
+
+            parse_line(keyword, line);
+        }
+
+        //-------------------------------------------------------------------------
+        void parse_line(std::string_view keyword, std::string_view line)
+        {
+            const internal::obj_element element = internal::element_type(keyword);
+            if (element != internal::obj_element::NONE)
+            {
+                const glm::vec3 value = internal::parse_element(element, line);
+
+                switch (element)
+                {
+                case internal::obj_element::POSITION: loaded_positions.push_back(value); break;
+                case internal::obj_element::UV: loaded_uvs.emplace_back(value); break;
+                case internal::obj_element::NORMAL: loaded_normals.push_back(value); break;
+                case internal::obj_element::NONE: break;
+                }
+            }
+            else if (keyword == "f")
+            {
+                polygon.clear();
+
+                for (std::string_view token = internal::next_token(line); !token.empty(); token = internal::next_token(line))
+                {
+                    polygon.push_back(internal::parse_face_vertex(token, loaded_positions.size(), loaded_uvs.size(), loaded_normals.size()));
+                }
+
+                builder.add_polygon(polygon.data(), static_cast<u32>(polygon.size()));
+            }
+            else if (keyword == "usemtl")
+            {
+                builder.use_material(internal::next_token(line));
+            }
+            else if (keyword == "g")
+            {
+                builder.use_group(internal::next_token(line));
             }
         }
 
+        geometry::geometry* geom;
+
+        std::vector<glm::vec3> loaded_positions;
+        std::vector<glm::vec3> loaded_normals;
+        std::vector<glm::vec2> loaded_uvs;
+
+        internal::obj_geometry_builder builder;
+
+        // Reused for every face so parsing does not allocate per line
+        std::vector<internal::obj_vertex_key> polygon;
+
+        // Start of a line that continues in the next chunk
+        std::string partial_line;
+    };
+
+    //-------------------------------------------------------------------------
+    obj_stream_parser::obj_stream_parser(geometry::geometry* geom)
+        : m_pimpl(std::make_unique<impl>(geom))
+    {}
+
+    //-------------------------------------------------------------------------
+    obj_stream_parser::~obj_stream_parser() = default;
+
+    //-------------------------------------------------------------------------
+    void obj_stream_parser::append(std::string_view chunk)
+    {
+        if (!m_pimpl->partial_line.empty())
+        {
+            // Complete the line that straddles the chunk boundary
+            const u64 line_end = chunk.find('\n');
+            if (line_end == std::string_view::npos)
+            {
+                m_pimpl->partial_line.append(chunk);
+                return;
+            }
+
+            m_pimpl->partial_line.append(chunk.substr(0, line_end));
+            m_pimpl->parse_line(m_pimpl->partial_line);
+            m_pimpl->partial_line.clear();
+
+            chunk.remove_prefix(line_end + 1);
+        }
+
+        const u64 last_line_end = chunk.rfind('\n');
+        if (last_line_end == std::string_view::npos)
+        {
+            m_pimpl->partial_line.assign(chunk);
+            return;
+        }
+
+        internal::for_each_line(chunk.substr(0, last_line_end + 1), [this](std::string_view keyword, std::string_view line) { m_pimpl->parse_line(keyword, line); });
+
+        m_pimpl->partial_line.assign(chunk.substr(last_line_end + 1));
+    }
+
+    //-------------------------------------------------------------------------
+    geometry::geometry* obj_stream_parser::finish()
+    {
+        if (!m_pimpl->partial_line.empty())
+        {
+            m_pimpl->parse_line(m_pimpl->partial_line);
+            m_pimpl->partial_line.clear();
+        }
+
+        geometry::geometry* geom = m_pimpl->geom;
+
         if (geom->vertex_normals().empty())
         {
             geom->compute_normals();
@@ -126,4 +657,4 @@ namespace ppp
 
         return geom;
     }
-}
\ No newline at end of file
+}
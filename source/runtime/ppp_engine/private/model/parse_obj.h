@@ -2,13 +2,8 @@
 
 #include "util/types.h"
 
-
-
-#include <glm/glm.hpp>
-
-#include <string>
-#include <vector>
-#include <unordered_map>
+#include <memory>
+#include <string_view>
 
 namespace ppp
 {
@@ -17,5 +12,30 @@ namespace ppp
         class geometry;
     }
 
-    geometry::geometry* parse_obj(geometry::geometry* geom, const std::vector<std::string_view>& buffer);
-}
\ No newline at end of file
+    // Parses the contents of an OBJ file in place, no copies are made of the buffer.
+    // Vertices are deduplicated per position/uv/normal/material combination, polygons are triangulated as a fan.
+    // The buffer is split into newline aligned chunks that are parsed on `thread_count` threads ( 0 picks a count based on the buffer size ),
+    // the result is identical for every thread count.
+    geometry::geometry* parse_obj(geometry::geometry* geom, std::string_view buffer, u32 thread_count = 0);
+
+    // Parses an OBJ file that is handed over in chunks, for files that are too large to keep in memory.
+    // Lines can straddle chunks, only the start of such a line is copied. The result is identical to `parse_obj`.
+    class obj_stream_parser
+    {
+    public:
+        explicit obj_stream_parser(geometry::geometry* geom);
+        ~obj_stream_parser();
+
+        obj_stream_parser(const obj_stream_parser&) = delete;
+        obj_stream_parser& operator=(const obj_stream_parser&) = delete;
+
+        void append(std::string_view chunk);
+
+        // Parses the last line ( when the file does not end with a newline ) and completes the geometry
+        geometry::geometry* finish();
+
+    private:
+        struct impl;
+        std::unique_ptr<impl> m_pimpl;
+    };
+}
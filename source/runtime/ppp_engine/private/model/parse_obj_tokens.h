@@ -0,0 +1,95 @@
+#pragma once
+
+#include "util/types.h"
+
+#include <glm/glm.hpp>
+
+#include <charconv>
+#include <string_view>
+
+namespace ppp
+{
+    // Tokenizer of the OBJ parsers, shared by `parse_obj` and `obj_stream_parser` so both read statements the same way
+    namespace internal
+    {
+        //-------------------------------------------------------------------------
+        // Elements declared by the vertex statements of an OBJ file
+        enum class obj_element : u8
+        {
+            NONE,
+            POSITION,   // "v"
+            UV,         // "vt"
+            NORMAL      // "vn"
+        };
+
+        //-------------------------------------------------------------------------
+        inline bool is_space(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+        }
+
+        //-------------------------------------------------------------------------
+        // Pops the next whitespace separated token from the front of the line
+        inline std::string_view next_token(std::string_view& line)
+        {
+            u64 begin = 0;
+            while (begin < line.size() && is_space(line[begin]))
+            {
+                ++begin;
+            }
+
+            u64 end = begin;
+            while (end < line.size() && !is_space(line[end]))
+            {
+                ++end;
+            }
+
+            std::string_view token = line.substr(begin, end - begin);
+            line.remove_prefix(end);
+            return token;
+        }
+
+        //-------------------------------------------------------------------------
+        inline f32 parse_float(std::string_view token)
+        {
+            if (!token.empty() && token[0] == '+')
+            {
+                token.remove_prefix(1);
+            }
+
+            f32 value = 0.0f;
+            std::from_chars(token.data(), token.data() + token.size(), value);
+            return value;
+        }
+
+        //-------------------------------------------------------------------------
+        // Element declared by a statement, NONE for every statement that is not a vertex statement
+        inline obj_element element_type(std::string_view keyword)
+        {
+            if (keyword == "v") return obj_element::POSITION;
+            if (keyword == "vt") return obj_element::UV;
+            if (keyword == "vn") return obj_element::NORMAL;
+
+            return obj_element::NONE;
+        }
+
+        //-------------------------------------------------------------------------
+        // Reads the values of a vertex statement from the rest of its line, uvs only use x and y and are flipped vertically
+        inline glm::vec3 parse_element(obj_element element, std::string_view& line)
+        {
+            if (element == obj_element::UV)
+            {
+                const f32 u = parse_float(next_token(line));
+                const f32 v = 1.0f - parse_float(next_token(line));
+
+                return glm::vec3(u, v, 0.0f);
+            }
+
+            const f32 x = parse_float(next_token(line));
+            const f32 y = parse_float(next_token(line));
+            const f32 z = parse_float(next_token(line));
+
+            return glm::vec3(x, y, z);
+        }
+    }
+}
@@ -1,5 +1,7 @@
 #include "ray.h"
 
+#include "resources/picking_pool.h"
+
 #include <algorithm>
 
 namespace ppp
@@ -36,4 +38,36 @@ namespace ppp
         t_min_out = tmin;
         return true;
     }
+
+    //-------------------------------------------------------------------------
+    void enable_picking()
+    {
+        picking_pool::enable(true);
+    }
+
+    //-------------------------------------------------------------------------
+    void disable_picking()
+    {
+        picking_pool::enable(false);
+    }
+
+    //-------------------------------------------------------------------------
+    ray_hit pick(const ray& r, pick_precision precision)
+    {
+        const picking_pool::pick_precision pool_precision = precision == pick_precision::BOUNDS
+            ? picking_pool::pick_precision::BOUNDS
+            : picking_pool::pick_precision::TRIANGLES;
+
+        const picking_pool::pick_hit pool_hit = picking_pool::pick(r.origin, r.dir, pool_precision);
+
+        ray_hit result;
+        result.hit = pool_hit.hit;
+        result.geometry = static_cast<geometry_id>(pool_hit.geometry_id);
+        result.item = static_cast<std::size_t>(pool_hit.item_index);
+        result.triangle = pool_hit.triangle_index;
+        result.distance = pool_hit.distance;
+        result.position = pool_hit.position;
+
+        return result;
+    }
 }
\ No newline at end of file
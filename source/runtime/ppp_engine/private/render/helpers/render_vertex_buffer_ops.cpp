@@ -86,6 +86,38 @@ namespace ppp
                     memcpy(dst_ptr, data_ptr, element_size);
                 }
             }
+
+            //-------------------------------------------------------------------------
+            void update_attribute_data(vertex_buffer& vb, attribute_type type, u64 first_element, u64 element_count, const void* data_ptr)
+            {
+                if (data_ptr == nullptr)
+                {
+                    log::warn("trying to copy an null-data");
+                    return;
+                }
+
+                assert(first_element + element_count <= vb.active_element_count() && "Updating vertices that were never added");
+
+                const attribute_layout* element_layout = vb.find_layout(type);
+                if (!element_layout)
+                {
+                    log::error("Attribute type not found in layout: {}", conversions::to_string(type));
+                    return;
+                }
+
+                u64 element_offset = element_layout->offset;
+                u64 element_stride = vb.element_size_in_bytes();
+                u64 element_size = element_layout->total_size_in_bytes();
+
+                for (u64 i = 0; i < element_count; ++i)
+                {
+                    const u8* src_ptr = reinterpret_cast<const u8*>(data_ptr) + i * element_size;
+                    u8* dst_ptr = vb.data() + (first_element + i) * element_stride + element_offset;
+                    memcpy(dst_ptr, src_ptr, element_size);
+                }
+
+                vb.invalidate(static_cast<u32>(first_element), static_cast<u32>(element_count));
+            }
         }
     }
 }
\ No newline at end of file
@@ -40,6 +40,10 @@ namespace ppp
             //-------------------------------------------------------------------------
             void map_attribute_data(vertex_attribute_addition_scope& vaas, attribute_type type, const void* data_ptr);
 
+            //-------------------------------------------------------------------------
+            // Overwrite attribute data of vertices that were already added, the range is re-uploaded on the next submit.
+            void update_attribute_data(vertex_buffer& vb, attribute_type type, u64 first_element, u64 element_count, const void* data_ptr);
+
             //-------------------------------------------------------------------------
             template<typename T>
             void transform_attribute_data(vertex_buffer& vb, attribute_type type, std::function<void(T&)> transform_func)
@@ -3,6 +3,7 @@
 #include "render/render_instance_data_table.h"
 #include "render/render_context.h"
 #include "render/render_scissor.h"
+#include "render/render_readback.h"
 #include "render/render_pipeline.h"
 #include "render/render_batch_renderer.h"
 #include "render/render_instance_renderer.h"
@@ -22,6 +23,14 @@
 
 #include "resources/shader_pool.h"
 #include "resources/framebuffer_pool.h"
+#include "resources/lights_pool.h"
+#include "resources/picking_pool.h"
+
+#include "camera/camera_manager.h"
+
+#include "geometry/geometry_frustum.h"
+#include "geometry/geometry_occlusion_buffer.h"
+#include "geometry/geometry_projection.h"
 
 #include "util/log.h"
 #include "util/color_ops.h"
@@ -131,6 +140,13 @@ namespace ppp
             std::vector<irender_pass*> wireframe_passes;
         };
 
+        // Planes are only extracted again when the view projection changes
+        struct culling_frustum
+        {
+            glm::mat4 view_proj = glm::mat4(0.0f);
+            geometry::frustum planes = {};
+        };
+
         //-------------------------------------------------------------------------
         struct context
         {
@@ -144,6 +160,17 @@ namespace ppp
 
             // drawing
             render_draw_mode            draw_mode = render_draw_mode::BATCHED;
+            glm::vec2                   viewport_size = glm::vec2(0.0f);
+
+            // culling
+            bool                        frustum_culling = true;
+            culling_frustum             camera_frustum;
+            culling_frustum             shadow_frustum;
+            f32                         small_feature_threshold = 0.0f;
+            bool                        occlusion_culling = false;
+            bool                        collect_occluders = false;
+            geometry::occlusion_buffer  occlusion_buffer;
+            glm::mat4                   occlusion_view_proj = glm::mat4(0.0f);
 
             // shaders
             string::string_id           fill_user_shader = string::string_id::create_invalid();
@@ -180,6 +207,184 @@ namespace ppp
             return render_context;
         }
 
+        //-------------------------------------------------------------------------
+        static const geometry::frustum& update_culling_frustum(culling_frustum& frustum, const glm::mat4& view_proj)
+        {
+            if (frustum.view_proj != view_proj)
+            {
+                frustum.view_proj = view_proj;
+                frustum.planes = geometry::make_frustum(view_proj);
+            }
+
+            return frustum.planes;
+        }
+
+        //-------------------------------------------------------------------------
+        static bool is_inside_shadow_frustum(const geometry::bounding_box& local_bounds, const glm::mat4& world)
+        {
+            if (g_ctx.shadows == false || lights_pool::has_directional_lights_with_shadow() == false)
+            {
+                return false;
+            }
+
+            // The shadow pass only renders the first directional light
+            const auto& dir_light = lights_pool::directional_lights()[0];
+            const auto shadow_framebuffer = framebuffer_pool::get(framebuffer_pool::tags::shadow_map(), framebuffer_flags::SAMPLED_DEPTH);
+
+            const glm::mat4 light_vp = lights_pool::directional_light_view_proj(
+                dir_light,
+                static_cast<f32>(shadow_framebuffer->width()),
+                static_cast<f32>(shadow_framebuffer->height()));
+
+            return geometry::frustum_intersects_aabb(update_culling_frustum(g_ctx.shadow_frustum, light_vp), local_bounds, world);
+        }
+
+        //-------------------------------------------------------------------------
+        static void submit_pickable_item(const irender_item* item, shading_blending_type shading_blend, const glm::mat4& world)
+        {
+            if (!picking_pool::is_enabled())
+            {
+                return;
+            }
+
+            // UI is rendered through its own camera and can not be hit by a world space ray
+            if (shading_blend == shading_blending_type::UI || item->local_bounds() == nullptr)
+            {
+                return;
+            }
+
+            picking_pool::add_item(item->geometry_id(), *item->local_bounds(), world, item->first_index(), item->index_count());
+        }
+
+        //-------------------------------------------------------------------------
+        static bool is_frustum_culled(const irender_item* item, shading_blending_type shading_blend, const glm::mat4& world)
+        {
+            // UI is rendered through its own camera
+            if (g_ctx.frustum_culling == false || shading_blend == shading_blending_type::UI)
+            {
+                return false;
+            }
+
+            const geometry::bounding_box* local_bounds = item->local_bounds();
+            if (local_bounds == nullptr)
+            {
+                return false;
+            }
+
+            const glm::mat4 camera_vp = camera_manager::get_proj() * camera_manager::get_view();
+            if (geometry::frustum_intersects_aabb(update_culling_frustum(g_ctx.camera_frustum, camera_vp), *local_bounds, world))
+            {
+                return false;
+            }
+
+            // Batches are shared with the shadow pass, an item outside of the view can still cast a visible shadow
+            return is_inside_shadow_frustum(*local_bounds, world) == false;
+        }
+
+        //-------------------------------------------------------------------------
+        static bool is_small_feature(topology_type topology, const irender_item* item, shading_blending_type shading_blend, const glm::mat4& world)
+        {
+            if (g_ctx.small_feature_threshold <= 0.0f || shading_blend == shading_blending_type::UI)
+            {
+                return false;
+            }
+
+            // Points and lines are rasterized with a fixed size in pixels, the extent of their bounds says nothing about their coverage
+            if (topology != topology_type::TRIANGLES)
+            {
+                return false;
+            }
+
+            const geometry::bounding_box* local_bounds = item->local_bounds();
+            if (local_bounds == nullptr)
+            {
+                return false;
+            }
+
+            const glm::mat4 camera_vp = camera_manager::get_proj() * camera_manager::get_view();
+            return geometry::is_small_on_screen(*local_bounds, camera_vp * world, g_ctx.viewport_size, g_ctx.small_feature_threshold);
+        }
+
+        //-------------------------------------------------------------------------
+        static void rasterize_occluder(const irender_item* item, shading_blending_type shading_blend, const glm::mat4& world)
+        {
+            if (g_ctx.occlusion_culling == false || shading_blend == shading_blending_type::UI || item->faces().empty())
+            {
+                return;
+            }
+
+            // Occluders are rasterized with the camera that is active when they are submitted, a camera switch starts over
+            const glm::mat4 camera_vp = camera_manager::get_proj() * camera_manager::get_view();
+            if (g_ctx.occlusion_view_proj != camera_vp)
+            {
+                g_ctx.occlusion_buffer.clear();
+                g_ctx.occlusion_view_proj = camera_vp;
+            }
+
+            g_ctx.occlusion_buffer.rasterize(item->vertex_positions().data(), item->first_face(), item->index_count() / 3, camera_vp * world);
+        }
+
+        //-------------------------------------------------------------------------
+        static bool is_occluded(const irender_item* item, shading_blending_type shading_blend, const glm::mat4& world)
+        {
+            if (g_ctx.occlusion_culling == false || shading_blend == shading_blending_type::UI || g_ctx.occlusion_buffer.empty())
+            {
+                return false;
+            }
+
+            const geometry::bounding_box* local_bounds = item->local_bounds();
+            if (local_bounds == nullptr)
+            {
+                return false;
+            }
+
+            // A hidden item can still cast a visible shadow
+            if (g_ctx.shadows && lights_pool::has_directional_lights_with_shadow())
+            {
+                return false;
+            }
+
+            const glm::mat4 camera_vp = camera_manager::get_proj() * camera_manager::get_view();
+            if (g_ctx.occlusion_view_proj != camera_vp)
+            {
+                return false;
+            }
+
+            return g_ctx.occlusion_buffer.is_occluded(*local_bounds, camera_vp * world);
+        }
+
+        //-------------------------------------------------------------------------
+        static bool accept_render_item(topology_type topology, const irender_item* item, shading_blending_type shading_blend, const glm::mat4& world)
+        {
+            submit_pickable_item(item, shading_blend, world);
+
+            if (is_frustum_culled(item, shading_blend, world))
+            {
+                ++g_ctx.stats.frustum_culled_items;
+                return false;
+            }
+
+            if (is_small_feature(topology, item, shading_blend, world))
+            {
+                ++g_ctx.stats.small_feature_culled_items;
+                return false;
+            }
+
+            if (g_ctx.collect_occluders)
+            {
+                rasterize_occluder(item, shading_blend, world);
+                return true;
+            }
+
+            if (is_occluded(item, shading_blend, world))
+            {
+                ++g_ctx.stats.occlusion_culled_items;
+                return false;
+            }
+
+            return true;
+        }
+
         //-------------------------------------------------------------------------
         void submit_custom_render_item(topology_type topology, const irender_item* item, const glm::vec4& color)
         {
@@ -199,6 +404,11 @@ namespace ppp
                 shading_model_type shading_model = shader_pool::shading_model_for_shader(shader_tag);
                 shading_blending_type shading_blend = shader_pool::shading_blending_for_shader(shader_tag);
 
+                if (accept_render_item(topology, item, shading_blend, transform_stack::active_world()) == false)
+                {
+                    return;
+                }
+
                 batch_data_key data_key = { shader_tag, shading_model,shading_blend, g_ctx.depth_test, g_ctx.depth_write, g_ctx.shadows };
                 batch_data_hash_map* batches = nullptr;
 
@@ -224,6 +434,11 @@ namespace ppp
                 shading_model_type shading_model = shader_pool::shading_model_for_shader(shader_tag);
                 shading_blending_type shading_blend = shader_pool::shading_blending_for_shader(shader_tag);
 
+                if (accept_render_item(topology, item, shading_blend, transform_stack::active_world()) == false)
+                {
+                    return;
+                }
+
                 instance_data_key data_key = { shader_tag, shading_model,shading_blend, g_ctx.depth_test, g_ctx.depth_write, g_ctx.shadows };
                 instance_data_hash_map* instances = nullptr;
 
@@ -333,6 +548,8 @@ namespace ppp
             push_scissor(0, 0, w, h);
             push_scissor_enable(false);
 
+            g_ctx.viewport_size = glm::vec2(w, h);
+
             push_renderpasses();
 
             constexpr bool enable_solid_rendering = true;
@@ -352,6 +569,8 @@ namespace ppp
         //-------------------------------------------------------------------------
         void terminate()
         {
+            readback::terminate();
+
             // Font
             g_ctx.font_batch_data->clear();
 
@@ -389,6 +608,23 @@ namespace ppp
             g_ctx.ui_instance_data.clear();
         }
 
+        //-------------------------------------------------------------------------
+        void release_geometry_item(u64 geometry_id)
+        {
+            for (auto& pair : g_ctx.opaque_instance_data)
+            {
+                pair.second->release_instance(geometry_id);
+            }
+            for (auto& pair : g_ctx.transparent_instance_data)
+            {
+                pair.second->release_instance(geometry_id);
+            }
+            for (auto& pair : g_ctx.ui_instance_data)
+            {
+                pair.second->release_instance(geometry_id);
+            }
+        }
+
         //-------------------------------------------------------------------------
         statistics stats()
         {
@@ -398,6 +634,17 @@ namespace ppp
         //-------------------------------------------------------------------------
         void begin()
         {
+            // Reads of earlier frames that the GPU finished
+            readback::update();
+
+            g_ctx.stats.frustum_culled_items = 0;
+            g_ctx.stats.occlusion_culled_items = 0;
+            g_ctx.stats.small_feature_culled_items = 0;
+
+            // Occluders have to be submitted again every frame
+            g_ctx.occlusion_buffer.clear();
+            g_ctx.collect_occluders = false;
+
             // Font
             g_ctx.font_batch_data->reset();
 
@@ -448,6 +695,9 @@ namespace ppp
         void end()
         {
             broadcast_on_draw_end();
+
+            // Reads that were requested this frame, including the ones from draw end callbacks
+            readback::flush();
         }
 
         //-------------------------------------------------------------------------
@@ -463,6 +713,8 @@ namespace ppp
             // Match GL viewport to the real backbuffer size (physical pixels).
             opengl::api::instance().viewport(0, 0, w, h);
 
+            g_ctx.viewport_size = glm::vec2(w, h);
+
             // Keep scissor in sync with the drawable area your pipeline expects.
             push_scissor(0, 0, w, h);
             push_scissor_enable(scissor_rect_enabled());
@@ -500,6 +752,72 @@ namespace ppp
             return g_ctx.shadows;
         }
 
+        //-------------------------------------------------------------------------
+        void enable_frustum_culling()
+        {
+            g_ctx.frustum_culling = true;
+        }
+
+        //-------------------------------------------------------------------------
+        void disable_frustum_culling()
+        {
+            g_ctx.frustum_culling = false;
+        }
+
+        //-------------------------------------------------------------------------
+        bool frustum_culling_enabled()
+        {
+            return g_ctx.frustum_culling;
+        }
+
+        //-------------------------------------------------------------------------
+        void enable_small_feature_culling(f32 threshold_in_pixels)
+        {
+            g_ctx.small_feature_threshold = threshold_in_pixels;
+        }
+
+        //-------------------------------------------------------------------------
+        void disable_small_feature_culling()
+        {
+            g_ctx.small_feature_threshold = 0.0f;
+        }
+
+        //-------------------------------------------------------------------------
+        f32 small_feature_culling_threshold()
+        {
+            return g_ctx.small_feature_threshold;
+        }
+
+        //-------------------------------------------------------------------------
+        void enable_occlusion_culling()
+        {
+            g_ctx.occlusion_culling = true;
+        }
+
+        //-------------------------------------------------------------------------
+        void disable_occlusion_culling()
+        {
+            g_ctx.occlusion_culling = false;
+        }
+
+        //-------------------------------------------------------------------------
+        bool occlusion_culling_enabled()
+        {
+            return g_ctx.occlusion_culling;
+        }
+
+        //-------------------------------------------------------------------------
+        void begin_occluders()
+        {
+            g_ctx.collect_occluders = true;
+        }
+
+        //-------------------------------------------------------------------------
+        void end_occluders()
+        {
+            g_ctx.collect_occluders = false;
+        }
+
         //-------------------------------------------------------------------------
         void enable_depth_test()
         {
@@ -714,7 +1032,7 @@ namespace ppp
                 assert(false);
             }
 
-            u32 texture_id;
+            u32 texture_id = 0;
 
             opengl::api::instance().generate_textures(1, &texture_id);
             opengl::api::instance().bind_texture(GL_TEXTURE_2D, texture_id);
@@ -742,6 +1060,79 @@ namespace ppp
             return texture_id;
         }
 
+        //-------------------------------------------------------------------------
+        u32 create_compressed_image_item(image_compression_type compression, const std::vector<compressed_image_level>& levels, image_filter_type filter_type, image_wrap_type wrap_type)
+        {
+            // S3TC is an extension that is not part of the generated loader, every desktop driver exposes it
+            constexpr GLenum compressed_rgb_s3tc_dxt1 = 0x83F0;
+            constexpr GLenum compressed_rgba_s3tc_dxt5 = 0x83F3;
+
+            assert(!levels.empty());
+
+            GLenum format = GL_INVALID_VALUE;
+
+            switch (compression)
+            {
+            case image_compression_type::BC1: format = compressed_rgb_s3tc_dxt1; break;
+            case image_compression_type::BC3: format = compressed_rgba_s3tc_dxt5; break;
+            case image_compression_type::BC5: format = GL_COMPRESSED_RG_RGTC2; break;
+            case image_compression_type::BC7: format = GL_COMPRESSED_RGBA_BPTC_UNORM; break;
+            default:
+                assert(false);
+            }
+
+            GLint min_filter = GL_INVALID_VALUE;
+            GLint mag_filter = GL_INVALID_VALUE;
+
+            switch (filter_type)
+            {
+            case image_filter_type::NEAREST: min_filter = GL_NEAREST_MIPMAP_NEAREST; mag_filter = GL_NEAREST; break;
+            case image_filter_type::LINEAR: min_filter = GL_LINEAR_MIPMAP_LINEAR; mag_filter = GL_LINEAR; break;
+            default:
+                assert(false);
+            }
+
+            GLint wrap = GL_INVALID_VALUE;
+
+            switch (wrap_type)
+            {
+            case image_wrap_type::CLAMP_TO_EDGE: wrap = GL_CLAMP_TO_EDGE; break;
+            case image_wrap_type::REPEAT: wrap = GL_REPEAT; break;
+            default:
+                assert(false);
+            }
+
+            u32 texture_id = 0;
+
+            opengl::api::instance().generate_textures(1, &texture_id);
+            opengl::api::instance().bind_texture(GL_TEXTURE_2D, texture_id);
+            opengl::api::instance().set_texture_integer_parameter(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
+            opengl::api::instance().set_texture_integer_parameter(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter);
+            opengl::api::instance().set_texture_integer_parameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+            opengl::api::instance().set_texture_integer_parameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+            opengl::api::instance().set_texture_integer_parameter(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels.size() - 1));
+
+            for (u64 i = 0; i < levels.size(); ++i)
+            {
+                opengl::api::instance().compressed_texture_image_2D(
+                    GL_TEXTURE_2D,
+                    static_cast<s32>(i),
+                    format,
+                    levels[i].width,
+                    levels[i].height,
+                    0,
+                    levels[i].size,
+                    levels[i].data);
+            }
+
+            opengl::api::instance().bind_texture(GL_TEXTURE_2D, 0);
+
+            // bookkeeping
+            g_ctx.stats.textures++;
+
+            return texture_id;
+        }
+
         //-------------------------------------------------------------------------
         void update_image_item(u32 id, f32 x, f32 y, f32 width, f32 height, s32 channels, u8* data)
         {
@@ -780,6 +1171,97 @@ namespace ppp
             opengl::api::instance().bind_texture(GL_TEXTURE_2D, 0);
         }
 
+        //-------------------------------------------------------------------------
+        void update_image_item_region(u32 id, s32 x, s32 y, s32 width, s32 height, s32 row_length, s32 channels, const u8* data)
+        {
+            GLint format = GL_RGBA;
+
+            switch (channels)
+            {
+            case 1:
+                format = GL_RED;
+                break;
+            case 2:
+                format = GL_RG;
+                break;
+            case 3:
+                format = GL_RGB;
+                break;
+            case 4:
+                format = GL_RGBA;
+                break;
+            default:
+                assert(false);
+            }
+
+            opengl::api::instance().bind_texture(GL_TEXTURE_2D, id);
+            opengl::api::instance().pixel_store_i(GL_UNPACK_ROW_LENGTH, row_length);
+            opengl::api::instance().texture_sub_image_2D(
+                GL_TEXTURE_2D,
+                0,
+                x,
+                y,
+                width,
+                height,
+                format,
+                GL_UNSIGNED_BYTE,
+                data);
+
+            opengl::api::instance().pixel_store_i(GL_UNPACK_ROW_LENGTH, 0);
+            opengl::api::instance().bind_texture(GL_TEXTURE_2D, 0);
+        }
+
+        //-------------------------------------------------------------------------
+        void delete_image_item(u32 id)
+        {
+            opengl::api::instance().delete_textures(1, &id);
+
+            // bookkeeping
+            g_ctx.stats.textures--;
+        }
+
+        //-------------------------------------------------------------------------
+        void evict_image_item(u32 id)
+        {
+            // A 1x1 level replaces the storage, the sampling parameters stay with the texture
+            opengl::api::instance().bind_texture(GL_TEXTURE_2D, id);
+            opengl::api::instance().texture_image_2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            opengl::api::instance().bind_texture(GL_TEXTURE_2D, 0);
+        }
+
+        //-------------------------------------------------------------------------
+        void restore_image_item(u32 id, f32 width, f32 height, s32 channels, const u8* data)
+        {
+            GLint format = GL_RGBA8;
+            GLint usage = GL_RGBA;
+
+            switch (channels)
+            {
+            case 1:
+                format = GL_R8;
+                usage = GL_RED;
+                break;
+            case 2:
+                format = GL_RG8;
+                usage = GL_RG;
+                break;
+            case 3:
+                format = GL_RGB8;
+                usage = GL_RGB;
+                break;
+            case 4:
+                format = GL_RGBA8;
+                usage = GL_RGBA;
+                break;
+            default:
+                assert(false);
+            }
+
+            opengl::api::instance().bind_texture(GL_TEXTURE_2D, id);
+            opengl::api::instance().texture_image_2D(GL_TEXTURE_2D, 0, format, static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0, usage, GL_UNSIGNED_BYTE, data);
+            opengl::api::instance().bind_texture(GL_TEXTURE_2D, 0);
+        }
+
         //-------------------------------------------------------------------------
         void read_pixels(s32 x, s32 y, s32 width, s32 height, u8* data)
         {
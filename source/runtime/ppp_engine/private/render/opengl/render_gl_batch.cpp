@@ -17,16 +17,145 @@
 #include "util/types.h"
 #include "util/log.h"
 #include "util/pointer_math.h"
+#include "util/hash.h"
 
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <limits>
+
 namespace ppp
 {
     namespace render
     {
         using batch_arr = std::vector<batch>;
 
+        //-------------------------------------------------------------------------
+        // Submesh with only the vertices its indices reference, batches copy every vertex of an item
+        class compacted_submesh_item : public irender_item
+        {
+        public:
+            //-------------------------------------------------------------------------
+            void assign(const irender_item* item)
+            {
+                m_item = item;
+
+                // The compacted vertices differ per submesh, batches tell them apart by their geometry id
+                m_submesh_id = utils::hash_combine(utils::hash_combine(static_cast<size_t>(item->geometry_id()), item->first_index()), item->index_count());
+
+                m_positions.clear();
+                m_normals.clear();
+                m_uvs.clear();
+                m_faces.clear();
+
+                if (m_vertex_remap.size() < item->vertex_count())
+                {
+                    m_vertex_remap.resize(item->vertex_count(), s_unused_vertex);
+                }
+
+                const face* first_face = item->first_face();
+                const u64 face_count = item->index_count() / 3;
+
+                m_faces.reserve(face_count);
+
+                for (u64 f = 0; f < face_count; ++f)
+                {
+                    face compacted;
+                    for (u64 i = 0; i < compacted.size(); ++i)
+                    {
+                        const index source = first_face[f][i];
+                        if (m_vertex_remap[source] == s_unused_vertex)
+                        {
+                            m_vertex_remap[source] = static_cast<index>(m_positions.size());
+
+                            m_positions.push_back(item->vertex_positions()[source]);
+                            if (!item->vertex_normals().empty())
+                            {
+                                m_normals.push_back(item->vertex_normals()[source]);
+                            }
+                            if (!item->vertex_uvs().empty())
+                            {
+                                m_uvs.push_back(item->vertex_uvs()[source]);
+                            }
+                        }
+
+                        compacted[i] = m_vertex_remap[source];
+                    }
+
+                    m_faces.push_back(compacted);
+                }
+
+                // Only the entries of this submesh were written, the next one starts from a clean table again
+                for (u64 f = 0; f < face_count; ++f)
+                {
+                    for (index source : first_face[f])
+                    {
+                        m_vertex_remap[source] = s_unused_vertex;
+                    }
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            bool has_smooth_normals() const override { return m_item->has_smooth_normals(); }
+            bool has_textures() const override { return m_item->has_textures(); }
+            bool cast_shadows() const override { return m_item->cast_shadows(); }
+
+            u32 vertex_count() const override { return static_cast<u32>(m_positions.size()); }
+            u32 index_count() const override { return static_cast<u32>(m_faces.size() * 3); }
+
+            const std::vector<glm::vec3>& vertex_positions() const override { return m_positions; }
+            const std::vector<glm::vec3>& vertex_normals() const override { return m_normals; }
+            const std::vector<glm::vec2>& vertex_uvs() const override { return m_uvs; }
+
+            const std::vector<face>& faces() const override { return m_faces; }
+
+            const u64 geometry_id() const override { return m_submesh_id; }
+            const u64 material_id() const override { return m_item->material_id(); }
+
+            const resources::imaterial* material() const override { return m_item->material(); }
+
+            const geometry::bounding_box* local_bounds() const override { return m_item->local_bounds(); }
+
+            // Vertices are remapped, an edit of the geometry changes the whole submesh
+            dirty_vertex_range dirty_vertices() const override
+            {
+                const dirty_vertex_range changes = m_item->dirty_vertices();
+
+                return { changes.revision, changes.base_revision, 0, vertex_count() };
+            }
+
+            glm::vec4 uv_rect() const override { return m_item->uv_rect(); }
+
+        private:
+            static constexpr index s_unused_vertex = std::numeric_limits<index>::max();
+
+            const irender_item* m_item = nullptr;
+            u64 m_submesh_id = 0;
+
+            std::vector<glm::vec3> m_positions;
+            std::vector<glm::vec3> m_normals;
+            std::vector<glm::vec2> m_uvs;
+            std::vector<face> m_faces;
+
+            // Vertex of the geometry to vertex of the submesh
+            std::vector<index> m_vertex_remap;
+        };
+
+        //-------------------------------------------------------------------------
+        // Vertices of an item as they were uploaded during the previous frame
+        struct uploaded_item
+        {
+            u64 geometry_id;
+            u64 revision;
+            u32 first_vertex;
+            u32 vertex_count;
+            s32 material_id;
+            glm::vec4 color;
+            glm::vec4 uv_rect;
+            glm::mat4 world;
+        };
+
         //-------------------------------------------------------------------------
         // Buffer Manager
         class batch_buffer_manager
@@ -44,6 +173,9 @@ namespace ppp
 
                 assert(layouts != nullptr);
                 assert(layout_count > 0);
+
+                // Batches are rebuilt every frame, only vertices of items that differ from the previous frame are uploaded
+                m_vertex_buffer.enable_explicit_invalidation();
             }
 
             //-------------------------------------------------------------------------
@@ -66,10 +198,18 @@ namespace ppp
                 copy_vertex_data(item, material_id, color);
                 transform_vertex_positions(start_index, end_index, world);
 
+                const glm::vec4 uv_rect = item->uv_rect();
+                if (m_vertex_buffer.has_layout(attribute_type::TEXCOORD) && uv_rect != full_uv_rect())
+                {
+                    transform_vertex_uvs(start_index, end_index, uv_rect);
+                }
+
                 if (m_vertex_buffer.has_layout(attribute_type::NORMAL))
                 {
                     transform_vertex_normals(start_index, end_index, world);
                 }
+
+                invalidate_changed_vertices(item, static_cast<u32>(start_index), material_id, color, world);
             }
             //-------------------------------------------------------------------------
             void add_indices(const irender_item* item)
@@ -100,12 +240,17 @@ namespace ppp
             {
                 m_vertex_buffer.reset();
                 m_index_buffer.reset();
+
+                m_item_count = 0;
             }
             //-------------------------------------------------------------------------
             void release()
             {
                 m_vertex_buffer.free();
                 m_index_buffer.free();
+
+                m_uploaded_items.clear();
+                m_item_count = 0;
             }
 
             //-------------------------------------------------------------------------
@@ -127,6 +272,52 @@ namespace ppp
             const void* indices() const { return m_index_buffer.data(); }
 
         private:
+            //-------------------------------------------------------------------------
+            // The same item on the same vertices as last frame only uploads the vertices its geometry reported as edited
+            void invalidate_changed_vertices(const irender_item* item, u32 first_vertex, s32 material_id, const glm::vec4& color, const glm::mat4& world)
+            {
+                const dirty_vertex_range changes = item->dirty_vertices();
+                const uploaded_item current = { item->geometry_id(), changes.revision, first_vertex, item->vertex_count(), material_id, color, item->uv_rect(), world };
+
+                if (m_item_count == m_uploaded_items.size())
+                {
+                    m_uploaded_items.push_back(current);
+                    ++m_item_count;
+
+                    m_vertex_buffer.invalidate(first_vertex, current.vertex_count);
+                    return;
+                }
+
+                uploaded_item& previous = m_uploaded_items[m_item_count++];
+
+                const bool same_vertices = previous.geometry_id == current.geometry_id
+                    && previous.first_vertex == current.first_vertex
+                    && previous.vertex_count == current.vertex_count
+                    && previous.material_id == current.material_id
+                    && previous.color == current.color
+                    && previous.uv_rect == current.uv_rect
+                    && previous.world == current.world;
+
+                if (!same_vertices)
+                {
+                    m_vertex_buffer.invalidate(first_vertex, current.vertex_count);
+                }
+                else if (previous.revision != current.revision)
+                {
+                    if (changes.base_revision == previous.revision && changes.count > 0 && changes.first < current.vertex_count)
+                    {
+                        m_vertex_buffer.invalidate(first_vertex + changes.first, std::min(changes.count, current.vertex_count - changes.first));
+                    }
+                    else
+                    {
+                        // We missed one or more edits, upload the whole item
+                        m_vertex_buffer.invalidate(first_vertex, current.vertex_count);
+                    }
+                }
+
+                previous = current;
+            }
+
             //-------------------------------------------------------------------------
             void copy_vertex_data(const irender_item* item, s32 material_id, const glm::vec4& color)
             {
@@ -178,7 +369,7 @@ namespace ppp
 
                 assert(sizeof(item->faces()[0][0]) == sizeof(index) && "different index size was used");
 
-                index_buffer_ops::set_index_data(ias, item->faces().data());
+                index_buffer_ops::set_index_data(ias, item->first_face());
             }
 
             //-------------------------------------------------------------------------
@@ -206,6 +397,14 @@ namespace ppp
                 });
             }
             //-------------------------------------------------------------------------
+            void transform_vertex_uvs(u64 start_index, u64 end_index, const glm::vec4& uv_rect)
+            {
+                vertex_buffer_ops::transform_attribute_data<glm::vec2>(m_vertex_buffer, attribute_type::TEXCOORD, start_index, end_index, [&](glm::vec2& uv)
+                {
+                    uv = transform_uv(uv_rect, uv);
+                });
+            }
+            //-------------------------------------------------------------------------
             void transform_vertex_diffuse_texture_ids(u64 start_index, u64 end_index, s32 sampler_id)
             {
                 vertex_buffer_ops::transform_attribute_data<s32>(m_vertex_buffer, attribute_type::MATERIAL_INDEX, start_index, end_index, [&](s32& id)
@@ -228,6 +427,9 @@ namespace ppp
 
             vertex_buffer m_vertex_buffer;
             index_buffer m_index_buffer;
+
+            std::vector<uploaded_item> m_uploaded_items;
+            u64 m_item_count = 0;
         };
 
         //-------------------------------------------------------------------------
@@ -615,6 +817,9 @@ namespace ppp
 
             batch_arr                   batches         = {};
 
+            // Scratch item for submeshes, reused by every append
+            compacted_submesh_item      submesh         = {};
+
             const attribute_layout*     layouts         = nullptr;
             const u64                   layout_count    = 0;
         };
@@ -640,6 +845,13 @@ namespace ppp
                 log::error("render item does not have vertices");
                 exit(EXIT_FAILURE);
             }
+
+            // A submesh only takes up room for the vertices it references
+            if (item->index_count() != 0 && !item->draws_all_faces())
+            {
+                m_pimpl->submesh.assign(item);
+                item = &m_pimpl->submesh;
+            }
             
             if (m_pimpl->batches[m_pimpl->push_batch].can_add(item->vertex_count(), item->index_count()))
             {
@@ -6,6 +6,7 @@
 #include "string/string_conversions.h"
 
 #include <glad/glad.h>
+#include <algorithm>
 #include <assert.h>
 #include <sstream>
 
@@ -1111,6 +1112,73 @@ namespace ppp
 
                 GL_CALL(glBufferSubData(target, offset, size, data));
             }
+            //-------------------------------------------------------------------------
+            void* function_library::map_buffer_range(u32 target, s64 offset, s64 length, u32 access)
+            {
+                GL_LOG("glMapBufferRange");
+#if ENABLE_GL_PARAMETER_LOGGING && ENABLE_GL_FUNCTION_LOGGING
+                GL_LOG("\ttarget: {0}", buffer_target_to_string(target));
+                GL_LOG("\toffset: {0}", offset);
+                GL_LOG("\tlength: {0}", length);
+                GL_LOG("\taccess: {0}", access);
+#endif
+
+                void* result = nullptr;
+
+                GL_CALL(result = glMapBufferRange(target, offset, length, access));
+
+                return result;
+            }
+            //-------------------------------------------------------------------------
+            bool function_library::unmap_buffer(u32 target)
+            {
+                GL_LOG("glUnmapBuffer");
+#if ENABLE_GL_PARAMETER_LOGGING && ENABLE_GL_FUNCTION_LOGGING
+                GL_LOG("\ttarget: {0}", buffer_target_to_string(target));
+#endif
+
+                GLboolean result = GL_FALSE;
+
+                GL_CALL(result = glUnmapBuffer(target));
+
+                return result == GL_TRUE;
+            }
+
+            //-------------------------------------------------------------------------
+            // Synchronization
+            //-------------------------------------------------------------------------
+            u64 function_library::fence_sync(u32 condition, u32 flags)
+            {
+                GL_LOG("glFenceSync");
+
+                GLsync sync = nullptr;
+
+                GL_CALL(sync = glFenceSync(condition, flags));
+
+                return reinterpret_cast<u64>(sync);
+            }
+            //-------------------------------------------------------------------------
+            u32 function_library::client_wait_sync(u64 sync, u32 flags, u64 timeout)
+            {
+                GL_LOG("glClientWaitSync");
+#if ENABLE_GL_PARAMETER_LOGGING && ENABLE_GL_FUNCTION_LOGGING
+                GL_LOG("\tsync: {0}", sync);
+                GL_LOG("\ttimeout: {0}", timeout);
+#endif
+
+                u32 result = GL_WAIT_FAILED;
+
+                GL_CALL(result = glClientWaitSync(reinterpret_cast<GLsync>(sync), flags, timeout));
+
+                return result;
+            }
+            //-------------------------------------------------------------------------
+            void function_library::delete_sync(u64 sync)
+            {
+                GL_LOG("glDeleteSync");
+
+                GL_CALL(glDeleteSync(reinterpret_cast<GLsync>(sync)));
+            }
 
             //-------------------------------------------------------------------------
             // Textures
@@ -1194,6 +1262,23 @@ namespace ppp
                 GL_CALL(glTexSubImage2D(target, level, xoffset, yoffset, gsl::narrow<GLsizei>(width), gsl::narrow<GLsizei>(height), format, type, data));
             }
             //-------------------------------------------------------------------------
+            void function_library::compressed_texture_image_2D(u32 target, s32 level, u32 internalformat, u64 width, u64 height, s32 border, u64 image_size, const void* data)
+            {
+                GL_LOG("glCompressedTexImage2D");
+#if ENABLE_GL_PARAMETER_LOGGING && ENABLE_GL_FUNCTION_LOGGING
+                GL_LOG("\ttarget: {0}", texture_target_to_string(target));
+                GL_LOG("\tlevel: {0}", level);
+                GL_LOG("\tinternal format: {0}", internalformat);
+                GL_LOG("\twidth: {0}", width);
+                GL_LOG("\theight: {0}", height);
+                GL_LOG("\tborder: {0}", border);
+                GL_LOG("\timage size: {0}", image_size);
+                GL_LOG("\tdata: {0}", fmt::ptr(data));
+#endif
+
+                GL_CALL(glCompressedTexImage2D(target, level, internalformat, gsl::narrow<GLsizei>(width), gsl::narrow<GLsizei>(height), border, gsl::narrow<GLsizei>(image_size), data));
+            }
+            //-------------------------------------------------------------------------
             void function_library::set_texture_integer_parameter(u32 target, u32 pname, s32 param)
             {
                 GL_LOG("glTexParameteri");
@@ -1647,6 +1732,70 @@ namespace ppp
             //-------------------------------------------------------------------------
             // MOCK FUNCTION LIBRARY
             //-------------------------------------------------------------------------
+            // Upload Statistics
+            //-------------------------------------------------------------------------
+            static u64 texel_size_in_bytes(u32 format, u32 type)
+            {
+                if (type == GL_UNSIGNED_INT_24_8)
+                {
+                    return 4;
+                }
+
+                u64 component_count = 0;
+                switch (format)
+                {
+                case GL_RED: // fallthrough
+                case GL_RED_INTEGER:
+                case GL_DEPTH_COMPONENT:    component_count = 1; break;
+                case GL_RG:                 component_count = 2; break;
+                case GL_RGB: // fallthrough
+                case GL_BGR:                component_count = 3; break;
+                case GL_RGBA: // fallthrough
+                case GL_BGRA:               component_count = 4; break;
+                default:
+                    assert(false && "Unsupported texture format");
+                    break;
+                }
+
+                u64 component_size = 0;
+                switch (type)
+                {
+                case GL_BYTE: // fallthrough
+                case GL_UNSIGNED_BYTE:      component_size = 1; break;
+                case GL_SHORT: // fallthrough
+                case GL_UNSIGNED_SHORT: 
+                case GL_HALF_FLOAT:         component_size = 2; break;
+                case GL_INT: // fallthrough
+                case GL_UNSIGNED_INT:
+                case GL_FLOAT:              component_size = 4; break;
+                default:
+                    assert(false && "Unsupported texture data type");
+                    break;
+                }
+
+                return component_count * component_size;
+            }
+            //-------------------------------------------------------------------------
+            const upload_statistics& mock_function_library::upload_stats() const
+            {
+                return m_upload_stats;
+            }
+            //-------------------------------------------------------------------------
+            void mock_function_library::reset_upload_stats()
+            {
+                m_upload_stats = {};
+            }
+            //-------------------------------------------------------------------------
+            void mock_function_library::signal_fences()
+            {
+                m_signaled_fence = m_next_fence - 1;
+            }
+            //-------------------------------------------------------------------------
+            void mock_function_library::set_read_pixels_value(u8 value)
+            {
+                m_read_pixels_value = value;
+            }
+            //-------------------------------------------------------------------------
             // General
             //-------------------------------------------------------------------------
             void mock_function_library::viewport(s32 x, s32 y, s32 width, s32 height)
@@ -1691,6 +1840,18 @@ namespace ppp
                 GL_LOG("\tformat: {0}", format_to_string(format));
                 GL_LOG("\ttype: {0}", pixeltype_to_string(type));
 #endif
+                // With a pixel pack buffer bound `data` is an offset into that buffer
+                auto it = m_pack_buffers.find(m_bound_pack_buffer);
+                if (it != m_pack_buffers.end())
+                {
+                    const u64 offset = reinterpret_cast<u64>(data);
+                    const u64 size = static_cast<u64>(width) * height * texel_size_in_bytes(format, type);
+
+                    if (offset + size <= it->second.size())
+                    {
+                        std::fill(it->second.begin() + offset, it->second.begin() + offset + size, m_read_pixels_value);
+                    }
+                }
             }
 
             //-------------------------------------------------------------------------
@@ -2144,6 +2305,10 @@ namespace ppp
                 GL_LOG("\tcount: {0}", count);
                 GL_LOG("\tbuffers: {0}", fmt::ptr(buffers));
 #endif
+                for (u64 i = 0; i < count; ++i)
+                {
+                    m_pack_buffers.erase(buffers[i]);
+                }
             }
             //-------------------------------------------------------------------------
             void mock_function_library::generate_buffers(u64 count, u32* buffers)
@@ -2153,6 +2318,10 @@ namespace ppp
                 GL_LOG("\tcount: {0}", count);
                 GL_LOG("\tbuffers: {0}", fmt::ptr(buffers));
 #endif
+                for (u64 i = 0; i < count; ++i)
+                {
+                    buffers[i] = m_next_buffer_id++;
+                }
             }
             //-------------------------------------------------------------------------
             void mock_function_library::bind_buffer(u32 target, u32 index)
@@ -2162,6 +2331,10 @@ namespace ppp
                 GL_LOG("\ttarget: {0}", buffer_target_to_string(target));
                 GL_LOG("\tindex: {0}", index);
 #endif
+                if (target == GL_PIXEL_PACK_BUFFER)
+                {
+                    m_bound_pack_buffer = index;
+                }
             }
             //-------------------------------------------------------------------------
             void mock_function_library::bind_buffer_base(u32 target, u32 index, u32 buffer)
@@ -2183,6 +2356,16 @@ namespace ppp
                 GL_LOG("\tdata: {0}", fmt::ptr(data));
                 GL_LOG("\tusage: {0}", buffer_usage_to_string(usage));
 #endif
+                if (target == GL_PIXEL_PACK_BUFFER && m_bound_pack_buffer != 0)
+                {
+                    m_pack_buffers[m_bound_pack_buffer].assign(size, 0);
+                }
+
+                if (data != nullptr)
+                {
+                    ++m_upload_stats.buffer_uploads;
+                    m_upload_stats.buffer_bytes += size;
+                }
             }
             //-------------------------------------------------------------------------
             void mock_function_library::buffer_sub_data(u32 target, s64 offset, s64 size, const void* data)
@@ -2194,6 +2377,63 @@ namespace ppp
                 GL_LOG("\tsize: {0}", size);
                 GL_LOG("\tdata: {0}", fmt::ptr(data));
 #endif
+                if (data != nullptr)
+                {
+                    ++m_upload_stats.buffer_uploads;
+                    m_upload_stats.buffer_bytes += size;
+                }
+            }
+            //-------------------------------------------------------------------------
+            void* mock_function_library::map_buffer_range(u32 target, s64 offset, s64 length, u32 access)
+            {
+                GL_LOG("glMapBufferRange");
+#if ENABLE_GL_PARAMETER_LOGGING && ENABLE_GL_FUNCTION_LOGGING
+                GL_LOG("\ttarget: {0}", buffer_target_to_string(target));
+                GL_LOG("\toffset: {0}", offset);
+                GL_LOG("\tlength: {0}", length);
+                GL_LOG("\taccess: {0}", access);
+#endif
+                auto it = m_pack_buffers.find(m_bound_pack_buffer);
+                if (target != GL_PIXEL_PACK_BUFFER || it == m_pack_buffers.end() || offset + length > static_cast<s64>(it->second.size()))
+                {
+                    return nullptr;
+                }
+
+                return it->second.data() + offset;
+            }
+            //-------------------------------------------------------------------------
+            bool mock_function_library::unmap_buffer(u32 target)
+            {
+                GL_LOG("glUnmapBuffer");
+#if ENABLE_GL_PARAMETER_LOGGING && ENABLE_GL_FUNCTION_LOGGING
+                GL_LOG("\ttarget: {0}", buffer_target_to_string(target));
+#endif
+                return true;
+            }
+
+            //-------------------------------------------------------------------------
+            // Synchronization
+            //-------------------------------------------------------------------------
+            u64 mock_function_library::fence_sync(u32 condition, u32 flags)
+            {
+                GL_LOG("glFenceSync");
+
+                return m_next_fence++;
+            }
+            //-------------------------------------------------------------------------
+            u32 mock_function_library::client_wait_sync(u64 sync, u32 flags, u64 timeout)
+            {
+                GL_LOG("glClientWaitSync");
+#if ENABLE_GL_PARAMETER_LOGGING && ENABLE_GL_FUNCTION_LOGGING
+                GL_LOG("\tsync: {0}", sync);
+                GL_LOG("\ttimeout: {0}", timeout);
+#endif
+                return sync <= m_signaled_fence ? GL_ALREADY_SIGNALED : GL_TIMEOUT_EXPIRED;
+            }
+            //-------------------------------------------------------------------------
+            void mock_function_library::delete_sync(u64 sync)
+            {
+                GL_LOG("glDeleteSync");
             }
 
             //-------------------------------------------------------------------------
@@ -2215,6 +2455,10 @@ namespace ppp
                 GL_LOG("\tcount: {0}", count);
                 GL_LOG("\ttextures: {0}", fmt::ptr(textures));
 #endif
+                for (u64 i = 0; i < count; ++i)
+                {
+                    textures[i] = m_next_texture_id++;
+                }
             }
             //-------------------------------------------------------------------------
             void mock_function_library::activate_texture(u32 texture)
@@ -2248,6 +2492,11 @@ namespace ppp
                 GL_LOG("\ttype: {0}", pixeltype_to_string(type));
                 GL_LOG("\tdata: {0}", fmt::ptr(data));
 #endif
+                if (data != nullptr)
+                {
+                    ++m_upload_stats.texture_uploads;
+                    m_upload_stats.texture_bytes += width * height * texel_size_in_bytes(format, type);
+                }
             }
             //-------------------------------------------------------------------------
             void mock_function_library::texture_sub_image_2D(u32 target, s32 level, s32 xoffset, s32 yoffset, u64 width, u64 height, u32 format, u32 type, const void* data)
@@ -2264,6 +2513,31 @@ namespace ppp
                 GL_LOG("\ttype: {0}", pixeltype_to_string(type));
                 GL_LOG("\tdata: {0}", fmt::ptr(data));
 #endif
+                if (data != nullptr)
+                {
+                    ++m_upload_stats.texture_uploads;
+                    m_upload_stats.texture_bytes += width * height * texel_size_in_bytes(format, type);
+                }
+            }
+            //-------------------------------------------------------------------------
+            void mock_function_library::compressed_texture_image_2D(u32 target, s32 level, u32 internalformat, u64 width, u64 height, s32 border, u64 image_size, const void* data)
+            {
+                GL_LOG("glCompressedTexImage2D");
+#if ENABLE_GL_PARAMETER_LOGGING && ENABLE_GL_FUNCTION_LOGGING
+                GL_LOG("\ttarget: {0}", texture_target_to_string(target));
+                GL_LOG("\tlevel: {0}", level);
+                GL_LOG("\tinternal format: {0}", internalformat);
+                GL_LOG("\twidth: {0}", width);
+                GL_LOG("\theight: {0}", height);
+                GL_LOG("\tborder: {0}", border);
+                GL_LOG("\timage size: {0}", image_size);
+                GL_LOG("\tdata: {0}", fmt::ptr(data));
+#endif
+                if (data != nullptr)
+                {
+                    ++m_upload_stats.texture_uploads;
+                    m_upload_stats.texture_bytes += image_size;
+                }
             }
             //-------------------------------------------------------------------------
             void mock_function_library::set_texture_integer_parameter(u32 target, u32 pname, s32 param)
@@ -2,6 +2,9 @@
 
 #include "util/types.h"
 
+#include <unordered_map>
+#include <vector>
+
 namespace ppp
 {
     namespace render
@@ -83,6 +86,13 @@ namespace ppp
                 virtual void bind_buffer_base(u32 target, u32 index, u32 buffer) = 0;
                 virtual void buffer_data(u32 target, u32 size, const void* data, u32 usage) = 0;
                 virtual void buffer_sub_data(u32 target, s64 offset, s64 size, const void* data) = 0;
+                virtual void* map_buffer_range(u32 target, s64 offset, s64 length, u32 access) = 0;
+                virtual bool unmap_buffer(u32 target) = 0;
+
+                // Synchronization, fences are passed around as opaque handles
+                virtual u64 fence_sync(u32 condition, u32 flags) = 0;
+                virtual u32 client_wait_sync(u64 sync, u32 flags, u64 timeout) = 0;
+                virtual void delete_sync(u64 sync) = 0;
 
                 // Textures
                 virtual void delete_textures(u64 count, const u32* textures) = 0;
@@ -91,6 +101,7 @@ namespace ppp
                 virtual void bind_texture(u32 target, u32 texture) = 0;
                 virtual void texture_image_2D(u32 target, s32 level, s32 internalformat, u64 width, u64 height, s32 border, u32 format, u32 type, const void* data) = 0;
                 virtual void texture_sub_image_2D(u32 target, s32 level, s32 xoffset, s32 yoffset, u64 width, u64 height, u32 format, u32 type, const void* data) = 0;
+                virtual void compressed_texture_image_2D(u32 target, s32 level, u32 internalformat, u64 width, u64 height, s32 border, u64 image_size, const void* data) = 0;
                 virtual void set_texture_integer_parameter(u32 target, u32 pname, s32 param) = 0;
                 virtual void set_texture_float_array_parameter(u32 target, u32 pname, f32* param) = 0;
 
@@ -215,6 +226,13 @@ namespace ppp
                 void bind_buffer_base(u32 target, u32 index, u32 buffer) override;
                 void buffer_data(u32 target, u32 size, const void* data, u32 usage) override;
                 void buffer_sub_data(u32 target, s64 offset, s64 size, const void* data) override;
+                void* map_buffer_range(u32 target, s64 offset, s64 length, u32 access) override;
+                bool unmap_buffer(u32 target) override;
+
+                // Synchronization
+                u64 fence_sync(u32 condition, u32 flags) override;
+                u32 client_wait_sync(u64 sync, u32 flags, u64 timeout) override;
+                void delete_sync(u64 sync) override;
 
                 // Textures
                 void delete_textures(u64 count, const u32* textures) override;
@@ -223,6 +241,7 @@ namespace ppp
                 void bind_texture(u32 target, u32 texture) override;
                 void texture_image_2D(u32 target, s32 level, s32 internalformat, u64 width, u64 height, s32 border, u32 format, u32 type, const void* data) override;
                 void texture_sub_image_2D(u32 target, s32 level, s32 xoffset, s32 yoffset, u64 width, u64 height, u32 format, u32 type, const void* data) override;
+                void compressed_texture_image_2D(u32 target, s32 level, u32 internalformat, u64 width, u64 height, s32 border, u64 image_size, const void* data) override;
                 void set_texture_integer_parameter(u32 target, u32 pname, s32 param) override;
                 void set_texture_float_array_parameter(u32 target, u32 pname, f32* param) override;
 
@@ -271,11 +290,29 @@ namespace ppp
                 void uniform_1uiv(s32 location, u64 count, const u32* x) override;
             };
 
+            // Amount of data that was handed to the driver, only tracked by the mock library
+            struct upload_statistics
+            {
+                u64 buffer_uploads = 0;
+                u64 buffer_bytes = 0;
+
+                u64 texture_uploads = 0;
+                u64 texture_bytes = 0;
+            };
+
             class mock_function_library : public ifunction_library
             {
             public:
                 ~mock_function_library() override = default;
 
+                // Statistics
+                const upload_statistics& upload_stats() const;
+                void reset_upload_stats();
+
+                // Readback, fences only signal when asked to so GPU latency can be simulated
+                void signal_fences();
+                void set_read_pixels_value(u8 value);
+
                 // General
                 void viewport(s32 x, s32 y, s32 width, s32 height) override;
                 void scissor(s32 x, s32 y, s64 width, s64 height) override;
@@ -347,6 +384,13 @@ namespace ppp
                 void bind_buffer_base(u32 target, u32 index, u32 buffer) override;
                 void buffer_data(u32 target, u32 size, const void* data, u32 usage) override;
                 void buffer_sub_data(u32 target, s64 offset, s64 size, const void* data) override;
+                void* map_buffer_range(u32 target, s64 offset, s64 length, u32 access) override;
+                bool unmap_buffer(u32 target) override;
+
+                // Synchronization
+                u64 fence_sync(u32 condition, u32 flags) override;
+                u32 client_wait_sync(u64 sync, u32 flags, u64 timeout) override;
+                void delete_sync(u64 sync) override;
 
                 // Textures
                 void delete_textures(u64 count, const u32* textures) override;
@@ -355,6 +399,7 @@ namespace ppp
                 void bind_texture(u32 target, u32 texture) override;
                 void texture_image_2D(u32 target, s32 level, s32 internalformat, u64 width, u64 height, s32 border, u32 format, u32 type, const void* data) override;
                 void texture_sub_image_2D(u32 target, s32 level, s32 xoffset, s32 yoffset, u64 width, u64 height, u32 format, u32 type, const void* data) override;
+                void compressed_texture_image_2D(u32 target, s32 level, u32 internalformat, u64 width, u64 height, s32 border, u64 image_size, const void* data) override;
                 void set_texture_integer_parameter(u32 target, u32 pname, s32 param) override;
                 void set_texture_float_array_parameter(u32 target, u32 pname, f32* param) override;
 
@@ -401,6 +446,20 @@ namespace ppp
                 void uniform_1iv(s32 location, u64 count, const s32* x) override;
                 void uniform_1ui(s32 location, u32 x) override;
                 void uniform_1uiv(s32 location, u64 count, const u32* x) override;
+
+            private:
+                upload_statistics m_upload_stats;
+
+                // Storage of pixel pack buffers, `read_pixels` fills the bound buffer with `m_read_pixels_value`
+                std::unordered_map<u32, std::vector<u8>> m_pack_buffers;
+                u32 m_bound_pack_buffer = 0;
+                u32 m_next_buffer_id = 1;
+                u32 m_next_texture_id = 1;
+                u8 m_read_pixels_value = 0;
+
+                // Fences signal in order, every fence up to `m_signaled_fence` is done
+                u64 m_next_fence = 1;
+                u64 m_signaled_fence = 0;
             };
         }
     }
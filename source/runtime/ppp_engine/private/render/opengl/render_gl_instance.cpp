@@ -22,6 +22,7 @@
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp >
 
+#include <algorithm>
 #include <numeric>
 
 namespace ppp
@@ -42,20 +43,29 @@ namespace ppp
             {
                 constexpr u64 total_size_in_bytes = sizeof(s32)   // material index
                     + sizeof(glm::mat4)                           // model matrix of the geometry
-                    + sizeof(glm::vec4);                          // color of the geometry
+                    + sizeof(glm::vec4)                           // color of the geometry
+                    + sizeof(glm::vec4);                          // part of the texture the uvs are mapped into
 
                 return total_size_in_bytes;
             }
         };
 
+        //-------------------------------------------------------------------------
+        // Part of the indices of an instance ( a submesh ) with the instances that draw it
+        struct instance_range
+        {
+            u32             first_index;
+            u32             index_count;
+            storage_buffer  instance_buffer;
+        };
+
         class instance_buffer_manager
         {
         public:
             //-------------------------------------------------------------------------
             instance_buffer_manager(const irender_item* instance, const attribute_layout* layouts, u32 layout_count)
                 : m_vertex_buffer(instance->vertex_count(), layouts, layout_count)
-                , m_index_buffer(instance->index_count())
-                , m_instance_buffer(s_instance_data_initial_capacity, instance_storage::size_in_bytes(), 0)
+                , m_index_buffer(static_cast<u32>(instance->faces().size() * 3))
             {
 
             }
@@ -63,13 +73,13 @@ namespace ppp
             //-------------------------------------------------------------------------
             bool has_data() const
             {
-                return (m_vertex_buffer.active_element_count() > 0 || m_index_buffer.active_element_count() > 0) && m_instance_buffer.active_element_count() > 0;
+                return (m_vertex_buffer.active_element_count() > 0 || m_index_buffer.active_element_count() > 0) && active_instance_count() > 0;
             }
 
             //-------------------------------------------------------------------------
-            void add_instance_data(s32 material_id, const glm::vec4& color, const glm::mat4& world)
+            void add_instance_data(const irender_item* item, s32 material_id, const glm::vec4& color, const glm::mat4& world)
             {
-                copy_instance_data(material_id, color, world);
+                copy_instance_data(find_or_add_range(item).instance_buffer, material_id, color, world, item->uv_rect());
             }
             //-------------------------------------------------------------------------
             void add_vertices(const irender_item* item)
@@ -78,35 +88,53 @@ namespace ppp
             }
 
             //-------------------------------------------------------------------------
-            void add_indices(const irender_item* item)
+            void update_vertices(const irender_item* item, u64 first_vertex, u64 vertex_count)
             {
-                assert(!item->faces().empty());
+                assert(item->vertex_count() == m_vertex_buffer.active_element_count() && "vertex count of an instance cannot change");
 
-                u64 start_index = m_index_buffer.active_element_count();
-                u64 end_index = start_index + item->index_count();
+                if (m_vertex_buffer.has_layout(attribute_type::POSITION))
+                {
+                    vertex_buffer_ops::update_attribute_data(m_vertex_buffer, attribute_type::POSITION, first_vertex, vertex_count, item->vertex_positions().data() + first_vertex);
+                }
 
-                copy_index_data(item);
+                if (m_vertex_buffer.has_layout(attribute_type::NORMAL) && item->vertex_normals().empty() == false)
+                {
+                    vertex_buffer_ops::update_attribute_data(m_vertex_buffer, attribute_type::NORMAL, first_vertex, vertex_count, item->vertex_normals().data() + first_vertex);
+                }
 
-                transform_index_locations(start_index, end_index, m_vertex_buffer.active_element_count());
+                if (m_vertex_buffer.has_layout(attribute_type::TEXCOORD) && item->vertex_uvs().empty() == false)
+                {
+                    vertex_buffer_ops::update_attribute_data(m_vertex_buffer, attribute_type::TEXCOORD, first_vertex, vertex_count, item->vertex_uvs().data() + first_vertex);
+                }
             }
 
             //-------------------------------------------------------------------------
-            void bind() const
+            // All faces of the geometry are stored once, submeshes draw their part of them
+            void add_indices(const irender_item* item)
             {
-                m_instance_buffer.bind();
+                assert(!item->faces().empty());
+
+                copy_index_data(item);
             }
 
             //-------------------------------------------------------------------------
             void unbind() const
             {
-                m_instance_buffer.unbind();
+                if (!m_ranges.empty())
+                {
+                    m_ranges.front().instance_buffer.unbind();
+                }
             }
 
             //-------------------------------------------------------------------------
             void submit() const
             {
                 m_vertex_buffer.submit();
-                m_instance_buffer.submit();
+
+                for (const instance_range& range : m_ranges)
+                {
+                    range.instance_buffer.submit();
+                }
 
                 if (active_index_count() != 0)
                 {
@@ -114,6 +142,36 @@ namespace ppp
                 }
             }
 
+            //-------------------------------------------------------------------------
+            // One draw per range, every range binds its own instance data
+            void draw(GLenum gl_topology) const
+            {
+                for (const instance_range& range : m_ranges)
+                {
+                    const u32 instance_count = range.instance_buffer.active_element_count();
+                    if (instance_count == 0)
+                    {
+                        continue;
+                    }
+
+                    range.instance_buffer.bind();
+
+                    if (active_index_count() != 0)
+                    {
+#ifndef NDEBUG
+                        check_drawing_type(range.index_count, gl_topology);
+#endif
+                        const void* first_index = reinterpret_cast<const void*>(static_cast<u64>(range.first_index) * sizeof(index));
+
+                        opengl::api::instance().draw_elements_instanced(gl_topology, range.index_count, gl_index_type(), first_index, instance_count);
+                    }
+                    else
+                    {
+                        opengl::api::instance().draw_arrays_instanced(gl_topology, 0, active_vertex_count(), instance_count);
+                    }
+                }
+            }
+
             //-------------------------------------------------------------------------
             void reset() const
             {   
@@ -125,14 +183,21 @@ namespace ppp
                 // m_vertex_buffer.reset();
                 // m_index_buffer.reset();
 
-                m_instance_buffer.reset();
+                for (const instance_range& range : m_ranges)
+                {
+                    range.instance_buffer.reset();
+                }
             }
             //-------------------------------------------------------------------------
             void release() const
             {
                 m_vertex_buffer.free();
                 m_index_buffer.free();
-                m_instance_buffer.free();
+
+                for (const instance_range& range : m_ranges)
+                {
+                    range.instance_buffer.free();
+                }
             }
 
             //-------------------------------------------------------------------------
@@ -141,11 +206,36 @@ namespace ppp
             u64 active_index_count() const { return m_index_buffer.active_element_count(); }
             u64 active_indices_byte_size() const { return m_index_buffer.total_buffer_size_in_bytes(); }
 
+            //-------------------------------------------------------------------------
+            u32 active_instance_count() const
+            {
+                return std::accumulate(m_ranges.cbegin(), m_ranges.cend(), 0u, [](u32 sum, const instance_range& range) { return sum + range.instance_buffer.active_element_count(); });
+            }
+            u64 range_count() const { return m_ranges.size(); }
+
             //-------------------------------------------------------------------------
             const void* vertices() const { return m_vertex_buffer.data(); }
             const void* indices() const { return m_index_buffer.data(); }
 
         private:
+            //-------------------------------------------------------------------------
+            instance_range& find_or_add_range(const irender_item* item)
+            {
+                auto it = std::find_if(m_ranges.begin(), m_ranges.end(), [item](const instance_range& range)
+                {
+                    return range.first_index == item->first_index() && range.index_count == item->index_count();
+                });
+
+                if (it != m_ranges.end())
+                {
+                    return *it;
+                }
+
+                m_ranges.push_back({ item->first_index(), item->index_count(), storage_buffer(s_instance_data_initial_capacity, instance_storage::size_in_bytes(), 0) });
+
+                return m_ranges.back();
+            }
+
             //-------------------------------------------------------------------------
             void copy_vertex_data(const irender_item* item)
             {
@@ -187,38 +277,29 @@ namespace ppp
             //-------------------------------------------------------------------------
             void copy_index_data(const irender_item* item)
             {
-                index_buffer_ops::index_addition_scope ias(m_index_buffer, item->index_count());
+                index_buffer_ops::index_addition_scope ias(m_index_buffer, static_cast<u32>(item->faces().size() * 3));
 
                 assert(sizeof(item->faces()[0][0]) == sizeof(index) && "different index size was used");
 
                 index_buffer_ops::set_index_data(ias, item->faces().data());
             }
             //-------------------------------------------------------------------------
-            void copy_instance_data(s32 material_id, const glm::vec4& color, const glm::mat4& world)
+            void copy_instance_data(storage_buffer& instance_buffer, s32 material_id, const glm::vec4& color, const glm::mat4& world, const glm::vec4& uv_rect)
             {
-                storage_buffer_ops::storage_data_addition_scope sdas(m_instance_buffer, 1);
+                storage_buffer_ops::storage_data_addition_scope sdas(instance_buffer, 1);
 
-                std::vector<u8> instance_data(m_instance_buffer.element_size_in_bytes());
+                std::vector<u8> instance_data(instance_buffer.element_size_in_bytes());
 
                 size_t offset = 0;
 
                 offset = copy_material_index(material_id, instance_data.data(), offset);
                 offset = copy_world_matrix(world, instance_data.data(), offset);
                 offset = copy_color(color, instance_data.data(), offset);
+                offset = copy_uv_rect(uv_rect, instance_data.data(), offset);
 
                 storage_buffer_ops::set_storage_data(sdas, instance_data.data());
             }
 
-            //-------------------------------------------------------------------------
-            void transform_index_locations(u64 start_index, u64 end_index, u64 offset)
-            {
-                index_buffer_ops::transform_index_data(m_index_buffer, start_index, end_index,
-                    [&](index& index)
-                {
-                    index += offset;
-                });
-            }
-
         private:
             //-------------------------------------------------------------------------
             size_t copy_material_index(s32 material_index, u8* buffer, u64 offset)
@@ -259,10 +340,24 @@ namespace ppp
 
                 return offset;
             }
+            //-------------------------------------------------------------------------
+            size_t copy_uv_rect(const glm::vec4& uv_rect, u8* buffer, u64 offset)
+            {
+                // For more info on why alignment is 16 see:
+                // https://www.khronos.org/opengl/wiki/Interface_Block_(GLSL)
+                const s32 alignment = 16;
+
+                offset = memory::align_up(offset, alignment); // Align for `vec4`.
+                std::memcpy(buffer + offset, &uv_rect, sizeof(glm::vec4));
+                offset += sizeof(glm::vec4);
+
+                return offset;
+            }
 
             vertex_buffer   m_vertex_buffer;
             index_buffer    m_index_buffer;
-            storage_buffer  m_instance_buffer;
+
+            std::vector<instance_range> m_ranges;
         };
 
         //-------------------------------------------------------------------------
@@ -426,6 +521,7 @@ namespace ppp
         public:
             impl(const irender_item* instance, const attribute_layout* layouts, u32 layout_count)
                 :m_instance_id(instance->geometry_id())
+                ,m_geometry_revision(instance->dirty_vertices().revision)
             {
                 assert(layouts != nullptr);
                 assert(layout_count > 0);
@@ -462,7 +558,6 @@ namespace ppp
             {
                 opengl::api::instance().bind_vertex_array(m_vao);
 
-                m_buffer_manager->bind();
                 m_material_manager->bind();
             }
 
@@ -493,20 +588,30 @@ namespace ppp
             //-------------------------------------------------------------------------
             void draw(topology_type topology) const
             {
-                GLenum gl_topology = gl_topology_type(topology);
+                m_buffer_manager->draw(gl_topology_type(topology));
+            }
 
-#ifndef NDEBUG
-                check_drawing_type(m_buffer_manager->active_index_count(), gl_topology);
-#endif
+            //-------------------------------------------------------------------------
+            void sync_geometry(const irender_item* item)
+            {
+                const dirty_vertex_range changes = item->dirty_vertices();
+                if (changes.revision == m_geometry_revision)
+                {
+                    return;
+                }
 
-                if (m_buffer_manager->active_index_count() != 0)
+                if (changes.base_revision == m_geometry_revision && changes.count > 0)
                 {
-                    opengl::api::instance().draw_elements_instanced(gl_topology, m_buffer_manager->active_index_count(), gl_index_type(), nullptr, m_instance_count);
+                    // Only the vertices edited since our last sync have to be uploaded
+                    m_buffer_manager->update_vertices(item, changes.first, changes.count);
                 }
                 else
                 {
-                    opengl::api::instance().draw_arrays_instanced(gl_topology, 0, m_buffer_manager->active_vertex_count(), m_instance_count);
+                    // We missed one or more edits ( eg. the geometry was not drawn for a while ), upload everything
+                    m_buffer_manager->update_vertices(item, 0, item->vertex_count());
                 }
+
+                m_geometry_revision = changes.revision;
             }
 
             //-------------------------------------------------------------------------
@@ -518,7 +623,7 @@ namespace ppp
 
                     if (material_id != -1)
                     {
-                        m_buffer_manager->add_instance_data(material_id, color, world);
+                        m_buffer_manager->add_instance_data(item, material_id, color, world);
                     }
                     else
                     {
@@ -528,12 +633,12 @@ namespace ppp
                 }
                 else
                 {
-                    m_buffer_manager->add_instance_data(-1, color, world);
+                    m_buffer_manager->add_instance_data(item, -1, color, world);
                 }
             }
 
             u64 m_instance_id = 0;
-            s32 m_instance_count = 0;
+            u64 m_geometry_revision = 0;
 
             std::unique_ptr<instance_buffer_manager> m_buffer_manager;
             std::unique_ptr<instance_material_manager> m_material_manager;
@@ -576,22 +681,15 @@ namespace ppp
             m_pimpl->draw(topology);
         }
 
-        //-------------------------------------------------------------------------
-        void instance::increment_instance_count() const
-        {
-            ++m_pimpl->m_instance_count;
-        }
-
         //-------------------------------------------------------------------------
         void instance::append(const irender_item* item, const glm::vec4& color, const glm::mat4& world) const
         {
+            m_pimpl->sync_geometry(item);
             m_pimpl->append(item, color, world);
         }
         //-------------------------------------------------------------------------
         void instance::reset() const
         {
-            m_pimpl->m_instance_count = 0;
-
             m_pimpl->m_buffer_manager->reset();
             m_pimpl->m_material_manager->reset();
         }
@@ -614,6 +712,11 @@ namespace ppp
         {
             return m_pimpl->m_instance_id;
         }
+        //-------------------------------------------------------------------------
+        u64 instance::range_count() const
+        {
+            return m_pimpl->m_buffer_manager->range_count();
+        }
 
         //-------------------------------------------------------------------------
         const void* instance::vertices() const { return m_pimpl->m_buffer_manager->vertices(); }
@@ -670,6 +773,8 @@ namespace ppp
             auto it = std::find_if(std::begin(m_pimpl->instances), std::end(m_pimpl->instances),
                 [item](const instance& inst)
             {
+                // Submeshes of the same geometry share an instance, each of them draws its own part of the indices
+                // Items that draw another part of their texture share it as well, the uv rect is part of the instance data
                 bool is_equal = inst.instance_id() == item->geometry_id();
                 return is_equal;
             });
@@ -687,7 +792,6 @@ namespace ppp
                 new_instance = &(*it);
             }
 
-            new_instance->increment_instance_count();
             new_instance->append(item, color, world);
         }
 
@@ -714,6 +818,26 @@ namespace ppp
             m_pimpl->draw_instance = 0;
         }
 
+        //-------------------------------------------------------------------------
+        void instance_drawing_data::release_instance(u64 geometry_id) const
+        {
+            auto it = std::find_if(std::begin(m_pimpl->instances), std::end(m_pimpl->instances),
+                [geometry_id](const instance& inst)
+            {
+                return inst.instance_id() == geometry_id;
+            });
+
+            if (it != std::end(m_pimpl->instances))
+            {
+                it->reset();
+                it->release();
+
+                m_pimpl->instances.erase(it);
+            }
+
+            m_pimpl->draw_instance = 0;
+        }
+
         //-------------------------------------------------------------------------
         const instance* instance_drawing_data::first_instance() const
         {
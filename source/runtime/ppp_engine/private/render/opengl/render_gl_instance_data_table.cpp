@@ -32,6 +32,14 @@ namespace ppp
             }
         }
         //-------------------------------------------------------------------------
+        void instance_data_table::release_instance(u64 geometry_id)
+        {
+            for (auto& pair : m_instances)
+            {
+                pair.second.release_instance(geometry_id);
+            }
+        }
+        //-------------------------------------------------------------------------
         void instance_data_table::append(topology_type topology, const irender_item* item, const glm::vec4& color, const glm::mat4& world)
         {
             if (m_instances.find(topology) == std::cend(m_instances))
@@ -203,22 +203,12 @@ namespace ppp
 
                 auto& dir_light = lights_pool::directional_lights()[0];
 
-                const glm::vec3 light_pos_active = -dir_light.direction * 500.0f;
-
                 const auto shadow_framebuffer = framebuffer_pool::get(framebuffer_pool::tags::shadow_map(), framebuffer_flags::SAMPLED_DEPTH);
 
-                constexpr f32 near_plane = 0.01f;
-                constexpr f32 far_plane = 1000.0f;
-
-                const glm::mat4 light_active_p = glm::ortho(
-                    static_cast<f32>(-shadow_framebuffer->width()) / 2.0f,
-                    static_cast<f32>(shadow_framebuffer->width()) / 2.0f,
-                    static_cast<f32>(-shadow_framebuffer->height()) / 2.0f,
-                    static_cast<f32>(shadow_framebuffer->height()) / 2.0f,
-                    near_plane,
-                    far_plane);
-                const glm::mat4 light_active_v = glm::lookAt(light_pos_active, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
-                const glm::mat4 light_active_vp = light_active_p * light_active_v;
+                const glm::mat4 light_active_vp = lights_pool::directional_light_view_proj(
+                    dir_light,
+                    static_cast<f32>(shadow_framebuffer->width()),
+                    static_cast<f32>(shadow_framebuffer->height()));
 
                 push_all_shadow_dependent_uniforms(shader_program(), light_active_vp);
             }
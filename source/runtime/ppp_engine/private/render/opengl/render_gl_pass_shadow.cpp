@@ -73,14 +73,10 @@ namespace ppp
 
             auto& dir_light = lights_pool::directional_lights()[0];
 
-            const glm::vec3 light_pos_active = -dir_light.direction * 500.0f;
-
-            const f32 near_plane = 0.01f;
-            const f32 far_plane = 1000.0f;
-
-            const glm::mat4 light_active_p = glm::ortho(-framebuffer()->width() / 2.0f, framebuffer()->width() / 2.0f, -framebuffer()->height() / 2.0f, framebuffer()->height() / 2.0f, near_plane, far_plane);;
-            const glm::mat4 light_active_v = glm::lookAt(light_pos_active, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
-            const glm::mat4 light_active_vp = light_active_p * light_active_v;
+            const glm::mat4 light_active_vp = lights_pool::directional_light_view_proj(
+                dir_light,
+                static_cast<f32>(framebuffer()->width()),
+                static_cast<f32>(framebuffer()->height()));
 
             push_all_shape_dependent_uniforms(shader_program(), light_active_vp);
         }
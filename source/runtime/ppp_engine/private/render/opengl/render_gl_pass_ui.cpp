@@ -48,7 +48,7 @@ namespace ppp
 
                 const u64 reserved_slot = texture_pool::reserved_white_slot();
                 opengl::api::instance().activate_texture(GL_TEXTURE0 + offset * reserved_slot);
-                opengl::api::instance().bind_texture(GL_TEXTURE_2D, texture_pool::image_solid_white()->image_id);
+                opengl::api::instance().bind_texture(GL_TEXTURE_2D, texture_pool::image_solid_white()->texture_id);
 
                 for (u64 i = 0; i < texture_size; ++i)
                 {
@@ -80,7 +80,7 @@ namespace ppp
 
                 const u64 reserved_slot = texture_pool::reserved_white_slot();
                 opengl::api::instance().activate_texture(GL_TEXTURE0 + offset * reserved_slot);
-                opengl::api::instance().bind_texture(GL_TEXTURE_2D, texture_pool::image_solid_white()->image_id);
+                opengl::api::instance().bind_texture(GL_TEXTURE_2D, texture_pool::image_solid_white()->texture_id);
 
                 for (u64 i = 0; i < texture_size; ++i)
                 {
@@ -0,0 +1,239 @@
+#include "render/render_readback.h"
+#include "render/opengl/render_gl_api.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace ppp
+{
+    namespace render
+    {
+        namespace readback
+        {
+            struct queued_read
+            {
+                u32                 id = 0;
+
+                s32                 x = 0;
+                s32                 y = 0;
+                s32                 width = 0;
+                s32                 height = 0;
+
+                readback_callback   callback;
+            };
+
+            //-------------------------------------------------------------------------
+            // A pixel buffer and the read that is in flight in it, `id` is 0 when the buffer is free
+            struct readback_slot
+            {
+                u32                 buffer = 0;
+                u64                 capacity = 0;
+
+                u32                 id = 0;
+                u64                 fence = 0;
+                u64                 frame = 0;
+
+                s32                 width = 0;
+                s32                 height = 0;
+
+                readback_callback   callback;
+            };
+
+            struct context
+            {
+                std::vector<readback_slot>  slots;
+                std::vector<queued_read>    queue;
+
+                u64                         frame = 0;
+                u32                         next_id = 1;
+            } g_ctx;
+
+            namespace internal
+            {
+                //-------------------------------------------------------------------------
+                readback_slot& acquire_slot()
+                {
+                    auto it = std::find_if(g_ctx.slots.begin(), g_ctx.slots.end(), [](const readback_slot& slot) { return slot.id == 0; });
+                    if (it != g_ctx.slots.end())
+                    {
+                        return *it;
+                    }
+
+                    readback_slot slot;
+                    opengl::api::instance().generate_buffers(1, &slot.buffer);
+
+                    g_ctx.slots.push_back(slot);
+
+                    return g_ctx.slots.back();
+                }
+
+                //-------------------------------------------------------------------------
+                bool is_signaled(u64 fence)
+                {
+                    const u32 status = opengl::api::instance().client_wait_sync(fence, 0, 0);
+
+                    return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+                }
+
+                //-------------------------------------------------------------------------
+                void deliver(readback_slot& slot)
+                {
+                    const u64 size = static_cast<u64>(slot.width) * slot.height * 4;
+
+                    opengl::api::instance().delete_sync(slot.fence);
+
+                    opengl::api::instance().bind_buffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+                    const u8* pixels = static_cast<const u8*>(opengl::api::instance().map_buffer_range(GL_PIXEL_PACK_BUFFER, 0, static_cast<s64>(size), GL_MAP_READ_BIT));
+
+                    // The slot is released before the callback runs, the callback is free to request another read
+                    readback_callback callback = std::move(slot.callback);
+                    const s32 width = slot.width;
+                    const s32 height = slot.height;
+
+                    slot.id = 0;
+                    slot.fence = 0;
+                    slot.callback = nullptr;
+
+                    if (pixels != nullptr && callback)
+                    {
+                        callback(pixels, width, height);
+                    }
+
+                    opengl::api::instance().unmap_buffer(GL_PIXEL_PACK_BUFFER);
+                    opengl::api::instance().bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            u32 request(s32 x, s32 y, s32 width, s32 height, readback_callback callback)
+            {
+                if (width <= 0 || height <= 0)
+                {
+                    return 0;
+                }
+
+                const u32 id = g_ctx.next_id++;
+
+                g_ctx.queue.push_back({ id, x, y, width, height, std::move(callback) });
+
+                return id;
+            }
+
+            //-------------------------------------------------------------------------
+            void flush()
+            {
+                for (queued_read& read : g_ctx.queue)
+                {
+                    readback_slot& slot = internal::acquire_slot();
+
+                    const u64 size = static_cast<u64>(read.width) * read.height * 4;
+
+                    opengl::api::instance().bind_buffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+                    if (slot.capacity < size)
+                    {
+                        opengl::api::instance().buffer_data(GL_PIXEL_PACK_BUFFER, static_cast<u32>(size), nullptr, GL_STREAM_READ);
+                        slot.capacity = size;
+                    }
+
+                    // With a pixel pack buffer bound the copy happens on the GPU, `data` is an offset into the buffer
+                    opengl::api::instance().read_pixels(read.x, read.y, read.width, read.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+                    opengl::api::instance().bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+
+                    slot.id = read.id;
+                    slot.fence = opengl::api::instance().fence_sync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                    slot.frame = g_ctx.frame;
+                    slot.width = read.width;
+                    slot.height = read.height;
+                    slot.callback = std::move(read.callback);
+                }
+
+                g_ctx.queue.clear();
+
+                ++g_ctx.frame;
+            }
+
+            //-------------------------------------------------------------------------
+            void update()
+            {
+                std::vector<u64> ready;
+
+                for (u64 i = 0; i < g_ctx.slots.size(); ++i)
+                {
+                    const readback_slot& slot = g_ctx.slots[i];
+
+                    if (slot.id != 0 && g_ctx.frame >= slot.frame + frame_latency && internal::is_signaled(slot.fence))
+                    {
+                        ready.push_back(i);
+                    }
+                }
+
+                // Reads are delivered in the order they were requested
+                std::sort(ready.begin(), ready.end(), [](u64 a, u64 b) { return g_ctx.slots[a].id < g_ctx.slots[b].id; });
+
+                for (u64 index : ready)
+                {
+                    internal::deliver(g_ctx.slots[index]);
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            void finish()
+            {
+                if (!g_ctx.queue.empty())
+                {
+                    flush();
+                }
+
+                std::vector<u64> in_flight;
+
+                for (u64 i = 0; i < g_ctx.slots.size(); ++i)
+                {
+                    if (g_ctx.slots[i].id != 0)
+                    {
+                        in_flight.push_back(i);
+                    }
+                }
+
+                std::sort(in_flight.begin(), in_flight.end(), [](u64 a, u64 b) { return g_ctx.slots[a].id < g_ctx.slots[b].id; });
+
+                // Mapping the buffer waits for the copy to complete
+                for (u64 index : in_flight)
+                {
+                    internal::deliver(g_ctx.slots[index]);
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            void terminate()
+            {
+                for (readback_slot& slot : g_ctx.slots)
+                {
+                    if (slot.id != 0)
+                    {
+                        opengl::api::instance().delete_sync(slot.fence);
+                    }
+
+                    opengl::api::instance().delete_buffers(1, &slot.buffer);
+                }
+
+                g_ctx.slots.clear();
+                g_ctx.queue.clear();
+            }
+
+            //-------------------------------------------------------------------------
+            bool is_pending(u32 id)
+            {
+                return std::any_of(g_ctx.slots.begin(), g_ctx.slots.end(), [id](const readback_slot& slot) { return slot.id == id; })
+                    || std::any_of(g_ctx.queue.begin(), g_ctx.queue.end(), [id](const queued_read& read) { return read.id == id; });
+            }
+
+            //-------------------------------------------------------------------------
+            u64 buffer_count()
+            {
+                return g_ctx.slots.size();
+            }
+        }
+    }
+}
@@ -404,6 +404,7 @@ namespace ppp
                                 {"int", "material_idx"},
                                 {"mat4", "mat_model"},
                                 {"vec4", "color"},
+                                {"vec4", "uv_rect"},
                             })
 
                         .add_ssbo("instance_buffer", "instance_data", "instances", 0, true)
@@ -499,6 +500,7 @@ namespace ppp
                                 {"int", "material_idx"},
                                 {"mat4", "mat_model"},
                                 {"vec4", "color"},
+                                {"vec4", "uv_rect"},
                             })
 
                         .add_ssbo("instance_buffer", "instance_data", "instances", 0, true)
@@ -514,7 +516,7 @@ namespace ppp
                         .set_main_function_body(R"(
                         instance_data data = instances[gl_InstanceID];
                         v_tint_color = u_wireframe ? u_wireframe_color : data.color;
-                        v_texture = a_texture;
+                        v_texture = data.uv_rect.xy + a_texture * data.uv_rect.zw;
                         v_material_idx = data.material_idx;
                         gl_Position = u_view_proj * data.mat_model * vec4(a_position, 1.0);
                     )").build();
@@ -644,6 +646,7 @@ namespace ppp
                                 {"int", "material_idx"},
                                 {"mat4", "mat_model"},
                                 {"vec4", "color"},
+                                {"vec4", "uv_rect"},
                             })
 
                         .add_ssbo("instance_buffer", "instance_data", "instances", 0, true)
@@ -702,6 +705,7 @@ namespace ppp
                                 {"int", "material_idx"},
                                 {"mat4", "mat_model"},
                                 {"vec4", "color"},
+                                {"vec4", "uv_rect"},
                             })
 
                         .add_ssbo("instance_buffer", "instance_data", "instances", 0, true)
@@ -755,6 +759,7 @@ namespace ppp
                                 {"int", "material_idx"},
                                 {"mat4", "mat_model"},
                                 {"vec4", "color"},
+                                {"vec4", "uv_rect"},
                             })
 
                         .add_ssbo("instance_buffer", "instance_data", "instances", 0, true)
@@ -865,6 +870,7 @@ namespace ppp
                                 {"int", "material_idx"},
                                 {"mat4", "mat_model"},
                                 {"vec4", "color"},
+                                {"vec4", "uv_rect"},
                             })
 
                         .add_ssbo("instance_buffer", "instance_data", "instances", 0, true)
@@ -1008,6 +1014,7 @@ namespace ppp
                                 {"int", "material_idx"},
                                 {"mat4", "mat_model"},
                                 {"vec4", "color"},
+                                {"vec4", "uv_rect"},
                             })
 
                         .add_ssbo("instance_buffer", "instance_data", "instances", 0, true)
@@ -1029,7 +1036,7 @@ namespace ppp
                         v_position = a_position;  
                         v_normal = a_normal;
                         v_tint_color = u_wireframe ? u_wireframe_color : data.color;
-                        v_texture = a_texture;
+                        v_texture = data.uv_rect.xy + a_texture * data.uv_rect.zw;
                         v_material_idx = data.material_idx;
                         v_light_position = u_light_vp * vec4(a_position, 1.0);   
                         gl_Position = u_view_proj * data.mat_model * vec4(a_position, 1.0);
@@ -1132,6 +1139,7 @@ namespace ppp
                                 {"int", "material_idx"},
                                 {"mat4", "mat_model"},
                                 {"vec4", "color"},
+                                {"vec4", "uv_rect"},
                             })
 
                         .add_ssbo("instance_buffer", "instance_data", "instances", 0, true)
@@ -6,6 +6,9 @@
 
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <limits>
+
 namespace ppp
 {
     namespace render
@@ -113,31 +116,61 @@ namespace ppp
             }
 
             //-------------------------------------------------------------------------
-            void submit() const
+            void submit()
             {
-                if (current_vertex_count == previous_vertex_count)
+                u32 first_vertex = previous_vertex_count;
+                u32 last_vertex = current_vertex_count;
+
+                // Ensure that current_vertex_count hasn't decreased unexpectedly.
+                assert(current_vertex_count >= previous_vertex_count && "Current vertex count decreased unexpectedly.");
+
+                if (explicit_invalidation)
+                {
+                    // Vertices that are already on the GPU are only uploaded again when they were invalidated
+                    first_vertex = std::min(std::max(first_vertex, uploaded_vertex_count), last_vertex);
+                    uploaded_vertex_count = std::max(uploaded_vertex_count, last_vertex);
+                }
+
+                if (invalid_first_vertex < invalid_last_vertex)
                 {
-                    // No new vertices have been added, skip upload
+                    // Vertices that were already uploaded have been modified, merge them with the newly added vertices
+                    const bool has_new_vertices = first_vertex != last_vertex;
+
+                    first_vertex = has_new_vertices ? std::min(first_vertex, invalid_first_vertex) : invalid_first_vertex;
+                    last_vertex = has_new_vertices ? std::max(last_vertex, invalid_last_vertex) : invalid_last_vertex;
+                    last_vertex = std::min(last_vertex, current_vertex_count);
+
+                    invalid_first_vertex = std::numeric_limits<u32>::max();
+                    invalid_last_vertex = 0;
+                }
+
+                if (first_vertex >= last_vertex)
+                {
+                    // No new or modified vertices, skip upload
                     return;
                 }
 
                 const u64 vertex_buffer_byte_size = calculate_total_size_layout(layouts, layout_count);
 
-                // Ensure that current_vertex_count hasn't decreased unexpectedly.
-                assert(current_vertex_count >= previous_vertex_count && "Current vertex count decreased unexpectedly.");
-
                 bind();
 
-                const u64 buffer_offset = previous_vertex_count * vertex_buffer_byte_size;
+                const u64 buffer_offset = first_vertex * vertex_buffer_byte_size;
                 assert(buffer_offset == static_cast<u32>(buffer_offset));
-                const u64 buffer_size = (current_vertex_count - previous_vertex_count) * vertex_buffer_byte_size;
+                const u64 buffer_size = (last_vertex - first_vertex) * vertex_buffer_byte_size;
                 assert(buffer_size == static_cast<u32>(buffer_size));
 
                 opengl::api::instance().buffer_sub_data(
                     GL_ARRAY_BUFFER,
                     static_cast<u32>(buffer_offset),
                     static_cast<u32>(buffer_size),
-                    buffer.data());
+                    buffer.data() + buffer_offset);
+            }
+
+            //-------------------------------------------------------------------------
+            void invalidate(u32 first_vertex, u32 count)
+            {
+                invalid_first_vertex = std::min(invalid_first_vertex, first_vertex);
+                invalid_last_vertex = std::max(invalid_last_vertex, first_vertex + count);
             }
 
             //-------------------------------------------------------------------------
@@ -149,9 +182,15 @@ namespace ppp
             u32                             vertex_count;
             u32                             current_vertex_count;
             u32                             max_elements_to_set;
+
+            u32                             invalid_first_vertex = std::numeric_limits<u32>::max();
+            u32                             invalid_last_vertex = 0;
             
             std::vector<u8>                 buffer;
 
+            bool                            explicit_invalidation = false;
+            u32                             uploaded_vertex_count = 0;
+
             u32                             vbo;
         };
 
@@ -198,6 +237,20 @@ namespace ppp
             m_pimpl->previous_vertex_count = m_pimpl->current_vertex_count;
         }
 
+        //-------------------------------------------------------------------------
+        void vertex_buffer::invalidate(u32 first_element, u32 element_count) const
+        {
+            assert(first_element + element_count <= m_pimpl->current_vertex_count && "Invalidating vertices that were never added");
+
+            m_pimpl->invalidate(first_element, element_count);
+        }
+
+        //-------------------------------------------------------------------------
+        void vertex_buffer::enable_explicit_invalidation() const
+        {
+            m_pimpl->explicit_invalidation = true;
+        }
+
         //-------------------------------------------------------------------------
         bool vertex_buffer::can_add(u32 max_elements_to_set) const
         {
@@ -234,6 +287,7 @@ namespace ppp
             reset();
 
             m_pimpl->buffer.clear();
+            m_pimpl->uploaded_vertex_count = 0;
 
             m_pimpl->unbind();
             m_pimpl->free();
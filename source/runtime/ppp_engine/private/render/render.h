@@ -26,6 +26,10 @@ namespace ppp
             s32 instanced_draw_calls = -1;
 
             s32 textures = 0;
+
+            s32 frustum_culled_items = 0;
+            s32 occlusion_culled_items = 0;
+            s32 small_feature_culled_items = 0;
         };
 
         constexpr u32 DEPTH_BUFFER_BIT = 0x00000100;
@@ -66,6 +70,27 @@ namespace ppp
 
         bool shadows_enabled();
 
+        // Culling
+        void enable_frustum_culling();
+        void disable_frustum_culling();
+
+        bool frustum_culling_enabled();
+
+        // Items with a projected size below the threshold ( in pixels ) are skipped, a threshold of 0 disables the test
+        void enable_small_feature_culling(f32 threshold_in_pixels);
+        void disable_small_feature_culling();
+
+        f32 small_feature_culling_threshold();
+
+        void enable_occlusion_culling();
+        void disable_occlusion_culling();
+
+        bool occlusion_culling_enabled();
+
+        // Items submitted in between are rasterized into the occlusion buffer, items submitted afterwards are tested against it
+        void begin_occluders();
+        void end_occluders();
+
         // Shader
         void push_active_shader(string::string_id tag, shading_model_type shading_model, shading_blending_type shading_blending);
 
@@ -81,10 +106,32 @@ namespace ppp
         u32 create_image_item(f32 width, f32 height, s32 channels, const u8* data);
         u32 create_image_item(f32 width, f32 height, s32 channels, const u8* data, image_filter_type filter_type, image_wrap_type wrap_type);
 
+        // Mip levels of a compressed texture, level 0 first
+        struct compressed_image_level
+        {
+            s32 width = 0;
+            s32 height = 0;
+
+            const u8* data = nullptr;
+            u64 size = 0;
+        };
+
+        u32 create_compressed_image_item(image_compression_type compression, const std::vector<compressed_image_level>& levels, image_filter_type filter_type, image_wrap_type wrap_type);
+
         void update_image_item(u32 id, f32 x, f32 y, f32 width, f32 height, s32 channels, u8* data);
+        // Uploads a region of a larger image, `data` points at the first pixel of the region and rows are `row_length` pixels apart
+        void update_image_item_region(u32 id, s32 x, s32 y, s32 width, s32 height, s32 row_length, s32 channels, const u8* data);
+        void delete_image_item(u32 id);
+        // Releases the storage of the texture but keeps its id, `restore_image_item` gives it pixels again
+        void evict_image_item(u32 id);
+        void restore_image_item(u32 id, f32 width, f32 height, s32 channels, const u8* data);
 
         void read_pixels(s32 x, s32 y, s32 width, s32 height, u8* data);
 
+        // Geometry
+        // Releases the instanced buffers of a geometry that was removed, its items are uploaded again when they are drawn later
+        void release_geometry_item(u64 geometry_id);
+
         // Font Item
         void submit_font_item(const irender_item* item);
         void submit_render_item(topology_type topology, const irender_item* item);
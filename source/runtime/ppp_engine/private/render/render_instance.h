@@ -54,12 +54,7 @@ namespace ppp
 
         public:
             /**
-             * @brief Increments the number of active instances.
-             */
-            void increment_instance_count() const;
-
-            /**
-             * @brief Appends a new instance transformation and color.
+             * @brief Appends a new instance transformation and color to the index range of the item.
              */
             void append(const irender_item* item, const glm::vec4& color, const glm::mat4& world) const;
 
@@ -81,6 +76,8 @@ namespace ppp
         public:
             /// @brief Returns the instance ID (geometry ID).
             u64 instance_id() const;
+            /// @brief Returns the number of index ranges ( submeshes ) drawn with separate instance data.
+            u64 range_count() const;
 
             /// @brief Returns a pointer to vertex data.
             const void* vertices() const;
@@ -140,6 +137,11 @@ namespace ppp
              */
             void release() const;
 
+            /**
+             * @brief Releases the instance of a geometry, a later item of the geometry creates a new instance.
+             */
+            void release_instance(u64 geometry_id) const;
+
             /**
              * @brief Returns the first instance (for iteration).
              */
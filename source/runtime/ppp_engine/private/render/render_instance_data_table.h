@@ -55,6 +55,13 @@ namespace ppp
              */
             void clear();
 
+            /**
+             * @brief Releases the instances of a geometry for every topology.
+             *
+             * @param geometry_id Identifier of the geometry that was removed.
+             */
+            void release_instance(u64 geometry_id);
+
             /**
              * @brief Appends a render item into the appropriate instance batch based on topology.
              *
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "geometry/geometry_bounding_box.h"
+
 #include "util/types.h"
 #include "util/log.h"
 
@@ -92,6 +94,28 @@ namespace ppp
             });
         }
 
+        //-------------------------------------------------------------------------
+        // Part of a texture the uvs of an item are mapped into, offset in xy and scale in zw
+        inline glm::vec4 full_uv_rect()
+        {
+            return glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+        }
+
+        //-------------------------------------------------------------------------
+        inline glm::vec2 transform_uv(const glm::vec4& uv_rect, const glm::vec2& uv)
+        {
+            return glm::vec2(uv_rect.x, uv_rect.y) + uv * glm::vec2(uv_rect.z, uv_rect.w);
+        }
+
+        //-------------------------------------------------------------------------
+        struct dirty_vertex_range
+        {
+            u64 revision = 0;       // revision of the geometry, incremented on every edit
+            u64 base_revision = 0;  // revision on top of which the dirty range was collected
+            u32 first = 0;          // first vertex that changed
+            u32 count = 0;          // amount of vertices that changed
+        };
+
         //-------------------------------------------------------------------------
         class irender_item
         {
@@ -115,6 +139,23 @@ namespace ppp
             virtual const u64 material_id() const = 0;
 
             virtual const resources::imaterial* material() const = 0;
+
+            // Items that draw a part of their geometry ( a submesh ) start at this index, `index_count` is the size of that part.
+            // The index is always the start of a face.
+            virtual u32 first_index() const { return 0; }
+            // Faces drawn by the item
+            const face* first_face() const { return faces().data() + first_index() / 3; }
+            // False for submeshes, they draw a part of the faces of their geometry
+            bool draws_all_faces() const { return first_index() == 0 && index_count() == faces().size() * 3; }
+
+            // Bounds in object space, items without bounds are never culled
+            virtual const geometry::bounding_box* local_bounds() const { return nullptr; }
+
+            // Only geometry that can be edited after creation has to report its changes
+            virtual dirty_vertex_range dirty_vertices() const { return {}; }
+
+            // Items that draw a part of a texture ( eg. a frame of a sprite sheet ) share their geometry and transform its uvs
+            virtual glm::vec4 uv_rect() const { return full_uv_rect(); }
         };
 
         namespace conversions
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "util/types.h"
+
+#include <functional>
+
+namespace ppp
+{
+    namespace render
+    {
+        // Asynchronous framebuffer reads.
+        // A read that is requested in frame N is copied into a pixel buffer at the end of that frame and fenced,
+        // the pixels are handed to the callback at the start of frame N + frame_latency ( or later when the GPU is not done yet ), rendering never waits for them.
+        namespace readback
+        {
+            constexpr u64 frame_latency = 2;
+
+            // The pixels are RGBA and only valid during the callback
+            using readback_callback = std::function<void(const u8* pixels, s32 width, s32 height)>;
+
+            // Returns an id to query the read with, 0 when the size is empty
+            u32 request(s32 x, s32 y, s32 width, s32 height, readback_callback callback);
+
+            // Copies the framebuffer for every read that was requested this frame, called at the end of a frame
+            void flush();
+            // Hands finished reads to their callbacks, called at the start of a frame
+            void update();
+            // Copies the queued reads and hands every read in flight to its callback right away, this waits on the GPU
+            void finish();
+
+            void terminate();
+
+            bool is_pending(u32 id);
+
+            // Pixel buffers in the ring, a buffer is reused as soon as its read was delivered
+            u64 buffer_count();
+        }
+    }
+}
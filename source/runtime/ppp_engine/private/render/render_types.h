@@ -48,6 +48,15 @@ namespace ppp
             REPEAT,
         };
 
+        // Block compressed formats, every block covers 4x4 texels
+        enum class image_compression_type
+        {
+            BC1,    // RGB, 8 bytes per block
+            BC3,    // RGBA, 16 bytes per block
+            BC5,    // RG, 16 bytes per block
+            BC7     // RGBA, 16 bytes per block
+        };
+
         enum class render_draw_mode
         {
             INSTANCED,
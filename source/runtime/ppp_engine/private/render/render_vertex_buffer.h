@@ -27,6 +27,11 @@ namespace ppp
             void                            unbind() const;
             void                            submit() const;
 
+            // Re-upload a range of vertices that was already submitted on the next `submit`
+            void                            invalidate(u32 first_element, u32 element_count) const;
+            // Vertices that were uploaded before are only sent again once they are invalidated, for owners that rebuild the same data every frame
+            void                            enable_explicit_invalidation() const;
+
         public:
             bool                            can_add(u32 max_elements_to_set) const;
 
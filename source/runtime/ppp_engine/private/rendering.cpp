@@ -59,4 +59,52 @@ namespace ppp
     {
         render::draw_mode(render::render_draw_mode::BATCHED);
     }
+
+    //-------------------------------------------------------------------------
+    void enable_frustum_culling()
+    {
+        render::enable_frustum_culling();
+    }
+
+    //-------------------------------------------------------------------------
+    void disable_frustum_culling()
+    {
+        render::disable_frustum_culling();
+    }
+
+    //-------------------------------------------------------------------------
+    void enable_small_feature_culling(float pixel_threshold)
+    {
+        render::enable_small_feature_culling(pixel_threshold);
+    }
+
+    //-------------------------------------------------------------------------
+    void disable_small_feature_culling()
+    {
+        render::disable_small_feature_culling();
+    }
+
+    //-------------------------------------------------------------------------
+    void enable_occlusion_culling()
+    {
+        render::enable_occlusion_culling();
+    }
+
+    //-------------------------------------------------------------------------
+    void disable_occlusion_culling()
+    {
+        render::disable_occlusion_culling();
+    }
+
+    //-------------------------------------------------------------------------
+    void begin_occluders()
+    {
+        render::begin_occluders();
+    }
+
+    //-------------------------------------------------------------------------
+    void end_occluders()
+    {
+        render::end_occluders();
+    }
 }
\ No newline at end of file
@@ -1,10 +1,12 @@
 #include "resources/geometry_pool.h"
 
-
+#include "render/render.h"
 
 #include "util/log.h"
 
+#include <algorithm>
 #include <unordered_map>
+#include <vector>
 
 namespace ppp
 {
@@ -20,10 +22,21 @@ namespace ppp
             }
         };
 
+        //-------------------------------------------------------------------------
+        struct triangle_bvh
+        {
+            u64 revision = 0;
+            geometry::bvh bvh;
+        };
+
         //-------------------------------------------------------------------------
         struct context
         {
             std::unordered_map<u64, geometry::geometry, geometry_id_hasher> geometry_map;
+
+            std::vector<u64> dirty_geometry;
+
+            std::unordered_map<u64, triangle_bvh, geometry_id_hasher> triangle_bvh_map;
         } g_ctx;
 
         //-------------------------------------------------------------------------
@@ -36,6 +49,8 @@ namespace ppp
         void terminate()
         {
             g_ctx.geometry_map.clear();
+            g_ctx.dirty_geometry.clear();
+            g_ctx.triangle_bvh_map.clear();
         }
 
         //-------------------------------------------------------------------------
@@ -63,6 +78,18 @@ namespace ppp
             return get_geometry(id);
         }
 
+        //-------------------------------------------------------------------------
+        void remove_geometry(u64 geometry_id)
+        {
+            g_ctx.geometry_map.erase(geometry_id);
+            g_ctx.triangle_bvh_map.erase(geometry_id);
+
+            // The instance renderer keeps the buffers of a geometry until it is told the geometry is gone
+            render::release_geometry_item(geometry_id);
+
+            g_ctx.dirty_geometry.erase(std::remove(std::begin(g_ctx.dirty_geometry), std::end(g_ctx.dirty_geometry), geometry_id), std::end(g_ctx.dirty_geometry));
+        }
+
         //-------------------------------------------------------------------------
         geometry::geometry* get_geometry(std::string_view geometry_id)
         {
@@ -81,5 +108,85 @@ namespace ppp
 
             return nullptr;
         }
+    
+        //-------------------------------------------------------------------------
+        void mark_geometry_dirty(u64 geometry_id)
+        {
+            geometry::geometry* geom = get_geometry(geometry_id);
+            if (geom == nullptr)
+            {
+                return;
+            }
+
+            mark_geometry_dirty(geometry_id, 0, geom->vertex_count());
+        }
+
+        //-------------------------------------------------------------------------
+        void mark_geometry_dirty(u64 geometry_id, u64 first_vertex, u64 vertex_count)
+        {
+            geometry::geometry* geom = get_geometry(geometry_id);
+            if (geom == nullptr)
+            {
+                return;
+            }
+
+            if (!geom->is_dirty())
+            {
+                g_ctx.dirty_geometry.push_back(geometry_id);
+            }
+
+            geom->mark_dirty(first_vertex, vertex_count);
+        }
+
+        //-------------------------------------------------------------------------
+        void clear_dirty_geometry()
+        {
+            for (u64 geometry_id : g_ctx.dirty_geometry)
+            {
+                auto it = g_ctx.geometry_map.find(geometry_id);
+                if (it != std::cend(g_ctx.geometry_map))
+                {
+                    it->second.clear_dirty();
+                }
+            }
+
+            g_ctx.dirty_geometry.clear();
+        }
+
+        //-------------------------------------------------------------------------
+        const geometry::bvh* get_triangle_bvh(u64 geometry_id)
+        {
+            const geometry::geometry* geom = get_geometry(geometry_id);
+            if (geom == nullptr || geom->faces().empty())
+            {
+                return nullptr;
+            }
+
+            auto it = g_ctx.triangle_bvh_map.find(geometry_id);
+            if (it != std::cend(g_ctx.triangle_bvh_map) && it->second.revision == geom->revision())
+            {
+                return &it->second.bvh;
+            }
+
+            const auto& positions = geom->vertex_positions();
+            const auto& faces = geom->faces();
+
+            std::vector<geometry::bounding_box> triangle_bounds(faces.size());
+            for (u64 i = 0; i < faces.size(); ++i)
+            {
+                const glm::vec3& v0 = positions[faces[i][0]];
+                const glm::vec3& v1 = positions[faces[i][1]];
+                const glm::vec3& v2 = positions[faces[i][2]];
+
+                triangle_bounds[i].min = glm::min(v0, glm::min(v1, v2));
+                triangle_bounds[i].max = glm::max(v0, glm::max(v1, v2));
+            }
+
+            triangle_bvh& entry = g_ctx.triangle_bvh_map[geometry_id];
+            entry.revision = geom->revision();
+            entry.bvh.build(triangle_bounds.data(), static_cast<u32>(triangle_bounds.size()));
+
+            return &entry.bvh;
+        }
     }
 }
\ No newline at end of file
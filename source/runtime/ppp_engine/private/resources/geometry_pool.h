@@ -1,6 +1,7 @@
 #pragma once
 
 #include "geometry/geometry.h"
+#include "geometry/geometry_bvh.h"
 
 #include "util/types.h"
 
@@ -17,8 +18,22 @@ namespace ppp
         bool has_geometry(u64 geometry_id);
 
         geometry::geometry* add_new_geometry(geometry::geometry&& geom);
+        void remove_geometry(u64 geometry_id);
 
         geometry::geometry* get_geometry(std::string_view geometry_id);
         geometry::geometry* get_geometry(u64 geometry_id);
+
+        // Mutable geometry
+        // Marks (a range of) the vertices of a geometry as changed, GPU buffers holding this geometry will re-upload only the dirty range.
+        void mark_geometry_dirty(u64 geometry_id);
+        void mark_geometry_dirty(u64 geometry_id, u64 first_vertex, u64 vertex_count);
+
+        // Called at the end of each frame, once every render path had the chance to pick up the changes
+        void clear_dirty_geometry();
+
+        // Picking
+        // Hierarchy over the triangles of a geometry, built on first use and rebuilt once the geometry has been edited.
+        // Returns nullptr for geometry without faces.
+        const geometry::bvh* get_triangle_bvh(u64 geometry_id);
     }
 }
\ No newline at end of file
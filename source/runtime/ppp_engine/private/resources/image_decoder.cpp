@@ -0,0 +1,50 @@
+#include "resources/image_decoder.h"
+
+#include "fileio/fileio.h"
+#include "fileio/file_stamp.h"
+
+#include "util/parallel_for.h"
+
+#include <stb/stb_image.h>
+
+namespace ppp
+{
+    namespace image_decoder
+    {
+        //-------------------------------------------------------------------------
+        texture_pool::image decode(const std::string& path)
+        {
+            auto buffer = fileio::read_resolved_binary_file(path);
+
+            texture_pool::image img;
+            if (buffer.empty())
+            {
+                return img;
+            }
+
+            img.stamp = fileio::read_file_stamp(path);
+            img.content_hash = fileio::content_hash(buffer.data(), buffer.size());
+
+            img.data = stbi_load_from_memory(
+                reinterpret_cast<const stbi_uc*>(buffer.data()),
+                static_cast<int>(buffer.size()),
+                &img.width,
+                &img.height,
+                &img.channels,
+                0);
+
+            return img;
+        }
+
+        //-------------------------------------------------------------------------
+        std::vector<texture_pool::image> decode_all(const std::vector<std::string>& paths, u32 thread_count)
+        {
+            std::vector<texture_pool::image> images(paths.size());
+
+            // Every image is written by exactly one thread
+            parallel_for(paths.size(), [&paths, &images](u64 i) { images[i] = decode(paths[i]); }, thread_count);
+
+            return images;
+        }
+    }
+}
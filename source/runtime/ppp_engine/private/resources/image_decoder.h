@@ -0,0 +1,20 @@
+#pragma once
+
+#include "resources/texture_pool.h"
+
+#include <string>
+#include <vector>
+
+namespace ppp
+{
+    // Decodes image files into pixels, nothing here touches the vfs, the pools or the GPU so it is safe to use from worker threads
+    namespace image_decoder
+    {
+        // Reads and decodes an image at an already resolved path, the image has no data when it could not be decoded.
+        // The stamp and content hash of the file are recorded on the image.
+        texture_pool::image decode(const std::string& path);
+
+        // Decodes every image on `thread_count` threads ( 0 uses every core ), the images are in the same order as the paths
+        std::vector<texture_pool::image> decode_all(const std::vector<std::string>& paths, u32 thread_count = 0);
+    }
+}
@@ -4,6 +4,8 @@
 
 #include "string/string_id.h"
 
+#include <glm/gtc/matrix_transform.hpp>
+
 namespace ppp
 {
     namespace lights_pool
@@ -304,5 +306,19 @@ namespace ppp
         {
             return g_ctx.directional_lights_with_shadow_enabled;
         }
+
+        //-------------------------------------------------------------------------
+        glm::mat4 directional_light_view_proj(const directional_light& light, f32 shadow_map_width, f32 shadow_map_height)
+        {
+            const glm::vec3 light_pos = -light.direction * 500.0f;
+
+            constexpr f32 near_plane = 0.01f;
+            constexpr f32 far_plane = 1000.0f;
+
+            const glm::mat4 light_p = glm::ortho(-shadow_map_width / 2.0f, shadow_map_width / 2.0f, -shadow_map_height / 2.0f, shadow_map_height / 2.0f, near_plane, far_plane);
+            const glm::mat4 light_v = glm::lookAt(light_pos, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
+
+            return light_p * light_v;
+        }
     }
 }
\ No newline at end of file
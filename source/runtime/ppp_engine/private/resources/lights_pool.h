@@ -61,5 +61,8 @@ namespace ppp
 
         bool has_point_lights_with_shadow();
         bool has_directional_lights_with_shadow();
+
+        // View projection used to render ( and sample ) the shadow map of a directional light
+        glm::mat4 directional_light_view_proj(const directional_light& light, f32 shadow_map_width, f32 shadow_map_height);
     }
 }
\ No newline at end of file
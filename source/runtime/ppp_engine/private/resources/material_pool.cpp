@@ -65,6 +65,15 @@ namespace ppp
                 static std::vector<render::texture_id> empty_ids;
                 return empty_ids;
             }
+
+            //-------------------------------------------------------------------------
+            bool is_bound(render::texture_id image)
+            {
+                return std::any_of(std::cbegin(g_ctx.registered_images), std::cend(g_ctx.registered_images), [image](const auto& pair)
+                {
+                    return std::find(std::cbegin(pair.second), std::cend(pair.second), image) != std::cend(pair.second);
+                });
+            }
         }
 
         //-------------------------------------------------------------------------
@@ -16,6 +16,9 @@ namespace ppp
             void reset_images(string::string_id shader_tag);
 
             const std::vector<render::texture_id>& images(string::string_id shader_tag);
+
+            // True while any shader has the texture bound, it can be sampled by every draw until the textures of the shader are reset
+            bool is_bound(render::texture_id image);
         }
 
         bool initialize();
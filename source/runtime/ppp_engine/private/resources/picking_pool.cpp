@@ -0,0 +1,259 @@
+#include "resources/picking_pool.h"
+#include "resources/geometry_pool.h"
+
+#include "geometry/geometry_bvh.h"
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+namespace ppp
+{
+    namespace picking_pool
+    {
+        // Sketches usually submit the same items every frame, the hierarchy is refitted and only rebuilt once in a while
+        constexpr s32 max_refits_before_rebuild = 30;
+
+        //-------------------------------------------------------------------------
+        struct pickable_item
+        {
+            u64 geometry_id;
+            glm::mat4 world;
+
+            // faces drawn by the item, [first_face, first_face + face_count)
+            u32 first_face;
+            u32 face_count;
+        };
+
+        //-------------------------------------------------------------------------
+        struct context
+        {
+            bool enabled = false;
+
+            // items of the frame that is being submitted
+            std::vector<pickable_item> submitted_items;
+            std::vector<geometry::bounding_box> submitted_bounds;
+
+            // items of the last completed frame
+            std::vector<pickable_item> items;
+            std::vector<geometry::bounding_box> bounds;
+
+            geometry::bvh item_bvh;
+            bool item_bvh_dirty = false;
+            s32 item_bvh_refits = 0;
+        } g_ctx;
+
+        //-------------------------------------------------------------------------
+        static geometry::bounding_box transform_bounds(const geometry::bounding_box& local_bounds, const glm::mat4& world)
+        {
+            const glm::vec3 local_center = (local_bounds.min + local_bounds.max) * 0.5f;
+            const glm::vec3 local_extents = (local_bounds.max - local_bounds.min) * 0.5f;
+
+            const glm::vec3 center = glm::vec3(world * glm::vec4(local_center, 1.0f));
+            const glm::vec3 extents =
+                glm::abs(glm::vec3(world[0])) * local_extents.x +
+                glm::abs(glm::vec3(world[1])) * local_extents.y +
+                glm::abs(glm::vec3(world[2])) * local_extents.z;
+
+            geometry::bounding_box world_bounds;
+            world_bounds.min = center - extents;
+            world_bounds.max = center + extents;
+            world_bounds.size = extents * 2.0f;
+            world_bounds.offset = center;
+
+            return world_bounds;
+        }
+
+        //-------------------------------------------------------------------------
+        static bool intersect_bounds(const geometry::bounding_box& bounds, const glm::vec3& ray_origin, const glm::vec3& inv_ray_dir, f32 closest_t, f32& t_out)
+        {
+            const glm::vec3 t1 = (bounds.min - ray_origin) * inv_ray_dir;
+            const glm::vec3 t2 = (bounds.max - ray_origin) * inv_ray_dir;
+
+            const glm::vec3 t_near = glm::min(t1, t2);
+            const glm::vec3 t_far = glm::max(t1, t2);
+
+            const f32 t_min = std::max(std::max(t_near.x, t_near.y), t_near.z);
+            const f32 t_max = std::min(std::min(t_far.x, t_far.y), t_far.z);
+
+            if (t_max < std::max(t_min, 0.0f) || t_min >= closest_t)
+            {
+                return false;
+            }
+
+            // A ray starting inside of the box hits it at its origin
+            t_out = std::max(t_min, 0.0f);
+            return true;
+        }
+
+        //-------------------------------------------------------------------------
+        // The local ray direction is not normalized so distances along it match the distances along the world ray
+        static bool intersect_triangles(const geometry::bvh& triangle_bvh, const pickable_item& item, const glm::vec3& ray_origin, const glm::vec3& ray_dir, f32& closest_t, s64& triangle_index)
+        {
+            const geometry::geometry* geom = geometry_pool::get_geometry(item.geometry_id);
+
+            const auto& positions = geom->vertex_positions();
+            const auto& faces = geom->faces();
+
+            const glm::mat4 inv_world = glm::inverse(item.world);
+            const glm::vec3 local_origin = glm::vec3(inv_world * glm::vec4(ray_origin, 1.0f));
+            const glm::vec3 local_dir = glm::vec3(inv_world * glm::vec4(ray_dir, 0.0f));
+
+            return triangle_bvh.intersect(local_origin, local_dir, closest_t, [&](u32 face_index, f32& t)
+            {
+                // The hierarchy covers the whole geometry, faces of other submeshes are not drawn by this item
+                if (face_index - item.first_face >= item.face_count)
+                {
+                    return false;
+                }
+
+                const render::face& face = faces[face_index];
+
+                f32 triangle_t = 0.0f;
+                if (geometry::ray_intersects_triangle(local_origin, local_dir, positions[face[0]], positions[face[1]], positions[face[2]], triangle_t) && triangle_t < t)
+                {
+                    t = triangle_t;
+                    triangle_index = face_index;
+                    return true;
+                }
+
+                return false;
+            });
+        }
+
+        //-------------------------------------------------------------------------
+        bool initialize()
+        {
+            return true;
+        }
+
+        //-------------------------------------------------------------------------
+        void terminate()
+        {
+            g_ctx.submitted_items.clear();
+            g_ctx.submitted_bounds.clear();
+            g_ctx.items.clear();
+            g_ctx.bounds.clear();
+            g_ctx.item_bvh.clear();
+            g_ctx.item_bvh_dirty = false;
+            g_ctx.item_bvh_refits = 0;
+            g_ctx.enabled = false;
+        }
+
+        //-------------------------------------------------------------------------
+        void enable(bool enabled)
+        {
+            g_ctx.enabled = enabled;
+
+            if (!enabled)
+            {
+                g_ctx.submitted_items.clear();
+                g_ctx.submitted_bounds.clear();
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        bool is_enabled()
+        {
+            return g_ctx.enabled;
+        }
+
+        //-------------------------------------------------------------------------
+        void add_item(u64 geometry_id, const geometry::bounding_box& local_bounds, const glm::mat4& world, u32 first_index, u32 index_count)
+        {
+            g_ctx.submitted_items.push_back({ geometry_id, world, first_index / 3, index_count / 3 });
+            g_ctx.submitted_bounds.push_back(transform_bounds(local_bounds, world));
+        }
+
+        //-------------------------------------------------------------------------
+        void end_frame()
+        {
+            std::swap(g_ctx.items, g_ctx.submitted_items);
+            std::swap(g_ctx.bounds, g_ctx.submitted_bounds);
+
+            g_ctx.submitted_items.clear();
+            g_ctx.submitted_bounds.clear();
+
+            g_ctx.item_bvh_dirty = true;
+        }
+
+        //-------------------------------------------------------------------------
+        u64 item_count()
+        {
+            return g_ctx.items.size();
+        }
+
+        //-------------------------------------------------------------------------
+        pick_hit pick(const glm::vec3& ray_origin, const glm::vec3& ray_dir, pick_precision precision)
+        {
+            g_ctx.enabled = true;
+
+            if (g_ctx.item_bvh_dirty)
+            {
+                const bool can_refit = !g_ctx.item_bvh.empty()
+                    && g_ctx.item_bvh.primitive_count() == g_ctx.bounds.size()
+                    && g_ctx.item_bvh_refits < max_refits_before_rebuild;
+
+                if (can_refit)
+                {
+                    g_ctx.item_bvh.refit(g_ctx.bounds.data());
+                    ++g_ctx.item_bvh_refits;
+                }
+                else
+                {
+                    g_ctx.item_bvh.build(g_ctx.bounds.data(), static_cast<u32>(g_ctx.bounds.size()));
+                    g_ctx.item_bvh_refits = 0;
+                }
+
+                g_ctx.item_bvh_dirty = false;
+            }
+
+            const glm::vec3 inv_ray_dir = 1.0f / ray_dir;
+
+            pick_hit result;
+            f32 closest_t = std::numeric_limits<f32>::max();
+
+            result.hit = g_ctx.item_bvh.intersect(ray_origin, ray_dir, closest_t, [&](u32 item_index, f32& t)
+            {
+                f32 bounds_t = 0.0f;
+                if (!intersect_bounds(g_ctx.bounds[item_index], ray_origin, inv_ray_dir, t, bounds_t))
+                {
+                    return false;
+                }
+
+                const pickable_item& item = g_ctx.items[item_index];
+
+                const geometry::bvh* triangle_bvh = precision == pick_precision::TRIANGLES
+                    ? geometry_pool::get_triangle_bvh(item.geometry_id)
+                    : nullptr;
+
+                s64 triangle_index = -1;
+                if (triangle_bvh != nullptr)
+                {
+                    if (!intersect_triangles(*triangle_bvh, item, ray_origin, ray_dir, t, triangle_index))
+                    {
+                        return false;
+                    }
+                }
+                else
+                {
+                    // Geometry without faces ( lines, points ) can only be picked by its bounds
+                    t = bounds_t;
+                }
+
+                result.geometry_id = item.geometry_id;
+                result.item_index = item_index;
+                result.triangle_index = triangle_index;
+                return true;
+            });
+
+            if (result.hit)
+            {
+                result.distance = closest_t;
+                result.position = ray_origin + ray_dir * closest_t;
+            }
+
+            return result;
+        }
+    }
+}
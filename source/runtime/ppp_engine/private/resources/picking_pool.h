@@ -0,0 +1,48 @@
+#pragma once
+
+#include "geometry/geometry_bounding_box.h"
+
+#include "util/types.h"
+
+#include <glm/glm.hpp>
+
+#include <limits>
+
+namespace ppp
+{
+    namespace picking_pool
+    {
+        enum class pick_precision
+        {
+            BOUNDS,
+            TRIANGLES
+        };
+
+        struct pick_hit
+        {
+            bool        hit                 = false;
+            u64         geometry_id         = 0;
+            u64         item_index          = 0;        // order in which the item was submitted during the frame
+            s64         triangle_index      = -1;       // face of the geometry that was hit, -1 when only the bounds were tested
+            f32         distance            = 0.0f;     // distance along the ray, in units of the ray direction
+            glm::vec3   position            = glm::vec3(0.0f, 0.0f, 0.0f);
+        };
+
+        bool initialize();
+        void terminate();
+
+        // Recording starts with the first pick, sketches that never pick do not pay for collecting their items
+        void enable(bool enabled);
+        bool is_enabled();
+
+        // Items are recorded while a frame is being submitted and become pickable once the frame has ended
+        // Items that draw a submesh pass its index range, only the faces in that range can be hit
+        void add_item(u64 geometry_id, const geometry::bounding_box& local_bounds, const glm::mat4& world, u32 first_index = 0, u32 index_count = std::numeric_limits<u32>::max());
+        void end_frame();
+
+        u64 item_count();
+
+        // Closest item along the ray, enables recording for the frames that follow, the hierarchy over the items is only rebuilt on the first query after a frame has ended
+        pick_hit pick(const glm::vec3& ray_origin, const glm::vec3& ray_dir, pick_precision precision = pick_precision::TRIANGLES);
+    }
+}
@@ -0,0 +1,263 @@
+#include "resources/qoi.h"
+
+#include <cstring>
+
+namespace ppp
+{
+    namespace qoi
+    {
+        namespace internal
+        {
+            constexpr u8 op_index = 0x00;
+            constexpr u8 op_diff = 0x40;
+            constexpr u8 op_luma = 0x80;
+            constexpr u8 op_run = 0xC0;
+            constexpr u8 op_rgb = 0xFE;
+            constexpr u8 op_rgba = 0xFF;
+            constexpr u8 op_mask = 0xC0;
+
+            constexpr u64 header_size = 14;
+            constexpr u8 end_marker[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+            constexpr s32 max_run = 62;
+
+            struct rgba
+            {
+                u8 r = 0;
+                u8 g = 0;
+                u8 b = 0;
+                u8 a = 255;
+
+                bool operator==(const rgba& other) const { return r == other.r && g == other.g && b == other.b && a == other.a; }
+            };
+
+            //-------------------------------------------------------------------------
+            u32 hash(const rgba& px)
+            {
+                return (px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % 64;
+            }
+
+            //-------------------------------------------------------------------------
+            void write_u32(std::vector<u8>& out, u32 value)
+            {
+                out.push_back(static_cast<u8>(value >> 24));
+                out.push_back(static_cast<u8>(value >> 16));
+                out.push_back(static_cast<u8>(value >> 8));
+                out.push_back(static_cast<u8>(value));
+            }
+
+            //-------------------------------------------------------------------------
+            u32 read_u32(const u8* data)
+            {
+                return (static_cast<u32>(data[0]) << 24) | (static_cast<u32>(data[1]) << 16) | (static_cast<u32>(data[2]) << 8) | data[3];
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        std::vector<u8> encode(const u8* pixels, s32 width, s32 height, s32 channels)
+        {
+            std::vector<u8> out;
+
+            if (pixels == nullptr || width <= 0 || height <= 0 || (channels != 3 && channels != 4))
+            {
+                return out;
+            }
+
+            const u64 pixel_count = static_cast<u64>(width) * height;
+
+            // Worst case is one RGBA op per pixel
+            out.reserve(internal::header_size + pixel_count * (channels + 1) + sizeof(internal::end_marker));
+
+            out.insert(out.end(), { 'q', 'o', 'i', 'f' });
+            internal::write_u32(out, static_cast<u32>(width));
+            internal::write_u32(out, static_cast<u32>(height));
+            out.push_back(static_cast<u8>(channels));
+            out.push_back(0); // sRGB with linear alpha
+
+            internal::rgba index[64] = {};
+            internal::rgba previous;
+            s32 run = 0;
+
+            for (u64 i = 0; i < pixel_count; ++i)
+            {
+                const u8* p = pixels + i * channels;
+
+                internal::rgba px;
+                px.r = p[0];
+                px.g = p[1];
+                px.b = p[2];
+                px.a = channels == 4 ? p[3] : 255;
+
+                if (px == previous)
+                {
+                    ++run;
+                    if (run == internal::max_run || i == pixel_count - 1)
+                    {
+                        out.push_back(static_cast<u8>(internal::op_run | (run - 1)));
+                        run = 0;
+                    }
+
+                    continue;
+                }
+
+                if (run > 0)
+                {
+                    out.push_back(static_cast<u8>(internal::op_run | (run - 1)));
+                    run = 0;
+                }
+
+                const u32 slot = internal::hash(px);
+
+                if (index[slot] == px)
+                {
+                    out.push_back(static_cast<u8>(internal::op_index | slot));
+                }
+                else
+                {
+                    index[slot] = px;
+
+                    if (px.a == previous.a)
+                    {
+                        const s32 dr = static_cast<s8>(px.r - previous.r);
+                        const s32 dg = static_cast<s8>(px.g - previous.g);
+                        const s32 db = static_cast<s8>(px.b - previous.b);
+
+                        const s32 dr_dg = dr - dg;
+                        const s32 db_dg = db - dg;
+
+                        if (dr > -3 && dr < 2 && dg > -3 && dg < 2 && db > -3 && db < 2)
+                        {
+                            out.push_back(static_cast<u8>(internal::op_diff | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+                        }
+                        else if (dr_dg > -9 && dr_dg < 8 && dg > -33 && dg < 32 && db_dg > -9 && db_dg < 8)
+                        {
+                            out.push_back(static_cast<u8>(internal::op_luma | (dg + 32)));
+                            out.push_back(static_cast<u8>((dr_dg + 8) << 4 | (db_dg + 8)));
+                        }
+                        else
+                        {
+                            out.insert(out.end(), { internal::op_rgb, px.r, px.g, px.b });
+                        }
+                    }
+                    else
+                    {
+                        out.insert(out.end(), { internal::op_rgba, px.r, px.g, px.b, px.a });
+                    }
+                }
+
+                previous = px;
+            }
+
+            out.insert(out.end(), std::begin(internal::end_marker), std::end(internal::end_marker));
+
+            return out;
+        }
+
+        //-------------------------------------------------------------------------
+        bool decode(const u8* data, u64 size, std::vector<u8>* pixels, s32* width, s32* height, s32* channels)
+        {
+            if (data == nullptr || size < internal::header_size + sizeof(internal::end_marker) || memcmp(data, "qoif", 4) != 0)
+            {
+                return false;
+            }
+
+            const u32 w = internal::read_u32(data + 4);
+            const u32 h = internal::read_u32(data + 8);
+            const s32 c = data[12];
+
+            if (w == 0 || h == 0 || (c != 3 && c != 4))
+            {
+                return false;
+            }
+
+            const u64 pixel_count = static_cast<u64>(w) * h;
+            const u64 data_end = size - sizeof(internal::end_marker);
+
+            pixels->resize(pixel_count * c);
+
+            internal::rgba index[64] = {};
+            internal::rgba px;
+            s32 run = 0;
+            u64 offset = internal::header_size;
+
+            for (u64 i = 0; i < pixel_count; ++i)
+            {
+                if (run > 0)
+                {
+                    --run;
+                }
+                else
+                {
+                    if (offset >= data_end)
+                    {
+                        return false;
+                    }
+
+                    const u8 op = data[offset++];
+
+                    if (op == internal::op_rgb || op == internal::op_rgba)
+                    {
+                        const u64 count = op == internal::op_rgb ? 3 : 4;
+                        if (offset + count > data_end)
+                        {
+                            return false;
+                        }
+
+                        px.r = data[offset++];
+                        px.g = data[offset++];
+                        px.b = data[offset++];
+                        if (op == internal::op_rgba)
+                        {
+                            px.a = data[offset++];
+                        }
+                    }
+                    else if ((op & internal::op_mask) == internal::op_index)
+                    {
+                        px = index[op];
+                    }
+                    else if ((op & internal::op_mask) == internal::op_diff)
+                    {
+                        px.r = static_cast<u8>(px.r + ((op >> 4) & 0x03) - 2);
+                        px.g = static_cast<u8>(px.g + ((op >> 2) & 0x03) - 2);
+                        px.b = static_cast<u8>(px.b + (op & 0x03) - 2);
+                    }
+                    else if ((op & internal::op_mask) == internal::op_luma)
+                    {
+                        if (offset >= data_end)
+                        {
+                            return false;
+                        }
+
+                        const u8 next = data[offset++];
+                        const s32 dg = (op & 0x3F) - 32;
+
+                        px.r = static_cast<u8>(px.r + dg - 8 + ((next >> 4) & 0x0F));
+                        px.g = static_cast<u8>(px.g + dg);
+                        px.b = static_cast<u8>(px.b + dg - 8 + (next & 0x0F));
+                    }
+                    else
+                    {
+                        run = op & 0x3F;
+                    }
+
+                    index[internal::hash(px)] = px;
+                }
+
+                u8* out = pixels->data() + i * c;
+                out[0] = px.r;
+                out[1] = px.g;
+                out[2] = px.b;
+                if (c == 4)
+                {
+                    out[3] = px.a;
+                }
+            }
+
+            *width = static_cast<s32>(w);
+            *height = static_cast<s32>(h);
+            *channels = c;
+
+            return true;
+        }
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "util/types.h"
+
+#include <vector>
+
+namespace ppp
+{
+    // "Quite OK Image" format, lossless and several times faster to encode than PNG
+    namespace qoi
+    {
+        // Pixels with 3 ( RGB ) or 4 ( RGBA ) channels
+        std::vector<u8> encode(const u8* pixels, s32 width, s32 height, s32 channels);
+
+        // Fails on data that is not a valid QOI image, the pixels have the channel count of the file
+        bool decode(const u8* data, u64 size, std::vector<u8>* pixels, s32* width, s32* height, s32* channels);
+    }
+}
@@ -0,0 +1,301 @@
+#include "resources/texture_atlas.h"
+#include "resources/texture_pool.h"
+
+#include "render/render.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+namespace ppp
+{
+    namespace texture_atlas
+    {
+        struct atlas_page
+        {
+            u32             texture_id = 0;
+            skyline_packer  packer = skyline_packer(page_size, page_size);
+            s32             image_count = 0;
+        };
+
+        struct context
+        {
+            std::vector<atlas_page>                 pages;
+            std::unordered_map<s32, atlas_entry>    entries;
+        } g_ctx;
+
+        namespace internal
+        {
+            //-------------------------------------------------------------------------
+            atlas_page* page_at_index(s32 page_index)
+            {
+                return page_index >= 0 && page_index < static_cast<s32>(g_ctx.pages.size()) ? &g_ctx.pages[page_index] : nullptr;
+            }
+
+            //-------------------------------------------------------------------------
+            // Converts the image to RGBA the same way the GPU samples textures with fewer channels, the edges are repeated into the padding
+            void upload(const texture_pool::image& img, const atlas_entry& entry)
+            {
+                const s32 padded_width = img.width + 2 * padding;
+                const s32 padded_height = img.height + 2 * padding;
+
+                std::vector<u8> pixels(static_cast<u64>(padded_width) * padded_height * 4);
+
+                for (s32 py = 0; py < padded_height; ++py)
+                {
+                    const s32 sy = std::clamp(py - padding, 0, img.height - 1);
+
+                    for (s32 px = 0; px < padded_width; ++px)
+                    {
+                        const s32 sx = std::clamp(px - padding, 0, img.width - 1);
+
+                        const u8* src = img.data + (static_cast<u64>(sy) * img.width + sx) * img.channels;
+                        u8* dst = pixels.data() + (static_cast<u64>(py) * padded_width + px) * 4;
+
+                        dst[0] = src[0];
+                        dst[1] = img.channels >= 2 ? src[1] : 0;
+                        dst[2] = img.channels >= 3 ? src[2] : 0;
+                        dst[3] = img.channels == 4 ? src[3] : 255;
+                    }
+                }
+
+                render::update_image_item(entry.page_texture_id, entry.rect.x - padding, entry.rect.y - padding, padded_width, padded_height, 4, pixels.data());
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        skyline_packer::skyline_packer(s32 width, s32 height)
+            : m_width(width)
+            , m_height(height)
+        {
+            reset();
+        }
+
+        //-------------------------------------------------------------------------
+        bool skyline_packer::pack(s32 width, s32 height, atlas_rect& rect)
+        {
+            s32 best_bottom = std::numeric_limits<s32>::max();
+            s32 best_width = std::numeric_limits<s32>::max();
+            u64 best_index = m_skyline.size();
+            s32 best_y = 0;
+
+            for (u64 i = 0; i < m_skyline.size(); ++i)
+            {
+                const s32 y = fit(i, width, height);
+                if (y < 0)
+                {
+                    continue;
+                }
+
+                // Lowest position first, the narrowest segment breaks ties so wide gaps stay available
+                if (y + height < best_bottom || (y + height == best_bottom && m_skyline[i].width < best_width))
+                {
+                    best_bottom = y + height;
+                    best_width = m_skyline[i].width;
+                    best_index = i;
+                    best_y = y;
+                }
+            }
+
+            if (best_index == m_skyline.size())
+            {
+                return false;
+            }
+
+            rect = { m_skyline[best_index].x, best_y, width, height };
+
+            m_skyline.insert(m_skyline.begin() + best_index, { rect.x, rect.y + height, width });
+
+            // Cut the segments that are now covered by the new one
+            for (u64 i = best_index + 1; i < m_skyline.size();)
+            {
+                const skyline_segment& previous = m_skyline[i - 1];
+                const s32 previous_end = previous.x + previous.width;
+
+                if (m_skyline[i].x >= previous_end)
+                {
+                    break;
+                }
+
+                const s32 shrink = previous_end - m_skyline[i].x;
+
+                m_skyline[i].x += shrink;
+                m_skyline[i].width -= shrink;
+
+                if (m_skyline[i].width > 0)
+                {
+                    break;
+                }
+
+                m_skyline.erase(m_skyline.begin() + i);
+            }
+
+            // Merge neighbours at the same height
+            for (u64 i = 0; i + 1 < m_skyline.size();)
+            {
+                if (m_skyline[i].y == m_skyline[i + 1].y)
+                {
+                    m_skyline[i].width += m_skyline[i + 1].width;
+                    m_skyline.erase(m_skyline.begin() + i + 1);
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+
+            return true;
+        }
+
+        //-------------------------------------------------------------------------
+        void skyline_packer::reset()
+        {
+            m_skyline.assign(1, { 0, 0, m_width });
+        }
+
+        //-------------------------------------------------------------------------
+        s32 skyline_packer::fit(u64 index, s32 width, s32 height) const
+        {
+            if (m_skyline[index].x + width > m_width)
+            {
+                return -1;
+            }
+
+            s32 y = 0;
+            s32 remaining = width;
+
+            for (u64 i = index; remaining > 0; ++i)
+            {
+                y = std::max(y, m_skyline[i].y);
+                if (y + height > m_height)
+                {
+                    return -1;
+                }
+
+                remaining -= m_skyline[i].width;
+            }
+
+            return y;
+        }
+
+        //-------------------------------------------------------------------------
+        void terminate()
+        {
+            for (const atlas_page& page : g_ctx.pages)
+            {
+                render::delete_image_item(page.texture_id);
+            }
+
+            g_ctx.pages.clear();
+            g_ctx.entries.clear();
+        }
+
+        //-------------------------------------------------------------------------
+        bool add_image(const texture_pool::image& img)
+        {
+            if (img.data == nullptr || img.width <= 0 || img.height <= 0 || img.width > max_image_size || img.height > max_image_size)
+            {
+                return false;
+            }
+
+            if (g_ctx.entries.find(img.image_id) != g_ctx.entries.end())
+            {
+                update_image(img);
+                return true;
+            }
+
+            const s32 padded_width = img.width + 2 * padding;
+            const s32 padded_height = img.height + 2 * padding;
+
+            atlas_rect rect;
+            atlas_page* target = nullptr;
+
+            for (atlas_page& page : g_ctx.pages)
+            {
+                if (page.packer.pack(padded_width, padded_height, rect))
+                {
+                    target = &page;
+                    break;
+                }
+            }
+
+            if (target == nullptr)
+            {
+                atlas_page page;
+                page.texture_id = render::create_image_item(page_size, page_size, 4, nullptr);
+
+                g_ctx.pages.push_back(page);
+
+                target = &g_ctx.pages.back();
+                target->packer.pack(padded_width, padded_height, rect);
+            }
+
+            ++target->image_count;
+
+            atlas_entry entry;
+            entry.page_texture_id = target->texture_id;
+            entry.page_index = static_cast<s32>(target - g_ctx.pages.data());
+            entry.rect = { rect.x + padding, rect.y + padding, img.width, img.height };
+            entry.uv_min = glm::vec2(entry.rect.x, entry.rect.y) / static_cast<f32>(page_size);
+            entry.uv_max = glm::vec2(entry.rect.x + entry.rect.width, entry.rect.y + entry.rect.height) / static_cast<f32>(page_size);
+
+            internal::upload(img, entry);
+
+            g_ctx.entries[img.image_id] = entry;
+
+            return true;
+        }
+
+        //-------------------------------------------------------------------------
+        void update_image(const texture_pool::image& img)
+        {
+            auto it = g_ctx.entries.find(img.image_id);
+            if (it == g_ctx.entries.end())
+            {
+                return;
+            }
+
+            if (img.data != nullptr && img.width == it->second.rect.width && img.height == it->second.rect.height)
+            {
+                internal::upload(img, it->second);
+                return;
+            }
+
+            remove_image(img.image_id);
+            add_image(img);
+        }
+
+        //-------------------------------------------------------------------------
+        void remove_image(s32 image_id)
+        {
+            auto it = g_ctx.entries.find(image_id);
+            if (it == g_ctx.entries.end())
+            {
+                return;
+            }
+
+            // Areas are not reused one by one, the whole page becomes available once it is empty
+            atlas_page* page = internal::page_at_index(it->second.page_index);
+            if (page != nullptr && --page->image_count == 0)
+            {
+                page->packer.reset();
+            }
+
+            g_ctx.entries.erase(it);
+        }
+
+        //-------------------------------------------------------------------------
+        const atlas_entry* find(s32 image_id)
+        {
+            auto it = g_ctx.entries.find(image_id);
+
+            return it != g_ctx.entries.end() ? &it->second : nullptr;
+        }
+
+        //-------------------------------------------------------------------------
+        s32 page_count()
+        {
+            return static_cast<s32>(g_ctx.pages.size());
+        }
+    }
+}
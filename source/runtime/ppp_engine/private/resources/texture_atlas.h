@@ -0,0 +1,92 @@
+#pragma once
+
+#include "util/types.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace ppp
+{
+    namespace texture_pool
+    {
+        struct image;
+    }
+
+    // Small images are copied into shared atlas pages so drawing many of them does not use a texture slot per image.
+    // The images keep their own texture, the atlas is only used to draw them as sprites.
+    namespace texture_atlas
+    {
+        // Size of every atlas page, pages are RGBA
+        constexpr s32 page_size = 1024;
+        // Images are packed when neither side is larger than this
+        constexpr s32 max_image_size = 128;
+        // Edge pixels are repeated around every image so neighbours never bleed into each other
+        constexpr s32 padding = 1;
+
+        struct atlas_rect
+        {
+            s32 x = 0;
+            s32 y = 0;
+            s32 width = 0;
+            s32 height = 0;
+        };
+
+        //-------------------------------------------------------------------------
+        // Bottom left skyline packer, the top edge of the packed rectangles is kept as a list of horizontal segments
+        class skyline_packer
+        {
+        public:
+            skyline_packer(s32 width, s32 height);
+
+            // Finds the lowest place where a rectangle of this size fits, false when the page is full
+            bool pack(s32 width, s32 height, atlas_rect& rect);
+            void reset();
+
+            s32 width() const { return m_width; }
+            s32 height() const { return m_height; }
+
+        private:
+            struct skyline_segment
+            {
+                s32 x;
+                s32 y;
+                s32 width;
+            };
+
+            // Height at which a rectangle starting at segment `index` would rest, -1 when it does not fit
+            s32 fit(u64 index, s32 width, s32 height) const;
+
+            std::vector<skyline_segment> m_skyline;
+
+            s32 m_width;
+            s32 m_height;
+        };
+
+        //-------------------------------------------------------------------------
+        struct atlas_entry
+        {
+            // Texture of the page on the GPU, the page is not an image of the texture pool
+            u32         page_texture_id = 0;
+            // Position of the page in the atlas, handed out as the page of an image
+            s32         page_index = -1;
+            atlas_rect  rect;
+
+            glm::vec2   uv_min = {};
+            glm::vec2   uv_max = {};
+        };
+
+        void terminate();
+
+        // Copies the image into a page, false when it is too large or has no pixels
+        bool add_image(const texture_pool::image& img);
+        // Copies the pixels of an image that is already packed again, the image is moved when its size changed
+        void update_image(const texture_pool::image& img);
+        // Releases the area of the image, a page is cleared once all of its images are removed
+        void remove_image(s32 image_id);
+
+        const atlas_entry* find(s32 image_id);
+
+        s32 page_count();
+    }
+}
@@ -0,0 +1,386 @@
+#include "resources/texture_cache.h"
+
+#include "fileio/mapped_file.h"
+
+#include "util/log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace ppp
+{
+    namespace texture_cache
+    {
+        namespace internal
+        {
+            constexpr u8 identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A }; // "\xABKTX 20\xBB\r\n\x1A\n"
+
+            // Changes whenever the encoder output changes, older caches are cooked again
+            constexpr u32 encoder_version = 1;
+
+            constexpr char source_key[] = "ppp.source";
+
+            //-------------------------------------------------------------------------
+            struct header
+            {
+                u32 vk_format = 0;
+                u32 type_size = 1;
+                u32 pixel_width = 0;
+                u32 pixel_height = 0;
+                u32 pixel_depth = 0;
+                u32 layer_count = 0;
+                u32 face_count = 1;
+                u32 level_count = 0;
+                u32 supercompression_scheme = 0;
+
+                u32 dfd_byte_offset = 0;
+                u32 dfd_byte_length = 0;
+                u32 kvd_byte_offset = 0;
+                u32 kvd_byte_length = 0;
+                // Supercompression global data is not used, its 64 bit offset and length are split so the header has no padding
+                u32 sgd_byte_offset_and_length[4] = {};
+            };
+
+            //-------------------------------------------------------------------------
+            struct level_index
+            {
+                u64 byte_offset = 0;
+                u64 byte_length = 0;
+                u64 uncompressed_byte_length = 0;
+            };
+
+            //-------------------------------------------------------------------------
+            // Value of the `ppp.source` key
+            struct source_record
+            {
+                u64 source_size = 0;
+                s64 source_write_time = 0;
+                u64 source_hash = 0;
+
+                u32 mip_filter = 0;
+                u32 encoder_version = 0;
+            };
+
+            static_assert(sizeof(header) == 68, "KTX2 header and index are written as is");
+            static_assert(sizeof(level_index) == 24, "KTX2 level index is written as is");
+            static_assert(std::is_trivially_copyable_v<source_record>, "source record is written as is");
+
+            constexpr u64 header_offset = sizeof(identifier);
+            constexpr u64 level_index_offset = header_offset + sizeof(header);
+
+            //-------------------------------------------------------------------------
+            struct format_description
+            {
+                u32 vk_format;
+                u8 color_model;
+
+                // Channel type and bit length of every sample
+                u8 sample_count;
+                u8 sample_channels[2];
+                u8 sample_bit_lengths[2];
+            };
+
+            //-------------------------------------------------------------------------
+            format_description describe(render::image_compression_type compression)
+            {
+                // Vulkan formats and Khronos data format color models
+                switch (compression)
+                {
+                case render::image_compression_type::BC1: return { 131, 128, 1, { 0, 0 }, { 64, 0 } };      // VK_FORMAT_BC1_RGB_UNORM_BLOCK, KHR_DF_MODEL_BC1A
+                case render::image_compression_type::BC3: return { 137, 130, 2, { 15, 0 }, { 64, 64 } };    // VK_FORMAT_BC3_UNORM_BLOCK, KHR_DF_MODEL_BC3
+                case render::image_compression_type::BC5: return { 141, 132, 2, { 0, 1 }, { 64, 64 } };     // VK_FORMAT_BC5_UNORM_BLOCK, KHR_DF_MODEL_BC5
+                case render::image_compression_type::BC7: return { 145, 134, 1, { 0, 0 }, { 128, 0 } };     // VK_FORMAT_BC7_UNORM_BLOCK, KHR_DF_MODEL_BC7
+                }
+
+                assert(false);
+                return {};
+            }
+
+            //-------------------------------------------------------------------------
+            template<typename T>
+            void append(std::vector<u8>& buffer, const T& value)
+            {
+                const u8* bytes = reinterpret_cast<const u8*>(&value);
+                buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+            }
+
+            //-------------------------------------------------------------------------
+            // Basic data format descriptor with a sample per plane of the block
+            std::vector<u8> make_data_format_descriptor(render::image_compression_type compression)
+            {
+                const format_description description = describe(compression);
+
+                const u32 block_size = 24 + 16 * description.sample_count;
+
+                std::vector<u8> dfd;
+                append<u32>(dfd, 4 + block_size);                           // dfdTotalSize
+                append<u32>(dfd, 0);                                        // vendorId, descriptorType
+                append<u32>(dfd, 2u | (block_size << 16));                  // versionNumber, descriptorBlockSize
+                append<u8>(dfd, description.color_model);
+                append<u8>(dfd, 1);                                         // KHR_DF_PRIMARIES_BT709
+                append<u8>(dfd, 1);                                         // KHR_DF_TRANSFER_LINEAR
+                append<u8>(dfd, 0);                                         // Straight alpha
+                append<u32>(dfd, 3u | (3u << 8));                           // 4x4 texel blocks
+                append<u32>(dfd, static_cast<u32>(texture_compression::block_size(compression)));
+                append<u32>(dfd, 0);
+
+                u32 bit_offset = 0;
+                for (u8 s = 0; s < description.sample_count; ++s)
+                {
+                    append<u16>(dfd, static_cast<u16>(bit_offset));
+                    append<u8>(dfd, static_cast<u8>(description.sample_bit_lengths[s] - 1));
+                    append<u8>(dfd, description.sample_channels[s]);
+                    append<u32>(dfd, 0);                                    // Sample position
+                    append<u32>(dfd, 0);                                    // Sample lower
+                    append<u32>(dfd, 0xFFFFFFFF);                           // Sample upper
+
+                    bit_offset += description.sample_bit_lengths[s];
+                }
+
+                return dfd;
+            }
+
+            //-------------------------------------------------------------------------
+            u64 align_up(u64 value, u64 alignment)
+            {
+                return (value + alignment - 1) / alignment * alignment;
+            }
+
+            //-------------------------------------------------------------------------
+            s32 level_dimension(s32 size, u64 level)
+            {
+                return std::max(1, size >> level);
+            }
+
+            //-------------------------------------------------------------------------
+            u32 full_level_count(s32 width, s32 height)
+            {
+                u32 count = 1;
+                while ((width >> count) > 0 || (height >> count) > 0)
+                {
+                    ++count;
+                }
+
+                return count;
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        std::string cache_path(std::string_view source_path, render::image_compression_type compression)
+        {
+            const char* suffixes[] = { ".bc1.ktx2", ".bc3.ktx2", ".bc5.ktx2", ".bc7.ktx2" };
+
+            return std::string(source_path) + suffixes[static_cast<s32>(compression)];
+        }
+
+        //-------------------------------------------------------------------------
+        bool write(std::string_view cache_path, const texture_compression::compressed_texture& texture, texture_compression::mip_filter_type mip_filter, const fileio::file_stamp& stamp, u64 source_hash)
+        {
+            if (texture.levels.empty())
+            {
+                log::warn("Unable to cook {}, the texture has no levels", cache_path);
+                return false;
+            }
+
+            const std::vector<u8> dfd = internal::make_data_format_descriptor(texture.compression);
+
+            internal::source_record record;
+            record.source_size = stamp.size;
+            record.source_write_time = stamp.write_time;
+            record.source_hash = source_hash;
+            record.mip_filter = static_cast<u32>(mip_filter);
+            record.encoder_version = internal::encoder_version;
+
+            // A single key/value pair: length, key with terminator, value, padding to 4 bytes
+            std::vector<u8> kvd;
+            internal::append<u32>(kvd, static_cast<u32>(sizeof(internal::source_key) + sizeof(record)));
+            kvd.insert(kvd.end(), internal::source_key, internal::source_key + sizeof(internal::source_key));
+            internal::append(kvd, record);
+            kvd.resize(internal::align_up(kvd.size(), 4), 0);
+
+            internal::header header;
+            header.vk_format = internal::describe(texture.compression).vk_format;
+            header.pixel_width = static_cast<u32>(texture.width);
+            header.pixel_height = static_cast<u32>(texture.height);
+            header.level_count = static_cast<u32>(texture.levels.size());
+            header.dfd_byte_offset = static_cast<u32>(internal::level_index_offset + texture.levels.size() * sizeof(internal::level_index));
+            header.dfd_byte_length = static_cast<u32>(dfd.size());
+            header.kvd_byte_offset = header.dfd_byte_offset + header.dfd_byte_length;
+            header.kvd_byte_length = static_cast<u32>(kvd.size());
+
+            // Level data is stored from the smallest level to the largest, every level starts on a block boundary
+            const u64 alignment = texture_compression::block_size(texture.compression);
+
+            std::vector<internal::level_index> levels(texture.levels.size());
+
+            u64 offset = header.kvd_byte_offset + header.kvd_byte_length;
+            for (u64 i = texture.levels.size(); i-- > 0;)
+            {
+                offset = internal::align_up(offset, alignment);
+
+                levels[i].byte_offset = offset;
+                levels[i].byte_length = texture.levels[i].size();
+                levels[i].uncompressed_byte_length = texture.levels[i].size();
+
+                offset += texture.levels[i].size();
+            }
+
+            // Write to a temporary file first, a reader never observes a partially written cache
+            const std::string temp_path = std::string(cache_path) + ".tmp";
+            {
+                std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+                if (!file.is_open())
+                {
+                    log::warn("Unable to open {} to write the texture cache", temp_path);
+                    return false;
+                }
+
+                file.write(reinterpret_cast<const char*>(internal::identifier), sizeof(internal::identifier));
+                file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                file.write(reinterpret_cast<const char*>(levels.data()), static_cast<std::streamsize>(levels.size() * sizeof(internal::level_index)));
+                file.write(reinterpret_cast<const char*>(dfd.data()), static_cast<std::streamsize>(dfd.size()));
+                file.write(reinterpret_cast<const char*>(kvd.data()), static_cast<std::streamsize>(kvd.size()));
+
+                for (u64 i = 0; i < levels.size(); ++i)
+                {
+                    file.seekp(static_cast<std::streamoff>(levels[i].byte_offset));
+                    file.write(reinterpret_cast<const char*>(texture.levels[i].data()), static_cast<std::streamsize>(texture.levels[i].size()));
+                }
+
+                if (!file.good())
+                {
+                    log::warn("Failed to write the texture cache {}", temp_path);
+
+                    file.close();
+                    std::filesystem::remove(temp_path);
+                    return false;
+                }
+            }
+
+            std::error_code error;
+            std::filesystem::rename(temp_path, std::filesystem::path(cache_path), error);
+            if (error)
+            {
+                log::warn("Failed to move the texture cache into place at {}: {}", cache_path, error.message());
+
+                std::filesystem::remove(temp_path, error);
+                return false;
+            }
+
+            return true;
+        }
+
+        //-------------------------------------------------------------------------
+        bool read(std::string_view cache_path, render::image_compression_type compression, texture_compression::mip_filter_type mip_filter, const fileio::file_stamp& stamp, const hash_source_fn& hash_fn, texture_compression::compressed_texture* texture, u64* source_hash)
+        {
+            internal::source_record record;
+            u64 record_offset = 0;
+            bool refresh_write_time = false;
+
+            {
+                fileio::mapped_file file;
+                if (!file.open(cache_path) || file.size() < internal::level_index_offset)
+                {
+                    return false;
+                }
+
+                internal::header header;
+                std::memcpy(&header, file.data() + internal::header_offset, sizeof(header));
+
+                if (std::memcmp(file.data(), internal::identifier, sizeof(internal::identifier)) != 0
+                    || header.vk_format != internal::describe(compression).vk_format
+                    || header.supercompression_scheme != 0
+                    || header.pixel_width == 0
+                    || header.pixel_height == 0
+                    || header.level_count != internal::full_level_count(header.pixel_width, header.pixel_height))
+                {
+                    return false;
+                }
+
+                if (header.kvd_byte_offset > file.size() || header.kvd_byte_length > file.size() - header.kvd_byte_offset
+                    || header.level_count > (file.size() - internal::level_index_offset) / sizeof(internal::level_index))
+                {
+                    log::warn("Texture cache {} is corrupt", cache_path);
+                    return false;
+                }
+
+                // The source record is the first key/value pair
+                const u64 expected_kvd_size = sizeof(u32) + sizeof(internal::source_key) + sizeof(record);
+                if (header.kvd_byte_length < expected_kvd_size
+                    || std::memcmp(file.data() + header.kvd_byte_offset + sizeof(u32), internal::source_key, sizeof(internal::source_key)) != 0)
+                {
+                    return false;
+                }
+
+                record_offset = header.kvd_byte_offset + sizeof(u32) + sizeof(internal::source_key);
+                std::memcpy(&record, file.data() + record_offset, sizeof(record));
+
+                if (record.encoder_version != internal::encoder_version || record.mip_filter != static_cast<u32>(mip_filter))
+                {
+                    return false;
+                }
+
+                if (record.source_size != stamp.size)
+                {
+                    return false;
+                }
+
+                if (record.source_write_time != stamp.write_time)
+                {
+                    // Touched or copied, only stale when the contents changed
+                    if (!hash_fn || hash_fn() != record.source_hash)
+                    {
+                        return false;
+                    }
+
+                    refresh_write_time = true;
+                }
+
+                std::vector<internal::level_index> levels(header.level_count);
+                std::memcpy(levels.data(), file.data() + internal::level_index_offset, levels.size() * sizeof(internal::level_index));
+
+                for (u64 i = 0; i < levels.size(); ++i)
+                {
+                    const u64 expected_size = texture_compression::compressed_size(compression, internal::level_dimension(header.pixel_width, i), internal::level_dimension(header.pixel_height, i));
+
+                    if (levels[i].byte_length != expected_size || levels[i].byte_offset > file.size() || levels[i].byte_length > file.size() - levels[i].byte_offset)
+                    {
+                        log::warn("Texture cache {} is corrupt", cache_path);
+                        return false;
+                    }
+                }
+
+                texture->compression = compression;
+                texture->width = static_cast<s32>(header.pixel_width);
+                texture->height = static_cast<s32>(header.pixel_height);
+                texture->levels.resize(levels.size());
+
+                for (u64 i = 0; i < levels.size(); ++i)
+                {
+                    const u8* data = reinterpret_cast<const u8*>(file.data() + levels[i].byte_offset);
+                    texture->levels[i].assign(data, data + levels[i].byte_length);
+                }
+            }
+
+            if (source_hash != nullptr)
+            {
+                *source_hash = record.source_hash;
+            }
+
+            if (refresh_write_time)
+            {
+                // Next launches can skip hashing the source again
+                record.source_write_time = stamp.write_time;
+
+                std::fstream file(std::string(cache_path), std::ios::binary | std::ios::in | std::ios::out);
+                file.seekp(static_cast<std::streamoff>(record_offset));
+                file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+            }
+
+            return true;
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "resources/texture_compression.h"
+
+#include "fileio/file_stamp.h"
+
+#include "util/types.h"
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace ppp
+{
+    // Cooked block compressed textures, stored as KTX2 files next to their source image.
+    // The stamp and content hash of the source and the mip filter are stored in the key/value data of the file.
+    namespace texture_cache
+    {
+        using hash_source_fn = std::function<u64()>;
+
+        // Location of the cooked texture for a ( resolved ) source path, every compression has its own file
+        std::string cache_path(std::string_view source_path, render::image_compression_type compression);
+
+        bool write(std::string_view cache_path, const texture_compression::compressed_texture& texture, texture_compression::mip_filter_type mip_filter, const fileio::file_stamp& stamp, u64 source_hash);
+
+        // Loads a cooked texture, fails when the cache is missing, corrupt, stale or cooked with a different compression or mip filter.
+        // The source size has to match, when only the write time differs the content hash of the source is compared ( `hash_fn` is only invoked in that case ).
+        bool read(std::string_view cache_path, render::image_compression_type compression, texture_compression::mip_filter_type mip_filter, const fileio::file_stamp& stamp, const hash_source_fn& hash_fn, texture_compression::compressed_texture* texture, u64* source_hash = nullptr);
+    }
+}
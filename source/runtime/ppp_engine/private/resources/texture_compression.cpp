@@ -0,0 +1,950 @@
+#include "resources/texture_compression.h"
+
+#include "util/parallel_for.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace ppp
+{
+    namespace texture_compression
+    {
+        namespace internal
+        {
+            constexpr s32 block_dimension = 4;
+            constexpr s32 block_texel_count = block_dimension * block_dimension;
+
+            // Kaiser window, measured in texels of the smaller mip
+            constexpr f32 kaiser_width = 3.0f;
+            constexpr f32 kaiser_alpha = 4.0f;
+
+            // 4 bit index weights of BC7
+            constexpr std::array<s32, 16> bc7_weights = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+            using rgba_block = std::array<u8, block_texel_count * 4>;
+
+            //-------------------------------------------------------------------------
+            // Bits are written and read from the least significant bit of the first byte onwards
+            class bit_writer
+            {
+            public:
+                explicit bit_writer(u8* data) : m_data(data) {}
+
+                void write(u32 value, u32 bit_count)
+                {
+                    for (u32 i = 0; i < bit_count; ++i, ++m_position)
+                    {
+                        if ((value >> i) & 1u)
+                        {
+                            m_data[m_position / 8] |= static_cast<u8>(1u << (m_position % 8));
+                        }
+                    }
+                }
+
+            private:
+                u8* m_data;
+                u32 m_position = 0;
+            };
+
+            //-------------------------------------------------------------------------
+            class bit_reader
+            {
+            public:
+                explicit bit_reader(const u8* data) : m_data(data) {}
+
+                u32 read(u32 bit_count)
+                {
+                    u32 value = 0;
+                    for (u32 i = 0; i < bit_count; ++i, ++m_position)
+                    {
+                        value |= ((m_data[m_position / 8] >> (m_position % 8)) & 1u) << i;
+                    }
+
+                    return value;
+                }
+
+            private:
+                const u8* m_data;
+                u32 m_position = 0;
+            };
+
+            //-------------------------------------------------------------------------
+            u8 to_u8(f32 value)
+            {
+                return static_cast<u8>(std::clamp(std::lround(value), 0l, 255l));
+            }
+
+            //-------------------------------------------------------------------------
+            template<s32 TDimension>
+            f32 squared_distance(const u8* a, const s32* b)
+            {
+                f32 distance = 0.0f;
+                for (s32 c = 0; c < TDimension; ++c)
+                {
+                    const f32 d = static_cast<f32>(a[c]) - static_cast<f32>(b[c]);
+                    distance += d * d;
+                }
+
+                return distance;
+            }
+
+            //-------------------------------------------------------------------------
+            // End points of the block along the principal axis of its texels ( only the first `TDimension` channels are used )
+            template<s32 TDimension>
+            void principal_end_points(const rgba_block& block, f32* low, f32* high)
+            {
+                f32 mean[TDimension] = {};
+                for (s32 i = 0; i < block_texel_count; ++i)
+                {
+                    for (s32 c = 0; c < TDimension; ++c)
+                    {
+                        mean[c] += block[i * 4 + c];
+                    }
+                }
+
+                for (s32 c = 0; c < TDimension; ++c)
+                {
+                    mean[c] /= block_texel_count;
+                }
+
+                f32 covariance[TDimension][TDimension] = {};
+                for (s32 i = 0; i < block_texel_count; ++i)
+                {
+                    for (s32 a = 0; a < TDimension; ++a)
+                    {
+                        for (s32 b = 0; b < TDimension; ++b)
+                        {
+                            covariance[a][b] += (block[i * 4 + a] - mean[a]) * (block[i * 4 + b] - mean[b]);
+                        }
+                    }
+                }
+
+                // Power iteration, a fixed number of steps keeps the result deterministic
+                f32 axis[TDimension];
+                for (s32 c = 0; c < TDimension; ++c)
+                {
+                    axis[c] = 1.0f;
+                }
+
+                for (s32 iteration = 0; iteration < 8; ++iteration)
+                {
+                    f32 next[TDimension] = {};
+                    f32 length = 0.0f;
+
+                    for (s32 a = 0; a < TDimension; ++a)
+                    {
+                        for (s32 b = 0; b < TDimension; ++b)
+                        {
+                            next[a] += covariance[a][b] * axis[b];
+                        }
+
+                        length = std::max(length, std::abs(next[a]));
+                    }
+
+                    if (length < std::numeric_limits<f32>::epsilon())
+                    {
+                        break;
+                    }
+
+                    for (s32 c = 0; c < TDimension; ++c)
+                    {
+                        axis[c] = next[c] / length;
+                    }
+                }
+
+                f32 axis_length_squared = 0.0f;
+                for (s32 c = 0; c < TDimension; ++c)
+                {
+                    axis_length_squared += axis[c] * axis[c];
+                }
+
+                f32 min_t = 0.0f;
+                f32 max_t = 0.0f;
+
+                for (s32 i = 0; i < block_texel_count; ++i)
+                {
+                    f32 t = 0.0f;
+                    for (s32 c = 0; c < TDimension; ++c)
+                    {
+                        t += (block[i * 4 + c] - mean[c]) * axis[c];
+                    }
+
+                    t /= axis_length_squared;
+
+                    min_t = std::min(min_t, t);
+                    max_t = std::max(max_t, t);
+                }
+
+                for (s32 c = 0; c < TDimension; ++c)
+                {
+                    low[c] = std::clamp(mean[c] + min_t * axis[c], 0.0f, 255.0f);
+                    high[c] = std::clamp(mean[c] + max_t * axis[c], 0.0f, 255.0f);
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            u16 pack_565(const f32* color)
+            {
+                const u16 r = static_cast<u16>(std::lround(color[0] * 31.0f / 255.0f));
+                const u16 g = static_cast<u16>(std::lround(color[1] * 63.0f / 255.0f));
+                const u16 b = static_cast<u16>(std::lround(color[2] * 31.0f / 255.0f));
+
+                return static_cast<u16>((r << 11) | (g << 5) | b);
+            }
+
+            //-------------------------------------------------------------------------
+            void unpack_565(u16 color, s32* rgb)
+            {
+                const s32 r = (color >> 11) & 31;
+                const s32 g = (color >> 5) & 63;
+                const s32 b = color & 31;
+
+                rgb[0] = (r << 3) | (r >> 2);
+                rgb[1] = (g << 2) | (g >> 4);
+                rgb[2] = (b << 3) | (b >> 2);
+            }
+
+            //-------------------------------------------------------------------------
+            // Palette of a BC1 color block, `opaque_only` is set for BC3 where the 3 color mode does not exist
+            void color_palette(u16 c0, u16 c1, bool opaque_only, s32 palette[4][4])
+            {
+                unpack_565(c0, palette[0]);
+                unpack_565(c1, palette[1]);
+                palette[0][3] = 255;
+                palette[1][3] = 255;
+
+                if (c0 > c1 || opaque_only)
+                {
+                    for (s32 c = 0; c < 3; ++c)
+                    {
+                        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+                    }
+                    palette[2][3] = 255;
+                    palette[3][3] = 255;
+                }
+                else
+                {
+                    for (s32 c = 0; c < 3; ++c)
+                    {
+                        palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                        palette[3][c] = 0;
+                    }
+                    palette[2][3] = 255;
+                    palette[3][3] = 0;
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            // 8 byte BC1 color block, always in 4 color mode
+            void encode_color_block(const rgba_block& block, u8* out)
+            {
+                f32 low[3];
+                f32 high[3];
+                principal_end_points<3>(block, low, high);
+
+                u16 c0 = pack_565(high);
+                u16 c1 = pack_565(low);
+
+                if (c0 < c1)
+                {
+                    std::swap(c0, c1);
+                }
+
+                u32 indices = 0;
+
+                if (c0 != c1)
+                {
+                    s32 palette[4][4];
+                    color_palette(c0, c1, true, palette);
+
+                    for (s32 i = 0; i < block_texel_count; ++i)
+                    {
+                        u32 best_index = 0;
+                        f32 best_distance = std::numeric_limits<f32>::max();
+
+                        for (u32 p = 0; p < 4; ++p)
+                        {
+                            const f32 distance = squared_distance<3>(&block[i * 4], palette[p]);
+                            if (distance < best_distance)
+                            {
+                                best_distance = distance;
+                                best_index = p;
+                            }
+                        }
+
+                        indices |= best_index << (2 * i);
+                    }
+                }
+
+                out[0] = static_cast<u8>(c0 & 0xff);
+                out[1] = static_cast<u8>(c0 >> 8);
+                out[2] = static_cast<u8>(c1 & 0xff);
+                out[3] = static_cast<u8>(c1 >> 8);
+                out[4] = static_cast<u8>(indices & 0xff);
+                out[5] = static_cast<u8>((indices >> 8) & 0xff);
+                out[6] = static_cast<u8>((indices >> 16) & 0xff);
+                out[7] = static_cast<u8>(indices >> 24);
+            }
+
+            //-------------------------------------------------------------------------
+            void decode_color_block(const u8* data, bool opaque_only, u8* texels, s32 stride)
+            {
+                const u16 c0 = static_cast<u16>(data[0] | (data[1] << 8));
+                const u16 c1 = static_cast<u16>(data[2] | (data[3] << 8));
+                const u32 indices = data[4] | (data[5] << 8) | (data[6] << 16) | (static_cast<u32>(data[7]) << 24);
+
+                s32 palette[4][4];
+                color_palette(c0, c1, opaque_only, palette);
+
+                for (s32 i = 0; i < block_texel_count; ++i)
+                {
+                    const s32* color = palette[(indices >> (2 * i)) & 3];
+                    for (s32 c = 0; c < 4; ++c)
+                    {
+                        texels[i * stride + c] = static_cast<u8>(color[c]);
+                    }
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            void single_channel_palette(s32 a0, s32 a1, s32 palette[8])
+            {
+                palette[0] = a0;
+                palette[1] = a1;
+
+                if (a0 > a1)
+                {
+                    for (s32 i = 2; i < 8; ++i)
+                    {
+                        palette[i] = ((8 - i) * a0 + (i - 1) * a1 + 3) / 7;
+                    }
+                }
+                else
+                {
+                    for (s32 i = 2; i < 6; ++i)
+                    {
+                        palette[i] = ((6 - i) * a0 + (i - 1) * a1 + 2) / 5;
+                    }
+                    palette[6] = 0;
+                    palette[7] = 255;
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            // 8 byte BC4 block of a single channel, always in 8 value mode
+            void encode_channel_block(const rgba_block& block, s32 channel, u8* out)
+            {
+                s32 a0 = 0;
+                s32 a1 = 255;
+                for (s32 i = 0; i < block_texel_count; ++i)
+                {
+                    a0 = std::max<s32>(a0, block[i * 4 + channel]);
+                    a1 = std::min<s32>(a1, block[i * 4 + channel]);
+                }
+
+                u64 indices = 0;
+
+                if (a0 != a1)
+                {
+                    s32 palette[8];
+                    single_channel_palette(a0, a1, palette);
+
+                    for (s32 i = 0; i < block_texel_count; ++i)
+                    {
+                        u64 best_index = 0;
+                        s32 best_distance = std::numeric_limits<s32>::max();
+
+                        for (u64 p = 0; p < 8; ++p)
+                        {
+                            const s32 distance = std::abs(palette[p] - block[i * 4 + channel]);
+                            if (distance < best_distance)
+                            {
+                                best_distance = distance;
+                                best_index = p;
+                            }
+                        }
+
+                        indices |= best_index << (3 * i);
+                    }
+                }
+
+                out[0] = static_cast<u8>(a0);
+                out[1] = static_cast<u8>(a1);
+                for (s32 i = 0; i < 6; ++i)
+                {
+                    out[2 + i] = static_cast<u8>((indices >> (8 * i)) & 0xff);
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            void decode_channel_block(const u8* data, u8* texels, s32 stride)
+            {
+                s32 palette[8];
+                single_channel_palette(data[0], data[1], palette);
+
+                u64 indices = 0;
+                for (s32 i = 0; i < 6; ++i)
+                {
+                    indices |= static_cast<u64>(data[2 + i]) << (8 * i);
+                }
+
+                for (s32 i = 0; i < block_texel_count; ++i)
+                {
+                    texels[i * stride] = static_cast<u8>(palette[(indices >> (3 * i)) & 7]);
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            // Quantizes an end point to 7 bits per channel, the p-bit is shared by every channel and appended as the least significant bit
+            void quantize_bc7_end_point(const f32* color, u32 p_bit, u32* quantized)
+            {
+                for (s32 c = 0; c < 4; ++c)
+                {
+                    quantized[c] = static_cast<u32>(std::clamp(std::lround((color[c] - static_cast<f32>(p_bit)) / 2.0f), 0l, 127l));
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            void bc7_mode_6_palette(const s32 e0[4], const s32 e1[4], s32 palette[16][4])
+            {
+                for (s32 i = 0; i < 16; ++i)
+                {
+                    for (s32 c = 0; c < 4; ++c)
+                    {
+                        palette[i][c] = ((64 - bc7_weights[i]) * e0[c] + bc7_weights[i] * e1[c] + 32) >> 6;
+                    }
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            // 16 byte BC7 block in mode 6, a single RGBA line with 16 interpolation steps
+            void encode_bc7_block(const rgba_block& block, u8* out)
+            {
+                f32 low[4];
+                f32 high[4];
+                principal_end_points<4>(block, low, high);
+
+                u32 q0[4];
+                u32 q1[4];
+                u32 p0 = 0;
+                u32 p1 = 0;
+                u32 indices[block_texel_count];
+                f32 best_error = std::numeric_limits<f32>::max();
+
+                // Every p-bit combination is tried, end points with a different p-bit reach both parities ( e.g. uniform blocks with odd and even channels )
+                for (u32 p = 0; p < 4; ++p)
+                {
+                    u32 candidate_q0[4];
+                    u32 candidate_q1[4];
+                    quantize_bc7_end_point(low, p & 1, candidate_q0);
+                    quantize_bc7_end_point(high, p >> 1, candidate_q1);
+
+                    s32 e0[4];
+                    s32 e1[4];
+                    for (s32 c = 0; c < 4; ++c)
+                    {
+                        e0[c] = static_cast<s32>((candidate_q0[c] << 1) | (p & 1));
+                        e1[c] = static_cast<s32>((candidate_q1[c] << 1) | (p >> 1));
+                    }
+
+                    s32 palette[16][4];
+                    bc7_mode_6_palette(e0, e1, palette);
+
+                    u32 candidate_indices[block_texel_count];
+                    f32 error = 0.0f;
+
+                    for (s32 i = 0; i < block_texel_count; ++i)
+                    {
+                        u32 best_index = 0;
+                        f32 best_distance = std::numeric_limits<f32>::max();
+
+                        for (u32 index = 0; index < 16; ++index)
+                        {
+                            const f32 distance = squared_distance<4>(&block[i * 4], palette[index]);
+                            if (distance < best_distance)
+                            {
+                                best_distance = distance;
+                                best_index = index;
+                            }
+                        }
+
+                        candidate_indices[i] = best_index;
+                        error += best_distance;
+                    }
+
+                    if (error < best_error)
+                    {
+                        best_error = error;
+                        p0 = p & 1;
+                        p1 = p >> 1;
+                        std::copy(candidate_q0, candidate_q0 + 4, q0);
+                        std::copy(candidate_q1, candidate_q1 + 4, q1);
+                        std::copy(candidate_indices, candidate_indices + block_texel_count, indices);
+                    }
+                }
+
+                // The most significant bit of the first index is implied to be 0, swapping the end points flips every index
+                if (indices[0] >= 8)
+                {
+                    std::swap(q0, q1);
+                    std::swap(p0, p1);
+
+                    for (u32& index : indices)
+                    {
+                        index = 15 - index;
+                    }
+                }
+
+                std::fill(out, out + 16, u8(0));
+
+                bit_writer writer(out);
+                writer.write(1u << 6, 7);
+
+                for (s32 c = 0; c < 4; ++c)
+                {
+                    writer.write(q0[c], 7);
+                    writer.write(q1[c], 7);
+                }
+
+                writer.write(p0, 1);
+                writer.write(p1, 1);
+
+                writer.write(indices[0], 3);
+                for (s32 i = 1; i < block_texel_count; ++i)
+                {
+                    writer.write(indices[i], 4);
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            void decode_bc7_block(const u8* data, u8* texels, s32 stride)
+            {
+                bit_reader reader(data);
+
+                if (reader.read(7) != (1u << 6))
+                {
+                    // Other modes are never written by the encoder
+                    for (s32 i = 0; i < block_texel_count; ++i)
+                    {
+                        std::fill(texels + i * stride, texels + i * stride + 4, u8(0));
+                    }
+                    return;
+                }
+
+                u32 q0[4];
+                u32 q1[4];
+                for (s32 c = 0; c < 4; ++c)
+                {
+                    q0[c] = reader.read(7);
+                    q1[c] = reader.read(7);
+                }
+
+                const u32 p0 = reader.read(1);
+                const u32 p1 = reader.read(1);
+
+                s32 e0[4];
+                s32 e1[4];
+                for (s32 c = 0; c < 4; ++c)
+                {
+                    e0[c] = static_cast<s32>((q0[c] << 1) | p0);
+                    e1[c] = static_cast<s32>((q1[c] << 1) | p1);
+                }
+
+                s32 palette[16][4];
+                bc7_mode_6_palette(e0, e1, palette);
+
+                for (s32 i = 0; i < block_texel_count; ++i)
+                {
+                    const u32 index = reader.read(i == 0 ? 3 : 4);
+                    for (s32 c = 0; c < 4; ++c)
+                    {
+                        texels[i * stride + c] = static_cast<u8>(palette[index][c]);
+                    }
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            rgba_block gather_block(const rgba_image& image, s32 block_x, s32 block_y)
+            {
+                rgba_block block;
+
+                for (s32 y = 0; y < block_dimension; ++y)
+                {
+                    const s32 sy = std::min(block_y * block_dimension + y, image.height - 1);
+
+                    for (s32 x = 0; x < block_dimension; ++x)
+                    {
+                        const s32 sx = std::min(block_x * block_dimension + x, image.width - 1);
+
+                        const u8* texel = &image.pixels[(static_cast<u64>(sy) * image.width + sx) * 4];
+                        std::copy(texel, texel + 4, &block[(y * block_dimension + x) * 4]);
+                    }
+                }
+
+                return block;
+            }
+
+            //-------------------------------------------------------------------------
+            void encode_block(const rgba_block& block, render::image_compression_type compression, u8* out)
+            {
+                switch (compression)
+                {
+                case render::image_compression_type::BC1:
+                    encode_color_block(block, out);
+                    break;
+                case render::image_compression_type::BC3:
+                    encode_channel_block(block, 3, out);
+                    encode_color_block(block, out + 8);
+                    break;
+                case render::image_compression_type::BC5:
+                    encode_channel_block(block, 0, out);
+                    encode_channel_block(block, 1, out + 8);
+                    break;
+                case render::image_compression_type::BC7:
+                    encode_bc7_block(block, out);
+                    break;
+                default:
+                    assert(false);
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            void decode_block(const u8* data, render::image_compression_type compression, rgba_block& block)
+            {
+                switch (compression)
+                {
+                case render::image_compression_type::BC1:
+                    decode_color_block(data, false, block.data(), 4);
+                    break;
+                case render::image_compression_type::BC3:
+                    decode_color_block(data + 8, true, block.data(), 4);
+                    decode_channel_block(data, block.data() + 3, 4);
+                    break;
+                case render::image_compression_type::BC5:
+                    decode_channel_block(data, block.data(), 4);
+                    decode_channel_block(data + 8, block.data() + 1, 4);
+                    for (s32 i = 0; i < block_texel_count; ++i)
+                    {
+                        block[i * 4 + 2] = 0;
+                        block[i * 4 + 3] = 255;
+                    }
+                    break;
+                case render::image_compression_type::BC7:
+                    decode_bc7_block(data, block.data(), 4);
+                    break;
+                default:
+                    assert(false);
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            f64 bessel_i0(f64 x)
+            {
+                f64 sum = 1.0;
+                f64 term = 1.0;
+
+                for (s32 k = 1; k < 32; ++k)
+                {
+                    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                    sum += term;
+                }
+
+                return sum;
+            }
+
+            //-------------------------------------------------------------------------
+            f64 kaiser_weight(f64 distance)
+            {
+                if (std::abs(distance) >= kaiser_width)
+                {
+                    return 0.0;
+                }
+
+                const f64 pi_distance = glm::pi<f64>() * distance;
+                const f64 sinc = std::abs(distance) < 1e-6 ? 1.0 : std::sin(pi_distance) / pi_distance;
+
+                const f64 t = distance / kaiser_width;
+                const f64 window = bessel_i0(kaiser_alpha * std::sqrt(1.0 - t * t)) / bessel_i0(kaiser_alpha);
+
+                return sinc * window;
+            }
+
+            //-------------------------------------------------------------------------
+            struct filter_tap
+            {
+                s32 source;
+                f32 weight;
+            };
+
+            //-------------------------------------------------------------------------
+            // Normalized Kaiser taps for every texel of a row ( or column ) that is downsampled from `source_size` to `target_size`
+            std::vector<std::vector<filter_tap>> kaiser_taps(s32 source_size, s32 target_size)
+            {
+                const f64 scale = static_cast<f64>(source_size) / target_size;
+                const s32 radius = static_cast<s32>(std::ceil(kaiser_width * scale));
+
+                std::vector<std::vector<filter_tap>> taps(target_size);
+
+                for (s32 x = 0; x < target_size; ++x)
+                {
+                    const f64 center = (x + 0.5) * scale;
+                    const s32 first = static_cast<s32>(std::floor(center)) - radius;
+
+                    f64 total = 0.0;
+                    std::vector<std::pair<s32, f64>> weights;
+
+                    for (s32 s = first; s <= first + 2 * radius; ++s)
+                    {
+                        const f64 weight = kaiser_weight((s + 0.5 - center) / scale);
+                        if (weight != 0.0)
+                        {
+                            weights.emplace_back(std::clamp(s, 0, source_size - 1), weight);
+                            total += weight;
+                        }
+                    }
+
+                    for (const auto& [source, weight] : weights)
+                    {
+                        taps[x].push_back({ source, static_cast<f32>(weight / total) });
+                    }
+                }
+
+                return taps;
+            }
+
+            //-------------------------------------------------------------------------
+            rgba_image box_downsample(const rgba_image& source, s32 width, s32 height)
+            {
+                rgba_image target;
+                target.width = width;
+                target.height = height;
+                target.pixels.resize(static_cast<u64>(width) * height * 4);
+
+                for (s32 y = 0; y < height; ++y)
+                {
+                    const s32 y0 = std::min(2 * y, source.height - 1);
+                    const s32 y1 = std::min(2 * y + 1, source.height - 1);
+
+                    for (s32 x = 0; x < width; ++x)
+                    {
+                        const s32 x0 = std::min(2 * x, source.width - 1);
+                        const s32 x1 = std::min(2 * x + 1, source.width - 1);
+
+                        for (s32 c = 0; c < 4; ++c)
+                        {
+                            const s32 sum =
+                                source.pixels[(static_cast<u64>(y0) * source.width + x0) * 4 + c] +
+                                source.pixels[(static_cast<u64>(y0) * source.width + x1) * 4 + c] +
+                                source.pixels[(static_cast<u64>(y1) * source.width + x0) * 4 + c] +
+                                source.pixels[(static_cast<u64>(y1) * source.width + x1) * 4 + c];
+
+                            target.pixels[(static_cast<u64>(y) * width + x) * 4 + c] = static_cast<u8>((sum + 2) / 4);
+                        }
+                    }
+                }
+
+                return target;
+            }
+
+            //-------------------------------------------------------------------------
+            // Separable, rows are filtered into a floating point image first
+            rgba_image kaiser_downsample(const rgba_image& source, s32 width, s32 height)
+            {
+                const auto row_taps = kaiser_taps(source.width, width);
+                const auto column_taps = kaiser_taps(source.height, height);
+
+                std::vector<f32> rows(static_cast<u64>(width) * source.height * 4);
+
+                for (s32 y = 0; y < source.height; ++y)
+                {
+                    for (s32 x = 0; x < width; ++x)
+                    {
+                        for (const filter_tap& tap : row_taps[x])
+                        {
+                            const u8* texel = &source.pixels[(static_cast<u64>(y) * source.width + tap.source) * 4];
+                            f32* result = &rows[(static_cast<u64>(y) * width + x) * 4];
+
+                            for (s32 c = 0; c < 4; ++c)
+                            {
+                                result[c] += tap.weight * texel[c];
+                            }
+                        }
+                    }
+                }
+
+                rgba_image target;
+                target.width = width;
+                target.height = height;
+                target.pixels.resize(static_cast<u64>(width) * height * 4);
+
+                for (s32 y = 0; y < height; ++y)
+                {
+                    for (s32 x = 0; x < width; ++x)
+                    {
+                        f32 result[4] = {};
+
+                        for (const filter_tap& tap : column_taps[y])
+                        {
+                            const f32* texel = &rows[(static_cast<u64>(tap.source) * width + x) * 4];
+
+                            for (s32 c = 0; c < 4; ++c)
+                            {
+                                result[c] += tap.weight * texel[c];
+                            }
+                        }
+
+                        for (s32 c = 0; c < 4; ++c)
+                        {
+                            target.pixels[(static_cast<u64>(y) * width + x) * 4 + c] = to_u8(result[c]);
+                        }
+                    }
+                }
+
+                return target;
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        rgba_image to_rgba(const u8* data, s32 width, s32 height, s32 channels)
+        {
+            rgba_image image;
+            image.width = width;
+            image.height = height;
+            image.pixels.resize(static_cast<u64>(width) * height * 4);
+
+            const u64 texel_count = static_cast<u64>(width) * height;
+            for (u64 i = 0; i < texel_count; ++i)
+            {
+                const u8* src = data + i * channels;
+                u8* dst = &image.pixels[i * 4];
+
+                dst[0] = src[0];
+                dst[1] = channels >= 2 ? src[1] : 0;
+                dst[2] = channels >= 3 ? src[2] : 0;
+                dst[3] = channels == 4 ? src[3] : 255;
+            }
+
+            return image;
+        }
+
+        //-------------------------------------------------------------------------
+        std::vector<rgba_image> generate_mips(const rgba_image& image, mip_filter_type filter)
+        {
+            std::vector<rgba_image> levels = { image };
+
+            while (levels.back().width > 1 || levels.back().height > 1)
+            {
+                const rgba_image& source = levels.back();
+
+                const s32 width = std::max(1, source.width / 2);
+                const s32 height = std::max(1, source.height / 2);
+
+                levels.push_back(filter == mip_filter_type::BOX
+                    ? internal::box_downsample(source, width, height)
+                    : internal::kaiser_downsample(source, width, height));
+            }
+
+            return levels;
+        }
+
+        //-------------------------------------------------------------------------
+        u64 block_size(render::image_compression_type compression)
+        {
+            return compression == render::image_compression_type::BC1 ? 8 : 16;
+        }
+
+        //-------------------------------------------------------------------------
+        u64 compressed_size(render::image_compression_type compression, s32 width, s32 height)
+        {
+            const u64 blocks_x = (width + internal::block_dimension - 1) / internal::block_dimension;
+            const u64 blocks_y = (height + internal::block_dimension - 1) / internal::block_dimension;
+
+            return blocks_x * blocks_y * block_size(compression);
+        }
+
+        //-------------------------------------------------------------------------
+        std::vector<u8> encode(const rgba_image& image, render::image_compression_type compression, u32 thread_count)
+        {
+            const s32 blocks_x = (image.width + internal::block_dimension - 1) / internal::block_dimension;
+            const s32 blocks_y = (image.height + internal::block_dimension - 1) / internal::block_dimension;
+            const u64 size = block_size(compression);
+
+            std::vector<u8> data(compressed_size(compression, image.width, image.height));
+
+            // Every block row is written by exactly one thread
+            parallel_for(blocks_y, [&](u64 block_y)
+            {
+                for (s32 block_x = 0; block_x < blocks_x; ++block_x)
+                {
+                    const internal::rgba_block block = internal::gather_block(image, block_x, static_cast<s32>(block_y));
+
+                    internal::encode_block(block, compression, &data[(block_y * blocks_x + block_x) * size]);
+                }
+            }, thread_count);
+
+            return data;
+        }
+
+        //-------------------------------------------------------------------------
+        rgba_image decode(const u8* data, s32 width, s32 height, render::image_compression_type compression)
+        {
+            const s32 blocks_x = (width + internal::block_dimension - 1) / internal::block_dimension;
+            const s32 blocks_y = (height + internal::block_dimension - 1) / internal::block_dimension;
+            const u64 size = block_size(compression);
+
+            rgba_image image;
+            image.width = width;
+            image.height = height;
+            image.pixels.resize(static_cast<u64>(width) * height * 4);
+
+            for (s32 block_y = 0; block_y < blocks_y; ++block_y)
+            {
+                for (s32 block_x = 0; block_x < blocks_x; ++block_x)
+                {
+                    internal::rgba_block block;
+                    internal::decode_block(data + (static_cast<u64>(block_y) * blocks_x + block_x) * size, compression, block);
+
+                    for (s32 y = 0; y < internal::block_dimension; ++y)
+                    {
+                        for (s32 x = 0; x < internal::block_dimension; ++x)
+                        {
+                            const s32 px = block_x * internal::block_dimension + x;
+                            const s32 py = block_y * internal::block_dimension + y;
+
+                            if (px < width && py < height)
+                            {
+                                const u8* texel = &block[(y * internal::block_dimension + x) * 4];
+                                std::copy(texel, texel + 4, &image.pixels[(static_cast<u64>(py) * width + px) * 4]);
+                            }
+                        }
+                    }
+                }
+            }
+
+            return image;
+        }
+
+        //-------------------------------------------------------------------------
+        compressed_texture compress(const rgba_image& image, render::image_compression_type compression, mip_filter_type mip_filter, u32 thread_count)
+        {
+            compressed_texture texture;
+            texture.compression = compression;
+            texture.width = image.width;
+            texture.height = image.height;
+
+            for (const rgba_image& level : generate_mips(image, mip_filter))
+            {
+                texture.levels.push_back(encode(level, compression, thread_count));
+            }
+
+            return texture;
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "render/render_types.h"
+
+#include "util/types.h"
+
+#include <vector>
+
+namespace ppp
+{
+    // CPU encoder for block compressed textures.
+    // Encoding is deterministic ( independent of the thread count ) and every format has a CPU decoder, so the output can be verified without a GPU.
+    namespace texture_compression
+    {
+        enum class mip_filter_type
+        {
+            BOX,    // Average of 2x2 texels
+            KAISER  // Kaiser windowed sinc, keeps mips sharper
+        };
+
+        struct rgba_image
+        {
+            s32 width = 0;
+            s32 height = 0;
+
+            std::vector<u8> pixels;
+        };
+
+        // Level 0 first, every level is half the size of the previous one down to 1x1
+        struct compressed_texture
+        {
+            render::image_compression_type compression = render::image_compression_type::BC7;
+
+            s32 width = 0;
+            s32 height = 0;
+
+            std::vector<std::vector<u8>> levels;
+        };
+
+        // Expands pixels with 1 to 4 channels to RGBA the same way the GPU samples textures with fewer channels
+        rgba_image to_rgba(const u8* data, s32 width, s32 height, s32 channels);
+
+        // Level 0 is a copy of the image
+        std::vector<rgba_image> generate_mips(const rgba_image& image, mip_filter_type filter);
+
+        u64 block_size(render::image_compression_type compression);
+        u64 compressed_size(render::image_compression_type compression, s32 width, s32 height);
+
+        // Edge texels are repeated to fill blocks that stick out of the image, blocks are encoded on `thread_count` threads ( 0 uses every core )
+        std::vector<u8> encode(const rgba_image& image, render::image_compression_type compression, u32 thread_count = 0);
+        // BC7 blocks are only decoded when they use mode 6, the mode the encoder writes
+        rgba_image decode(const u8* data, s32 width, s32 height, render::image_compression_type compression);
+
+        compressed_texture compress(const rgba_image& image, render::image_compression_type compression, mip_filter_type mip_filter, u32 thread_count = 0);
+    }
+}
@@ -0,0 +1,116 @@
+#include "resources/texture_dirty_regions.h"
+
+#include <algorithm>
+
+namespace ppp
+{
+    namespace texture_dirty_regions
+    {
+        namespace internal
+        {
+            // Above this share of dirty pixels a single upload of the whole image is cheaper than many small ones
+            constexpr f32 full_upload_ratio = 0.75f;
+
+            //-------------------------------------------------------------------------
+            // Marks the tiles of one row of tiles that are touched by at least one of the written areas
+            void find_dirty_tiles(const std::vector<region>& written, s32 width, s32 height, s32 first_row, s32 row_count, std::vector<bool>& dirty)
+            {
+                std::fill(dirty.begin(), dirty.end(), false);
+
+                for (const region& area : written)
+                {
+                    const s32 min_x = std::clamp(area.x, 0, width);
+                    const s32 max_x = std::clamp(area.x + area.width, 0, width);
+                    const s32 min_y = std::clamp(area.y, 0, height);
+                    const s32 max_y = std::clamp(area.y + area.height, 0, height);
+
+                    if (max_x <= min_x || max_y <= first_row || min_y >= first_row + row_count)
+                    {
+                        continue;
+                    }
+
+                    for (s32 tile = min_x / tile_size; tile <= (max_x - 1) / tile_size; ++tile)
+                    {
+                        dirty[tile] = true;
+                    }
+                }
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        std::vector<region> merge(const std::vector<region>& written, s32 width, s32 height)
+        {
+            std::vector<region> regions;
+
+            if (width <= 0 || height <= 0)
+            {
+                return regions;
+            }
+
+            const s32 tile_columns = (width + tile_size - 1) / tile_size;
+
+            std::vector<bool> dirty(tile_columns);
+            // Regions that end at the current row of tiles, they grow downwards while the next row has a run with the same span
+            std::vector<region> open;
+            std::vector<region> next_open;
+
+            u64 dirty_pixels = 0;
+
+            for (s32 y = 0; y < height; y += tile_size)
+            {
+                const s32 row_count = std::min(tile_size, height - y);
+
+                internal::find_dirty_tiles(written, width, height, y, row_count, dirty);
+
+                next_open.clear();
+
+                for (s32 tile = 0; tile < tile_columns; ++tile)
+                {
+                    if (!dirty[tile])
+                    {
+                        continue;
+                    }
+
+                    const s32 first_tile = tile;
+                    while (tile + 1 < tile_columns && dirty[tile + 1])
+                    {
+                        ++tile;
+                    }
+
+                    region run;
+                    run.x = first_tile * tile_size;
+                    run.y = y;
+                    run.width = std::min((tile + 1) * tile_size, width) - run.x;
+                    run.height = row_count;
+
+                    dirty_pixels += static_cast<u64>(run.width) * run.height;
+
+                    auto it = std::find_if(open.begin(), open.end(), [&run](const region& r) { return r.x == run.x && r.width == run.width; });
+                    if (it != open.end())
+                    {
+                        run.y = it->y;
+                        run.height += it->height;
+
+                        open.erase(it);
+                    }
+
+                    next_open.push_back(run);
+                }
+
+                // Whatever did not continue into this row of tiles is finished
+                regions.insert(regions.end(), open.begin(), open.end());
+
+                std::swap(open, next_open);
+            }
+
+            regions.insert(regions.end(), open.begin(), open.end());
+
+            if (dirty_pixels >= static_cast<u64>(internal::full_upload_ratio * static_cast<f32>(width) * static_cast<f32>(height)))
+            {
+                regions.assign(1, { 0, 0, width, height });
+            }
+
+            return regions;
+        }
+    }
+}
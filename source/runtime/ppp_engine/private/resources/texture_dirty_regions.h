@@ -0,0 +1,27 @@
+#pragma once
+
+#include "util/types.h"
+
+#include <vector>
+
+namespace ppp
+{
+    // Merges the areas that were written to an image into the parts of the image that have to be uploaded.
+    // The areas are snapped to a grid of tiles, dirty tiles are merged into as few rectangles as possible so only those regions are uploaded.
+    namespace texture_dirty_regions
+    {
+        constexpr s32 tile_size = 32;
+
+        struct region
+        {
+            s32 x = 0;
+            s32 y = 0;
+            s32 width = 0;
+            s32 height = 0;
+        };
+
+        // The regions cover every tile an area touches, they are aligned to the tile grid and clipped to the image.
+        // When most of the image is dirty a single region covering the whole image is returned instead.
+        std::vector<region> merge(const std::vector<region>& written, s32 width, s32 height);
+    }
+}
@@ -1,6 +1,8 @@
 #include "resources/texture_pool.h"
 #include "render/render_features.h"
 #include "render/render.h"
+#include "resources/texture_dirty_regions.h"
+#include <algorithm>
 #include <unordered_map>
 
 namespace ppp
@@ -58,7 +60,7 @@ namespace ppp
             default_texture tex;
 
             tex.reserved_slot = reserved_slots_manager().next_reserved_slot();
-            tex.img.image_id = render::create_image_item(width, height, channels, reinterpret_cast<const u8*>(&data), render::image_filter_type::NEAREST, render::image_wrap_type::REPEAT);
+            tex.img.texture_id = render::create_image_item(width, height, channels, reinterpret_cast<const u8*>(&data), render::image_filter_type::NEAREST, render::image_wrap_type::REPEAT);
             tex.img.width = width;
             tex.img.height = height;
             tex.img.channels = channels;
@@ -71,18 +73,92 @@ namespace ppp
 
         struct context
         {
-            images_hash_map images_hash_map;
+            image_slots     images;
+            std::vector<u32> free_slots;
+            u64             frame = 0;
+            std::unordered_map<string::string_id, s32> image_ids;
+
             u8*             active_pixels;
+            // Areas of the active pixels written since they were loaded or last uploaded
+            std::vector<texture_dirty_regions::region> active_dirty_areas;
 
             // default textures
             default_texture image_solid_white;
             default_texture image_solid_black;
         } g_ctx;
 
+        namespace internal
+        {
+            // The lower bits of an id hold the index of the slot, the upper bits its generation
+            constexpr u32 slot_index_bits = 20;
+            constexpr u32 slot_index_mask = (1u << slot_index_bits) - 1;
+            // Keeps ids positive, -1 stays the id of an image that is not in the pool
+            constexpr u32 generation_mask = (1u << (31 - slot_index_bits)) - 1;
+
+            //-------------------------------------------------------------------------
+            s32 make_id(u32 index, u32 generation)
+            {
+                return static_cast<s32>(((generation & generation_mask) << slot_index_bits) | index);
+            }
+
+            //-------------------------------------------------------------------------
+            u32 slot_index(s32 id)
+            {
+                return static_cast<u32>(id) & slot_index_mask;
+            }
+
+            //-------------------------------------------------------------------------
+            u32 slot_generation(s32 id)
+            {
+                return static_cast<u32>(id) >> slot_index_bits;
+            }
+
+            //-------------------------------------------------------------------------
+            // Skips generation 0 so no id is ever 0
+            u32 next_generation(u32 generation)
+            {
+                generation = (generation + 1) & generation_mask;
+
+                return generation == 0 ? 1 : generation;
+            }
+
+            //-------------------------------------------------------------------------
+            u32 allocate_slot()
+            {
+                if (!g_ctx.free_slots.empty())
+                {
+                    const u32 index = g_ctx.free_slots.back();
+                    g_ctx.free_slots.pop_back();
+                    return index;
+                }
+
+                assert(g_ctx.images.size() <= slot_index_mask);
+
+                g_ctx.images.emplace_back();
+                g_ctx.images.back().generation = next_generation(0);
+                return static_cast<u32>(g_ctx.images.size() - 1);
+            }
+
+            //-------------------------------------------------------------------------
+            // Copies a region of the active pixels into the image and uploads only that region
+            void upload_region(const image& img, s32 x, s32 y, s32 width, s32 height)
+            {
+                const u64 row_bytes = static_cast<u64>(img.width) * img.channels;
+                const u64 offset = (static_cast<u64>(y) * img.width + x) * img.channels;
+
+                for (s32 row = 0; row < height; ++row)
+                {
+                    memcpy(img.data + offset + row * row_bytes, g_ctx.active_pixels + offset + row * row_bytes, static_cast<u64>(width) * img.channels);
+                }
+
+                render::update_image_item_region(img.texture_id, x, y, width, height, img.width, img.channels, img.data + offset);
+            }
+        }
+
         //-------------------------------------------------------------------------
-        images_hash_map& all_images()
+        image_slots& all_images()
         {
-            return g_ctx.images_hash_map;
+            return g_ctx.images;
         }
 
         //-------------------------------------------------------------------------
@@ -94,8 +170,8 @@ namespace ppp
             g_ctx.image_solid_white = make_default_texture(white_data);
             g_ctx.image_solid_black = make_default_texture(black_data);
 
-            add_new_image(g_ctx.image_solid_white.img);
-            add_new_image(g_ctx.image_solid_black.img);
+            g_ctx.image_solid_white.img.image_id = add_new_image(g_ctx.image_solid_white.img);
+            g_ctx.image_solid_black.img.image_id = add_new_image(g_ctx.image_solid_black.img);
 
             return true;
         }
@@ -108,10 +184,17 @@ namespace ppp
                 free(g_ctx.active_pixels);
             }
 
-            for (const auto& i : g_ctx.images_hash_map)
+            for (image_slot& slot : g_ctx.images)
             {
-                free(i.second.data);
+                if (slot.occupied)
+                {
+                    release_pixels(slot.img);
+                }
             }
+
+            g_ctx.images.clear();
+            g_ctx.free_slots.clear();
+            g_ctx.image_ids.clear();
         }
 
         //-------------------------------------------------------------------------
@@ -135,27 +218,22 @@ namespace ppp
         //-------------------------------------------------------------------------
         bool has_image(string::string_id file_path)
         {
-            return g_ctx.images_hash_map.find(file_path) != g_ctx.images_hash_map.cend();
+            return g_ctx.image_ids.find(file_path) != g_ctx.image_ids.cend();
         }
 
         //-------------------------------------------------------------------------
         bool has_image(s32 id)
         {
-            auto it = std::find_if(std::cbegin(g_ctx.images_hash_map), std::cend(g_ctx.images_hash_map),
-                [id](const auto& pair)
-            {
-                return pair.second.image_id == id;
-            });
-
-            return it != g_ctx.images_hash_map.cend();
+            return slot_at_id(id) != nullptr;
         }
 
         //-------------------------------------------------------------------------
         const image* image_at_path(string::string_id file_path)
         {
-            if (has_image(file_path))
+            auto it = g_ctx.image_ids.find(file_path);
+            if (it != g_ctx.image_ids.cend())
             {
-                return &g_ctx.images_hash_map.find(file_path)->second;
+                return image_at_id(it->second);
             }
 
             return nullptr;
@@ -164,18 +242,9 @@ namespace ppp
         //-------------------------------------------------------------------------
         const image* image_at_id(s32 id)
         {
-            if (has_image(id))
-            {
-                auto it = std::find_if(std::cbegin(g_ctx.images_hash_map), std::cend(g_ctx.images_hash_map),
-                    [id](const auto& pair)
-                {
-                    return pair.second.image_id == id;
-                });
+            const image_slot* slot = slot_at_id(id);
 
-                return &it->second;
-            }
-
-            return nullptr;
+            return slot != nullptr ? &slot->img : nullptr;
         }
 
         //-------------------------------------------------------------------------
@@ -193,9 +262,192 @@ namespace ppp
         }
 
         //-------------------------------------------------------------------------
-        void add_new_image(const image& image)
+        s32 add_new_image(const image& image)
         {
-            g_ctx.images_hash_map.emplace(image.file_path, image);
+            u32 index = 0;
+
+            image_slot* existing = slot_at_id(image.image_id);
+            if (existing != nullptr)
+            {
+                // Replacing an image keeps its id, the previous pixels are released
+                index = internal::slot_index(image.image_id);
+
+                auto it = g_ctx.image_ids.find(existing->img.file_path);
+                if (it != g_ctx.image_ids.cend() && it->second == image.image_id)
+                {
+                    g_ctx.image_ids.erase(it);
+                }
+
+                if (existing->img.data != image.data)
+                {
+                    release_pixels(existing->img);
+                }
+            }
+            else
+            {
+                index = internal::allocate_slot();
+            }
+
+            image_slot& slot = g_ctx.images[index];
+            const s32 id = internal::make_id(index, slot.generation);
+
+            slot.img = image;
+            slot.img.image_id = id;
+            slot.occupied = true;
+            slot.evicted = false;
+            slot.edited = false;
+            slot.last_used_frame = g_ctx.frame;
+
+            if (slot.img.gpu_bytes == 0)
+            {
+                slot.img.gpu_bytes = static_cast<u64>(slot.img.width) * slot.img.height * slot.img.channels;
+            }
+
+            if (!image.file_path.is_none())
+            {
+                g_ctx.image_ids[image.file_path] = id;
+            }
+
+            return id;
+        }
+
+        //-------------------------------------------------------------------------
+        void remove_image(s32 id)
+        {
+            image_slot* found = slot_at_id(id);
+            if (found == nullptr)
+            {
+                return;
+            }
+
+            image_slot& slot = *found;
+
+            auto it = g_ctx.image_ids.find(slot.img.file_path);
+            if (it != g_ctx.image_ids.cend() && it->second == id)
+            {
+                g_ctx.image_ids.erase(it);
+            }
+
+            release_pixels(slot.img);
+
+            slot.img = {};
+            slot.occupied = false;
+            slot.evicted = false;
+            slot.edited = false;
+            slot.generation = internal::next_generation(slot.generation);
+
+            g_ctx.free_slots.push_back(internal::slot_index(id));
+        }
+
+        //-------------------------------------------------------------------------
+        image_slot* slot_at_id(s32 id)
+        {
+            if (id <= 0)
+            {
+                return nullptr;
+            }
+
+            const u32 index = internal::slot_index(id);
+            if (index >= g_ctx.images.size())
+            {
+                return nullptr;
+            }
+
+            image_slot& slot = g_ctx.images[index];
+
+            return slot.occupied && slot.generation == internal::slot_generation(id) ? &slot : nullptr;
+        }
+
+        //-------------------------------------------------------------------------
+        void release_pixels(image& img)
+        {
+            if (img.data != nullptr)
+            {
+                switch (img.ownership)
+                {
+                case pixel_ownership::OWNED:
+                    free(img.data);
+                    break;
+                case pixel_ownership::ADOPTED:
+                    if (img.deleter)
+                    {
+                        img.deleter(img.data);
+                    }
+                    break;
+                case pixel_ownership::BORROWED:
+                    break;
+                }
+            }
+
+            img.data = nullptr;
+            img.ownership = pixel_ownership::OWNED;
+            img.deleter = nullptr;
+        }
+
+        //-------------------------------------------------------------------------
+        pixel_memory pixel_memory_usage()
+        {
+            pixel_memory memory;
+
+            for (const image_slot& slot : g_ctx.images)
+            {
+                if (!slot.occupied || slot.img.data == nullptr)
+                {
+                    continue;
+                }
+
+                const u64 size = static_cast<u64>(slot.img.width) * slot.img.height * slot.img.channels;
+
+                switch (slot.img.ownership)
+                {
+                case pixel_ownership::OWNED: memory.owned += size; break;
+                case pixel_ownership::ADOPTED: memory.adopted += size; break;
+                case pixel_ownership::BORROWED: memory.borrowed += size; break;
+                }
+            }
+
+            return memory;
+        }
+
+        //-------------------------------------------------------------------------
+        u32 image_generation(s32 id)
+        {
+            if (id <= 0 || internal::slot_index(id) >= g_ctx.images.size())
+            {
+                return 0;
+            }
+
+            return g_ctx.images[internal::slot_index(id)].generation;
+        }
+
+        //-------------------------------------------------------------------------
+        u64 frame_index()
+        {
+            return g_ctx.frame;
+        }
+
+        //-------------------------------------------------------------------------
+        void next_frame()
+        {
+            ++g_ctx.frame;
+        }
+
+        //-------------------------------------------------------------------------
+        void mark_used(s32 id)
+        {
+            if (image_slot* slot = slot_at_id(id))
+            {
+                slot->last_used_frame = g_ctx.frame;
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        void mark_edited(s32 id)
+        {
+            if (image_slot* slot = slot_at_id(id))
+            {
+                slot->edited = true;
+            }
         }
 
         //-------------------------------------------------------------------------
@@ -203,7 +455,8 @@ namespace ppp
         {
             const image* img = image_at_id(id);
 
-            if (img != nullptr)
+            // Compressed images do not keep their pixels
+            if (img != nullptr && img->data != nullptr)
             {
                 if (g_ctx.active_pixels != nullptr)
                 {
@@ -211,6 +464,7 @@ namespace ppp
                 }
 
                 g_ctx.active_pixels = (u8*)malloc(img->width * img->height * img->channels);
+                g_ctx.active_dirty_areas.clear();
 
                 memcpy(g_ctx.active_pixels, img->data, img->width * img->height * img->channels);
             }
@@ -227,19 +481,62 @@ namespace ppp
             }
 
             g_ctx.active_pixels = (u8*)malloc((width - x) * (height - y) * channels);
+            g_ctx.active_dirty_areas.clear();
 
             return g_ctx.active_pixels;
         }
 
+        //-------------------------------------------------------------------------
+        void mark_active_pixels_dirty(s32 x, s32 y, s32 width, s32 height)
+        {
+            if (width > 0 && height > 0)
+            {
+                g_ctx.active_dirty_areas.push_back({ x, y, width, height });
+            }
+        }
+
         //-------------------------------------------------------------------------
         void update_active_pixels(s32 id)
         {
             const image* img = image_at_id(id);
-            if (img != nullptr)
+            if (img != nullptr && img->data != nullptr)
             {
-                memcpy(img->data, g_ctx.active_pixels, img->width * img->height * img->channels);
+                // Only the tiles of the recorded areas are copied and uploaded, without them any pixel could have been written
+                const auto regions = g_ctx.active_dirty_areas.empty()
+                    ? std::vector<texture_dirty_regions::region>(1, { 0, 0, img->width, img->height })
+                    : texture_dirty_regions::merge(g_ctx.active_dirty_areas, img->width, img->height);
+
+                for (const texture_dirty_regions::region& region : regions)
+                {
+                    internal::upload_region(*img, region.x, region.y, region.width, region.height);
+                }
 
-                render::update_image_item(id, 0, 0, img->width, img->height, img->channels, img->data);
+                if (!regions.empty())
+                {
+                    mark_edited(id);
+                }
+
+                g_ctx.active_dirty_areas.clear();
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        void update_active_pixels(s32 id, s32 x, s32 y, s32 width, s32 height)
+        {
+            const image* img = image_at_id(id);
+            if (img != nullptr && img->data != nullptr)
+            {
+                const s32 min_x = std::clamp(x, 0, img->width);
+                const s32 min_y = std::clamp(y, 0, img->height);
+                const s32 max_x = std::clamp(x + width, 0, img->width);
+                const s32 max_y = std::clamp(y + height, 0, img->height);
+
+                if (max_x > min_x && max_y > min_y)
+                {
+                    internal::upload_region(*img, min_x, min_y, max_x - min_x, max_y - min_y);
+
+                    mark_edited(id);
+                }
             }
         }
 
@@ -3,29 +3,70 @@
 
 #include "util/types.h"
 #include "string/string_id.h"
+#include "fileio/file_stamp.h"
 
+#include <functional>
 #include <string>
+#include <vector>
 
 namespace ppp
 {
     namespace texture_pool
     {
+        // Who releases the pixels of an image
+        enum class pixel_ownership
+        {
+            OWNED,      // Allocated with malloc by the engine, freed by the pool
+            ADOPTED,    // Handed over by the caller without a copy, released through the deleter of the image
+            BORROWED    // Owned by the caller, who keeps them alive until the image is removed
+        };
+
+        using pixel_deleter = std::function<void(u8*)>;
+
         struct image
         {
             string::string_id   file_path = string::string_id::create_invalid();
 
+            // Handle handed out by the pool ( see `add_new_image` ) and the name of the texture on the GPU
             s32                 image_id = -1;
+            u32                 texture_id = 0;
 
             s32			        width = -1;
             s32			        height = -1;
             s32			        channels = -1;
 
             u8*                 data = nullptr;
+            pixel_ownership     ownership = pixel_ownership::OWNED;
+            pixel_deleter       deleter;
+
+            // Size of the texture on the GPU, computed from the size and channels when left at 0 ( compressed images fill it in )
+            u64                 gpu_bytes = 0;
+
+            // State of the source file when it was decoded, used to skip unchanged files on reload
+            fileio::file_stamp  stamp = {};
+            u64                 content_hash = 0;
+        };
+
+        //-------------------------------------------------------------------------
+        // Slots are allocated densely by the pool and reused after an image is removed.
+        // The id of an image holds the index of its slot and the generation of the slot, the generation changes every time the slot is reused
+        // so an id of a removed image never resolves to the image that took over its slot.
+        struct image_slot
+        {
+            image   img{};
+            u32     generation = 0;
+            bool    occupied = false;
+
+            // Residency, an evicted image has neither pixels nor texture storage until it is used again
+            u64     last_used_frame = 0;
+            bool    evicted = false;
+            // The pixels were changed after decoding, they can not be loaded from the file again
+            bool    edited = false;
         };
 
-        using images_hash_map = std::unordered_map<string::string_id, image>;
+        using image_slots = std::vector<image_slot>;
 
-        images_hash_map& all_images();
+        image_slots& all_images();
 
         bool initialize();
         void terminate();
@@ -42,12 +83,46 @@ namespace ppp
         const image* image_solid_white();
         const image* image_solid_black();
 
-        void add_new_image(const image& image);
+        // Stores the image in a free slot and returns its id, the id is also written to the stored image
+        // An image with the id of an image in the pool replaces that image and keeps the id
+        s32 add_new_image(const image& image);
+        // Frees the pixels of the image and releases its slot, the texture itself is not deleted
+        void remove_image(s32 id);
+
+        // Slot of an image in the pool, nullptr for unknown or removed ids
+        image_slot* slot_at_id(s32 id);
+
+        // Releases the pixels according to their ownership, the image no longer references any pixels afterwards
+        void release_pixels(image& img);
+
+        struct pixel_memory
+        {
+            u64 owned = 0;
+            u64 adopted = 0;
+            u64 borrowed = 0;
+        };
+
+        // Bytes of the pixels referenced by the pool, per ownership
+        pixel_memory pixel_memory_usage();
+
+        // Generation of the slot the id refers to, it changes whenever the image in the slot is removed, 0 when there never was a slot
+        u32 image_generation(s32 id);
+
+        // Frame counter of the pool, images remember the frame they were last used in
+        u64 frame_index();
+        void next_frame();
+        void mark_used(s32 id);
+        void mark_edited(s32 id);
 
         u8* load_active_pixels(s32 id);
         u8* load_active_pixels(s32 x, s32 y, s32 width, s32 height, s32 channels);
 
+        // Records an area of the active pixels that was written, the areas are forgotten when other pixels are loaded
+        void mark_active_pixels_dirty(s32 x, s32 y, s32 width, s32 height);
+        // Uploads the tiles covered by the recorded areas, the whole image when no area was recorded
         void update_active_pixels(s32 id);
+        // Uploads a region of the active pixels without comparing them, the region is clipped to the image
+        void update_active_pixels(s32 id, s32 x, s32 y, s32 width, s32 height);
 
         u8* active_pixels();
     }
@@ -1,75 +1,141 @@
 #include "resources/texture_reloader.h"
 #include "resources/texture_pool.h"
+#include "resources/texture_atlas.h"
+#include "resources/image_decoder.h"
 
-#include "fileio/fileio.h"
 #include "fileio/vfs.h"
+#include "fileio/file_stamp.h"
 
 #include "render/render.h"
 
-#include "image.h"
+#include "util/log.h"
+#include "util/parallel_for.h"
 
-#include <stb/stb_image.h>
+#include <string>
+#include <vector>
 
 namespace ppp
 {
     namespace texture_reloader
     {
-        s32 reload()
+        namespace internal
         {
-            s32 count = 0;
+            struct reload_candidate
+            {
+                s32                 image_id = -1;
+                std::string         path;
+                fileio::file_stamp  stamp;
+                bool                changed = true;
+            };
+        }
+
+        reload_result reload()
+        {
+            texture_pool::image_slots& all_images = texture_pool::all_images();
 
-            texture_pool::images_hash_map& all_images = texture_pool::all_images();
-            for (auto& pair : all_images)
+            reload_result result;
+
+            // Resolve the paths up front, the vfs is not safe to use from the worker threads
+            std::vector<internal::reload_candidate> candidates;
+
+            for (const auto& slot : all_images)
             {
-                if (pair.first.is_none())
+                // Compressed images keep no pixels, they are cooked again the next time they are loaded.
+                // Evicted images have no pixels either, they are decoded from the file when they are used again.
+                if (!slot.occupied || slot.img.file_path.is_none() || slot.img.data == nullptr)
                 {
                     continue;
                 }
 
-                auto file_path = string::restore_sid(pair.first);
+                auto file_path = string::restore_sid(slot.img.file_path);
                 if (file_path.empty())
                 {
                     log::error("Invalid file path for image found.");
                     continue;
                 }
 
-                auto& img = pair.second;
+                internal::reload_candidate candidate;
+                candidate.image_id = slot.img.image_id;
+                candidate.path = vfs::resolve_path(file_path);
+                candidate.stamp = fileio::read_file_stamp(candidate.path);
+
+                if (candidate.stamp.valid() && candidate.stamp == slot.img.stamp)
+                {
+                    ++result.skipped;
+                    continue;
+                }
+
+                candidates.push_back(std::move(candidate));
+            }
+
+            // Only the write time changed ( e.g. the file was saved without edits ), the contents decide whether it has to be decoded again
+            parallel_for(candidates.size(), [&candidates](u64 i)
+            {
+                auto& candidate = candidates[i];
+                const auto& img = texture_pool::slot_at_id(candidate.image_id)->img;
+
+                if (candidate.stamp.valid() && candidate.stamp.size == img.stamp.size)
+                {
+                    candidate.changed = fileio::hash_resolved_file(candidate.path) != img.content_hash;
+                }
+            });
+
+            std::vector<s32> reload_ids;
+            std::vector<std::string> reload_paths;
 
-                auto buffer = fileio::read_binary_file(vfs::resolve_path(file_path));
-                if (buffer.empty())
+            for (auto& candidate : candidates)
+            {
+                if (!candidate.changed)
                 {
-                    log::error("Unable to read binary from disk.");
+                    texture_pool::slot_at_id(candidate.image_id)->img.stamp = candidate.stamp;
+
+                    ++result.skipped;
                     continue;
                 }
 
-                s32 width, height, channels;
-                u8* data = stbi_load_from_memory(
-                    reinterpret_cast<pixels_u8_ptr>(buffer.data()),
-                    static_cast<s32>(buffer.size()),
-                    &width,
-                    &height,
-                    &channels,
-                    0);
+                reload_ids.push_back(candidate.image_id);
+                reload_paths.push_back(std::move(candidate.path));
+            }
+
+            std::vector<texture_pool::image> decoded = image_decoder::decode_all(reload_paths);
 
-                if (data == nullptr)
+            // Upload on this thread in slot order, errors are reported per image
+            for (u64 i = 0; i < decoded.size(); ++i)
+            {
+                if (decoded[i].data == nullptr)
                 {
-                    log::error("Image {} could not be reloaded!", file_path);
+                    log::error("Image {} could not be reloaded!", reload_paths[i]);
                     continue;
                 }
 
-                free(img.data);
+                auto& slot = *texture_pool::slot_at_id(reload_ids[i]);
+                auto& img = slot.img;
+
+                // The file replaces any edits, the image can be evicted and loaded again
+                slot.edited = false;
+
+                // The decoded pixels belong to the pool, whoever owned the previous ones releases them
+                texture_pool::release_pixels(img);
 
-                img.data = data;
-                img.width = width;
-                img.height = height;
-                img.channels = channels;
+                img.data = decoded[i].data;
+                img.width = decoded[i].width;
+                img.height = decoded[i].height;
+                img.channels = decoded[i].channels;
+                img.stamp = decoded[i].stamp;
+                img.content_hash = decoded[i].content_hash;
 
-                render::update_image_item(img.image_id, 0, 0, img.width, img.height, img.channels, img.data);
+                render::update_image_item(img.texture_id, 0, 0, img.width, img.height, img.channels, img.data);
+                texture_atlas::update_image(img);
 
-                ++count;
+                ++result.reloaded;
+            }
+
+            if (result.skipped > 0)
+            {
+                log::info("{} unchanged images were not reloaded", result.skipped);
             }
 
-            return count;
+            return result;
         }
     }
-}
\ No newline at end of file
+}
@@ -6,6 +6,14 @@ namespace ppp
 {
     namespace texture_reloader
     {
-        s32 reload();
+        struct reload_result
+        {
+            s32 reloaded = 0;
+            // Images whose file did not change since it was decoded
+            s32 skipped = 0;
+        };
+
+        // Decodes and uploads the images whose source file changed on disk, unchanged files are not read again
+        reload_result reload();
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,250 @@
+#include "resources/texture_residency.h"
+#include "resources/texture_pool.h"
+#include "resources/material_pool.h"
+#include "resources/texture_atlas.h"
+#include "resources/image_decoder.h"
+
+#include "fileio/vfs.h"
+
+#include "render/render.h"
+
+#include "util/log.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace ppp
+{
+    namespace texture_residency
+    {
+        struct context
+        {
+            memory_budget   budget;
+
+            u64             evictions = 0;
+            u64             reloads = 0;
+            u64             failed_reloads = 0;
+        } g_ctx;
+
+        namespace internal
+        {
+            //-------------------------------------------------------------------------
+            bool is_over_budget(const residency_statistics& stats)
+            {
+                return (g_ctx.budget.cpu_bytes != 0 && stats.cpu_bytes > g_ctx.budget.cpu_bytes)
+                    || (g_ctx.budget.gpu_bytes != 0 && stats.gpu_bytes > g_ctx.budget.gpu_bytes);
+            }
+
+            //-------------------------------------------------------------------------
+            u64 cpu_bytes(const texture_pool::image& img)
+            {
+                if (img.data == nullptr || img.ownership == texture_pool::pixel_ownership::BORROWED)
+                {
+                    return 0;
+                }
+
+                return static_cast<u64>(img.width) * img.height * img.channels;
+            }
+
+            //-------------------------------------------------------------------------
+            bool reload(texture_pool::image_slot& slot)
+            {
+                texture_pool::image& img = slot.img;
+
+                // Resolved on this thread, the vfs is not safe to use from the worker threads
+                const std::string path = vfs::resolve_path(string::restore_sid(img.file_path));
+
+                texture_pool::image decoded = image_decoder::decode(path);
+                if (decoded.data == nullptr)
+                {
+                    log::error("Evicted image {} could not be loaded again!", path);
+
+                    ++g_ctx.failed_reloads;
+                    return false;
+                }
+
+                const bool changed = decoded.content_hash != img.content_hash;
+
+                img.data = decoded.data;
+                img.ownership = texture_pool::pixel_ownership::OWNED;
+                img.width = decoded.width;
+                img.height = decoded.height;
+                img.channels = decoded.channels;
+                img.stamp = decoded.stamp;
+                img.content_hash = decoded.content_hash;
+                img.gpu_bytes = static_cast<u64>(img.width) * img.height * img.channels;
+
+                render::restore_image_item(img.texture_id, img.width, img.height, img.channels, img.data);
+
+                // The atlas kept its copy while the image was evicted, it only needs the pixels when the file changed in the meantime
+                if (changed)
+                {
+                    texture_atlas::update_image(img);
+                }
+
+                slot.evicted = false;
+
+                ++g_ctx.reloads;
+
+                return true;
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        void set_budget(const memory_budget& budget)
+        {
+            g_ctx.budget = budget;
+        }
+
+        //-------------------------------------------------------------------------
+        const memory_budget& budget()
+        {
+            return g_ctx.budget;
+        }
+
+        //-------------------------------------------------------------------------
+        bool touch(s32 id)
+        {
+            if (!texture_pool::has_image(id))
+            {
+                return false;
+            }
+
+            texture_pool::mark_used(id);
+
+            texture_pool::image_slot& slot = *texture_pool::slot_at_id(id);
+
+            return !slot.evicted || internal::reload(slot);
+        }
+
+        //-------------------------------------------------------------------------
+        bool is_resident(s32 id)
+        {
+            const texture_pool::image_slot* slot = texture_pool::slot_at_id(id);
+
+            return slot != nullptr && !slot->evicted;
+        }
+
+        //-------------------------------------------------------------------------
+        bool is_evictable(s32 id)
+        {
+            if (!is_resident(id))
+            {
+                return false;
+            }
+
+            const texture_pool::image_slot& slot = *texture_pool::slot_at_id(id);
+
+            // Only pixels that can be decoded again from their file ( the default textures have none ), compressed images keep no pixels to begin with
+            if (slot.edited || slot.img.file_path.is_none() || slot.img.data == nullptr || slot.img.ownership != texture_pool::pixel_ownership::OWNED)
+            {
+                return false;
+            }
+
+            // A texture bound to a shader is sampled by every draw of that shader, even when the image itself is not touched again
+            return !material_pool::texture_cache::is_bound(slot.img.texture_id);
+        }
+
+        //-------------------------------------------------------------------------
+        bool evict(s32 id)
+        {
+            if (!is_evictable(id))
+            {
+                return false;
+            }
+
+            texture_pool::image_slot& slot = *texture_pool::slot_at_id(id);
+
+            texture_pool::release_pixels(slot.img);
+            render::evict_image_item(slot.img.texture_id);
+
+            slot.evicted = true;
+
+            ++g_ctx.evictions;
+
+            return true;
+        }
+
+        //-------------------------------------------------------------------------
+        void enforce_budget()
+        {
+            residency_statistics stats = statistics();
+            if (!internal::is_over_budget(stats))
+            {
+                return;
+            }
+
+            texture_pool::image_slots& slots = texture_pool::all_images();
+
+            const u64 frame = texture_pool::frame_index();
+
+            // Images used in this frame are never evicted, when they alone exceed the budget it stays exceeded until they are no longer used
+            std::vector<texture_pool::image_slot*> candidates;
+            for (texture_pool::image_slot& slot : slots)
+            {
+                if (slot.occupied && slot.last_used_frame < frame && is_evictable(slot.img.image_id))
+                {
+                    candidates.push_back(&slot);
+                }
+            }
+
+            // Least recently used first, ties go to the lowest slot
+            std::stable_sort(candidates.begin(), candidates.end(), [](const texture_pool::image_slot* a, const texture_pool::image_slot* b) { return a->last_used_frame < b->last_used_frame; });
+
+            for (texture_pool::image_slot* slot : candidates)
+            {
+                if (!internal::is_over_budget(stats))
+                {
+                    break;
+                }
+
+                const texture_pool::image& img = slot->img;
+
+                stats.cpu_bytes -= internal::cpu_bytes(img);
+                stats.gpu_bytes -= img.gpu_bytes;
+
+                evict(img.image_id);
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        void end_frame()
+        {
+            enforce_budget();
+
+            texture_pool::next_frame();
+        }
+
+        //-------------------------------------------------------------------------
+        residency_statistics statistics()
+        {
+            residency_statistics stats;
+
+            for (const texture_pool::image_slot& slot : texture_pool::all_images())
+            {
+                if (!slot.occupied)
+                {
+                    continue;
+                }
+
+                if (slot.evicted)
+                {
+                    ++stats.evicted;
+                    continue;
+                }
+
+                ++stats.resident;
+
+                stats.cpu_bytes += internal::cpu_bytes(slot.img);
+                stats.gpu_bytes += slot.img.gpu_bytes;
+            }
+
+            stats.budget = g_ctx.budget;
+            stats.evictions = g_ctx.evictions;
+            stats.reloads = g_ctx.reloads;
+            stats.failed_reloads = g_ctx.failed_reloads;
+
+            return stats;
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "util/types.h"
+
+namespace ppp
+{
+    // Keeps the memory of the texture pool within a budget.
+    // At the end of every frame the least recently used images are evicted: their pixels are freed and their texture storage released.
+    // Only images that were loaded from a file can be evicted, they are decoded and uploaded again the next time they are used.
+    namespace texture_residency
+    {
+        // A budget of 0 bytes is unlimited
+        struct memory_budget
+        {
+            u64 cpu_bytes = 0;
+            u64 gpu_bytes = 0;
+        };
+
+        struct residency_statistics
+        {
+            // Pixels the pool is responsible for ( borrowed pixels are not counted ) and the texture storage of resident images
+            u64             cpu_bytes = 0;
+            u64             gpu_bytes = 0;
+
+            memory_budget   budget;
+
+            u32             resident = 0;
+            u32             evicted = 0;
+
+            // Totals since the start of the application
+            u64             evictions = 0;
+            u64             reloads = 0;
+            u64             failed_reloads = 0;
+        };
+
+        void set_budget(const memory_budget& budget);
+        const memory_budget& budget();
+
+        // Marks the image as used this frame, an evicted image is loaded again first
+        // Returns false when the image does not exist or could not be loaded again
+        bool touch(s32 id);
+
+        bool is_resident(s32 id);
+        bool is_evictable(s32 id);
+
+        bool evict(s32 id);
+
+        // Evicts the least recently used images until the pool fits the budget, images used in the current frame are kept
+        void enforce_budget();
+
+        // Enforces the budget and starts the next frame, called by the engine after a frame was rendered
+        void end_frame();
+
+        residency_statistics statistics();
+    }
+}
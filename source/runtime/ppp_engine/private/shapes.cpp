@@ -112,6 +112,11 @@ namespace ppp
             return m_material;
         }
 
+        const geometry::bounding_box* local_bounds() const override
+        {
+            return &m_geometry->aabb();
+        }
+
     private:
         const geometry::geometry*       m_geometry;
         const resources::imaterial*     m_material;
@@ -0,0 +1,184 @@
+#include "util/async_loader.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ppp
+{
+    namespace async_loader
+    {
+        //-------------------------------------------------------------------------
+        struct job
+        {
+            work_fn work;
+            completion_fn completion;
+        };
+
+        //-------------------------------------------------------------------------
+        struct context
+        {
+            std::vector<std::thread> workers;
+
+            std::mutex mutex;
+            std::condition_variable work_available;
+            std::condition_variable work_finished;
+
+            std::deque<job> queued_jobs;
+            std::vector<completion_fn> completed_jobs;
+
+            // Jobs that were submitted but did not finish their work yet
+            u32 busy_count = 0;
+
+            bool stopping = false;
+        } g_ctx;
+
+        //-------------------------------------------------------------------------
+        static void finish_job(completion_fn&& completion)
+        {
+            std::lock_guard<std::mutex> lock(g_ctx.mutex);
+
+            g_ctx.completed_jobs.push_back(std::move(completion));
+
+            --g_ctx.busy_count;
+
+            g_ctx.work_finished.notify_all();
+        }
+
+        //-------------------------------------------------------------------------
+        static void worker_loop()
+        {
+            while (true)
+            {
+                job next_job;
+                {
+                    std::unique_lock<std::mutex> lock(g_ctx.mutex);
+
+                    g_ctx.work_available.wait(lock, []() { return g_ctx.stopping || !g_ctx.queued_jobs.empty(); });
+
+                    if (g_ctx.stopping)
+                    {
+                        return;
+                    }
+
+                    next_job = std::move(g_ctx.queued_jobs.front());
+                    g_ctx.queued_jobs.pop_front();
+                }
+
+                if (next_job.work)
+                {
+                    next_job.work();
+                }
+
+                finish_job(std::move(next_job.completion));
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        bool initialize(u32 worker_count)
+        {
+            g_ctx.stopping = false;
+
+            g_ctx.workers.reserve(worker_count);
+            for (u32 i = 0; i < worker_count; ++i)
+            {
+                g_ctx.workers.emplace_back(worker_loop);
+            }
+
+            return true;
+        }
+
+        //-------------------------------------------------------------------------
+        void terminate()
+        {
+            {
+                std::lock_guard<std::mutex> lock(g_ctx.mutex);
+
+                // Work that did not start yet is dropped, running work is finished first
+                g_ctx.busy_count -= static_cast<u32>(g_ctx.queued_jobs.size());
+                g_ctx.queued_jobs.clear();
+
+                g_ctx.stopping = true;
+            }
+
+            g_ctx.work_available.notify_all();
+
+            for (std::thread& worker : g_ctx.workers)
+            {
+                worker.join();
+            }
+
+            g_ctx.workers.clear();
+            g_ctx.completed_jobs.clear();
+            g_ctx.busy_count = 0;
+        }
+
+        //-------------------------------------------------------------------------
+        void submit(work_fn work, completion_fn completion)
+        {
+            if (g_ctx.workers.empty())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(g_ctx.mutex);
+                    ++g_ctx.busy_count;
+                }
+
+                if (work)
+                {
+                    work();
+                }
+
+                finish_job(std::move(completion));
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(g_ctx.mutex);
+
+                g_ctx.queued_jobs.push_back({ std::move(work), std::move(completion) });
+
+                ++g_ctx.busy_count;
+            }
+
+            g_ctx.work_available.notify_one();
+        }
+
+        //-------------------------------------------------------------------------
+        void process_completed()
+        {
+            std::vector<completion_fn> completed;
+            {
+                std::lock_guard<std::mutex> lock(g_ctx.mutex);
+
+                std::swap(completed, g_ctx.completed_jobs);
+            }
+
+            for (completion_fn& completion : completed)
+            {
+                if (completion)
+                {
+                    completion();
+                }
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        void wait_idle()
+        {
+            std::unique_lock<std::mutex> lock(g_ctx.mutex);
+
+            g_ctx.work_finished.wait(lock, []() { return g_ctx.busy_count == 0; });
+        }
+
+        //-------------------------------------------------------------------------
+        u32 pending_count()
+        {
+            std::lock_guard<std::mutex> lock(g_ctx.mutex);
+
+            return g_ctx.busy_count + static_cast<u32>(g_ctx.completed_jobs.size());
+        }
+    }
+}
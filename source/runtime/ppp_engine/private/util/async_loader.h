@@ -0,0 +1,30 @@
+#pragma once
+
+#include "util/types.h"
+
+#include <functional>
+
+namespace ppp
+{
+    // Runs loading work ( file I/O, parsing, decoding ) on worker threads.
+    // The completion of every job is deferred to the main thread, GPU resources can only be created there.
+    namespace async_loader
+    {
+        using work_fn = std::function<void()>;
+        using completion_fn = std::function<void()>;
+
+        // With 0 worker threads the work runs inline when it is submitted, completions are still deferred to `process_completed`
+        bool initialize(u32 worker_count);
+        void terminate();
+
+        void submit(work_fn work, completion_fn completion);
+
+        // Runs the completions of all finished jobs, called by the engine at the start of every frame
+        void process_completed();
+
+        // Blocks until every submitted job has finished its work ( its completion still has to be processed )
+        void wait_idle();
+
+        u32 pending_count();
+    }
+}
@@ -0,0 +1,539 @@
+#include "util/frame_capture.h"
+#include "util/log.h"
+
+#include "resources/qoi.h"
+
+#include <stb/stb_image_write.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ppp
+{
+    namespace frame_capture
+    {
+        //-------------------------------------------------------------------------
+        struct frame
+        {
+            std::vector<u8> pixels;
+
+            s32 width = 0;
+            s32 height = 0;
+
+            u64 index = 0;
+        };
+
+        //-------------------------------------------------------------------------
+        struct context
+        {
+            capture_settings settings;
+
+            std::vector<std::thread> encoders;
+
+            std::mutex mutex;
+            std::condition_variable frame_available;
+            std::condition_variable buffer_available;
+            std::condition_variable frame_finished;
+
+            std::deque<frame> queued_frames;
+            std::vector<std::vector<u8>> free_buffers;
+            u32 allocated_buffers = 0;
+
+            // Frames that were accepted but are not finished yet
+            u32 busy_count = 0;
+            u64 next_frame = 0;
+
+            capture_statistics statistics;
+
+            bool capturing = false;
+            bool stopping = false;
+
+            // The Y4M stream is written in frame order, converted frames that are ahead of the stream wait in `converted_frames`
+            std::mutex stream_mutex;
+            std::ofstream stream;
+            std::map<u64, std::vector<u8>> converted_frames;
+            u64 next_stream_frame = 0;
+
+            s32 stream_width = 0;
+            s32 stream_height = 0;
+        } g_ctx;
+
+        namespace internal
+        {
+            //-------------------------------------------------------------------------
+            void release_buffer(std::vector<u8>&& buffer)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(g_ctx.mutex);
+
+                    g_ctx.free_buffers.push_back(std::move(buffer));
+                }
+
+                g_ctx.buffer_available.notify_one();
+            }
+
+            //-------------------------------------------------------------------------
+            void finish_frame(u64 written, u64 failed)
+            {
+                std::lock_guard<std::mutex> lock(g_ctx.mutex);
+
+                g_ctx.statistics.written += written;
+                g_ctx.statistics.failed += failed;
+
+                g_ctx.frame_finished.notify_all();
+            }
+
+            //-------------------------------------------------------------------------
+            void copy_frame(std::vector<u8>& buffer, const u8* pixels, s32 width, s32 height, bool flip_vertically)
+            {
+                const u64 row_size = static_cast<u64>(width) * 4;
+
+                buffer.resize(row_size * height);
+
+                if (!flip_vertically)
+                {
+                    memcpy(buffer.data(), pixels, buffer.size());
+                    return;
+                }
+
+                for (s32 y = 0; y < height; ++y)
+                {
+                    memcpy(buffer.data() + row_size * y, pixels + row_size * (height - 1 - y), row_size);
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            bool write_file(const std::string& path, const std::vector<u8>& data)
+            {
+                std::ofstream file(path, std::ios::binary | std::ios::trunc);
+                if (!file.is_open())
+                {
+                    return false;
+                }
+
+                file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+                return file.good();
+            }
+
+            //-------------------------------------------------------------------------
+            u8 clamp_to_byte(s32 value)
+            {
+                return static_cast<u8>(std::clamp(value, 0, 255));
+            }
+
+            //-------------------------------------------------------------------------
+            // Full range BT.601 ( the JPEG variant ), planes are stored one after the other: Y, Cb, Cr
+            std::vector<u8> convert_to_yuv420(const frame& f)
+            {
+                const s32 chroma_width = (f.width + 1) / 2;
+                const s32 chroma_height = (f.height + 1) / 2;
+
+                const u64 luma_size = static_cast<u64>(f.width) * f.height;
+                const u64 chroma_size = static_cast<u64>(chroma_width) * chroma_height;
+
+                std::vector<u8> yuv(luma_size + chroma_size * 2);
+
+                u8* plane_y = yuv.data();
+                u8* plane_u = plane_y + luma_size;
+                u8* plane_v = plane_u + chroma_size;
+
+                for (s32 y = 0; y < f.height; ++y)
+                {
+                    const u8* row = f.pixels.data() + static_cast<u64>(y) * f.width * 4;
+
+                    for (s32 x = 0; x < f.width; ++x)
+                    {
+                        const u8* p = row + x * 4;
+
+                        plane_y[static_cast<u64>(y) * f.width + x] = static_cast<u8>((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+                    }
+                }
+
+                for (s32 cy = 0; cy < chroma_height; ++cy)
+                {
+                    for (s32 cx = 0; cx < chroma_width; ++cx)
+                    {
+                        s32 r = 0;
+                        s32 g = 0;
+                        s32 b = 0;
+                        s32 count = 0;
+
+                        // Average the 2x2 block, blocks on an odd edge only cover the pixels that exist
+                        for (s32 y = cy * 2; y < std::min(cy * 2 + 2, f.height); ++y)
+                        {
+                            for (s32 x = cx * 2; x < std::min(cx * 2 + 2, f.width); ++x)
+                            {
+                                const u8* p = f.pixels.data() + (static_cast<u64>(y) * f.width + x) * 4;
+
+                                r += p[0];
+                                g += p[1];
+                                b += p[2];
+
+                                ++count;
+                            }
+                        }
+
+                        r /= count;
+                        g /= count;
+                        b /= count;
+
+                        // The 128 offset is folded in before the shift to keep the shifted value positive
+                        plane_u[static_cast<u64>(cy) * chroma_width + cx] = clamp_to_byte((-43 * r - 85 * g + 128 * b + (128 << 8) + 128) >> 8);
+                        plane_v[static_cast<u64>(cy) * chroma_width + cx] = clamp_to_byte((128 * r - 107 * g - 21 * b + (128 << 8) + 128) >> 8);
+                    }
+                }
+
+                return yuv;
+            }
+
+            //-------------------------------------------------------------------------
+            void write_stream_frame(u64 index, std::vector<u8>&& yuv)
+            {
+                u64 written = 0;
+                u64 failed = 0;
+                {
+                    std::lock_guard<std::mutex> lock(g_ctx.stream_mutex);
+
+                    g_ctx.converted_frames.emplace(index, std::move(yuv));
+
+                    for (auto it = g_ctx.converted_frames.find(g_ctx.next_stream_frame); it != g_ctx.converted_frames.end(); it = g_ctx.converted_frames.find(g_ctx.next_stream_frame))
+                    {
+                        if (g_ctx.next_stream_frame == 0)
+                        {
+                            // The samples are full range, without XCOLORRANGE readers assume the limited ( 16 - 235 ) range
+                            g_ctx.stream << "YUV4MPEG2 W" << g_ctx.stream_width << " H" << g_ctx.stream_height << " F" << g_ctx.settings.frame_rate << ":1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n";
+                        }
+
+                        g_ctx.stream << "FRAME\n";
+                        g_ctx.stream.write(reinterpret_cast<const char*>(it->second.data()), static_cast<std::streamsize>(it->second.size()));
+
+                        if (g_ctx.stream.good())
+                        {
+                            ++written;
+                        }
+                        else
+                        {
+                            ++failed;
+                        }
+
+                        g_ctx.converted_frames.erase(it);
+                        ++g_ctx.next_stream_frame;
+                    }
+                }
+
+                if (written != 0 || failed != 0)
+                {
+                    finish_frame(written, failed);
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            void encode(frame&& f)
+            {
+                switch (g_ctx.settings.format)
+                {
+                case capture_format::PNG:
+                {
+                    const bool success = stbi_write_png(frame_path(g_ctx.settings.path, f.index).c_str(), f.width, f.height, 4, f.pixels.data(), f.width * 4) != 0;
+
+                    release_buffer(std::move(f.pixels));
+                    finish_frame(success ? 1 : 0, success ? 0 : 1);
+                    break;
+                }
+                case capture_format::QOI:
+                {
+                    const std::vector<u8> data = qoi::encode(f.pixels.data(), f.width, f.height, 4);
+
+                    // The encoded copy is all that is needed from here on, the buffer can take the next frame
+                    release_buffer(std::move(f.pixels));
+
+                    const bool success = !data.empty() && write_file(frame_path(g_ctx.settings.path, f.index), data);
+
+                    finish_frame(success ? 1 : 0, success ? 0 : 1);
+                    break;
+                }
+                case capture_format::Y4M:
+                {
+                    std::vector<u8> yuv = convert_to_yuv420(f);
+
+                    release_buffer(std::move(f.pixels));
+                    write_stream_frame(f.index, std::move(yuv));
+                    break;
+                }
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            void encoder_loop()
+            {
+                while (true)
+                {
+                    frame next_frame;
+                    {
+                        std::unique_lock<std::mutex> lock(g_ctx.mutex);
+
+                        g_ctx.frame_available.wait(lock, []() { return g_ctx.stopping || !g_ctx.queued_frames.empty(); });
+
+                        if (g_ctx.queued_frames.empty())
+                        {
+                            return;
+                        }
+
+                        next_frame = std::move(g_ctx.queued_frames.front());
+                        g_ctx.queued_frames.pop_front();
+                    }
+
+                    encode(std::move(next_frame));
+
+                    {
+                        std::lock_guard<std::mutex> lock(g_ctx.mutex);
+
+                        --g_ctx.busy_count;
+                    }
+
+                    g_ctx.frame_finished.notify_all();
+                }
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        bool begin(const capture_settings& settings)
+        {
+            if (g_ctx.capturing)
+            {
+                log::error("Frame capture already active, end it before starting another one");
+                return false;
+            }
+
+            if (settings.path.empty() || settings.queue_size == 0)
+            {
+                log::error("Invalid frame capture settings");
+                return false;
+            }
+
+            std::error_code error;
+            const std::filesystem::path parent = std::filesystem::path(settings.path).parent_path();
+            if (!parent.empty())
+            {
+                std::filesystem::create_directories(parent, error);
+            }
+
+            if (settings.format == capture_format::Y4M)
+            {
+                g_ctx.stream.open(settings.path, std::ios::binary | std::ios::trunc);
+                if (!g_ctx.stream.is_open())
+                {
+                    log::error("Unable to open capture stream: {}", settings.path);
+                    return false;
+                }
+            }
+
+            g_ctx.settings = settings;
+            g_ctx.statistics = {};
+            g_ctx.next_frame = 0;
+            g_ctx.next_stream_frame = 0;
+            g_ctx.stream_width = 0;
+            g_ctx.stream_height = 0;
+            g_ctx.stopping = false;
+            g_ctx.capturing = true;
+
+            u32 encoder_count = settings.encoder_count;
+            if (encoder_count == 0)
+            {
+                encoder_count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+                encoder_count = std::max(1u, encoder_count);
+            }
+
+            g_ctx.encoders.reserve(encoder_count);
+            for (u32 i = 0; i < encoder_count; ++i)
+            {
+                g_ctx.encoders.emplace_back(internal::encoder_loop);
+            }
+
+            return true;
+        }
+
+        //-------------------------------------------------------------------------
+        capture_statistics end()
+        {
+            if (!g_ctx.capturing)
+            {
+                return {};
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(g_ctx.mutex);
+
+                g_ctx.capturing = false;
+
+                g_ctx.frame_finished.wait(lock, []() { return g_ctx.busy_count == 0; });
+
+                g_ctx.stopping = true;
+            }
+
+            g_ctx.frame_available.notify_all();
+            // Submits that are waiting for a buffer give up
+            g_ctx.buffer_available.notify_all();
+
+            for (std::thread& encoder : g_ctx.encoders)
+            {
+                encoder.join();
+            }
+
+            g_ctx.encoders.clear();
+
+            if (g_ctx.stream.is_open())
+            {
+                g_ctx.stream.close();
+            }
+
+            g_ctx.converted_frames.clear();
+            g_ctx.free_buffers.clear();
+            g_ctx.allocated_buffers = 0;
+
+            return g_ctx.statistics;
+        }
+
+        //-------------------------------------------------------------------------
+        bool submit(const u8* pixels, s32 width, s32 height, bool flip_vertically)
+        {
+            if (pixels == nullptr || width <= 0 || height <= 0)
+            {
+                return false;
+            }
+
+            std::vector<u8> buffer;
+            u64 index = 0;
+            {
+                std::unique_lock<std::mutex> lock(g_ctx.mutex);
+
+                if (!g_ctx.capturing)
+                {
+                    return false;
+                }
+
+                // A video stream has a single frame size
+                if (g_ctx.settings.format == capture_format::Y4M)
+                {
+                    if (g_ctx.stream_width == 0)
+                    {
+                        g_ctx.stream_width = width;
+                        g_ctx.stream_height = height;
+                    }
+                    else if (g_ctx.stream_width != width || g_ctx.stream_height != height)
+                    {
+                        ++g_ctx.statistics.failed;
+                        return false;
+                    }
+                }
+
+                if (g_ctx.free_buffers.empty())
+                {
+                    if (g_ctx.allocated_buffers < g_ctx.settings.queue_size)
+                    {
+                        g_ctx.free_buffers.emplace_back();
+                        ++g_ctx.allocated_buffers;
+                    }
+                    else if (g_ctx.settings.backpressure == backpressure_type::DROP)
+                    {
+                        ++g_ctx.statistics.dropped;
+                        return false;
+                    }
+                    else
+                    {
+                        g_ctx.buffer_available.wait(lock, []() { return !g_ctx.capturing || !g_ctx.free_buffers.empty(); });
+
+                        if (!g_ctx.capturing)
+                        {
+                            return false;
+                        }
+                    }
+                }
+
+                buffer = std::move(g_ctx.free_buffers.back());
+                g_ctx.free_buffers.pop_back();
+
+                index = g_ctx.next_frame++;
+
+                ++g_ctx.statistics.captured;
+                ++g_ctx.busy_count;
+            }
+
+            internal::copy_frame(buffer, pixels, width, height, flip_vertically);
+
+            {
+                std::lock_guard<std::mutex> lock(g_ctx.mutex);
+
+                g_ctx.queued_frames.push_back({ std::move(buffer), width, height, index });
+            }
+
+            g_ctx.frame_available.notify_one();
+
+            return true;
+        }
+
+        //-------------------------------------------------------------------------
+        bool is_capturing()
+        {
+            std::lock_guard<std::mutex> lock(g_ctx.mutex);
+
+            return g_ctx.capturing;
+        }
+
+        //-------------------------------------------------------------------------
+        capture_statistics statistics()
+        {
+            std::lock_guard<std::mutex> lock(g_ctx.mutex);
+
+            return g_ctx.statistics;
+        }
+
+        //-------------------------------------------------------------------------
+        std::string frame_path(const std::string& pattern, u64 frame_index)
+        {
+            u64 first = pattern.find('#');
+
+            std::string number = std::to_string(frame_index);
+
+            if (first == std::string::npos)
+            {
+                // Without a pattern the number goes in front of the extension
+                const std::filesystem::path path(pattern);
+
+                if (number.size() < 6)
+                {
+                    number.insert(0, 6 - number.size(), '0');
+                }
+
+                std::filesystem::path result = path.parent_path() / path.stem();
+                result += "_" + number;
+                result += path.extension();
+
+                return result.string();
+            }
+
+            u64 last = first;
+            while (last < pattern.size() && pattern[last] == '#')
+            {
+                ++last;
+            }
+
+            const u64 width = last - first;
+            if (number.size() < width)
+            {
+                number.insert(0, width - number.size(), '0');
+            }
+
+            return pattern.substr(0, first) + number + pattern.substr(last);
+        }
+    }
+}
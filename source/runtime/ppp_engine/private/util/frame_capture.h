@@ -0,0 +1,65 @@
+#pragma once
+
+#include "util/types.h"
+
+#include <string>
+
+namespace ppp
+{
+    // Writes a sequence of frames to disk on a pool of encoder threads.
+    // Frames are copied into a bounded pool of buffers, the caller only waits when the pool is full and the backpressure is set to block.
+    namespace frame_capture
+    {
+        enum class capture_format
+        {
+            PNG,    // One numbered PNG file per frame
+            QOI,    // One numbered QOI file per frame, lossless and a lot faster to encode than PNG
+            Y4M     // A single uncompressed YUV 4:2:0 stream, readable by ffmpeg and most video tools
+        };
+
+        enum class backpressure_type
+        {
+            BLOCK,  // Wait for an encoder to free a buffer, no frame is lost
+            DROP    // Skip the frame when every buffer is in use
+        };
+
+        struct capture_settings
+        {
+            // A run of '#' is replaced by the zero padded frame number ( "frames/frame_####.png" ), without one the number is appended to the file name.
+            // The Y4M stream is written to the path as is.
+            std::string         path;
+
+            capture_format      format = capture_format::PNG;
+            backpressure_type   backpressure = backpressure_type::BLOCK;
+
+            u32                 queue_size = 8;
+            // 0 uses every core except the one of the main thread
+            u32                 encoder_count = 0;
+            // Only stored in the Y4M header
+            u32                 frame_rate = 60;
+        };
+
+        struct capture_statistics
+        {
+            u64 captured = 0;   // Frames that were accepted
+            u64 dropped = 0;    // Frames that were skipped because every buffer was in use
+            u64 written = 0;    // Frames that were encoded and written to disk
+            u64 failed = 0;     // Frames that could not be encoded or written
+        };
+
+        bool begin(const capture_settings& settings);
+        // Waits until every accepted frame is written
+        capture_statistics end();
+
+        // The pixels are RGBA, rows are flipped while copying when the source is bottom-up ( OpenGL framebuffers )
+        // Returns false when the frame was dropped or no capture is active
+        bool submit(const u8* pixels, s32 width, s32 height, bool flip_vertically = false);
+
+        bool is_capturing();
+
+        capture_statistics statistics();
+
+        // Replaces the run of '#' in the pattern with the frame index
+        std::string frame_path(const std::string& pattern, u64 frame_index);
+    }
+}
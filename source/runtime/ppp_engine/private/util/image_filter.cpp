@@ -0,0 +1,519 @@
+#include "util/image_filter.h"
+#include "util/parallel_for.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_FILTER_SSE2 1
+#include <emmintrin.h>
+#else
+#define IMAGE_FILTER_SSE2 0
+#endif
+
+namespace ppp
+{
+    namespace image_filter
+    {
+        namespace internal
+        {
+            // Blur weights are fixed point, they sum up to exactly 1 << weight_bits
+            constexpr s32 weight_bits = 14;
+            constexpr s32 max_blur_radius = 64;
+
+            // Rows per task, small enough to keep every core busy on small images
+            constexpr s32 rows_per_task = 16;
+
+            using lookup_table = std::array<u8, 256>;
+
+            //-------------------------------------------------------------------------
+            s32 color_channels(s32 channels)
+            {
+                return channels == 2 || channels == 4 ? channels - 1 : channels;
+            }
+
+            //-------------------------------------------------------------------------
+            u8 luminance(const u8* pixel, s32 channels)
+            {
+                if (channels < 3)
+                {
+                    return pixel[0];
+                }
+
+                return static_cast<u8>((77 * pixel[0] + 151 * pixel[1] + 28 * pixel[2]) >> 8);
+            }
+
+            //-------------------------------------------------------------------------
+            s32 threshold_level(f32 param)
+            {
+                return static_cast<s32>(std::clamp(std::lround(param * 255.0f), 0l, 255l));
+            }
+
+            //-------------------------------------------------------------------------
+            s32 posterize_levels(f32 param)
+            {
+                return static_cast<s32>(std::clamp(std::lround(param), 2l, 255l));
+            }
+
+            //-------------------------------------------------------------------------
+            u8 posterize(u8 value, s32 levels)
+            {
+                return static_cast<u8>((((value * levels) >> 8) * 255) / (levels - 1));
+            }
+
+            //-------------------------------------------------------------------------
+            // Symmetric Gaussian kernel with 2 * radius + 1 taps, rounding errors are moved into the center tap
+            std::vector<s16> blur_kernel(f32 sigma)
+            {
+                const s32 radius = std::clamp(static_cast<s32>(std::ceil(sigma * 3.0f)), 1, max_blur_radius);
+
+                std::vector<f64> gaussian(2 * radius + 1);
+                f64 total = 0.0;
+                for (s32 k = -radius; k <= radius; ++k)
+                {
+                    gaussian[k + radius] = std::exp(-(static_cast<f64>(k) * k) / (2.0 * static_cast<f64>(sigma) * sigma));
+                    total += gaussian[k + radius];
+                }
+
+                std::vector<s16> weights(gaussian.size());
+                s32 sum = 0;
+                for (u64 i = 0; i < gaussian.size(); ++i)
+                {
+                    weights[i] = static_cast<s16>(std::lround(gaussian[i] / total * (1 << weight_bits)));
+                    sum += weights[i];
+                }
+
+                weights[radius] = static_cast<s16>(weights[radius] + ((1 << weight_bits) - sum));
+
+                return weights;
+            }
+
+            //-------------------------------------------------------------------------
+            // Table for the color channels of point filters that do not depend on other channels
+            lookup_table point_table(filter_type type, f32 param)
+            {
+                lookup_table table;
+
+                for (s32 v = 0; v < 256; ++v)
+                {
+                    switch (type)
+                    {
+                    case filter_type::THRESHOLD: table[v] = v >= threshold_level(param) ? 255 : 0; break;
+                    case filter_type::INVERT: table[v] = static_cast<u8>(255 - v); break;
+                    case filter_type::POSTERIZE: table[v] = posterize(static_cast<u8>(v), posterize_levels(param)); break;
+                    default: table[v] = static_cast<u8>(v); break;
+                    }
+                }
+
+                return table;
+            }
+
+            //-------------------------------------------------------------------------
+            // Applies a point filter to one pixel, shared by the reference and the remainder of the SIMD loops
+            void point_pixel(u8* pixel, s32 channels, filter_type type, const lookup_table& table, s32 threshold)
+            {
+                const s32 colors = color_channels(channels);
+
+                switch (type)
+                {
+                case filter_type::THRESHOLD:
+                {
+                    const u8 value = luminance(pixel, channels) >= threshold ? 255 : 0;
+                    std::fill(pixel, pixel + colors, value);
+                    break;
+                }
+                case filter_type::GRAY:
+                {
+                    const u8 value = luminance(pixel, channels);
+                    std::fill(pixel, pixel + colors, value);
+                    break;
+                }
+                case filter_type::OPAQUE:
+                    if (colors != channels)
+                    {
+                        pixel[channels - 1] = 255;
+                    }
+                    break;
+                case filter_type::INVERT:
+                case filter_type::POSTERIZE:
+                    for (s32 c = 0; c < colors; ++c)
+                    {
+                        pixel[c] = table[pixel[c]];
+                    }
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            // Point filter over a run of whole pixels
+            void point_span(u8* pixels, u64 pixel_count, s32 channels, filter_type type, const lookup_table& table, s32 threshold)
+            {
+                u64 i = 0;
+
+#if IMAGE_FILTER_SSE2
+                const u64 byte_count = pixel_count * channels;
+                const s32 colors = color_channels(channels);
+
+                // The alpha pattern repeats every 16 bytes for 2 and 4 channels, 1 and 3 channel images have no alpha
+                u8 alpha_pattern[16];
+                for (s32 b = 0; b < 16; ++b)
+                {
+                    alpha_pattern[b] = colors != channels && (b % channels) == channels - 1 ? 0xFF : 0x00;
+                }
+                const __m128i alpha_mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha_pattern));
+
+                if (type == filter_type::INVERT || type == filter_type::OPAQUE)
+                {
+                    const __m128i color_mask = _mm_xor_si128(alpha_mask, _mm_set1_epi8(static_cast<char>(0xFF)));
+
+                    // 48 bytes are whole pixels for every channel count
+                    u64 b = 0;
+                    for (; b + 48 <= byte_count; b += 48)
+                    {
+                        for (u64 offset = 0; offset < 48; offset += 16)
+                        {
+                            __m128i* block = reinterpret_cast<__m128i*>(pixels + b + offset);
+                            const __m128i value = _mm_loadu_si128(block);
+
+                            _mm_storeu_si128(block, type == filter_type::INVERT
+                                ? _mm_xor_si128(value, color_mask)
+                                : _mm_or_si128(value, alpha_mask));
+                        }
+                    }
+
+                    i = b / channels;
+                }
+                else if (channels == 4 && (type == filter_type::GRAY || type == filter_type::THRESHOLD))
+                {
+                    const __m128i zero = _mm_setzero_si128();
+                    const __m128i weights = _mm_setr_epi16(77, 151, 28, 0, 77, 151, 28, 0);
+                    const __m128i level = _mm_set1_epi32(threshold - 1);
+                    const __m128i rgb_mask = _mm_set1_epi32(0x00FFFFFF);
+
+                    for (; i + 4 <= pixel_count; i += 4)
+                    {
+                        __m128i* block = reinterpret_cast<__m128i*>(pixels + i * 4);
+                        const __m128i value = _mm_loadu_si128(block);
+
+                        // r * 77 + g * 151 and b * 28 per pixel, added pairwise into the low half of every 64 bit lane
+                        __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(value, zero), weights);
+                        __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(value, zero), weights);
+                        lo = _mm_add_epi32(lo, _mm_srli_epi64(lo, 32));
+                        hi = _mm_add_epi32(hi, _mm_srli_epi64(hi, 32));
+
+                        const __m128i sums = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0)));
+                        const __m128i lum = _mm_srli_epi32(sums, 8);
+
+                        const __m128i rgb = type == filter_type::GRAY
+                            ? _mm_or_si128(_mm_or_si128(lum, _mm_slli_epi32(lum, 8)), _mm_slli_epi32(lum, 16))
+                            : _mm_and_si128(_mm_cmpgt_epi32(lum, level), rgb_mask);
+
+                        _mm_storeu_si128(block, _mm_or_si128(rgb, _mm_and_si128(value, alpha_mask)));
+                    }
+                }
+#endif
+
+                for (; i < pixel_count; ++i)
+                {
+                    point_pixel(pixels + i * channels, channels, type, table, threshold);
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            // out[i] = sum( weights[k] * sources[k][i] ), rounded back to 8 bits
+            void convolve_span(const u8* const* sources, const s16* weights, s32 taps, u8* out, u64 count)
+            {
+                u64 i = 0;
+
+#if IMAGE_FILTER_SSE2
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i round = _mm_set1_epi32(1 << (weight_bits - 1));
+
+                for (; i + 8 <= count; i += 8)
+                {
+                    __m128i acc_lo = round;
+                    __m128i acc_hi = round;
+
+                    // Two taps at a time, the values of both taps are interleaved so a single multiply-add handles them
+                    for (s32 k = 0; k < taps; k += 2)
+                    {
+                        const bool pair = k + 1 < taps;
+
+                        const __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(sources[k] + i)), zero);
+                        const __m128i b = pair ? _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(sources[k + 1] + i)), zero) : zero;
+                        const __m128i w = _mm_set1_epi32(static_cast<s32>(static_cast<u16>(weights[k]) | (static_cast<u32>(pair ? static_cast<u16>(weights[k + 1]) : 0) << 16)));
+
+                        acc_lo = _mm_add_epi32(acc_lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w));
+                        acc_hi = _mm_add_epi32(acc_hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w));
+                    }
+
+                    const __m128i packed = _mm_packs_epi32(_mm_srai_epi32(acc_lo, weight_bits), _mm_srai_epi32(acc_hi, weight_bits));
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(packed, packed));
+                }
+#endif
+
+                for (; i < count; ++i)
+                {
+                    s32 acc = 1 << (weight_bits - 1);
+                    for (s32 k = 0; k < taps; ++k)
+                    {
+                        acc += weights[k] * sources[k][i];
+                    }
+
+                    out[i] = static_cast<u8>(std::min(acc >> weight_bits, 255));
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            // out[i] = min ( or max ) of sources[0..2][i]
+            void morphology_span(const u8* const* sources, bool erode, u8* out, u64 count)
+            {
+                u64 i = 0;
+
+#if IMAGE_FILTER_SSE2
+                for (; i + 16 <= count; i += 16)
+                {
+                    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sources[0] + i));
+                    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sources[1] + i));
+                    const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sources[2] + i));
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), erode
+                        ? _mm_min_epu8(_mm_min_epu8(a, b), c)
+                        : _mm_max_epu8(_mm_max_epu8(a, b), c));
+                }
+#endif
+
+                for (; i < count; ++i)
+                {
+                    out[i] = erode
+                        ? std::min({ sources[0][i], sources[1][i], sources[2][i] })
+                        : std::max({ sources[0][i], sources[1][i], sources[2][i] });
+                }
+            }
+
+            //-------------------------------------------------------------------------
+            // Runs a separable filter, `span` receives one source pointer per tap and writes `count` bytes.
+            // The horizontal pass repeats the edge pixels into a padded copy of the row, the vertical pass clamps the row index.
+            template<typename TSpan>
+            void separable(u8* pixels, s32 width, s32 height, s32 channels, s32 radius, const TSpan& span, u32 thread_count)
+            {
+                const s32 taps = 2 * radius + 1;
+                const u64 row_bytes = static_cast<u64>(width) * channels;
+                const u64 task_count = (height + rows_per_task - 1) / rows_per_task;
+
+                std::vector<u8> horizontal(row_bytes * height);
+
+                parallel_for(task_count, [&](u64 task)
+                {
+                    std::vector<u8> padded((static_cast<u64>(width) + 2 * radius) * channels);
+                    std::vector<const u8*> sources(taps);
+
+                    const s32 first_row = static_cast<s32>(task) * rows_per_task;
+                    const s32 last_row = std::min(first_row + rows_per_task, height);
+
+                    for (s32 y = first_row; y < last_row; ++y)
+                    {
+                        const u8* row = pixels + y * row_bytes;
+
+                        for (s32 x = 0; x < radius; ++x)
+                        {
+                            std::copy(row, row + channels, padded.data() + x * channels);
+                            std::copy(row + row_bytes - channels, row + row_bytes, padded.data() + (radius + width + x) * channels);
+                        }
+                        std::copy(row, row + row_bytes, padded.data() + radius * channels);
+
+                        for (s32 k = 0; k < taps; ++k)
+                        {
+                            sources[k] = padded.data() + k * channels;
+                        }
+
+                        span(sources.data(), horizontal.data() + y * row_bytes, row_bytes);
+                    }
+                }, thread_count);
+
+                parallel_for(task_count, [&](u64 task)
+                {
+                    std::vector<const u8*> sources(taps);
+
+                    const s32 first_row = static_cast<s32>(task) * rows_per_task;
+                    const s32 last_row = std::min(first_row + rows_per_task, height);
+
+                    for (s32 y = first_row; y < last_row; ++y)
+                    {
+                        for (s32 k = 0; k < taps; ++k)
+                        {
+                            sources[k] = horizontal.data() + std::clamp(y + k - radius, 0, height - 1) * row_bytes;
+                        }
+
+                        span(sources.data(), pixels + y * row_bytes, row_bytes);
+                    }
+                }, thread_count);
+            }
+
+            //-------------------------------------------------------------------------
+            // Reference for the separable filters, every output texel reads its neighbours directly
+            template<typename TReduce>
+            void separable_reference(u8* pixels, s32 width, s32 height, s32 channels, s32 radius, const TReduce& reduce)
+            {
+                const u64 row_bytes = static_cast<u64>(width) * channels;
+
+                std::vector<u8> horizontal(row_bytes * height);
+                std::vector<u8> values(2 * radius + 1);
+
+                for (s32 y = 0; y < height; ++y)
+                {
+                    for (s32 x = 0; x < width; ++x)
+                    {
+                        for (s32 c = 0; c < channels; ++c)
+                        {
+                            for (s32 k = -radius; k <= radius; ++k)
+                            {
+                                values[k + radius] = pixels[y * row_bytes + std::clamp(x + k, 0, width - 1) * channels + c];
+                            }
+
+                            horizontal[y * row_bytes + x * channels + c] = reduce(values);
+                        }
+                    }
+                }
+
+                for (s32 y = 0; y < height; ++y)
+                {
+                    for (u64 i = 0; i < row_bytes; ++i)
+                    {
+                        for (s32 k = -radius; k <= radius; ++k)
+                        {
+                            values[k + radius] = horizontal[std::clamp(y + k, 0, height - 1) * row_bytes + i];
+                        }
+
+                        pixels[y * row_bytes + i] = reduce(values);
+                    }
+                }
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        f32 default_param(filter_type type)
+        {
+            switch (type)
+            {
+            case filter_type::THRESHOLD: return 0.5f;
+            case filter_type::POSTERIZE: return 4.0f;
+            case filter_type::BLUR: return 1.0f;
+            default: return 0.0f;
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        void apply(u8* pixels, s32 width, s32 height, s32 channels, filter_type type, f32 param, u32 thread_count)
+        {
+            if (pixels == nullptr || width <= 0 || height <= 0 || channels < 1 || channels > 4)
+            {
+                return;
+            }
+
+            switch (type)
+            {
+            case filter_type::BLUR:
+            {
+                if (param <= 0.0f)
+                {
+                    return;
+                }
+
+                const std::vector<s16> weights = internal::blur_kernel(param);
+                const s32 taps = static_cast<s32>(weights.size());
+
+                internal::separable(pixels, width, height, channels, taps / 2, [&weights, taps](const u8* const* sources, u8* out, u64 count)
+                {
+                    internal::convolve_span(sources, weights.data(), taps, out, count);
+                }, thread_count);
+                break;
+            }
+            case filter_type::ERODE:
+            case filter_type::DILATE:
+            {
+                const bool erode = type == filter_type::ERODE;
+
+                internal::separable(pixels, width, height, channels, 1, [erode](const u8* const* sources, u8* out, u64 count)
+                {
+                    internal::morphology_span(sources, erode, out, count);
+                }, thread_count);
+                break;
+            }
+            default:
+            {
+                const internal::lookup_table table = internal::point_table(type, param);
+                const s32 threshold = internal::threshold_level(param);
+
+                const u64 row_pixels = static_cast<u64>(width) * internal::rows_per_task;
+                const u64 pixel_count = static_cast<u64>(width) * height;
+                const u64 task_count = (height + internal::rows_per_task - 1) / internal::rows_per_task;
+
+                parallel_for(task_count, [&](u64 task)
+                {
+                    const u64 first = task * row_pixels;
+                    const u64 count = std::min(row_pixels, pixel_count - first);
+
+                    internal::point_span(pixels + first * channels, count, channels, type, table, threshold);
+                }, thread_count);
+                break;
+            }
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        void apply_reference(u8* pixels, s32 width, s32 height, s32 channels, filter_type type, f32 param)
+        {
+            if (pixels == nullptr || width <= 0 || height <= 0 || channels < 1 || channels > 4)
+            {
+                return;
+            }
+
+            switch (type)
+            {
+            case filter_type::BLUR:
+            {
+                if (param <= 0.0f)
+                {
+                    return;
+                }
+
+                const std::vector<s16> weights = internal::blur_kernel(param);
+
+                internal::separable_reference(pixels, width, height, channels, static_cast<s32>(weights.size()) / 2, [&weights](const std::vector<u8>& values)
+                {
+                    s32 acc = 1 << (internal::weight_bits - 1);
+                    for (u64 k = 0; k < values.size(); ++k)
+                    {
+                        acc += weights[k] * values[k];
+                    }
+
+                    return static_cast<u8>(std::min(acc >> internal::weight_bits, 255));
+                });
+                break;
+            }
+            case filter_type::ERODE:
+                internal::separable_reference(pixels, width, height, channels, 1, [](const std::vector<u8>& values) { return *std::min_element(values.begin(), values.end()); });
+                break;
+            case filter_type::DILATE:
+                internal::separable_reference(pixels, width, height, channels, 1, [](const std::vector<u8>& values) { return *std::max_element(values.begin(), values.end()); });
+                break;
+            default:
+            {
+                const internal::lookup_table table = internal::point_table(type, param);
+                const s32 threshold = internal::threshold_level(param);
+
+                for (u64 i = 0; i < static_cast<u64>(width) * height; ++i)
+                {
+                    internal::point_pixel(pixels + i * channels, channels, type, table, threshold);
+                }
+                break;
+            }
+            }
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "util/types.h"
+
+namespace ppp
+{
+    // Image processing filters on tightly packed 8 bit pixel buffers with 1 to 4 channels, the last channel of 2 and 4 channel images is alpha.
+    // Rows are split across worker threads and processed with SIMD kernels where the pixel layout allows it.
+    // Every filter is integer only, `apply` and `apply_reference` produce the exact same pixels.
+    namespace image_filter
+    {
+        enum class filter_type
+        {
+            THRESHOLD,  // White when the luminance is at least `param` ( 0 to 1 ), black otherwise
+            GRAY,       // Luminance of the pixel
+            OPAQUE,     // Alpha set to 255
+            INVERT,     // 255 - color, alpha is kept
+            POSTERIZE,  // `param` levels per color channel ( 2 to 255 )
+            BLUR,       // Gaussian blur, `param` is the standard deviation in pixels
+            ERODE,      // Minimum of the 3x3 neighbourhood, per channel
+            DILATE      // Maximum of the 3x3 neighbourhood, per channel
+        };
+
+        // Parameter that is used when a filter is applied without one
+        f32 default_param(filter_type type);
+
+        // Filters in place on `thread_count` threads ( 0 uses every core )
+        void apply(u8* pixels, s32 width, s32 height, s32 channels, filter_type type, f32 param, u32 thread_count = 0);
+
+        // Straightforward single threaded scalar version of every filter, used to verify `apply`
+        void apply_reference(u8* pixels, s32 width, s32 height, s32 channels, filter_type type, f32 param);
+    }
+}
@@ -0,0 +1,69 @@
+#include "util/image_kernel.h"
+#include "util/parallel_for.h"
+
+#include <algorithm>
+
+namespace ppp
+{
+    namespace image_kernel
+    {
+        namespace internal
+        {
+            //-------------------------------------------------------------------------
+            // Finalizer of murmur3, every input bit affects every output bit
+            u32 mix(u32 value)
+            {
+                value ^= value >> 16;
+                value *= 0x85ebca6bu;
+                value ^= value >> 13;
+                value *= 0xc2b2ae35u;
+                value ^= value >> 16;
+
+                return value;
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        u32 tile_seed(u32 seed, s32 tile_x, s32 tile_y)
+        {
+            u32 value = internal::mix(seed + 0x9e3779b9u);
+            value = internal::mix(value ^ static_cast<u32>(tile_x));
+            value = internal::mix(value ^ static_cast<u32>(tile_y) * 0x27d4eb2du);
+
+            return value;
+        }
+
+        //-------------------------------------------------------------------------
+        void run(u8* pixels, s32 width, s32 height, s32 channels, const row_kernel& kernel, u32 seed, u32 thread_count)
+        {
+            if (pixels == nullptr || !kernel || width <= 0 || height <= 0 || channels < 1 || channels > 4)
+            {
+                return;
+            }
+
+            const s32 tiles_x = (width + tile_size - 1) / tile_size;
+            const s32 tiles_y = (height + tile_size - 1) / tile_size;
+
+            const u64 stride = static_cast<u64>(width) * channels;
+
+            parallel_for(static_cast<u64>(tiles_x) * tiles_y, [&](u64 index)
+            {
+                const s32 tile_x = static_cast<s32>(index % tiles_x);
+                const s32 tile_y = static_cast<s32>(index / tiles_x);
+
+                const s32 x = tile_x * tile_size;
+                const s32 count = std::min(tile_size, width - x);
+
+                const s32 begin_y = tile_y * tile_size;
+                const s32 end_y = std::min(begin_y + tile_size, height);
+
+                const u32 tile = tile_seed(seed, tile_x, tile_y);
+
+                for (s32 y = begin_y; y < end_y; ++y)
+                {
+                    kernel(x, y, count, tile, pixels + y * stride + static_cast<u64>(x) * channels);
+                }
+            }, thread_count);
+        }
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "util/types.h"
+
+#include <functional>
+
+namespace ppp
+{
+    // Runs a user kernel over every pixel of a tightly packed 8 bit pixel buffer on worker threads.
+    // The buffer is split in square tiles, every tile is a task and is handed to the kernel one row at a time.
+    // Each tile gets a seed that only depends on the base seed and the position of the tile, the result does not depend on the number of threads.
+    namespace image_kernel
+    {
+        constexpr s32 tile_size = 64;
+
+        // Fills `count` pixels of row `y` starting at column `x`, `pixels` points at the first of them
+        // Called from several threads at once, every call writes to its own pixels
+        using row_kernel = std::function<void(s32 x, s32 y, s32 count, u32 seed, u8* pixels)>;
+
+        u32 tile_seed(u32 seed, s32 tile_x, s32 tile_y);
+
+        // Runs `kernel` over every row of every tile on `thread_count` threads ( 0 uses every core )
+        void run(u8* pixels, s32 width, s32 height, s32 channels, const row_kernel& kernel, u32 seed, u32 thread_count = 0);
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "util/types.h"
+#include "util/thread_pool.h"
+
+namespace ppp
+{
+    // Runs `fn(index)` for every index in [0, count) and blocks until all of them are done.
+    // Indices are handed out one at a time to at most `thread_count` threads of the thread pool ( 0 uses every core ), the calling thread is one of them.
+    // Work that has to be ordered ( e.g. GPU uploads ) is done after this returns, on the calling thread.
+    template<typename TFunction>
+    void parallel_for(u64 count, const TFunction& fn, u32 thread_count = 0)
+    {
+        thread_pool::run(count, [&fn](u64 index) { fn(index); }, thread_count);
+    }
+}
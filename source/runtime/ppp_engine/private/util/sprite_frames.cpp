@@ -0,0 +1,56 @@
+#include "util/sprite_frames.h"
+
+namespace ppp
+{
+    namespace sprite_frames
+    {
+        //-------------------------------------------------------------------------
+        s32 frame_count(s32 sheet_width, s32 sheet_height, s32 frame_width, s32 frame_height)
+        {
+            if (frame_width <= 0 || frame_height <= 0)
+            {
+                return 0;
+            }
+
+            return (sheet_width / frame_width) * (sheet_height / frame_height);
+        }
+
+        //-------------------------------------------------------------------------
+        frame_rect frame(s32 sheet_width, s32 frame_width, s32 frame_height, s32 frame_count, s32 frame)
+        {
+            const s32 columns = frame_width > 0 ? sheet_width / frame_width : 0;
+            if (columns <= 0 || frame_height <= 0 || frame_count <= 0)
+            {
+                return {};
+            }
+
+            const s32 index = ((frame % frame_count) + frame_count) % frame_count;
+
+            return { (index % columns) * frame_width, (index / columns) * frame_height, frame_width, frame_height };
+        }
+
+        //-------------------------------------------------------------------------
+        glm::vec4 source_rect(s32 image_width, s32 image_height, f32 x, f32 y, f32 width, f32 height)
+        {
+            if (image_width <= 0 || image_height <= 0)
+            {
+                return glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+            }
+
+            const glm::vec2 size = glm::vec2(static_cast<f32>(image_width), static_cast<f32>(image_height));
+
+            return glm::vec4(glm::vec2(x, y) / size, glm::vec2(width, height) / size);
+        }
+
+        //-------------------------------------------------------------------------
+        glm::vec4 uv_rect(const glm::vec2& uv_min, const glm::vec2& uv_max, const glm::vec4& source)
+        {
+            // uv_min + (source.xy + (uv - uv_min) / extent * source.zw) * extent, written as offset + uv * scale
+            const glm::vec2 extent = uv_max - uv_min;
+            const glm::vec2 scale = glm::vec2(source.z, source.w);
+            const glm::vec2 offset = uv_min + glm::vec2(source.x, source.y) * extent - uv_min * scale;
+
+            return glm::vec4(offset, scale);
+        }
+    }
+}
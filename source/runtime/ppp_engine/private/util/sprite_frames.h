@@ -0,0 +1,34 @@
+#pragma once
+
+#include "util/types.h"
+
+#include <glm/glm.hpp>
+
+namespace ppp
+{
+    // Frames of a sprite sheet are cells of equal size in a grid, numbered row by row from the top left.
+    // A frame is drawn by mapping the uvs of the quad of the image into the area of the frame, every frame shares the same geometry.
+    namespace sprite_frames
+    {
+        struct frame_rect
+        {
+            s32 x = 0;
+            s32 y = 0;
+            s32 width = 0;
+            s32 height = 0;
+        };
+
+        // Number of whole frames that fit in the sheet
+        s32 frame_count(s32 sheet_width, s32 sheet_height, s32 frame_width, s32 frame_height);
+
+        // Area of `frame` in pixels, frames outside of [0, frame_count) wrap around so an animation can pass an ever increasing frame
+        frame_rect frame(s32 sheet_width, s32 frame_width, s32 frame_height, s32 frame_count, s32 frame);
+
+        // Part of the image ( 0 to 1 ) that is covered by a rectangle in pixels
+        glm::vec4 source_rect(s32 image_width, s32 image_height, f32 x, f32 y, f32 width, f32 height);
+
+        // Uv rect ( offset in xy, scale in zw ) that maps uvs covering [uv_min, uv_max] onto the part of the image in `source`
+        // Images in an atlas cover their area of the atlas page, other images cover [0, 1]
+        glm::vec4 uv_rect(const glm::vec2& uv_min, const glm::vec2& uv_max, const glm::vec4& source);
+    }
+}
@@ -0,0 +1,205 @@
+#include "util/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ppp
+{
+    namespace thread_pool
+    {
+        void stop_workers();
+
+        //-------------------------------------------------------------------------
+        struct context
+        {
+            // Tests and tools never terminate the engine, the workers are still joined when the program exits
+            ~context() { stop_workers(); }
+
+            std::vector<std::thread> workers;
+
+            // Held by the thread that runs a loop, one loop uses the workers at a time
+            std::mutex loop_mutex;
+
+            std::mutex mutex;
+            std::condition_variable work_available;
+            std::condition_variable work_finished;
+
+            const index_fn* fn = nullptr;
+            u64 count = 0;
+            std::atomic<u64> next_index = 0;
+
+            // Changes for every loop so a worker joins each loop at most once
+            u64 loop = 0;
+            // Workers that may still join the current loop
+            u32 open_slots = 0;
+            // Workers that joined the current loop and did not finish yet
+            u32 busy_count = 0;
+
+            bool stopping = false;
+        } g_ctx;
+
+        // Set on the workers and on a thread while it runs a loop, nested loops do not wait for the workers they are running on
+        thread_local bool t_in_loop = false;
+
+        //-------------------------------------------------------------------------
+        static void run_indices()
+        {
+            const index_fn& fn = *g_ctx.fn;
+
+            for (u64 index = g_ctx.next_index++; index < g_ctx.count; index = g_ctx.next_index++)
+            {
+                fn(index);
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        static void worker_loop()
+        {
+            t_in_loop = true;
+
+            u64 joined_loop = 0;
+
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(g_ctx.mutex);
+
+                    g_ctx.work_available.wait(lock, [&joined_loop]() { return g_ctx.stopping || (g_ctx.loop != joined_loop && g_ctx.open_slots > 0); });
+
+                    if (g_ctx.stopping)
+                    {
+                        return;
+                    }
+
+                    joined_loop = g_ctx.loop;
+
+                    --g_ctx.open_slots;
+                    ++g_ctx.busy_count;
+                }
+
+                run_indices();
+
+                {
+                    std::lock_guard<std::mutex> lock(g_ctx.mutex);
+
+                    if (--g_ctx.busy_count == 0)
+                    {
+                        g_ctx.work_finished.notify_all();
+                    }
+                }
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        static void start_workers()
+        {
+            if (!g_ctx.workers.empty())
+            {
+                return;
+            }
+
+            g_ctx.stopping = false;
+
+            // The thread that runs a loop is the last worker
+            const u32 count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+            g_ctx.workers.reserve(count);
+            for (u32 i = 0; i < count; ++i)
+            {
+                g_ctx.workers.emplace_back(worker_loop);
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        void stop_workers()
+        {
+            {
+                std::lock_guard<std::mutex> lock(g_ctx.mutex);
+
+                g_ctx.stopping = true;
+            }
+
+            g_ctx.work_available.notify_all();
+
+            for (std::thread& worker : g_ctx.workers)
+            {
+                worker.join();
+            }
+
+            g_ctx.workers.clear();
+        }
+
+        //-------------------------------------------------------------------------
+        void run(u64 count, const index_fn& fn, u32 thread_count)
+        {
+            if (thread_count == 0)
+            {
+                thread_count = std::max(1u, std::thread::hardware_concurrency());
+            }
+
+            std::unique_lock<std::mutex> loop_lock(g_ctx.loop_mutex, std::defer_lock);
+
+            if (count <= 1 || thread_count <= 1 || t_in_loop || !loop_lock.try_lock())
+            {
+                for (u64 index = 0; index < count; ++index)
+                {
+                    fn(index);
+                }
+
+                return;
+            }
+
+            start_workers();
+
+            t_in_loop = true;
+
+            {
+                std::lock_guard<std::mutex> lock(g_ctx.mutex);
+
+                g_ctx.fn = &fn;
+                g_ctx.count = count;
+                g_ctx.next_index = 0;
+
+                ++g_ctx.loop;
+                g_ctx.open_slots = static_cast<u32>(std::min<u64>({ thread_count - 1, count - 1, g_ctx.workers.size() }));
+            }
+
+            g_ctx.work_available.notify_all();
+
+            run_indices();
+
+            {
+                std::unique_lock<std::mutex> lock(g_ctx.mutex);
+
+                // Every index is taken, workers that did not wake up yet have nothing left to do
+                g_ctx.open_slots = 0;
+
+                g_ctx.work_finished.wait(lock, []() { return g_ctx.busy_count == 0; });
+
+                g_ctx.fn = nullptr;
+            }
+
+            t_in_loop = false;
+        }
+
+        //-------------------------------------------------------------------------
+        void terminate()
+        {
+            std::lock_guard<std::mutex> loop_lock(g_ctx.loop_mutex);
+
+            stop_workers();
+        }
+
+        //-------------------------------------------------------------------------
+        u32 worker_count()
+        {
+            std::lock_guard<std::mutex> loop_lock(g_ctx.loop_mutex);
+
+            return static_cast<u32>(g_ctx.workers.size());
+        }
+    }
+}
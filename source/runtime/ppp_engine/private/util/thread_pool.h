@@ -0,0 +1,25 @@
+#pragma once
+
+#include "util/types.h"
+
+#include <functional>
+
+namespace ppp
+{
+    // Worker threads shared by every data parallel loop of the engine ( OBJ parsing, image decoding, filters, pixel kernels ).
+    // The workers are started by the first loop that needs them and sleep in between loops.
+    namespace thread_pool
+    {
+        using index_fn = std::function<void(u64)>;
+
+        // Runs `fn(index)` for every index in [0, count) and blocks until all of them are done, the calling thread takes part.
+        // At most `thread_count` threads work on the loop ( 0 uses every core ).
+        // Loops started from inside a loop, or while another thread runs one, run on the calling thread only.
+        void run(u64 count, const index_fn& fn, u32 thread_count);
+
+        // Joins the workers, a later loop starts them again
+        void terminate();
+
+        u32 worker_count();
+    }
+}
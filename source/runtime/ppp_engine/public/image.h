@@ -7,6 +7,7 @@
 
 #include "color.h"
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -49,6 +50,34 @@ namespace ppp
      */
     image create(float w, float h, int c, pixels_u8_ptr data);
 
+    /** @brief Releases pixel memory that was handed to `create`. */
+    using pixels_deleter = std::function<void(pixels_u8_ptr data)>;
+
+    /**
+     * @brief Create an image that takes ownership of the pixels without copying them.
+     *
+     * The image keeps using the memory as its pixel data, the deleter runs once when the image is unloaded.
+     * @param w Width of image.
+     * @param h Height of image.
+     * @param c Number of channels.
+     * @param data Pixel data of w * h * c bytes.
+     * @param deleter Releases the pixel data, e.g. `[](pixels_u8_ptr p) { delete[] p; }`.
+     * @return Descriptor for the new image.
+     */
+    image create(float w, float h, int c, pixels_u8_ptr data, pixels_deleter deleter);
+
+    /**
+     * @brief Create an image that uses the caller's pixels without copying or owning them.
+     *
+     * The memory has to stay valid until the image is unloaded, functions that edit the image ( `filter`, `update_pixels` ) write into it.
+     * @param w Width of image.
+     * @param h Height of image.
+     * @param c Number of channels.
+     * @param data Pixel data of w * h * c bytes.
+     * @return Descriptor for the new image.
+     */
+    image create_borrowed(float w, float h, int c, pixels_u8_ptr data);
+
     /**
      * @brief Rotate pixels clockwise by 90 degrees increments.
      * @param a Pointer to source pixel array.
@@ -84,26 +113,339 @@ namespace ppp
      */
     image load(std::string_view path);
 
+    /**
+     * @brief Load many image files at once.
+     *
+     * The files are decoded in parallel, the textures are created afterwards in the order of the paths.
+     * @param paths Filesystem paths to the images.
+     * @return Descriptors in the same order as the paths, empty for images that could not be loaded.
+     */
+    std::vector<image> load_images(const std::vector<std::string_view>& paths);
+
+    /** @brief Block compression formats for compressed images. */
+    enum class image_compression_type : std::uint8_t
+    {
+        BC1, /**< RGB, 4 bits per pixel. */
+        BC3, /**< RGBA, 8 bits per pixel. */
+        BC5, /**< Red and green only ( e.g. normal maps ), 8 bits per pixel. */
+        BC7  /**< RGBA at a higher quality than BC3, 8 bits per pixel. */
+    };
+
+    /**
+     * @brief Load an image file as a block compressed texture with a full mip chain.
+     *
+     * The texture is compressed once and cooked into a KTX2 file next to the image ( e.g. "image.png.bc7.ktx2" ),
+     * later loads upload the cooked file directly until the image changes.
+     * Compressed images do not keep their pixels in memory, they can not be read or updated with `load_pixels` and `update_pixels`.
+     * @param path Filesystem path to the image.
+     * @param compression Format to compress the image to.
+     * @return Descriptor for the loaded image.
+     */
+    image load_compressed(std::string_view path, image_compression_type compression);
+
+    /** @brief Type alias for an image that is loading in the background. */
+    using image_handle = unsigned int;
+
+    /**
+     * @brief Load an image file without blocking.
+     *
+     * Reading and decoding happen on a worker thread, the texture is created at the start of a later frame.
+     * Use `get_image` to draw it, a solid white placeholder is returned until the image is loaded.
+     * @param path Filesystem path to the image.
+     * @return Handle to query the image with.
+     */
+    image_handle load_async(std::string_view path);
+
+    /**
+     * @brief Check if an image requested with `load_async` finished loading.
+     */
+    bool is_image_loaded(image_handle handle);
+
+    /**
+     * @brief Get the image requested with `load_async`.
+     * @return Descriptor of the loaded image, or of a placeholder while it is still loading.
+     */
+    image get_image(image_handle handle);
+
+    /**
+     * @brief Release an image and its texture.
+     *
+     * The id can be handed out again to an image that is created later, the released id should no longer be drawn.
+     * @param id Identifier of the image to release.
+     */
+    void unload_image(image_id id);
+
+    /** @brief Memory used by the loaded images. */
+    struct texture_memory_statistics
+    {
+        unsigned long long cpu_bytes;       /**< Pixel copies kept by the engine. */
+        unsigned long long gpu_bytes;       /**< Texture storage of the resident images. */
+        unsigned long long cpu_budget;      /**< 0 when unlimited. */
+        unsigned long long gpu_budget;      /**< 0 when unlimited. */
+        unsigned int resident;              /**< Images that are ready to draw. */
+        unsigned int evicted;               /**< Images that are loaded again the next time they are used. */
+        unsigned long long evictions;       /**< Evictions since the start. */
+        unsigned long long reloads;         /**< Evicted images that were loaded again since the start. */
+    };
+
+    /**
+     * @brief Limit the memory of the loaded images.
+     *
+     * At the end of every frame the least recently used images are evicted until the budget is met,
+     * an evicted image is loaded from its file again the next time it is drawn or its pixels are used.
+     * Only images loaded with `load`, `load_images` or `load_async` that were not edited can be evicted,
+     * images bound to a shader with `texture` stay loaded until the textures of the shader are reset.
+     * @param cpu_bytes Budget of the pixel copies, 0 is unlimited.
+     * @param gpu_bytes Budget of the texture storage, 0 is unlimited.
+     */
+    void texture_memory_budget(unsigned long long cpu_bytes, unsigned long long gpu_bytes);
+
+    /**
+     * @brief Get the memory used by the loaded images and the evictions so far.
+     */
+    texture_memory_statistics texture_memory();
+
+    /**
+     * @brief Identifier of a page of the shared atlas textures.
+     *
+     * A page is not an image, it can not be used where an `image_id` is expected.
+     */
+    using atlas_page_handle = unsigned int;
+
+    /**
+     * @brief Describe where a small image is stored in a shared atlas texture.
+     */
+    struct image_atlas_region
+    {
+        /** @brief True when the image is drawn from an atlas. */
+        bool packed;
+        /** @brief Page of the atlas the image is packed into, images in the same page share a texture. */
+        atlas_page_handle page;
+        /** @brief Position and size of the image in the atlas, in pixels. */
+        int x;
+        int y;
+        int width;
+        int height;
+    };
+
+    /**
+     * @brief Get the atlas area of an image.
+     *
+     * Images that are at most 128 pixels wide and high are copied into shared atlas textures when they are created,
+     * drawing many of them does not require a texture per draw. Larger images are not packed.
+     * @param id Identifier of the image.
+     * @return Area of the image, `packed` is false when the image is not in an atlas.
+     */
+    image_atlas_region atlas_region(image_id id);
+
     /**
      * @brief Draw a loaded image to the canvas.
      */
     void draw(image_id id, float x, float y, float w, float h);
 
+    /**
+     * @brief Draw a part of a loaded image to the canvas.
+     *
+     * Every part of an image is drawn with the same quad, only its texture coordinates change.
+     * Drawing other parts every frame ( e.g. animating a sprite ) creates no geometry and still batches together.
+     * @param id Identifier of the image.
+     * @param x Horizontal position on the canvas.
+     * @param y Vertical position on the canvas.
+     * @param w Width on the canvas.
+     * @param h Height on the canvas.
+     * @param sx Left edge of the part of the image, in pixels.
+     * @param sy Top edge of the part of the image, in pixels.
+     * @param sw Width of the part of the image, in pixels.
+     * @param sh Height of the part of the image, in pixels.
+     */
+    void draw(image_id id, float x, float y, float w, float h, float sx, float sy, float sw, float sh);
+
+    /**
+     * @brief Describe an image that holds a grid of equally sized frames.
+     */
+    struct sprite_sheet
+    {
+        /** @brief Identifier of the image. */
+        image_id image;
+        /** @brief Size of a frame in pixels. */
+        int frame_width;
+        int frame_height;
+        /** @brief Number of frames, numbered row by row from the top left. */
+        int frame_count;
+    };
+
+    /**
+     * @brief Split a loaded image in frames.
+     * @param id Identifier of the image.
+     * @param frame_width Width of a frame in pixels.
+     * @param frame_height Height of a frame in pixels.
+     * @param frame_count Number of frames, 0 uses every whole frame that fits in the image.
+     */
+    sprite_sheet create_sprite_sheet(image_id id, int frame_width, int frame_height, int frame_count = 0);
+
+    /**
+     * @brief Draw a frame of a sprite sheet to the canvas.
+     *
+     * Frames outside of the sheet wrap around, an animation can pass an ever increasing frame ( e.g. `frame_count() / 4` ).
+     * @param sheet Sprite sheet to draw from.
+     * @param frame Index of the frame.
+     * @param x Horizontal position on the canvas.
+     * @param y Vertical position on the canvas.
+     * @param w Width on the canvas.
+     * @param h Height on the canvas.
+     */
+    void draw_sprite(const sprite_sheet& sheet, int frame, float x, float y, float w, float h);
+
     /**
      * @brief Read pixels from the canvas into an array.
      */
     unsigned char* load_pixels(int x, int y, int w, int h);
 
+    /** @brief Type alias for a canvas read that completes in a later frame. */
+    using pixels_handle = unsigned int;
+    /** @brief Receives the RGBA pixels of an asynchronous canvas read, the pixels are only valid during the call. */
+    using pixels_callback = std::function<void(const unsigned char* pixels, int w, int h)>;
+
+    /**
+     * @brief Read pixels from the canvas without stalling rendering.
+     *
+     * The pixels are copied on the GPU at the end of the frame and handed to the callback two frames later,
+     * or later when the GPU has not finished the frame yet.
+     * @param x Left edge of the area, in pixels.
+     * @param y Bottom edge of the area, in pixels.
+     * @param w Width of the area, in pixels.
+     * @param h Height of the area, in pixels.
+     * @param callback Function receiving the pixels.
+     * @return Handle of the read, 0 when the area is empty.
+     */
+    pixels_handle load_pixels_async(int x, int y, int w, int h, pixels_callback callback);
+
+    /**
+     * @brief Read pixels from the canvas without stalling rendering, use `poll_pixels` to take the result.
+     */
+    pixels_handle load_pixels_async(int x, int y, int w, int h);
+
+    /**
+     * @brief Take the pixels of an asynchronous read that was started without a callback.
+     * @param handle Handle returned by `load_pixels_async`.
+     * @param pixels Receives the RGBA pixels.
+     * @return True once the pixels arrived, the handle can not be polled again afterwards.
+     */
+    bool poll_pixels(pixels_handle handle, std::vector<unsigned char>& pixels);
+
     /**
      * @brief Read pixels from a loaded image.
      */
     unsigned char* load_pixels(image_id id);
 
+    /**
+     * @brief Record a region of the pixels returned by `load_pixels` that was edited.
+     *
+     * The next `update_pixels` of the image only uploads the recorded regions, loading pixels again forgets them.
+     * @param x Left edge of the region, in pixels.
+     * @param y Top edge of the region, in pixels.
+     * @param w Width of the region, in pixels.
+     * @param h Height of the region, in pixels.
+     */
+    void mark_pixels_dirty(int x, int y, int w, int h);
+
     /**
      * @brief Update a loaded image's pixel data from the canvas.
+     *
+     * Only the 32x32 tiles covered by the regions passed to `mark_pixels_dirty` are uploaded to the GPU,
+     * the whole image is uploaded when no region was recorded.
      */
     void update_pixels(image_id id);
 
+    /**
+     * @brief Update a region of a loaded image's pixel data from the canvas.
+     *
+     * The region is uploaded without checking which pixels changed, cheaper when the edited area is known.
+     * @param id Identifier of the image.
+     * @param x Left edge of the region, in pixels.
+     * @param y Top edge of the region, in pixels.
+     * @param w Width of the region, in pixels.
+     * @param h Height of the region, in pixels.
+     */
+    void update_pixels(image_id id, int x, int y, int w, int h);
+
+    /** @brief Image processing filters. */
+    enum class filter_type : std::uint8_t
+    {
+        THRESHOLD,  /**< White where the luminance is at least the level ( 0 to 1, default 0.5 ), black elsewhere. */
+        GRAY,       /**< Luminance of every pixel. */
+        OPAQUE,     /**< Sets alpha to fully opaque. */
+        INVERT,     /**< Inverts the colors, alpha is kept. */
+        POSTERIZE,  /**< Limits every color channel to a number of levels ( 2 to 255, default 4 ). */
+        BLUR,       /**< Gaussian blur with a standard deviation in pixels ( default 1 ). */
+        ERODE,      /**< Darkest value of the 3x3 neighbourhood, per channel. */
+        DILATE      /**< Brightest value of the 3x3 neighbourhood, per channel. */
+    };
+
+    /**
+     * @brief Apply a filter to a loaded image with its default parameter.
+     * @param id Identifier of the image.
+     * @param type Filter to apply.
+     */
+    void filter(image_id id, filter_type type);
+
+    /**
+     * @brief Apply a filter to a loaded image.
+     *
+     * The pixels are filtered on every core and uploaded again, compressed images are left untouched.
+     * @param id Identifier of the image.
+     * @param type Filter to apply.
+     * @param param Level, number of levels or blur size, depending on the filter.
+     */
+    void filter(image_id id, filter_type type, float param);
+
+    /**
+     * @brief Apply a filter to a pixel array in place ( e.g. the result of `load_pixels` ).
+     * @param pixels Tightly packed pixels, the last channel of 2 and 4 channel images is alpha.
+     * @param w Width of the pixel array.
+     * @param h Height of the pixel array.
+     * @param c Number of channels ( 1 to 4 ).
+     * @param type Filter to apply.
+     * @param param Level, number of levels or blur size, depending on the filter.
+     */
+    void filter(pixels_u8_ptr pixels, int w, int h, int c, filter_type type, float param);
+
+    /**
+     * @brief Computes the color of the pixel at ( x, y ).
+     *
+     * Called from several threads at once, it can not draw or use `random` and should only depend on its arguments.
+     * `seed` is the same for every pixel of a 64x64 tile, it only depends on the seed of the call and the position of the tile.
+     */
+    using pixel_kernel = std::function<color(int x, int y, unsigned int seed)>;
+
+    /**
+     * @brief Fills `count` pixels of row `y` starting at column `x`.
+     *
+     * `pixels` points at the first of them and holds `count` times the channels of the image.
+     * Rows are at most 64 pixels wide and `seed` is the same for every row of a 64x64 tile, it only depends on the seed of the call and the position of the tile.
+     */
+    using pixel_row_kernel = std::function<void(int x, int y, int count, unsigned int seed, pixels_u8_ptr pixels)>;
+
+    /**
+     * @brief Compute every pixel of a loaded image on every core and upload the result once.
+     *
+     * Images with fewer than 4 channels keep red ( and alpha ), compressed images are left untouched.
+     * @param id Identifier of the image.
+     * @param kernel Color of a pixel.
+     * @param seed Base of the seed of every tile, the same seed gives the same pixels on any number of cores.
+     */
+    void generate_pixels(image_id id, const pixel_kernel& kernel, unsigned int seed = 0);
+
+    /**
+     * @brief Compute every pixel of a loaded image a row at a time on every core and upload the result once.
+     *
+     * Rows can be filled with SIMD code, the same seed gives the same pixels on any number of cores.
+     * @param id Identifier of the image.
+     * @param kernel Fills a row of pixels.
+     * @param seed Base of the seed of every tile.
+     */
+    void generate_pixel_rows(image_id id, const pixel_row_kernel& kernel, unsigned int seed);
+
     /**
      * @brief Save raw pixel data to a PNG file.
      */
@@ -119,6 +461,79 @@ namespace ppp
      */
     void save_pixels(std::string_view name, image_id id);
 
+    /** @brief File formats of a frame capture. */
+    enum class capture_format_type : std::uint8_t
+    {
+        PNG,    /**< One numbered PNG file per frame. */
+        QOI,    /**< One numbered QOI file per frame, lossless and much faster to encode than PNG. */
+        Y4M     /**< A single uncompressed YUV 4:2:0 video stream ( e.g. `ffmpeg -i capture.y4m capture.mp4` ). */
+    };
+
+    /** @brief What happens to a frame when every capture buffer is still being encoded. */
+    enum class capture_backpressure_type : std::uint8_t
+    {
+        BLOCK,  /**< Wait for a free buffer, no frame is lost. */
+        DROP    /**< Skip the frame. */
+    };
+
+    /** @brief Settings of a frame capture. */
+    struct capture_settings
+    {
+        /** Output path, a run of '#' is replaced by the zero padded frame number ( "frames/frame_####.png" ). */
+        std::string path;
+
+        capture_format_type format = capture_format_type::PNG;
+        capture_backpressure_type backpressure = capture_backpressure_type::BLOCK;
+
+        /** Number of frames that can wait for an encoder. */
+        unsigned int queue_size = 8;
+        /** Number of encoder threads, 0 uses every core except one. */
+        unsigned int encoder_count = 0;
+        /** Frame rate stored in a Y4M stream. */
+        unsigned int frame_rate = 60;
+
+        /** Capture the canvas at the end of every frame, disable to only capture the frames passed to `capture_frame`. */
+        bool capture_canvas = true;
+    };
+
+    /** @brief Result of a frame capture. */
+    struct capture_statistics
+    {
+        unsigned long long captured = 0;    /**< Frames that were accepted. */
+        unsigned long long dropped = 0;     /**< Frames that were skipped because every buffer was in use. */
+        unsigned long long written = 0;     /**< Frames that were written to disk. */
+        unsigned long long failed = 0;      /**< Frames that could not be encoded or written. */
+    };
+
+    /**
+     * @brief Start writing frames to disk on background encoder threads.
+     *
+     * The canvas is read back asynchronously, rendering does not wait for the GPU or the encoders.
+     * Without a window ( headless ) frames are passed in with `capture_frame`.
+     * @param settings Output path, format and queue behaviour.
+     * @return False when a capture is already running or the output can not be created.
+     */
+    bool begin_capture(const capture_settings& settings);
+
+    /**
+     * @brief Add a frame to the running capture.
+     * @param pixels Top-down RGBA pixels, copied before the call returns.
+     * @param w Width of the frame.
+     * @param h Height of the frame.
+     * @return False when the frame was dropped.
+     */
+    bool capture_frame(const unsigned char* pixels, int w, int h);
+
+    /**
+     * @brief Stop the capture, waits until every accepted frame is written.
+     */
+    capture_statistics end_capture();
+
+    /**
+     * @brief Check if a frame capture is running.
+     */
+    bool is_capturing();
+
     /**
      * @brief Read raw canvas pixels (RGBA).
      * @return Pointer to pixel data.
@@ -4,6 +4,8 @@
  */
 #pragma once
 
+#include "vector.h"
+
 #include <string>
 #include <functional>
 
@@ -24,6 +26,9 @@ namespace ppp
 
     /**
      * @brief Create a model from in-memory model data.
+     *
+     * Models are shared, creating a model from the same contents again returns the existing model.
+     * Every call has to be balanced by a call to `unload_model` to release the model.
      * @param model_string String containing the model file contents.
      * @param file_type Type of the model file (e.g., OBJ).
      * @return Identifier of the newly created model.
@@ -32,15 +37,147 @@ namespace ppp
 
     /**
      * @brief Load a model from a file on disk.
+     *
+     * The parsed model is cooked into a binary mesh next to the source file ( `<model_path>.ppmesh` ).
+     * Later loads map that file instead of parsing the source again, as long as the source did not change.
+     * Models are shared, loading the same ( unchanged ) file again returns the existing model.
+     * Every call has to be balanced by a call to `unload_model` to release the model.
      * @param model_path Filesystem path to the model file.
      * @return Identifier of the loaded model.
      */
     model_id load_model(std::string_view model_path);
 
+    /**
+     * @brief Type alias for a model that is loading in the background.
+     */
+    using model_handle = unsigned int;
+
+    /**
+     * @brief Load a model from a file on disk without blocking.
+     *
+     * Reading and parsing happen on a worker thread, the model is added at the start of a later frame.
+     * Use `get_model` to draw it, a placeholder box is returned until the model is loaded.
+     * Once loaded the model has to be released with `unload_model` like any other model.
+     * @param model_path Filesystem path to the model file.
+     * @return Handle to query the model with.
+     */
+    model_handle load_model_async(std::string_view model_path);
+
+    /**
+     * @brief Check if a model requested with `load_model_async` finished loading.
+     */
+    bool is_model_loaded(model_handle handle);
+
+    /**
+     * @brief Check if a model requested with `load_model_async` could not be loaded.
+     *
+     * The file is missing, unreadable or holds no vertices. `get_model` keeps returning the placeholder box.
+     */
+    bool is_model_failed(model_handle handle);
+
+    /**
+     * @brief Get the model requested with `load_model_async`.
+     * @return Identifier of the loaded model, or of a placeholder box while it is still loading or when it failed to load.
+     */
+    model_id get_model(model_handle handle);
+
+    /**
+     * @brief Parse a model file and (re)write its cooked binary mesh, without loading the model.
+     * @param model_path Filesystem path to the model file.
+     * @return True when the cooked mesh was written.
+     */
+    bool cook_model(std::string_view model_path);
+
+    /**
+     * @brief Release a model obtained from `load_model` or `create_model`.
+     *
+     * The model is destroyed once every load of it has been unloaded.
+     * @param model_id Identifier of the model to release.
+     */
+    void unload_model(model_id model_id);
+
+    /**
+     * @brief Mutable view on the vertex data of a model.
+     *
+     * The pointers stay valid for as long as the model exists, the vertex count can not be changed.
+     */
+    struct model_vertices
+    {
+        std::size_t vertex_count = 0;   /**< Amount of vertices that can be edited. */
+
+        vec3* positions = nullptr;      /**< Vertex positions. */
+        vec3* normals = nullptr;        /**< Vertex normals, nullptr when the model has no normals. */
+        vec2* uvs = nullptr;            /**< Vertex texture coordinates, nullptr when the model has no uvs. */
+    };
+
+    /**
+     * @brief Get write access to the vertices of a model.
+     * @param model_id Identifier of the model to edit.
+     * @return View on the vertex data, empty when the model does not exist.
+     * @note Call `mark_model_dirty` after editing so the changes are uploaded to the GPU.
+     */
+    model_vertices edit_model(model_id model_id);
+
+    /**
+     * @brief Flag all vertices of a model as changed.
+     * @param model_id Identifier of the edited model.
+     */
+    void mark_model_dirty(model_id model_id);
+
+    /**
+     * @brief Flag a range of vertices of a model as changed, only this range is re-uploaded to the GPU.
+     * @param model_id Identifier of the edited model.
+     * @param first_vertex Index of the first edited vertex.
+     * @param vertex_count Amount of edited vertices.
+     */
+    void mark_model_dirty(model_id model_id, std::size_t first_vertex, std::size_t vertex_count);
+
+    /**
+     * @brief Part of a model that shares a material and a group ( `usemtl` / `g` in an OBJ file ).
+     *
+     * Submeshes are ranges of the index buffer of the model, their vertices and indices are not duplicated.
+     */
+    struct model_submesh
+    {
+        std::string_view material;      /**< Name of the material, empty when none was assigned. */
+        std::string_view group;         /**< Name of the group, empty when none was assigned. */
+
+        std::size_t first_index = 0;    /**< First index of the submesh. */
+        std::size_t index_count = 0;    /**< Amount of indices of the submesh. */
+    };
+
+    /**
+     * @brief Get the amount of submeshes of a model.
+     *
+     * Models without materials or groups have a single submesh that covers all faces.
+     * @param model_id Identifier of the model.
+     * @return Amount of submeshes, 0 when the model does not exist.
+     */
+    std::size_t model_submesh_count(model_id model_id);
+
+    /**
+     * @brief Get a submesh of a model.
+     * @param model_id Identifier of the model.
+     * @param submesh Index of the submesh, in file order.
+     * @return The submesh, empty when it does not exist. The names stay valid for as long as the model exists.
+     */
+    model_submesh get_model_submesh(model_id model_id, std::size_t submesh);
+
     /**
      * @brief Render a loaded model.
+     *
+     * Every submesh is drawn with the active shader and textures.
      * @param model_id Identifier of the model to render.
      */
     void draw(model_id model_id);
 
+    /**
+     * @brief Render a single submesh of a loaded model.
+     *
+     * Switch the shader or textures in between calls to give every submesh its own material.
+     * @param model_id Identifier of the model to render.
+     * @param submesh Index of the submesh to render.
+     */
+    void draw_submesh(model_id model_id, std::size_t submesh);
+
 } // namespace ppp
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "vector.h"
+#include "shapes.h"
 
 namespace ppp
 {
@@ -16,4 +17,45 @@ namespace ppp
     };
 
     bool ray_intersects_aabb(const glm::vec3& ray_origin, const glm::vec3& ray_dir, const glm::vec3& aabb_min, const glm::vec3& aabb_max, float& t_min_out);
+
+    /**
+     * @brief Precision used when picking items with a ray.
+     */
+    enum class pick_precision : std::uint8_t
+    {
+        BOUNDS,     /**< Only test the bounding boxes of the items. */
+        TRIANGLES   /**< Test the triangles of the items that pass the bounding box test. */
+    };
+
+    /**
+     * @brief Result of a pick query.
+     */
+    struct ray_hit
+    {
+        bool hit = false;                   /**< True when the ray hit an item. */
+        geometry_id geometry = 0;           /**< Geometry id of the item, as returned by the shape functions. */
+        std::size_t item = 0;               /**< Index of the item in submission order of the frame. */
+        long long triangle = -1;            /**< Triangle that was hit, -1 when only the bounds were tested. */
+        float distance = 0.0f;              /**< Distance along the ray, in units of the ray direction. */
+        vec3 position = vec3(0.0f);         /**< World space position of the hit. */
+    };
+
+    /**
+     * @brief Record the items drawn every frame so they can be picked, the first call to `pick` does this as well.
+     */
+    void enable_picking();
+
+    /**
+     * @brief Stop recording the items drawn every frame, until the next call to `pick`.
+     */
+    void disable_picking();
+
+    /**
+     * @brief Find the closest item drawn during the previous frame that is hit by a ray.
+     * @note Items are only recorded once picking is enabled, call `enable_picking` in setup to let the first pick hit.
+     * @param r Ray in world space, for instance the result of `screen_to_world`.
+     * @param precision Test only item bounds or also the triangles of the item.
+     * @return Information about the closest hit, `hit` is false when nothing was hit.
+     */
+    ray_hit pick(const ray& r, pick_precision precision = pick_precision::TRIANGLES);
 }
\ No newline at end of file
@@ -53,4 +53,48 @@ namespace ppp
      * @brief Switch to batched draw mode for subsequent renders.
      */
     void enable_batched_draw_mode();
+
+    /**
+     * @brief Skip shapes, models and images whose bounds fall outside of the camera view (enabled by default).
+     */
+    void enable_frustum_culling();
+
+    /**
+     * @brief Submit every shape, model and image regardless of the camera view.
+     */
+    void disable_frustum_culling();
+
+    /**
+     * @brief Skip shapes, models and images that are smaller on screen than the given size (disabled by default).
+     * @param pixel_threshold Width or height in pixels below which an item is not drawn.
+     */
+    void enable_small_feature_culling(float pixel_threshold = 1.0f);
+
+    /**
+     * @brief Draw items regardless of their size on screen.
+     */
+    void disable_small_feature_culling();
+
+    /**
+     * @brief Skip shapes, models and images that are hidden behind occluders (disabled by default).
+     *
+     * Occluders are drawn in between `begin_occluders` and `end_occluders` and have to be drawn before the items they hide.
+     * Items are never occlusion culled while a directional light casts shadows.
+     */
+    void enable_occlusion_culling();
+
+    /**
+     * @brief Draw every item regardless of occluders.
+     */
+    void disable_occlusion_culling();
+
+    /**
+     * @brief Subsequent shapes and models are used as occluders, preferably a few large and closed shapes.
+     */
+    void begin_occluders();
+
+    /**
+     * @brief Stop using subsequent shapes and models as occluders.
+     */
+    void end_occluders();
 }
\ No newline at end of file
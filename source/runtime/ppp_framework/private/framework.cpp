@@ -106,11 +106,11 @@ namespace
         });
         ppp::imgui::inspector::subscribe_reload_images([]()
         {
-            s32 count = ppp::texture_reloader::reload();
+            ppp::texture_reloader::reload_result result = ppp::texture_reloader::reload();
             
-            if (count > 0)
+            if (result.reloaded > 0)
             {
-                ppp::imgui::inspector::notify(ppp::imgui::inspector::notification_type::INFO, "Images " + std::to_string(count) + " reloaded", 1.0f);
+                ppp::imgui::inspector::notify(ppp::imgui::inspector::notification_type::INFO, "Images " + std::to_string(result.reloaded) + " reloaded, " + std::to_string(result.skipped) + " unchanged", 1.0f);
             }
             else
             {
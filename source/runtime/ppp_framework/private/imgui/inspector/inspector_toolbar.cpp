@@ -4,6 +4,7 @@
 
 #include "device/device.h"
 #include "render/render.h"
+#include "resources/texture_residency.h"
 #include "environment.h"
 
 #include <sstream>
@@ -113,6 +114,17 @@ namespace ppp
                 {
                     append_sep();
                     ss << "textures:" << stats.textures;
+
+                    const auto residency = texture_residency::statistics();
+                    constexpr f32 megabyte = 1024.0f * 1024.0f;
+
+                    append_sep();
+                    ss << std::setprecision(1) << "texture memory cpu:" << (residency.cpu_bytes / megabyte) << "MB gpu:" << (residency.gpu_bytes / megabyte) << "MB";
+                    if (residency.budget.cpu_bytes != 0 || residency.budget.gpu_bytes != 0)
+                    {
+                        append_sep();
+                        ss << "evicted:" << residency.evicted << " reloads:" << residency.reloads;
+                    }
                 }
 
                 if (g_toolbar_state.show_cwd)
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "render/opengl/render_gl_api.h"
+
+namespace ppp
+{
+    // The headless tests run on the mock GL api, it counts the uploads instead of talking to a driver
+    inline render::opengl::mock_function_library& mock_library()
+    {
+        return static_cast<render::opengl::mock_function_library&>(render::opengl::api::instance());
+    }
+}
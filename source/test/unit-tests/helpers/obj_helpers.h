@@ -0,0 +1,87 @@
+#pragma once
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "geometry/geometry.h"
+
+#include <random>
+#include <string>
+
+namespace ppp
+{
+    // Positions, uvs, normals and faces of both geometries are the same
+    inline void require_identical_vertices(const geometry::geometry& actual, const geometry::geometry& expected)
+    {
+        REQUIRE(actual.vertex_positions() == expected.vertex_positions());
+        REQUIRE(actual.vertex_uvs() == expected.vertex_uvs());
+        REQUIRE(actual.vertex_normals() == expected.vertex_normals());
+
+        REQUIRE(actual.faces().size() == expected.faces().size());
+        for (u64 i = 0; i < actual.faces().size(); ++i)
+        {
+            REQUIRE(actual.faces()[i].fvs == expected.faces()[i].fvs);
+        }
+    }
+
+    inline void require_identical_submeshes(const geometry::geometry& actual, const geometry::geometry& expected)
+    {
+        REQUIRE(actual.submeshes().size() == expected.submeshes().size());
+        for (u64 i = 0; i < actual.submeshes().size(); ++i)
+        {
+            REQUIRE(actual.submeshes()[i].material == expected.submeshes()[i].material);
+            REQUIRE(actual.submeshes()[i].group == expected.submeshes()[i].group);
+            REQUIRE(actual.submeshes()[i].first_index == expected.submeshes()[i].first_index);
+            REQUIRE(actual.submeshes()[i].index_count == expected.submeshes()[i].index_count);
+        }
+    }
+
+    inline void require_identical(const geometry::geometry& actual, const geometry::geometry& expected)
+    {
+        require_identical_vertices(actual, expected);
+        require_identical_submeshes(actual, expected);
+    }
+
+    // Grid of quads with positions, uvs and normals, every row picks one of a few materials and every few rows start a group
+    inline std::string make_grid_obj(s32 quads_per_side, bool with_uvs = true, bool with_normals = true, u32 seed = 0)
+    {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<f32> height(-1.0f, 1.0f);
+        std::uniform_int_distribution<s32> material(0, 3);
+
+        const s32 vertices_per_side = quads_per_side + 1;
+
+        std::string obj = "# synthetic grid\n";
+        obj.reserve(static_cast<u64>(quads_per_side) * quads_per_side * 96);
+
+        for (s32 y = 0; y < vertices_per_side; ++y)
+        {
+            for (s32 x = 0; x < vertices_per_side; ++x)
+            {
+                obj += "v " + std::to_string(x * 0.5f) + " " + std::to_string(height(generator)) + " " + std::to_string(y * -0.25f) + "\n";
+                if (with_uvs) obj += "vt " + std::to_string(x / static_cast<f32>(quads_per_side)) + " " + std::to_string(y / static_cast<f32>(quads_per_side)) + "\n";
+                if (with_normals) obj += "vn 0.0 1.0 " + std::to_string(height(generator)) + "\n";
+            }
+        }
+
+        auto vertex = [&](s32 x, s32 y)
+        {
+            const std::string index = std::to_string(y * vertices_per_side + x + 1);
+            if (with_uvs && with_normals) return index + "/" + index + "/" + index;
+            if (with_uvs) return index + "/" + index;
+            return index;
+        };
+
+        for (s32 y = 0; y < quads_per_side; ++y)
+        {
+            if (y % 5 == 0) obj += "g part_" + std::to_string(y / 5) + "\n";
+            obj += "usemtl material_" + std::to_string(material(generator)) + "\n";
+
+            for (s32 x = 0; x < quads_per_side; ++x)
+            {
+                obj += "f " + vertex(x, y) + " " + vertex(x + 1, y) + " " + vertex(x + 1, y + 1) + " " + vertex(x, y + 1) + "\n";
+            }
+        }
+
+        return obj;
+    }
+}
@@ -0,0 +1,70 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include "util/async_loader.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace ppp;
+
+TEST_CASE("Async loader defers completions to the main thread", "[async_loader]")
+{
+    const u32 worker_count = GENERATE(0u, 1u, 4u);
+
+    async_loader::initialize(worker_count);
+
+    const std::thread::id main_thread = std::this_thread::get_id();
+
+    std::atomic<s32> work_done = 0;
+    std::vector<s32> completed;
+
+    for (s32 i = 0; i < 64; ++i)
+    {
+        async_loader::submit(
+            [&work_done]() { ++work_done; },
+            [&completed, main_thread, i]()
+            {
+                REQUIRE(std::this_thread::get_id() == main_thread);
+                completed.push_back(i);
+            });
+    }
+
+    async_loader::wait_idle();
+
+    REQUIRE(work_done == 64);
+    REQUIRE(completed.empty());
+    REQUIRE(async_loader::pending_count() == 64);
+
+    async_loader::process_completed();
+
+    REQUIRE(completed.size() == 64);
+    REQUIRE(async_loader::pending_count() == 0);
+
+    async_loader::terminate();
+}
+
+TEST_CASE("Async loader completions can submit new work", "[async_loader]")
+{
+    async_loader::initialize(2);
+
+    s32 stage = 0;
+
+    async_loader::submit(nullptr, [&stage]()
+    {
+        stage = 1;
+
+        async_loader::submit(nullptr, [&stage]() { stage = 2; });
+    });
+
+    async_loader::wait_idle();
+    async_loader::process_completed();
+    REQUIRE(stage == 1);
+
+    async_loader::wait_idle();
+    async_loader::process_completed();
+    REQUIRE(stage == 2);
+
+    async_loader::terminate();
+}
@@ -0,0 +1,347 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "ray.h"
+
+#include "geometry/geometry.h"
+#include "geometry/geometry_bvh.h"
+
+#include "resources/geometry_pool.h"
+#include "resources/picking_pool.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <random>
+#include <vector>
+#include <limits>
+
+using namespace ppp;
+
+// Unit cube centered around the origin, made out of 12 triangles
+static u64 add_cube_geometry()
+{
+    geometry::geometry* geom = geometry_pool::add_new_geometry(geometry::geometry("bvh_unit_cube", false, [](geometry::geometry* self)
+    {
+        for (s32 i = 0; i < 8; ++i)
+        {
+            self->vertex_positions().push_back(glm::vec3(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f));
+        }
+
+        const std::array<render::face, 12> faces = {{
+            {{ 0, 2, 1 }}, {{ 1, 2, 3 }},   // -z
+            {{ 4, 5, 6 }}, {{ 5, 7, 6 }},   // +z
+            {{ 0, 1, 4 }}, {{ 1, 5, 4 }},   // -y
+            {{ 2, 6, 3 }}, {{ 3, 6, 7 }},   // +y
+            {{ 0, 4, 2 }}, {{ 2, 4, 6 }},   // -x
+            {{ 1, 3, 5 }}, {{ 3, 7, 5 }}    // +x
+        }};
+
+        self->faces().assign(std::cbegin(faces), std::cend(faces));
+    }));
+
+    return geom->id();
+}
+
+static geometry::bounding_box make_box(const glm::vec3& center, f32 half_size)
+{
+    geometry::bounding_box box;
+    box.min = center - glm::vec3(half_size);
+    box.max = center + glm::vec3(half_size);
+    box.size = glm::vec3(half_size * 2.0f);
+    box.offset = center;
+    return box;
+}
+
+// Scatters boxes of different sizes in a cube, every box is registered as a pickable item
+static std::vector<geometry::bounding_box> add_random_items(u64 geometry_id, s32 item_count, f32 extent, u32 seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<f32> position(-extent, extent);
+    std::uniform_real_distribution<f32> size(0.1f, 1.0f);
+
+    const geometry::bounding_box local_bounds = make_box(glm::vec3(0.0f), 0.5f);
+
+    std::vector<geometry::bounding_box> world_bounds;
+    world_bounds.reserve(item_count);
+
+    for (s32 i = 0; i < item_count; ++i)
+    {
+        const glm::vec3 center(position(generator), position(generator), position(generator));
+        const f32 scale = size(generator);
+
+        const glm::mat4 world = glm::scale(glm::translate(glm::mat4(1.0f), center), glm::vec3(scale));
+
+        picking_pool::add_item(geometry_id, local_bounds, world);
+        world_bounds.push_back(make_box(center, scale * 0.5f));
+    }
+
+    picking_pool::end_frame();
+
+    return world_bounds;
+}
+
+// Reference result, every item is tested
+static picking_pool::pick_hit pick_brute_force(const std::vector<geometry::bounding_box>& world_bounds, const glm::vec3& ray_origin, const glm::vec3& ray_dir)
+{
+    picking_pool::pick_hit result;
+
+    f32 closest_t = std::numeric_limits<f32>::max();
+    for (u64 i = 0; i < world_bounds.size(); ++i)
+    {
+        f32 t = 0.0f;
+        if (ray_intersects_aabb(ray_origin, ray_dir, world_bounds[i].min, world_bounds[i].max, t) && t >= 0.0f && t < closest_t)
+        {
+            closest_t = t;
+
+            result.hit = true;
+            result.item_index = i;
+            result.distance = t;
+        }
+    }
+
+    return result;
+}
+
+// --------------------------------------------------------------------------
+// Tests for the bounding volume hierarchy
+// --------------------------------------------------------------------------
+TEST_CASE("BVH keeps every primitive in exactly one leaf", "[bvh]")
+{
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<f32> position(-100.0f, 100.0f);
+
+    std::vector<geometry::bounding_box> bounds;
+    for (s32 i = 0; i < 1000; ++i)
+    {
+        bounds.push_back(make_box(glm::vec3(position(generator), position(generator), position(generator)), 0.5f));
+    }
+
+    geometry::bvh bvh;
+    bvh.build(bounds.data(), static_cast<u32>(bounds.size()));
+
+    std::vector<s32> seen(bounds.size(), 0);
+    for (const geometry::bvh_node& node : bvh.nodes())
+    {
+        if (!node.is_leaf())
+        {
+            continue;
+        }
+
+        for (u32 i = 0; i < node.count; ++i)
+        {
+            const u32 primitive = bvh.primitive_indices()[node.left_first + i];
+            ++seen[primitive];
+
+            REQUIRE(glm::all(glm::greaterThanEqual(bounds[primitive].min, node.min)));
+            REQUIRE(glm::all(glm::lessThanEqual(bounds[primitive].max, node.max)));
+        }
+    }
+
+    for (s32 count : seen)
+    {
+        REQUIRE(count == 1);
+    }
+
+    REQUIRE(bvh.nodes().size() < bounds.size() * 2);
+}
+
+TEST_CASE("Ray intersects triangle", "[bvh]")
+{
+    const glm::vec3 v0(-1.0f, -1.0f, 0.0f);
+    const glm::vec3 v1(1.0f, -1.0f, 0.0f);
+    const glm::vec3 v2(0.0f, 1.0f, 0.0f);
+
+    f32 t = 0.0f;
+    REQUIRE(geometry::ray_intersects_triangle(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f, 0.0f, -1.0f), v0, v1, v2, t));
+    REQUIRE(t == 5.0f);
+
+    // back face
+    REQUIRE(geometry::ray_intersects_triangle(glm::vec3(0.0f, 0.0f, -5.0f), glm::vec3(0.0f, 0.0f, 1.0f), v0, v1, v2, t));
+    // pointing away
+    REQUIRE_FALSE(geometry::ray_intersects_triangle(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f, 0.0f, 1.0f), v0, v1, v2, t));
+    // next to the triangle
+    REQUIRE_FALSE(geometry::ray_intersects_triangle(glm::vec3(2.0f, 0.0f, 5.0f), glm::vec3(0.0f, 0.0f, -1.0f), v0, v1, v2, t));
+}
+
+// --------------------------------------------------------------------------
+// Tests for picking
+// --------------------------------------------------------------------------
+TEST_CASE("Picking matches brute force", "[bvh][picking]")
+{
+    const u64 geometry_id = add_cube_geometry();
+    const std::vector<geometry::bounding_box> world_bounds = add_random_items(geometry_id, 5000, 50.0f, 42);
+
+    REQUIRE(picking_pool::item_count() == world_bounds.size());
+
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<f32> direction(-1.0f, 1.0f);
+
+    for (s32 i = 0; i < 500; ++i)
+    {
+        const glm::vec3 ray_origin(0.0f, 0.0f, 100.0f);
+        const glm::vec3 ray_dir = glm::normalize(glm::vec3(direction(generator) * 0.5f, direction(generator) * 0.5f, -1.0f));
+
+        const picking_pool::pick_hit expected = pick_brute_force(world_bounds, ray_origin, ray_dir);
+        const picking_pool::pick_hit actual = picking_pool::pick(ray_origin, ray_dir, picking_pool::pick_precision::BOUNDS);
+
+        REQUIRE(actual.hit == expected.hit);
+        if (expected.hit)
+        {
+            REQUIRE(actual.item_index == expected.item_index);
+            REQUIRE(actual.distance == Catch::Approx(expected.distance));
+        }
+    }
+
+    picking_pool::terminate();
+}
+
+TEST_CASE("Picking refits the hierarchy when the same items move", "[bvh][picking]")
+{
+    const u64 geometry_id = add_cube_geometry();
+    const geometry::bounding_box& local_bounds = geometry_pool::get_geometry(geometry_id)->aabb();
+
+    const glm::vec3 ray_origin(0.0f, 0.0f, 10.0f);
+    const glm::vec3 ray_dir(0.0f, 0.0f, -1.0f);
+
+    for (s32 frame = 0; frame < 3; ++frame)
+    {
+        // The first item moves in and out of the ray
+        const f32 offset = frame == 1 ? 0.0f : 5.0f;
+
+        picking_pool::add_item(geometry_id, local_bounds, glm::translate(glm::mat4(1.0f), glm::vec3(offset, 0.0f, 0.0f)));
+        picking_pool::add_item(geometry_id, local_bounds, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f)));
+        picking_pool::end_frame();
+
+        const picking_pool::pick_hit hit = picking_pool::pick(ray_origin, ray_dir);
+
+        REQUIRE(hit.hit);
+        REQUIRE(hit.item_index == (frame == 1 ? 0 : 1));
+    }
+
+    picking_pool::terminate();
+}
+
+TEST_CASE("Picking returns the closest triangle", "[bvh][picking]")
+{
+    const u64 geometry_id = add_cube_geometry();
+
+    // Two cubes in a row, the ray should stop at the first one
+    picking_pool::add_item(geometry_id, geometry_pool::get_geometry(geometry_id)->aabb(), glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -10.0f)));
+    picking_pool::add_item(geometry_id, geometry_pool::get_geometry(geometry_id)->aabb(), glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f)));
+    picking_pool::end_frame();
+
+    const picking_pool::pick_hit hit = picking_pool::pick(glm::vec3(0.1f, 0.2f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+
+    REQUIRE(hit.hit);
+    REQUIRE(hit.item_index == 1);
+    REQUIRE(hit.geometry_id == geometry_id);
+    REQUIRE(hit.distance == 4.5f);
+    REQUIRE((hit.triangle_index == 2 || hit.triangle_index == 3));
+    REQUIRE(hit.position.z == -4.5f);
+
+    // Passes the corner of the bounds of the rotated cube but misses its triangles
+    picking_pool::add_item(geometry_id, geometry_pool::get_geometry(geometry_id)->aabb(), glm::rotate(glm::mat4(1.0f), glm::radians(45.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
+    picking_pool::end_frame();
+
+    const glm::vec3 corner_origin(0.65f, 0.65f, 10.0f);
+    REQUIRE(picking_pool::pick(corner_origin, glm::vec3(0.0f, 0.0f, -1.0f), picking_pool::pick_precision::BOUNDS).hit);
+    REQUIRE_FALSE(picking_pool::pick(corner_origin, glm::vec3(0.0f, 0.0f, -1.0f), picking_pool::pick_precision::TRIANGLES).hit);
+
+    picking_pool::terminate();
+}
+
+TEST_CASE("Picking a submesh only hits its own triangles", "[bvh][picking]")
+{
+    const u64 geometry_id = add_cube_geometry();
+    const geometry::bounding_box& local_bounds = geometry_pool::get_geometry(geometry_id)->aabb();
+    const glm::mat4 world = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f));
+
+    // Only the -z side is drawn, the ray passes through the missing +z side
+    picking_pool::add_item(geometry_id, local_bounds, world, 0, 6);
+    picking_pool::end_frame();
+
+    const picking_pool::pick_hit hit = picking_pool::pick(glm::vec3(0.1f, 0.2f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+
+    REQUIRE(hit.hit);
+    REQUIRE(hit.distance == 5.5f);
+    REQUIRE((hit.triangle_index == 0 || hit.triangle_index == 1));
+
+    // Only the +x side is drawn, it is parallel to the ray
+    picking_pool::add_item(geometry_id, local_bounds, world, 30, 6);
+    picking_pool::end_frame();
+
+    REQUIRE_FALSE(picking_pool::pick(glm::vec3(0.1f, 0.2f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f)).hit);
+
+    picking_pool::terminate();
+}
+
+TEST_CASE("Picking only records items once it is used", "[bvh][picking]")
+{
+    picking_pool::terminate();
+
+    REQUIRE_FALSE(picking_pool::is_enabled());
+
+    picking_pool::pick(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+    REQUIRE(picking_pool::is_enabled());
+
+    disable_picking();
+    REQUIRE_FALSE(picking_pool::is_enabled());
+
+    enable_picking();
+    REQUIRE(picking_pool::is_enabled());
+
+    picking_pool::terminate();
+    REQUIRE_FALSE(picking_pool::is_enabled());
+}
+
+// --------------------------------------------------------------------------
+// Benchmark, run with the "[!benchmark]" tag
+// --------------------------------------------------------------------------
+TEST_CASE("Picking 100k items", "[!benchmark][picking]")
+{
+    const u64 geometry_id = add_cube_geometry();
+    const std::vector<geometry::bounding_box> world_bounds = add_random_items(geometry_id, 100000, 500.0f, 42);
+
+    const glm::vec3 ray_origin(0.0f, 0.0f, 1000.0f);
+    const glm::vec3 ray_dir = glm::normalize(glm::vec3(0.01f, 0.02f, -1.0f));
+
+    BENCHMARK("build")
+    {
+        std::vector<geometry::bounding_box> bounds = world_bounds;
+
+        geometry::bvh bvh;
+        bvh.build(bounds.data(), static_cast<u32>(bounds.size()));
+        return bvh.nodes().size();
+    };
+
+    geometry::bvh refit_bvh;
+    refit_bvh.build(world_bounds.data(), static_cast<u32>(world_bounds.size()));
+
+    BENCHMARK("refit")
+    {
+        refit_bvh.refit(world_bounds.data());
+        return refit_bvh.nodes().size();
+    };
+
+    // the first query builds the hierarchy
+    picking_pool::pick(ray_origin, ray_dir, picking_pool::pick_precision::BOUNDS);
+
+    BENCHMARK("bvh")
+    {
+        return picking_pool::pick(ray_origin, ray_dir, picking_pool::pick_precision::BOUNDS);
+    };
+
+    BENCHMARK("bvh triangles")
+    {
+        return picking_pool::pick(ray_origin, ray_dir, picking_pool::pick_precision::TRIANGLES);
+    };
+
+    BENCHMARK("brute force")
+    {
+        return pick_brute_force(world_bounds, ray_origin, ray_dir);
+    };
+
+    picking_pool::terminate();
+}
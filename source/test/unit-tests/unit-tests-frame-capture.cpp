@@ -0,0 +1,359 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "util/frame_capture.h"
+#include "resources/qoi.h"
+
+#include <stb/stb_image.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace ppp;
+
+static std::string capture_directory(const std::string& name)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "ppp-frame-capture" / name;
+
+    std::filesystem::remove_all(directory);
+
+    return directory.string();
+}
+
+// Every frame gets its own color, the top row is red and the bottom row blue to check the orientation
+static std::vector<u8> make_frame(s32 width, s32 height, u8 value)
+{
+    std::vector<u8> pixels(static_cast<u64>(width) * height * 4);
+
+    for (s32 y = 0; y < height; ++y)
+    {
+        for (s32 x = 0; x < width; ++x)
+        {
+            u8* p = pixels.data() + (static_cast<u64>(y) * width + x) * 4;
+
+            p[0] = y == 0 ? 255 : value;
+            p[1] = static_cast<u8>(x * 7 + y * 3);
+            p[2] = y == height - 1 ? 255 : value;
+            p[3] = 255;
+        }
+    }
+
+    return pixels;
+}
+
+static std::vector<u8> read_file(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+
+    return std::vector<u8>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// --------------------------------------------------------------------------
+// QOI
+// --------------------------------------------------------------------------
+TEST_CASE("QOI encoding is lossless", "[frame_capture]")
+{
+    for (s32 channels : { 3, 4 })
+    {
+        const s32 width = 37;
+        const s32 height = 21;
+
+        std::vector<u8> pixels(static_cast<u64>(width) * height * channels);
+
+        // Runs, small differences and random colors so every op is used
+        u32 state = 12345;
+        for (u64 i = 0; i < pixels.size(); ++i)
+        {
+            state = state * 1664525u + 1013904223u;
+
+            const u64 pixel = i / channels;
+            if (pixel < 50)
+            {
+                pixels[i] = 10;
+            }
+            else if (pixel < 300)
+            {
+                pixels[i] = static_cast<u8>(pixel + (state >> 30));
+            }
+            else
+            {
+                pixels[i] = static_cast<u8>(state >> 24);
+            }
+        }
+
+        const std::vector<u8> encoded = qoi::encode(pixels.data(), width, height, channels);
+        REQUIRE(encoded.size() > 22);
+
+        std::vector<u8> decoded;
+        s32 decoded_width = 0;
+        s32 decoded_height = 0;
+        s32 decoded_channels = 0;
+
+        REQUIRE(qoi::decode(encoded.data(), encoded.size(), &decoded, &decoded_width, &decoded_height, &decoded_channels));
+        REQUIRE(decoded_width == width);
+        REQUIRE(decoded_height == height);
+        REQUIRE(decoded_channels == channels);
+        REQUIRE(decoded == pixels);
+    }
+}
+
+TEST_CASE("QOI rejects invalid data", "[frame_capture]")
+{
+    const std::vector<u8> pixels = make_frame(8, 8, 3);
+    std::vector<u8> encoded = qoi::encode(pixels.data(), 8, 8, 4);
+
+    std::vector<u8> decoded;
+    s32 w, h, c;
+
+    REQUIRE_FALSE(qoi::decode(encoded.data(), 10, &decoded, &w, &h, &c));
+
+    encoded[0] = 'x';
+    REQUIRE_FALSE(qoi::decode(encoded.data(), encoded.size(), &decoded, &w, &h, &c));
+
+    REQUIRE(qoi::encode(pixels.data(), 8, 8, 2).empty());
+}
+
+// --------------------------------------------------------------------------
+// Capture
+// --------------------------------------------------------------------------
+TEST_CASE("Frame paths are numbered", "[frame_capture]")
+{
+    REQUIRE(frame_capture::frame_path("frames/frame_####.png", 7) == "frames/frame_0007.png");
+    REQUIRE(frame_capture::frame_path("frames/frame_##.png", 123) == "frames/frame_123.png");
+    REQUIRE(frame_capture::frame_path("frames/frame.qoi", 42) == std::filesystem::path("frames/frame_000042.qoi").string());
+}
+
+TEST_CASE("A PNG sequence is written in frame order", "[frame_capture]")
+{
+    const std::string directory = capture_directory("png");
+
+    frame_capture::capture_settings settings;
+    settings.path = directory + "/frame_###.png";
+    settings.format = frame_capture::capture_format::PNG;
+    settings.encoder_count = 3;
+
+    REQUIRE(frame_capture::begin(settings));
+    REQUIRE(frame_capture::is_capturing());
+
+    for (u8 i = 0; i < 10; ++i)
+    {
+        const std::vector<u8> frame = make_frame(16, 8, i * 10);
+        REQUIRE(frame_capture::submit(frame.data(), 16, 8));
+    }
+
+    const frame_capture::capture_statistics statistics = frame_capture::end();
+
+    REQUIRE_FALSE(frame_capture::is_capturing());
+    REQUIRE(statistics.captured == 10);
+    REQUIRE(statistics.written == 10);
+    REQUIRE(statistics.dropped == 0);
+    REQUIRE(statistics.failed == 0);
+
+    for (u8 i = 0; i < 10; ++i)
+    {
+        const std::string path = frame_capture::frame_path(settings.path, i);
+
+        s32 width = 0;
+        s32 height = 0;
+        s32 channels = 0;
+        stbi_uc* pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+
+        REQUIRE(pixels != nullptr);
+        REQUIRE(width == 16);
+        REQUIRE(height == 8);
+
+        const std::vector<u8> expected = make_frame(16, 8, i * 10);
+        REQUIRE(std::equal(expected.begin(), expected.end(), pixels));
+
+        stbi_image_free(pixels);
+    }
+}
+
+TEST_CASE("A QOI sequence decodes to the submitted frames", "[frame_capture]")
+{
+    const std::string directory = capture_directory("qoi");
+
+    frame_capture::capture_settings settings;
+    settings.path = directory + "/frame_####.qoi";
+    settings.format = frame_capture::capture_format::QOI;
+    settings.encoder_count = 2;
+
+    REQUIRE(frame_capture::begin(settings));
+
+    for (u8 i = 0; i < 6; ++i)
+    {
+        const std::vector<u8> frame = make_frame(33, 17, i);
+        REQUIRE(frame_capture::submit(frame.data(), 33, 17));
+    }
+
+    REQUIRE(frame_capture::end().written == 6);
+
+    for (u8 i = 0; i < 6; ++i)
+    {
+        const std::vector<u8> data = read_file(frame_capture::frame_path(settings.path, i));
+
+        std::vector<u8> pixels;
+        s32 width, height, channels;
+
+        REQUIRE(qoi::decode(data.data(), data.size(), &pixels, &width, &height, &channels));
+        REQUIRE(channels == 4);
+        REQUIRE(pixels == make_frame(33, 17, i));
+    }
+}
+
+TEST_CASE("A Y4M stream keeps frame order with several encoders", "[frame_capture]")
+{
+    const std::string directory = capture_directory("y4m");
+
+    frame_capture::capture_settings settings;
+    settings.path = directory + "/capture.y4m";
+    settings.format = frame_capture::capture_format::Y4M;
+    settings.encoder_count = 4;
+    settings.frame_rate = 30;
+
+    const s32 width = 15;
+    const s32 height = 9;
+
+    REQUIRE(frame_capture::begin(settings));
+
+    for (s32 i = 0; i < 24; ++i)
+    {
+        // Uniform gray frames, the luma is the gray value
+        const std::vector<u8> frame(static_cast<u64>(width) * height * 4, static_cast<u8>(i * 10));
+        REQUIRE(frame_capture::submit(frame.data(), width, height));
+    }
+
+    // A video has a single frame size
+    const std::vector<u8> other(4 * 4 * 4, 0);
+    REQUIRE_FALSE(frame_capture::submit(other.data(), 4, 4));
+
+    const frame_capture::capture_statistics statistics = frame_capture::end();
+    REQUIRE(statistics.written == 24);
+    REQUIRE(statistics.failed == 1);
+
+    const std::vector<u8> data = read_file(settings.path);
+    const std::string header = "YUV4MPEG2 W15 H9 F30:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n";
+
+    REQUIRE(data.size() > header.size());
+    REQUIRE(std::string(data.begin(), data.begin() + header.size()) == header);
+
+    const u64 luma_size = static_cast<u64>(width) * height;
+    const u64 chroma_size = static_cast<u64>((width + 1) / 2) * ((height + 1) / 2);
+    const u64 frame_size = 6 + luma_size + chroma_size * 2;
+
+    REQUIRE(data.size() == header.size() + frame_size * 24);
+
+    for (s32 i = 0; i < 24; ++i)
+    {
+        const u8* frame = data.data() + header.size() + frame_size * i;
+
+        REQUIRE(std::string(frame, frame + 6) == "FRAME\n");
+
+        // Full range, black is 0 instead of 16
+        const u8 gray = static_cast<u8>(i * 10);
+        for (u64 p = 0; p < luma_size; ++p)
+        {
+            REQUIRE(std::abs(frame[6 + p] - gray) <= 1);
+        }
+
+        // Gray has no color
+        for (u64 p = 0; p < chroma_size * 2; ++p)
+        {
+            REQUIRE(std::abs(frame[6 + luma_size + p] - 128) <= 1);
+        }
+    }
+}
+
+TEST_CASE("Dropping frames never loses an accepted frame", "[frame_capture]")
+{
+    const std::string directory = capture_directory("drop");
+
+    frame_capture::capture_settings settings;
+    settings.path = directory + "/frame_####.png";
+    settings.format = frame_capture::capture_format::PNG;
+    settings.backpressure = frame_capture::backpressure_type::DROP;
+    settings.queue_size = 2;
+    settings.encoder_count = 1;
+
+    REQUIRE(frame_capture::begin(settings));
+
+    // Large frames so the encoder falls behind
+    const std::vector<u8> frame = make_frame(256, 256, 99);
+
+    u64 accepted = 0;
+    for (s32 i = 0; i < 50; ++i)
+    {
+        accepted += frame_capture::submit(frame.data(), 256, 256) ? 1 : 0;
+    }
+
+    const frame_capture::capture_statistics statistics = frame_capture::end();
+
+    REQUIRE(statistics.captured == accepted);
+    REQUIRE(statistics.captured + statistics.dropped == 50);
+    REQUIRE(statistics.written == statistics.captured);
+    REQUIRE(statistics.dropped > 0);
+
+    // Accepted frames are numbered without gaps
+    for (u64 i = 0; i < accepted; ++i)
+    {
+        REQUIRE(std::filesystem::exists(frame_capture::frame_path(settings.path, i)));
+    }
+    REQUIRE_FALSE(std::filesystem::exists(frame_capture::frame_path(settings.path, accepted)));
+}
+
+TEST_CASE("Blocking backpressure keeps every frame", "[frame_capture]")
+{
+    const std::string directory = capture_directory("block");
+
+    frame_capture::capture_settings settings;
+    settings.path = directory + "/frame_####.qoi";
+    settings.format = frame_capture::capture_format::QOI;
+    settings.backpressure = frame_capture::backpressure_type::BLOCK;
+    settings.queue_size = 1;
+    settings.encoder_count = 2;
+
+    REQUIRE(frame_capture::begin(settings));
+
+    const std::vector<u8> frame = make_frame(128, 128, 1);
+    for (s32 i = 0; i < 30; ++i)
+    {
+        REQUIRE(frame_capture::submit(frame.data(), 128, 128));
+    }
+
+    const frame_capture::capture_statistics statistics = frame_capture::end();
+
+    REQUIRE(statistics.captured == 30);
+    REQUIRE(statistics.dropped == 0);
+    REQUIRE(statistics.written == 30);
+}
+
+TEST_CASE("Bottom-up frames are flipped while copying", "[frame_capture]")
+{
+    const std::string directory = capture_directory("flip");
+
+    frame_capture::capture_settings settings;
+    settings.path = directory + "/frame_#.qoi";
+    settings.format = frame_capture::capture_format::QOI;
+
+    REQUIRE(frame_capture::begin(settings));
+    REQUIRE_FALSE(frame_capture::begin(settings));
+
+    const std::vector<u8> frame = make_frame(4, 6, 0);
+    REQUIRE(frame_capture::submit(frame.data(), 4, 6, true));
+
+    REQUIRE(frame_capture::end().written == 1);
+    REQUIRE_FALSE(frame_capture::submit(frame.data(), 4, 6));
+
+    const std::vector<u8> data = read_file(frame_capture::frame_path(settings.path, 0));
+
+    std::vector<u8> pixels;
+    s32 width, height, channels;
+    REQUIRE(qoi::decode(data.data(), data.size(), &pixels, &width, &height, &channels));
+
+    // The blue bottom row is now on top
+    REQUIRE(pixels[0] == 0);
+    REQUIRE(pixels[2] == 255);
+    REQUIRE(pixels[(5 * 4) * 4 + 0] == 255);
+}
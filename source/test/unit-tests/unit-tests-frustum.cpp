@@ -0,0 +1,151 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include "geometry/geometry_frustum.h"
+#include "geometry/geometry_projection.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace ppp;
+
+static glm::mat4 make_perspective_view_proj()
+{
+    const glm::mat4 proj = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    return proj * view;
+}
+
+static geometry::bounding_box make_unit_box()
+{
+    return { glm::vec3(-0.5f), glm::vec3(0.5f) };
+}
+
+// --------------------------------------------------------------------------
+// Tests for frustum against axis aligned bounding box
+// --------------------------------------------------------------------------
+TEST_CASE("Frustum accepts boxes in front of the camera", "[frustum]")
+{
+    const geometry::frustum f = geometry::make_frustum(make_perspective_view_proj());
+
+    REQUIRE(geometry::frustum_intersects_aabb(f, make_unit_box(), glm::mat4(1.0f)));
+    REQUIRE(geometry::frustum_intersects_aabb(f, make_unit_box(), glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, -2.0f, -20.0f))));
+}
+
+TEST_CASE("Frustum rejects boxes outside of the view", "[frustum]")
+{
+    const geometry::frustum f = geometry::make_frustum(make_perspective_view_proj());
+
+    // behind the camera
+    REQUIRE_FALSE(geometry::frustum_intersects_aabb(f, make_unit_box(), glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 20.0f))));
+    // beyond the far plane
+    REQUIRE_FALSE(geometry::frustum_intersects_aabb(f, make_unit_box(), glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -200.0f))));
+    // left and right
+    REQUIRE_FALSE(geometry::frustum_intersects_aabb(f, make_unit_box(), glm::translate(glm::mat4(1.0f), glm::vec3(-50.0f, 0.0f, 0.0f))));
+    REQUIRE_FALSE(geometry::frustum_intersects_aabb(f, make_unit_box(), glm::translate(glm::mat4(1.0f), glm::vec3(50.0f, 0.0f, 0.0f))));
+    // above and below
+    REQUIRE_FALSE(geometry::frustum_intersects_aabb(f, make_unit_box(), glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 50.0f, 0.0f))));
+    REQUIRE_FALSE(geometry::frustum_intersects_aabb(f, make_unit_box(), glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -50.0f, 0.0f))));
+}
+
+TEST_CASE("Frustum accepts boxes straddling a plane", "[frustum]")
+{
+    const geometry::frustum f = geometry::make_frustum(make_perspective_view_proj());
+
+    // At a distance of 10 the half width of the view is ~5.77, this box crosses the right plane
+    const geometry::bounding_box box = { glm::vec3(5.0f, -0.5f, -0.5f), glm::vec3(7.0f, 0.5f, 0.5f) };
+
+    REQUIRE(geometry::frustum_intersects_aabb(f, box, glm::mat4(1.0f)));
+}
+
+TEST_CASE("Frustum applies the world transform to the local bounds", "[frustum]")
+{
+    const geometry::frustum f = geometry::make_frustum(make_perspective_view_proj());
+
+    // A thin box that only reaches into the view once it is rotated around the z axis
+    const geometry::bounding_box box = { glm::vec3(-0.1f, 10.0f, -0.1f), glm::vec3(0.1f, 30.0f, 0.1f) };
+
+    REQUIRE_FALSE(geometry::frustum_intersects_aabb(f, box, glm::mat4(1.0f)));
+
+    const glm::mat4 rotated = glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    REQUIRE_FALSE(geometry::frustum_intersects_aabb(f, box, rotated));
+
+    const glm::mat4 moved = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -15.0f, 0.0f));
+    REQUIRE(geometry::frustum_intersects_aabb(f, box, moved));
+
+    const glm::mat4 scaled = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, 0.1f, 1.0f));
+    REQUIRE(geometry::frustum_intersects_aabb(f, box, scaled));
+}
+
+TEST_CASE("Frustum of an orthographic light keeps off-screen shadow casters", "[frustum]")
+{
+    const geometry::frustum camera = geometry::make_frustum(make_perspective_view_proj());
+
+    // Directional light looking straight down, covering a large area
+    const glm::mat4 light_proj = glm::ortho(-512.0f, 512.0f, -512.0f, 512.0f, 0.01f, 1000.0f);
+    const glm::mat4 light_view = glm::lookAt(glm::vec3(0.0f, 500.0f, 0.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+    const geometry::frustum light = geometry::make_frustum(light_proj * light_view);
+
+    const glm::mat4 world = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 30.0f));
+
+    REQUIRE_FALSE(geometry::frustum_intersects_aabb(camera, make_unit_box(), world));
+    REQUIRE(geometry::frustum_intersects_aabb(light, make_unit_box(), world));
+}
+
+// --------------------------------------------------------------------------
+// Tests for projected bounds, used by small feature culling
+// --------------------------------------------------------------------------
+TEST_CASE("Projected bounds measure the size on screen in pixels", "[frustum][projection]")
+{
+    // 90 degree field of view, at a distance of 10 the view is 20 units wide
+    const glm::mat4 proj = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::vec2 viewport(1000.0f, 1000.0f);
+
+    // Flat box of 2 units in the plane at distance 10, 1/10th of the view
+    const geometry::bounding_box box = { glm::vec3(-1.0f, -1.0f, 0.0f), glm::vec3(1.0f, 1.0f, 0.0f) };
+
+    const geometry::projected_bounds projected = geometry::project_bounds(box, proj * view, viewport);
+
+    REQUIRE(projected.valid);
+    REQUIRE(projected.size().x == Catch::Approx(100.0f));
+    REQUIRE(projected.size().y == Catch::Approx(100.0f));
+    REQUIRE(projected.min.x == Catch::Approx(450.0f));
+    REQUIRE(projected.nearest_depth > 0.0f);
+    REQUIRE(projected.nearest_depth < 1.0f);
+
+    // Same box 1000 times smaller ends up below a pixel
+    const glm::mat4 world = glm::scale(glm::mat4(1.0f), glm::vec3(0.001f));
+    const geometry::projected_bounds small = geometry::project_bounds(box, proj * view * world, viewport);
+
+    REQUIRE(small.valid);
+    REQUIRE(small.size().x < 1.0f);
+}
+
+TEST_CASE("Projected bounds are invalid behind the camera", "[frustum][projection]")
+{
+    const glm::mat4 proj = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    const geometry::bounding_box box = { glm::vec3(-1.0f), glm::vec3(1.0f) };
+
+    REQUIRE_FALSE(geometry::project_bounds(box, proj * view * glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 10.0f)), glm::vec2(100.0f)).valid);
+    REQUIRE_FALSE(geometry::project_bounds(box, proj * view * glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 20.0f)), glm::vec2(100.0f)).valid);
+}
+
+TEST_CASE("Small feature test keeps bounds without extent", "[frustum][projection]")
+{
+    const glm::mat4 proj = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::vec2 viewport(1000.0f, 1000.0f);
+
+    // A single point projects to a rectangle of size zero, it is drawn with a size in pixels of its own
+    const geometry::bounding_box point = { glm::vec3(1.0f, 2.0f, 0.0f), glm::vec3(1.0f, 2.0f, 0.0f) };
+    REQUIRE_FALSE(geometry::is_small_on_screen(point, proj * view, viewport, 1.0f));
+
+    // Bounds with an extent are measured as usual
+    const geometry::bounding_box box = { glm::vec3(-1.0f, -1.0f, 0.0f), glm::vec3(1.0f, 1.0f, 0.0f) };
+    REQUIRE_FALSE(geometry::is_small_on_screen(box, proj * view, viewport, 1.0f));
+    REQUIRE(geometry::is_small_on_screen(box, proj * view * glm::scale(glm::mat4(1.0f), glm::vec3(0.001f)), viewport, 1.0f));
+}
@@ -0,0 +1,262 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_session.hpp>
+#include "structure.h"
+
+#include "geometry/geometry.h"
+
+#include "render/render_batch.h"
+#include "render/render_vertex_buffer.h"
+#include "render/helpers/render_vertex_buffer_ops.h"
+#include "render/helpers/render_vertex_layouts.h"
+#include "helpers/mock_library.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    ppp::headless();
+
+    return Catch::Session().run(argc, argv);
+}
+
+using namespace ppp;
+
+// Geometry made out of a line of vertices along the x axis
+static geometry::geometry make_line_geometry(std::string_view id, u64 vertex_count)
+{
+    return geometry::geometry(id, false, [vertex_count](geometry::geometry* self)
+    {
+        for (u64 i = 0; i < vertex_count; ++i)
+        {
+            self->vertex_positions().push_back(glm::vec3(static_cast<f32>(i), 0.0f, 0.0f));
+            self->vertex_normals().push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+        }
+    });
+}
+
+static void add_vertices(render::vertex_buffer& vb, const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals)
+{
+    render::vertex_buffer_ops::vertex_attribute_addition_scope vaas(vb, positions.size());
+
+    render::vertex_buffer_ops::set_attribute_data(vaas, render::attribute_type::POSITION, positions.data());
+    render::vertex_buffer_ops::set_attribute_data(vaas, render::attribute_type::NORMAL, normals.data());
+}
+
+// --------------------------------------------------------------------------
+// Tests for dirty range tracking on geometry
+// --------------------------------------------------------------------------
+TEST_CASE("Geometry merges dirty ranges until cleared", "[geometry]")
+{
+    geometry::geometry geom = make_line_geometry("dirty_ranges", 10);
+
+    REQUIRE_FALSE(geom.is_dirty());
+    REQUIRE(geom.revision() == 0);
+
+    geom.mark_dirty(2, 3);
+    geom.mark_dirty(7, 1);
+
+    REQUIRE(geom.is_dirty());
+    REQUIRE(geom.dirty_range().first == 2);
+    REQUIRE(geom.dirty_range().count == 6);
+    REQUIRE(geom.revision() == 2);
+    REQUIRE(geom.base_revision() == 0);
+
+    geom.clear_dirty();
+
+    REQUIRE_FALSE(geom.is_dirty());
+    REQUIRE(geom.base_revision() == 2);
+}
+
+TEST_CASE("Geometry clamps dirty ranges to its vertices", "[geometry]")
+{
+    geometry::geometry geom = make_line_geometry("dirty_clamp", 10);
+
+    geom.mark_dirty(20, 5);
+    REQUIRE_FALSE(geom.is_dirty());
+    REQUIRE(geom.revision() == 0);
+
+    geom.mark_dirty(8, 5);
+    REQUIRE(geom.dirty_range().first == 8);
+    REQUIRE(geom.dirty_range().count == 2);
+}
+
+TEST_CASE("Geometry recomputes its bounding box after an edit", "[geometry]")
+{
+    geometry::geometry geom = make_line_geometry("dirty_aabb", 4);
+
+    REQUIRE(geom.aabb().max.x == 3.0f);
+
+    geom.vertex_positions()[3].x = 10.0f;
+    geom.mark_dirty(3, 1);
+
+    REQUIRE(geom.aabb().max.x == 10.0f);
+}
+
+// --------------------------------------------------------------------------
+// Tests for partial vertex uploads, bytes are counted by the mock library
+// --------------------------------------------------------------------------
+TEST_CASE("Vertex buffer uploads only invalidated vertices", "[geometry][upload]")
+{
+    constexpr u64 vertex_count = 16;
+    constexpr u64 vertex_size = sizeof(render::pos_norm_format);
+
+    render::vertex_buffer vb(64, render::pos_norm_layout().data(), static_cast<u32>(render::pos_norm_layout().size()));
+
+    std::vector<glm::vec3> positions(vertex_count, glm::vec3(1.0f));
+    std::vector<glm::vec3> normals(vertex_count, glm::vec3(0.0f, 1.0f, 0.0f));
+
+    mock_library().reset_upload_stats();
+
+    add_vertices(vb, positions, normals);
+    vb.submit();
+
+    REQUIRE(mock_library().upload_stats().buffer_bytes == vertex_count * vertex_size);
+
+    mock_library().reset_upload_stats();
+
+    std::vector<glm::vec3> edited_positions(2, glm::vec3(5.0f));
+    render::vertex_buffer_ops::update_attribute_data(vb, render::attribute_type::POSITION, 4, 2, edited_positions.data());
+    vb.submit();
+
+    REQUIRE(mock_library().upload_stats().buffer_uploads == 1);
+    REQUIRE(mock_library().upload_stats().buffer_bytes == 2 * vertex_size);
+
+    mock_library().reset_upload_stats();
+
+    vb.submit();
+
+    REQUIRE(mock_library().upload_stats().buffer_bytes == 0);
+
+    vb.free();
+}
+
+TEST_CASE("Vertex buffer with explicit invalidation keeps uploaded vertices", "[geometry][upload]")
+{
+    constexpr u64 vertex_count = 16;
+    constexpr u64 vertex_size = sizeof(render::pos_norm_format);
+
+    render::vertex_buffer vb(64, render::pos_norm_layout().data(), static_cast<u32>(render::pos_norm_layout().size()));
+    vb.enable_explicit_invalidation();
+
+    std::vector<glm::vec3> positions(vertex_count, glm::vec3(1.0f));
+    std::vector<glm::vec3> normals(vertex_count, glm::vec3(0.0f, 1.0f, 0.0f));
+
+    mock_library().reset_upload_stats();
+
+    // First frame, everything is new
+    add_vertices(vb, positions, normals);
+    vb.submit();
+
+    REQUIRE(mock_library().upload_stats().buffer_bytes == vertex_count * vertex_size);
+
+    // Second frame, the same vertices are added again without being invalidated
+    mock_library().reset_upload_stats();
+
+    vb.reset();
+    add_vertices(vb, positions, normals);
+    vb.submit();
+
+    REQUIRE(mock_library().upload_stats().buffer_bytes == 0);
+
+    // Third frame, a single vertex is invalidated and two vertices are added that were never uploaded
+    mock_library().reset_upload_stats();
+
+    positions.resize(vertex_count + 2, glm::vec3(1.0f));
+    normals.resize(vertex_count + 2, glm::vec3(0.0f, 1.0f, 0.0f));
+
+    vb.reset();
+    add_vertices(vb, positions, normals);
+    vb.invalidate(vertex_count - 1, 1);
+    vb.submit();
+
+    REQUIRE(mock_library().upload_stats().buffer_uploads == 1);
+    REQUIRE(mock_library().upload_stats().buffer_bytes == 3 * vertex_size);
+
+    vb.free();
+}
+
+// Item drawing a geometry that can be edited, reports its changes like models do
+class editable_item : public render::irender_item
+{
+public:
+    explicit editable_item(const geometry::geometry* geom)
+        : m_geometry(geom)
+    {}
+
+    bool has_smooth_normals() const override { return false; }
+    bool has_textures() const override { return false; }
+    bool cast_shadows() const override { return false; }
+
+    u32 vertex_count() const override { return static_cast<u32>(m_geometry->vertex_count()); }
+    u32 index_count() const override { return 0; }
+
+    const std::vector<glm::vec3>& vertex_positions() const override { return m_geometry->vertex_positions(); }
+    const std::vector<glm::vec3>& vertex_normals() const override { return m_geometry->vertex_normals(); }
+    const std::vector<glm::vec2>& vertex_uvs() const override { return m_geometry->vertex_uvs(); }
+
+    const std::vector<render::face>& faces() const override { return m_geometry->faces(); }
+
+    const u64 geometry_id() const override { return m_geometry->id(); }
+    const u64 material_id() const override { return 0; }
+
+    const resources::imaterial* material() const override { return nullptr; }
+
+    render::dirty_vertex_range dirty_vertices() const override
+    {
+        const geometry::vertex_range& range = m_geometry->dirty_range();
+
+        return { m_geometry->revision(), m_geometry->base_revision(), static_cast<u32>(range.first), static_cast<u32>(range.count) };
+    }
+
+private:
+    const geometry::geometry* m_geometry;
+};
+
+TEST_CASE("Batches only upload the vertices an item reported as edited", "[geometry][upload]")
+{
+    constexpr u64 vertex_count = 16;
+
+    const auto& layout = render::pos_norm_col_layout();
+    const u64 vertex_size = render::calculate_total_size_layout(layout.data(), layout.size());
+
+    render::batch_drawing_data drawing_data(64, 64, layout.data(), layout.size());
+
+    geometry::geometry geom = make_line_geometry("batch_edits", vertex_count);
+    const editable_item item(&geom);
+
+    auto draw_frame = [&](const glm::mat4& world)
+    {
+        mock_library().reset_upload_stats();
+
+        drawing_data.reset();
+        drawing_data.append(&item, glm::vec4(1.0f), world);
+        drawing_data.first_batch()->submit();
+
+        geom.clear_dirty();
+    };
+
+    draw_frame(glm::mat4(1.0f));
+    REQUIRE(mock_library().upload_stats().buffer_bytes == vertex_count * vertex_size);
+
+    // Nothing changed, nothing is uploaded
+    draw_frame(glm::mat4(1.0f));
+    REQUIRE(mock_library().upload_stats().buffer_bytes == 0);
+
+    // Two vertices were edited
+    geom.vertex_positions()[3].y = 1.0f;
+    geom.vertex_positions()[4].y = 1.0f;
+    geom.mark_dirty(3, 2);
+
+    draw_frame(glm::mat4(1.0f));
+    REQUIRE(mock_library().upload_stats().buffer_uploads == 1);
+    REQUIRE(mock_library().upload_stats().buffer_bytes == 2 * vertex_size);
+
+    // Moving the item changes every vertex
+    draw_frame(glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 0.0f, 0.0f)));
+    REQUIRE(mock_library().upload_stats().buffer_bytes == vertex_count * vertex_size);
+
+    drawing_data.release();
+}
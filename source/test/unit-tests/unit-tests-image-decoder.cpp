@@ -0,0 +1,160 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "resources/image_decoder.h"
+
+#include "util/parallel_for.h"
+#include "util/thread_pool.h"
+
+#include <stb/stb_image_write.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ppp;
+
+// Writes a small PNG with a pattern that depends on the index, returns its path
+static std::string write_png(s32 index)
+{
+    const s32 width = 3 + index;
+    const s32 height = 2 + (index % 5);
+    const s32 channels = 1 + (index % 4);
+
+    std::vector<u8> pixels(width * height * channels);
+    for (u64 i = 0; i < pixels.size(); ++i)
+    {
+        pixels[i] = static_cast<u8>(i * 7 + index * 13);
+    }
+
+    const std::string path = (std::filesystem::temp_directory_path() / ("ppp_decoder_" + std::to_string(index) + ".png")).string();
+
+    REQUIRE(stbi_write_png(path.c_str(), width, height, channels, pixels.data(), width * channels) != 0);
+
+    return path;
+}
+
+static void free_images(std::vector<texture_pool::image>& images)
+{
+    for (texture_pool::image& img : images)
+    {
+        free(img.data);
+    }
+}
+
+TEST_CASE("parallel_for visits every index once", "[parallel_for]")
+{
+    for (u32 thread_count : { 0u, 1u, 3u, 64u })
+    {
+        INFO("thread count: " << thread_count);
+
+        std::vector<std::atomic<s32>> visits(1000);
+
+        parallel_for(visits.size(), [&visits](u64 i) { ++visits[i]; }, thread_count);
+
+        for (const std::atomic<s32>& count : visits)
+        {
+            REQUIRE(count == 1);
+        }
+    }
+
+    // Nothing to do, nothing is called
+    parallel_for(0, [](u64) { FAIL("no index expected"); });
+}
+
+TEST_CASE("parallel_for reuses the threads of the thread pool", "[parallel_for]")
+{
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+
+    for (s32 loop = 0; loop < 20; ++loop)
+    {
+        parallel_for(256, [&mutex, &threads](u64)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+        });
+    }
+
+    // The workers plus the calling thread, no thread is started per loop
+    REQUIRE(threads.size() <= thread_pool::worker_count() + 1);
+
+    SECTION("loops inside a loop run on the thread that starts them")
+    {
+        std::vector<std::atomic<s32>> visits(64 * 64);
+
+        parallel_for(64, [&visits](u64 outer)
+        {
+            parallel_for(64, [&visits, outer](u64 inner) { ++visits[outer * 64 + inner]; });
+        });
+
+        for (const std::atomic<s32>& count : visits)
+        {
+            REQUIRE(count == 1);
+        }
+    }
+}
+
+TEST_CASE("Images decoded in parallel match a sequential decode", "[image_decoder]")
+{
+    std::vector<std::string> paths;
+    for (s32 i = 0; i < 24; ++i)
+    {
+        paths.push_back(write_png(i));
+    }
+
+    // Failures are reported in place, they do not shift the other images
+    const std::string corrupt_path = (std::filesystem::temp_directory_path() / "ppp_decoder_corrupt.png").string();
+    std::ofstream(corrupt_path, std::ios::binary) << "not a png";
+
+    paths.insert(paths.begin() + 5, (std::filesystem::temp_directory_path() / "ppp_decoder_missing.png").string());
+    paths.insert(paths.begin() + 11, corrupt_path);
+
+    std::vector<texture_pool::image> expected;
+    for (const std::string& path : paths)
+    {
+        expected.push_back(image_decoder::decode(path));
+    }
+
+    REQUIRE(expected[5].data == nullptr);
+    REQUIRE(expected[11].data == nullptr);
+
+    for (u32 thread_count : { 1u, 4u, 0u })
+    {
+        INFO("thread count: " << thread_count);
+
+        std::vector<texture_pool::image> actual = image_decoder::decode_all(paths, thread_count);
+
+        REQUIRE(actual.size() == expected.size());
+        for (u64 i = 0; i < actual.size(); ++i)
+        {
+            INFO("image: " << i);
+
+            REQUIRE((actual[i].data == nullptr) == (expected[i].data == nullptr));
+            if (actual[i].data == nullptr)
+            {
+                continue;
+            }
+
+            REQUIRE(actual[i].width == expected[i].width);
+            REQUIRE(actual[i].height == expected[i].height);
+            REQUIRE(actual[i].channels == expected[i].channels);
+            REQUIRE(std::memcmp(actual[i].data, expected[i].data, actual[i].width * actual[i].height * actual[i].channels) == 0);
+        }
+
+        free_images(actual);
+    }
+
+    free_images(expected);
+
+    for (const std::string& path : paths)
+    {
+        std::filesystem::remove(path);
+    }
+}
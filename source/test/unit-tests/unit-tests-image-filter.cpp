@@ -0,0 +1,208 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "util/image_filter.h"
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace ppp;
+
+static const image_filter::filter_type all_filters[] =
+{
+    image_filter::filter_type::THRESHOLD,
+    image_filter::filter_type::GRAY,
+    image_filter::filter_type::OPAQUE,
+    image_filter::filter_type::INVERT,
+    image_filter::filter_type::POSTERIZE,
+    image_filter::filter_type::BLUR,
+    image_filter::filter_type::ERODE,
+    image_filter::filter_type::DILATE
+};
+
+static std::vector<u8> make_noise(s32 width, s32 height, s32 channels, u32 seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<s32> value(0, 255);
+
+    std::vector<u8> pixels(static_cast<u64>(width) * height * channels);
+    for (u8& p : pixels)
+    {
+        p = static_cast<u8>(value(rng));
+    }
+
+    return pixels;
+}
+
+// --------------------------------------------------------------------------
+// Tests against the reference implementation
+// --------------------------------------------------------------------------
+TEST_CASE("Filters match the scalar reference exactly", "[image_filter]")
+{
+    // Sizes that are not a multiple of the SIMD width or the rows per task
+    const s32 sizes[][2] = { { 67, 45 }, { 1, 9 }, { 9, 1 }, { 128, 33 } };
+
+    u64 mismatches = 0;
+
+    for (image_filter::filter_type type : all_filters)
+    {
+        for (s32 channels = 1; channels <= 4; ++channels)
+        {
+            for (const auto& size : sizes)
+            {
+                const std::vector<u8> source = make_noise(size[0], size[1], channels, 11 * channels + size[0]);
+
+                std::vector<u8> expected = source;
+                image_filter::apply_reference(expected.data(), size[0], size[1], channels, type, image_filter::default_param(type));
+
+                for (u32 threads : { 1u, 4u })
+                {
+                    std::vector<u8> actual = source;
+                    image_filter::apply(actual.data(), size[0], size[1], channels, type, image_filter::default_param(type), threads);
+
+                    mismatches += actual == expected ? 0 : 1;
+                }
+            }
+        }
+    }
+
+    REQUIRE(mismatches == 0);
+}
+
+TEST_CASE("Filter parameters match the scalar reference exactly", "[image_filter]")
+{
+    const std::vector<u8> source = make_noise(50, 40, 4, 3);
+
+    const std::pair<image_filter::filter_type, f32> cases[] =
+    {
+        { image_filter::filter_type::THRESHOLD, 0.0f },
+        { image_filter::filter_type::THRESHOLD, 0.8f },
+        { image_filter::filter_type::THRESHOLD, 1.0f },
+        { image_filter::filter_type::POSTERIZE, 2.0f },
+        { image_filter::filter_type::POSTERIZE, 255.0f },
+        { image_filter::filter_type::BLUR, 0.3f },
+        { image_filter::filter_type::BLUR, 4.5f },
+        { image_filter::filter_type::BLUR, 30.0f }
+    };
+
+    for (const auto& [type, param] : cases)
+    {
+        std::vector<u8> expected = source;
+        image_filter::apply_reference(expected.data(), 50, 40, 4, type, param);
+
+        std::vector<u8> actual = source;
+        image_filter::apply(actual.data(), 50, 40, 4, type, param);
+
+        REQUIRE(actual == expected);
+    }
+}
+
+// --------------------------------------------------------------------------
+// Tests for the behaviour of every filter
+// --------------------------------------------------------------------------
+TEST_CASE("Point filters keep alpha unless they are meant to change it", "[image_filter]")
+{
+    const std::vector<u8> source = make_noise(16, 16, 4, 5);
+
+    SECTION("invert twice is the original image")
+    {
+        std::vector<u8> pixels = source;
+        image_filter::apply(pixels.data(), 16, 16, 4, image_filter::filter_type::INVERT, 0.0f);
+
+        REQUIRE(pixels[0] == 255 - source[0]);
+        REQUIRE(pixels[3] == source[3]);
+
+        image_filter::apply(pixels.data(), 16, 16, 4, image_filter::filter_type::INVERT, 0.0f);
+        REQUIRE(pixels == source);
+    }
+
+    SECTION("opaque only changes alpha")
+    {
+        std::vector<u8> pixels = source;
+        image_filter::apply(pixels.data(), 16, 16, 4, image_filter::filter_type::OPAQUE, 0.0f);
+
+        for (u64 i = 0; i < pixels.size(); ++i)
+        {
+            REQUIRE(pixels[i] == (i % 4 == 3 ? 255 : source[i]));
+        }
+    }
+
+    SECTION("gray and threshold write the same value to every color channel")
+    {
+        for (auto type : { image_filter::filter_type::GRAY, image_filter::filter_type::THRESHOLD })
+        {
+            std::vector<u8> pixels = source;
+            image_filter::apply(pixels.data(), 16, 16, 4, type, 0.5f);
+
+            for (u64 i = 0; i < pixels.size(); i += 4)
+            {
+                REQUIRE(pixels[i] == pixels[i + 1]);
+                REQUIRE(pixels[i] == pixels[i + 2]);
+                REQUIRE(pixels[i + 3] == source[i + 3]);
+
+                if (type == image_filter::filter_type::THRESHOLD)
+                {
+                    REQUIRE((pixels[i] == 0 || pixels[i] == 255));
+                }
+            }
+        }
+    }
+
+    SECTION("posterize limits the number of values")
+    {
+        std::vector<u8> pixels = source;
+        image_filter::apply(pixels.data(), 16, 16, 4, image_filter::filter_type::POSTERIZE, 3.0f);
+
+        std::set<u8> values;
+        for (u64 i = 0; i < pixels.size(); i += 4)
+        {
+            values.insert(pixels[i]);
+        }
+
+        REQUIRE(values == std::set<u8>{ 0, 127, 255 });
+    }
+}
+
+TEST_CASE("Blur keeps uniform images and spreads detail", "[image_filter]")
+{
+    std::vector<u8> uniform(32 * 32 * 3, 90);
+    image_filter::apply(uniform.data(), 32, 32, 3, image_filter::filter_type::BLUR, 3.0f);
+
+    REQUIRE(std::all_of(uniform.begin(), uniform.end(), [](u8 v) { return v == 90; }));
+
+    std::vector<u8> dot(32 * 32, 0);
+    dot[16 * 32 + 16] = 255;
+    image_filter::apply(dot.data(), 32, 32, 1, image_filter::filter_type::BLUR, 1.0f);
+
+    REQUIRE(dot[16 * 32 + 16] < 255);
+    REQUIRE(dot[16 * 32 + 17] > 0);
+    REQUIRE(dot[16 * 32 + 17] == dot[16 * 32 + 15]);
+    REQUIRE(dot[17 * 32 + 16] == dot[15 * 32 + 16]);
+    REQUIRE(dot[0] == 0);
+}
+
+TEST_CASE("Erode and dilate grow dark and bright areas by one pixel", "[image_filter]")
+{
+    std::vector<u8> pixels(8 * 8, 100);
+    pixels[3 * 8 + 3] = 255;
+    pixels[6 * 8 + 6] = 0;
+
+    std::vector<u8> dilated = pixels;
+    image_filter::apply(dilated.data(), 8, 8, 1, image_filter::filter_type::DILATE, 0.0f);
+
+    std::vector<u8> eroded = pixels;
+    image_filter::apply(eroded.data(), 8, 8, 1, image_filter::filter_type::ERODE, 0.0f);
+
+    for (s32 y = 0; y < 8; ++y)
+    {
+        for (s32 x = 0; x < 8; ++x)
+        {
+            const bool near_bright = std::abs(x - 3) <= 1 && std::abs(y - 3) <= 1;
+            const bool near_dark = std::abs(x - 6) <= 1 && std::abs(y - 6) <= 1;
+
+            REQUIRE(dilated[y * 8 + x] == (near_bright ? 255 : 100));
+            REQUIRE(eroded[y * 8 + x] == (near_dark ? 0 : 100));
+        }
+    }
+}
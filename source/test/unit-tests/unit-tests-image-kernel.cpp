@@ -0,0 +1,125 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "util/image_kernel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <set>
+#include <vector>
+
+using namespace ppp;
+
+// Value noise from the tile seed and the position, the same for any order of the tiles
+static void noise_rows(s32 x, s32 y, s32 count, u32 seed, u8* pixels, s32 channels)
+{
+    for (s32 i = 0; i < count; ++i)
+    {
+        u32 value = seed ^ static_cast<u32>((x + i) * 73856093) ^ static_cast<u32>(y * 19349663);
+        value *= 0x9e3779b1u;
+
+        for (s32 c = 0; c < channels; ++c)
+        {
+            pixels[i * channels + c] = static_cast<u8>(value >> (8 * c));
+        }
+    }
+}
+
+static std::vector<u8> generate_noise(s32 width, s32 height, s32 channels, u32 seed, u32 thread_count)
+{
+    std::vector<u8> pixels(static_cast<u64>(width) * height * channels, 0);
+
+    image_kernel::run(pixels.data(), width, height, channels, [channels](s32 x, s32 y, s32 count, u32 tile_seed, u8* row)
+    {
+        noise_rows(x, y, count, tile_seed, row, channels);
+    }, seed, thread_count);
+
+    return pixels;
+}
+
+// --------------------------------------------------------------------------
+// Tests for running kernels over images
+// --------------------------------------------------------------------------
+TEST_CASE("Every pixel is handed to the kernel exactly once", "[image_kernel]")
+{
+    // Sizes that are not a multiple of the tile size
+    for (s32 width : { 1, 63, 64, 130 })
+    {
+        for (s32 height : { 1, 65, 129 })
+        {
+            std::vector<u8> pixels(static_cast<u64>(width) * height * 2, 0);
+            std::atomic<u64> rows = 0;
+            std::atomic<bool> valid = true;
+
+            // Catch assertions are not thread safe, the rows are checked on the workers and the result afterwards
+            image_kernel::run(pixels.data(), width, height, 2, [&pixels, &rows, &valid, width](s32 x, s32 y, s32 count, u32, u8* row)
+            {
+                if (count <= 0 || count > image_kernel::tile_size || x % image_kernel::tile_size != 0 || x + count > width
+                    || row != pixels.data() + (static_cast<u64>(y) * width + x) * 2)
+                {
+                    valid = false;
+                    return;
+                }
+
+                for (s32 i = 0; i < count * 2; ++i)
+                {
+                    ++row[i];
+                }
+
+                ++rows;
+            }, 1, 4);
+
+            const s32 tiles_x = (width + image_kernel::tile_size - 1) / image_kernel::tile_size;
+
+            REQUIRE(valid);
+            REQUIRE(rows == static_cast<u64>(tiles_x) * height);
+            REQUIRE(std::all_of(pixels.begin(), pixels.end(), [](u8 p) { return p == 1; }));
+        }
+    }
+}
+
+TEST_CASE("The result does not depend on the number of threads", "[image_kernel]")
+{
+    const std::vector<u8> single = generate_noise(300, 200, 4, 1234, 1);
+
+    for (u32 thread_count : { 2u, 3u, 8u, 0u })
+    {
+        REQUIRE(generate_noise(300, 200, 4, 1234, thread_count) == single);
+    }
+
+    // Another seed gives other pixels
+    REQUIRE(generate_noise(300, 200, 4, 4321, 0) != single);
+}
+
+TEST_CASE("Every tile gets its own seed", "[image_kernel]")
+{
+    std::set<u32> seeds;
+    for (s32 tile_y = 0; tile_y < 16; ++tile_y)
+    {
+        for (s32 tile_x = 0; tile_x < 16; ++tile_x)
+        {
+            seeds.insert(image_kernel::tile_seed(7, tile_x, tile_y));
+        }
+    }
+
+    REQUIRE(seeds.size() == 16 * 16);
+
+    REQUIRE(image_kernel::tile_seed(7, 2, 3) == image_kernel::tile_seed(7, 2, 3));
+    REQUIRE(image_kernel::tile_seed(7, 2, 3) != image_kernel::tile_seed(7, 3, 2));
+    REQUIRE(image_kernel::tile_seed(7, 2, 3) != image_kernel::tile_seed(8, 2, 3));
+}
+
+TEST_CASE("Invalid input is ignored", "[image_kernel]")
+{
+    std::vector<u8> pixels(16, 5);
+    bool called = false;
+
+    const image_kernel::row_kernel kernel = [&called](s32, s32, s32, u32, u8*) { called = true; };
+
+    image_kernel::run(nullptr, 2, 2, 4, kernel, 0);
+    image_kernel::run(pixels.data(), 0, 2, 4, kernel, 0);
+    image_kernel::run(pixels.data(), 2, 2, 5, kernel, 0);
+    image_kernel::run(pixels.data(), 2, 2, 4, nullptr, 0);
+
+    REQUIRE_FALSE(called);
+    REQUIRE(std::all_of(pixels.begin(), pixels.end(), [](u8 p) { return p == 5; }));
+}
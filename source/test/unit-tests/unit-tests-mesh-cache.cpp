@@ -0,0 +1,142 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "model/mesh_cache.h"
+#include "model/parse_obj.h"
+
+#include "geometry/geometry.h"
+
+#include "helpers/obj_helpers.h"
+
+#include <glm/glm.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace ppp;
+
+static constexpr std::string_view quad_obj =
+    "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+    "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+    "vn 0 0 1\n"
+    "g quad\n"
+    "usemtl front\n"
+    "f 1/1/1 2/2/1 3/3/1\n"
+    "usemtl back\n"
+    "f 1/1/1 3/3/1 4/4/1\n";
+
+static geometry::geometry parse(std::string_view obj)
+{
+    return geometry::geometry("mesh_cache_test", false, [obj](geometry::geometry* self) { parse_obj(self, obj, 1); });
+}
+
+static std::string temp_cache_path(std::string_view name)
+{
+    return (std::filesystem::temp_directory_path() / name).string() + ".ppmesh";
+}
+
+TEST_CASE("Mesh cache round trips a parsed model", "[mesh_cache]")
+{
+    const std::string path = temp_cache_path("ppp_mesh_cache_round_trip");
+
+    const geometry::geometry source = parse(quad_obj);
+    const fileio::file_stamp stamp = { quad_obj.size(), 1234 };
+
+    REQUIRE(mesh_cache::write(path, source, stamp, fileio::content_hash(quad_obj.data(), quad_obj.size())));
+
+    s32 hash_calls = 0;
+    auto hash_fn = [&hash_calls]() { ++hash_calls; return fileio::content_hash(quad_obj.data(), quad_obj.size()); };
+
+    geometry::geometry cooked("mesh_cache_cooked", false, [&](geometry::geometry* self)
+    {
+        REQUIRE(mesh_cache::read(path, stamp, hash_fn, self));
+    });
+
+    require_identical(cooked, source);
+    REQUIRE(cooked.aabb().min == source.aabb().min);
+    REQUIRE(cooked.aabb().max == source.aabb().max);
+
+    // Matching size and write time, the source does not have to be hashed
+    REQUIRE(hash_calls == 0);
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Mesh cache detects stale sources", "[mesh_cache]")
+{
+    const std::string path = temp_cache_path("ppp_mesh_cache_stale");
+
+    const geometry::geometry source = parse(quad_obj);
+    const fileio::file_stamp stamp = { quad_obj.size(), 1234 };
+    const u64 source_hash = fileio::content_hash(quad_obj.data(), quad_obj.size());
+
+    REQUIRE(mesh_cache::write(path, source, stamp, source_hash));
+
+    s32 hash_calls = 0;
+
+    auto read = [&](const fileio::file_stamp& current_stamp, u64 current_hash)
+    {
+        bool result = false;
+        geometry::geometry geom("mesh_cache_stale", false, [&](geometry::geometry* self)
+        {
+            result = mesh_cache::read(path, current_stamp, [&]() { ++hash_calls; return current_hash; }, self);
+        });
+        return result;
+    };
+
+    SECTION("different size")
+    {
+        REQUIRE_FALSE(read({ stamp.size + 1, stamp.write_time }, source_hash));
+        REQUIRE(hash_calls == 0);
+    }
+
+    SECTION("different write time and contents")
+    {
+        REQUIRE_FALSE(read({ stamp.size, stamp.write_time + 1 }, source_hash + 1));
+        REQUIRE(hash_calls == 1);
+    }
+
+    SECTION("different write time, same contents")
+    {
+        REQUIRE(read({ stamp.size, stamp.write_time + 1 }, source_hash));
+        REQUIRE(hash_calls == 1);
+
+        // The new write time is stored, the next read does not hash again
+        REQUIRE(read({ stamp.size, stamp.write_time + 1 }, source_hash));
+        REQUIRE(hash_calls == 1);
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Mesh cache rejects corrupt files", "[mesh_cache]")
+{
+    const std::string path = temp_cache_path("ppp_mesh_cache_corrupt");
+
+    const geometry::geometry source = parse(quad_obj);
+    const fileio::file_stamp stamp = { quad_obj.size(), 1234 };
+
+    REQUIRE(mesh_cache::write(path, source, stamp, 0));
+
+    // Cut off the index stream
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+
+    geometry::geometry geom("mesh_cache_corrupt", false, [&](geometry::geometry* self)
+    {
+        REQUIRE_FALSE(mesh_cache::read(path, stamp, nullptr, self));
+    });
+
+    REQUIRE(geom.vertex_count() == 0);
+
+    SECTION("missing file")
+    {
+        std::filesystem::remove(path);
+
+        geometry::geometry missing("mesh_cache_missing", false, [&](geometry::geometry* self)
+        {
+            REQUIRE_FALSE(mesh_cache::read(path, stamp, nullptr, self));
+        });
+    }
+
+    std::filesystem::remove(path);
+}
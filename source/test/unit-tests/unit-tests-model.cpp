@@ -0,0 +1,240 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "model.h"
+
+#include "fileio/vfs.h"
+
+#include "resources/geometry_pool.h"
+
+#include "util/async_loader.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace ppp;
+
+static constexpr std::string_view triangle_obj = "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+static constexpr std::string_view quad_obj = "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nf 1 2 3 4\n";
+
+// Writes an OBJ file to the temp directory, returns the path to load it with
+static std::string write_obj(std::string_view filename, std::string_view contents)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path();
+
+    vfs::add_wildcard(string::store_sid("test:"), directory.generic_string());
+
+    std::ofstream file(directory / filename, std::ios::binary | std::ios::trunc);
+    file << contents;
+
+    std::filesystem::remove(directory / (std::string(filename) + ".ppmesh"));
+
+    return "test:/" + std::string(filename);
+}
+
+TEST_CASE("Loading the same model file twice shares the geometry", "[model]")
+{
+    const std::string path = write_obj("ppp_model_shared.obj", triangle_obj);
+
+    const model_id first = load_model(path);
+    const model_id second = load_model(path);
+
+    REQUIRE(first == second);
+    REQUIRE(edit_model(first).vertex_count == 3);
+
+    SECTION("geometry is released when every load is unloaded")
+    {
+        unload_model(first);
+        REQUIRE(geometry_pool::has_geometry(first));
+
+        unload_model(second);
+        REQUIRE_FALSE(geometry_pool::has_geometry(first));
+
+        // A new load after releasing creates the model again
+        const model_id third = load_model(path);
+        REQUIRE(geometry_pool::has_geometry(third));
+        unload_model(third);
+    }
+
+    SECTION("a changed file is loaded as a new model")
+    {
+        write_obj("ppp_model_shared.obj", quad_obj);
+
+        const model_id changed = load_model(path);
+
+        REQUIRE(changed != first);
+        REQUIRE(edit_model(changed).vertex_count == 4);
+
+        // The previous model stays alive until it is unloaded
+        REQUIRE(geometry_pool::has_geometry(first));
+
+        unload_model(first);
+        unload_model(second);
+        unload_model(changed);
+
+        REQUIRE_FALSE(geometry_pool::has_geometry(first));
+        REQUIRE_FALSE(geometry_pool::has_geometry(changed));
+    }
+}
+
+TEST_CASE("Using a model after it was unloaded does nothing", "[model]")
+{
+    const std::string path = write_obj("ppp_model_unloaded.obj", triangle_obj);
+
+    const model_id id = load_model(path);
+    unload_model(id);
+
+    // Sketches often keep drawing a model every frame after unloading it
+    for (s32 frame = 0; frame < 3; ++frame)
+    {
+        draw(id);
+        draw_submesh(id, 0);
+        mark_model_dirty(id);
+
+        REQUIRE(edit_model(id).vertex_count == 0);
+        REQUIRE(model_submesh_count(id) == 0);
+    }
+}
+
+TEST_CASE("Creating a model from the same contents twice shares the geometry", "[model]")
+{
+    const model_id first = create_model(triangle_obj, model_file_type::OBJ);
+    const model_id second = create_model(std::string(triangle_obj), model_file_type::OBJ);
+    const model_id other = create_model(quad_obj, model_file_type::OBJ);
+
+    REQUIRE(first == second);
+    REQUIRE(first != other);
+
+    unload_model(first);
+    unload_model(second);
+    unload_model(other);
+
+    REQUIRE_FALSE(geometry_pool::has_geometry(first));
+    REQUIRE_FALSE(geometry_pool::has_geometry(other));
+}
+
+TEST_CASE("Loading a model asynchronously completes on the main thread", "[model]")
+{
+    const std::string path = write_obj("ppp_model_async.obj", quad_obj);
+
+    async_loader::initialize(2);
+
+    const model_handle first = load_model_async(path);
+    const model_handle second = load_model_async(path);
+
+    // Completions only run when they are processed, a placeholder is handed out until then
+    async_loader::wait_idle();
+
+    REQUIRE_FALSE(is_model_loaded(first));
+    REQUIRE_FALSE(is_model_loaded(second));
+    REQUIRE(get_model(first) == get_model(second));
+
+    async_loader::process_completed();
+
+    REQUIRE(is_model_loaded(first));
+    REQUIRE(is_model_loaded(second));
+
+    const model_id loaded = get_model(first);
+    REQUIRE(get_model(second) == loaded);
+    REQUIRE(edit_model(loaded).vertex_count == 4);
+
+    // Loaded models are shared with blocking loads
+    REQUIRE(load_model(path) == loaded);
+
+    unload_model(loaded);
+    unload_model(loaded);
+    REQUIRE(geometry_pool::has_geometry(loaded));
+
+    unload_model(loaded);
+    REQUIRE_FALSE(geometry_pool::has_geometry(loaded));
+
+    async_loader::terminate();
+}
+
+TEST_CASE("A model that fails to load asynchronously is reported", "[model]")
+{
+    const std::string path = write_obj("ppp_model_async_empty.obj", "# no vertices\n");
+
+    async_loader::initialize(2);
+
+    const model_handle first = load_model_async(path);
+    const model_handle second = load_model_async(path);
+    const model_handle missing = load_model_async("test:/ppp_model_async_missing.obj");
+
+    async_loader::wait_idle();
+    async_loader::process_completed();
+
+    REQUIRE(is_model_failed(first));
+    REQUIRE(is_model_failed(second));
+    REQUIRE(is_model_failed(missing));
+
+    REQUIRE_FALSE(is_model_loaded(first));
+    REQUIRE(get_model(first) == get_model(missing));
+
+    // The file is no longer in flight, a request after it was fixed loads it
+    write_obj("ppp_model_async_empty.obj", triangle_obj);
+
+    const model_handle retry = load_model_async(path);
+
+    async_loader::wait_idle();
+    async_loader::process_completed();
+
+    REQUIRE(is_model_loaded(retry));
+    REQUIRE_FALSE(is_model_failed(retry));
+    REQUIRE(edit_model(get_model(retry)).vertex_count == 3);
+
+    unload_model(get_model(retry));
+
+    async_loader::terminate();
+}
+
+TEST_CASE("Cooking a model leaves no temporary files behind", "[model]")
+{
+    const std::string path = write_obj("ppp_model_cook.obj", quad_obj);
+
+    REQUIRE(cook_model(path));
+    REQUIRE(cook_model(path));
+
+    for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::temp_directory_path()))
+    {
+        const std::string filename = entry.path().filename().generic_string();
+
+        REQUIRE_FALSE((filename.rfind("ppp_model_cook.obj", 0) == 0 && entry.path().extension() == ".tmp"));
+    }
+}
+
+TEST_CASE("Submeshes of a model survive the mesh cache", "[model]")
+{
+    constexpr std::string_view obj =
+        "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+        "g panel\nusemtl front\nf 1 2 3 4\n"
+        "usemtl back\nf 1 3 2\n";
+
+    const std::string path = write_obj("ppp_model_submeshes.obj", obj);
+
+    // Parsed from the source the first time, read from the cooked mesh the second time
+    for (s32 load = 0; load < 2; ++load)
+    {
+        INFO("load: " << load);
+
+        const model_id id = load_model(path);
+
+        REQUIRE(model_submesh_count(id) == 2);
+
+        const model_submesh front = get_model_submesh(id, 0);
+        REQUIRE(front.material == "front");
+        REQUIRE(front.group == "panel");
+        REQUIRE(front.first_index == 0);
+        REQUIRE(front.index_count == 6);
+
+        const model_submesh back = get_model_submesh(id, 1);
+        REQUIRE(back.material == "back");
+        REQUIRE(back.group == "panel");
+        REQUIRE(back.first_index == 6);
+        REQUIRE(back.index_count == 3);
+
+        REQUIRE(get_model_submesh(id, 2).index_count == 0);
+
+        unload_model(id);
+    }
+}
@@ -0,0 +1,201 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "model/parse_obj.h"
+
+#include "fileio/fileio.h"
+
+#include "geometry/geometry.h"
+
+#include "helpers/obj_helpers.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <string>
+
+using namespace ppp;
+
+// --------------------------------------------------------------------------
+// Counting allocator, every allocation of this executable is tracked
+// --------------------------------------------------------------------------
+namespace
+{
+    std::atomic<u64> g_allocated_bytes = 0;
+    std::atomic<u64> g_peak_bytes = 0;
+
+    // Size of every allocation is stored in front of the block
+    constexpr u64 header_size = alignof(std::max_align_t);
+
+    void* counted_alloc(std::size_t size)
+    {
+        void* block = std::malloc(size + header_size);
+        if (block == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+
+        *static_cast<u64*>(block) = size;
+
+        const u64 allocated = g_allocated_bytes += size;
+
+        u64 peak = g_peak_bytes.load();
+        while (allocated > peak && !g_peak_bytes.compare_exchange_weak(peak, allocated)) {}
+
+        return static_cast<u8*>(block) + header_size;
+    }
+
+    void counted_free(void* ptr)
+    {
+        if (ptr == nullptr)
+        {
+            return;
+        }
+
+        void* block = static_cast<u8*>(ptr) - header_size;
+
+        g_allocated_bytes -= *static_cast<u64*>(block);
+
+        std::free(block);
+    }
+
+    // Peak of the allocated bytes since the last reset, relative to what was allocated at that point
+    struct peak_scope
+    {
+        peak_scope() : baseline(g_allocated_bytes.load()) { g_peak_bytes = baseline; }
+
+        u64 peak() const { return g_peak_bytes.load() - baseline; }
+
+        u64 baseline;
+    };
+}
+
+void* operator new(std::size_t size) { return counted_alloc(size); }
+void* operator new[](std::size_t size) { return counted_alloc(size); }
+void operator delete(void* ptr) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { counted_free(ptr); }
+
+// --------------------------------------------------------------------------
+// Helpers
+// --------------------------------------------------------------------------
+static std::string write_temp_file(std::string_view name, const std::string& contents)
+{
+    const std::string path = (std::filesystem::temp_directory_path() / name).string();
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << contents;
+
+    return path;
+}
+
+static u64 output_bytes(const geometry::geometry& geom)
+{
+    return geom.vertex_positions().capacity() * sizeof(glm::vec3)
+        + geom.vertex_normals().capacity() * sizeof(glm::vec3)
+        + geom.vertex_uvs().capacity() * sizeof(glm::vec2)
+        + geom.faces().capacity() * sizeof(render::face);
+}
+
+static void stream_file(geometry::geometry* geom, const std::string& path, u64 chunk_size)
+{
+    obj_stream_parser parser(geom);
+
+    REQUIRE(fileio::read_resolved_file_chunked(path, chunk_size, [&parser](std::string_view chunk) { parser.append(chunk); }));
+
+    parser.finish();
+}
+
+// --------------------------------------------------------------------------
+// Tests
+// --------------------------------------------------------------------------
+TEST_CASE("Streaming OBJ parser matches the in memory parser", "[obj]")
+{
+    std::string obj = make_grid_obj(24);
+
+    // No newline at the end of the file, the last face is still parsed
+    obj += "f 1/1/1 2/2/2 3/3/3";
+
+    const geometry::geometry expected("obj_in_memory", false, [&obj](geometry::geometry* self) { parse_obj(self, obj, 1); });
+
+    for (u64 chunk_size : { 1ull, 7ull, 64ull, 4096ull, 1ull << 20 })
+    {
+        INFO("chunk size: " << chunk_size);
+
+        const geometry::geometry streamed("obj_streamed", false, [&obj, chunk_size](geometry::geometry* self)
+        {
+            obj_stream_parser parser(self);
+
+            for (u64 offset = 0; offset < obj.size(); offset += chunk_size)
+            {
+                parser.append(std::string_view(obj).substr(offset, chunk_size));
+            }
+
+            parser.finish();
+        });
+
+        require_identical(streamed, expected);
+    }
+}
+
+TEST_CASE("Streaming OBJ parser keeps memory bounded by the output", "[obj]")
+{
+    constexpr u64 chunk_size = 64 * 1024;
+
+    SECTION("large mesh")
+    {
+        const std::string path = write_temp_file("ppp_obj_stream_mesh.obj", make_grid_obj(300));
+
+        u64 in_memory_peak = 0;
+        {
+            peak_scope scope;
+
+            const geometry::geometry geom("obj_in_memory_mesh", false, [&path](geometry::geometry* self)
+            {
+                const std::string buffer = fileio::read_resolved_text_file(path);
+                parse_obj(self, buffer, 1);
+            });
+
+            in_memory_peak = scope.peak();
+        }
+
+        {
+            peak_scope scope;
+
+            const geometry::geometry geom("obj_stream_mesh", false, [&path](geometry::geometry* self) { stream_file(self, path, chunk_size); });
+
+            // The output, plus the intermediate attributes and vertex lookup that are as large as the output
+            REQUIRE(scope.peak() <= 4 * output_bytes(geom) + 2 * chunk_size);
+            // The file itself is never held in memory
+            REQUIRE(scope.peak() < in_memory_peak);
+        }
+
+        std::filesystem::remove(path);
+    }
+
+    SECTION("small mesh in a large file")
+    {
+        // Comments make the file large, the peak does not depend on the file size
+        std::string obj = make_grid_obj(4);
+        for (s32 i = 0; i < 200000; ++i)
+        {
+            obj += "# a comment line that is skipped by the parser\n";
+        }
+
+        const std::string path = write_temp_file("ppp_obj_stream_comments.obj", obj);
+        obj = std::string();
+
+        peak_scope scope;
+        {
+            geometry::geometry geom("obj_stream_comments", false, [&path](geometry::geometry* self) { stream_file(self, path, chunk_size); });
+
+            REQUIRE(scope.peak() < 4 * chunk_size);
+        }
+
+        std::filesystem::remove(path);
+    }
+}
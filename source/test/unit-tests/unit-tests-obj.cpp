@@ -0,0 +1,364 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "model/parse_obj.h"
+#include "model/parse_obj_tokens.h"
+
+#include "geometry/geometry.h"
+
+#include "helpers/obj_helpers.h"
+
+#include <glm/glm.hpp>
+
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace ppp;
+
+// Reference implementation, the string based parser that was used before the in place parser.
+// Only valid for faces in the "p", "p/t" or "p/t/n" format, other formats trigger out of bounds reads in the original.
+static void legacy_parse_obj(geometry::geometry* geom, std::string_view buffer)
+{
+    auto split = [](const std::string& str, char delimiter)
+    {
+        std::vector<std::string> parts;
+        std::string part;
+        for (char c : str)
+        {
+            if (c == delimiter) { if (!part.empty()) parts.push_back(part); part.clear(); }
+            else { part.push_back(c); }
+        }
+        if (!part.empty()) parts.push_back(part);
+        return parts;
+    };
+
+    std::unordered_map<std::string, std::unordered_map<std::string, s32>> used_verts;
+    std::vector<glm::vec3> positions, normals;
+    std::vector<glm::vec2> uvs;
+    std::string current_material;
+
+    std::istringstream lines{ std::string(buffer) };
+    for (std::string line; std::getline(lines, line);)
+    {
+        std::istringstream line_stream(line);
+        std::vector<std::string> tokens;
+        for (std::string token; line_stream >> token;) tokens.push_back(token);
+
+        if (tokens.empty()) continue;
+
+        if (tokens[0] == "usemtl") current_material = tokens[1];
+        else if (tokens[0] == "v") positions.emplace_back(std::stof(tokens[1]), std::stof(tokens[2]), std::stof(tokens[3]));
+        else if (tokens[0] == "vn") normals.emplace_back(std::stof(tokens[1]), std::stof(tokens[2]), std::stof(tokens[3]));
+        else if (tokens[0] == "vt") uvs.emplace_back(std::stof(tokens[1]), 1.0f - std::stof(tokens[2]));
+        else if (tokens[0] == "f")
+        {
+            for (u64 tri = 3; tri < tokens.size(); ++tri)
+            {
+                std::vector<u32> face;
+                for (u64 token_index : { u64(1), tri - 1, tri })
+                {
+                    const std::string& vert_string = tokens[token_index];
+
+                    std::vector<s32> parts;
+                    for (const auto& part : split(vert_string, '/')) parts.push_back(std::stoi(part) - 1);
+
+                    auto& per_material = used_verts[vert_string];
+                    if (per_material.find(current_material) == per_material.end())
+                    {
+                        s32 vert_index = static_cast<s32>(geom->vertex_positions().size());
+
+                        geom->vertex_positions().push_back(positions[parts[0]]);
+                        geom->vertex_uvs().push_back(!uvs.empty() ? uvs[parts[1]] : glm::vec2(0.0f));
+                        geom->vertex_normals().push_back(!normals.empty() ? normals[parts[2]] : glm::vec3(0.0f));
+
+                        per_material[current_material] = vert_index;
+                    }
+
+                    face.push_back(per_material[current_material]);
+                }
+
+                if (face[0] != face[1] && face[0] != face[2] && face[1] != face[2])
+                {
+                    geom->faces().push_back({ face[0], face[1], face[2] });
+                }
+            }
+        }
+    }
+}
+
+static geometry::geometry parse(std::string_view obj, u32 thread_count = 1)
+{
+    return geometry::geometry("obj_test", false, [obj, thread_count](geometry::geometry* self) { parse_obj(self, obj, thread_count); });
+}
+
+static geometry::geometry legacy_parse(std::string_view obj)
+{
+    return geometry::geometry("obj_test_legacy", false, [obj](geometry::geometry* self) { legacy_parse_obj(self, obj); });
+}
+
+// --------------------------------------------------------------------------
+// Golden tests, the parser has to match the previous implementation
+// --------------------------------------------------------------------------
+TEST_CASE("OBJ parser matches the reference on a textured cube", "[obj]")
+{
+    constexpr std::string_view cube =
+        "# cube\n"
+        "mtllib cube.mtl\n"
+        "o cube\n"
+        "v -0.5 -0.5  0.5\nv 0.5 -0.5  0.5\nv -0.5 0.5  0.5\nv 0.5 0.5  0.5\n"
+        "v -0.5 0.5 -0.5\nv 0.5 0.5 -0.5\nv -0.5 -0.5 -0.5\nv 0.5 -0.5 -0.5\n"
+        "vt 0.0 0.0\nvt 1.0 0.0\nvt 0.0 1.0\nvt 1.0 1.0\n"
+        "vn 0.0 0.0 1.0\nvn 0.0 1.0 0.0\nvn 0.0 0.0 -1.0\nvn 0.0 -1.0 0.0\nvn 1.0 0.0 0.0\nvn -1.0 0.0 0.0\n"
+        "usemtl front\n"
+        "s off\n"
+        "f 1/1/1 2/2/1 3/3/1\nf 3/3/1 2/2/1 4/4/1\n"
+        "f 3/1/2 4/2/2 5/3/2\nf 5/3/2 4/2/2 6/4/2\n"
+        "usemtl back\n"
+        "f 5/4/3 6/3/3 7/2/3\nf 7/2/3 6/3/3 8/1/3\n"
+        "f 7/1/4 8/2/4 1/3/4\nf 1/3/4 8/2/4 2/4/4\n"
+        "usemtl front\n"
+        "f 2/1/5 8/2/5 4/3/5\nf 4/3/5 8/2/5 6/4/5\r\n"
+        "f 7/1/6 1/2/6 5/3/6\n"
+        "f\t5/3/6  1/2/6\t3/4/6\n";
+
+    const geometry::geometry actual = parse(cube);
+    const geometry::geometry expected = legacy_parse(cube);
+
+    require_identical_vertices(actual, expected);
+
+    REQUIRE(actual.faces().size() == 12);
+    REQUIRE(actual.vertex_uvs()[0] == glm::vec2(0.0f, 1.0f));
+}
+
+TEST_CASE("OBJ parser matches the reference on polygons and materials", "[obj]")
+{
+    SECTION("positions, uvs and normals")
+    {
+        const std::string obj = make_grid_obj(24, true, true, 3);
+        require_identical_vertices(parse(obj), legacy_parse(obj));
+    }
+
+    SECTION("positions and uvs")
+    {
+        const std::string obj = make_grid_obj(24, true, false, 5);
+        require_identical_vertices(parse(obj), legacy_parse(obj));
+    }
+
+    SECTION("positions only")
+    {
+        const std::string obj = make_grid_obj(24, false, false, 7);
+        require_identical_vertices(parse(obj), legacy_parse(obj));
+    }
+
+    SECTION("degenerate triangles are dropped")
+    {
+        constexpr std::string_view obj = "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 1 2\nf 1 2 3\nf 3 3 3\n";
+        require_identical_vertices(parse(obj), legacy_parse(obj));
+
+        REQUIRE(parse(obj).faces().size() == 1);
+    }
+}
+
+// --------------------------------------------------------------------------
+// Tokenizer, this target is built with bounds checked containers
+// --------------------------------------------------------------------------
+TEST_CASE("OBJ tokenizer reads single character vertex statements", "[obj]")
+{
+    std::string_view line = "v 1 -2 +3.5";
+
+    const internal::obj_element element = internal::element_type(internal::next_token(line));
+    REQUIRE(element == internal::obj_element::POSITION);
+    REQUIRE(internal::parse_element(element, line) == glm::vec3(1.0f, -2.0f, 3.5f));
+
+    // A keyword of one character is never indexed past its end
+    REQUIRE(internal::element_type("v") == internal::obj_element::POSITION);
+    REQUIRE(internal::element_type("f") == internal::obj_element::NONE);
+    REQUIRE(internal::element_type("") == internal::obj_element::NONE);
+}
+
+TEST_CASE("OBJ tokenizer reads normals and flipped uvs", "[obj]")
+{
+    std::string_view normal = "vn 0 0 1";
+    REQUIRE(internal::parse_element(internal::element_type(internal::next_token(normal)), normal) == glm::vec3(0.0f, 0.0f, 1.0f));
+
+    std::string_view uv = "vt 0.25 0.75";
+    REQUIRE(internal::parse_element(internal::element_type(internal::next_token(uv)), uv) == glm::vec3(0.25f, 0.25f, 0.0f));
+
+    REQUIRE(internal::element_type("vp") == internal::obj_element::NONE);
+    REQUIRE(internal::element_type("vtn") == internal::obj_element::NONE);
+}
+
+TEST_CASE("OBJ parser reads a file of plain vertex lines", "[obj]")
+{
+    constexpr std::string_view obj = "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3";
+
+    const geometry::geometry geom = parse(obj);
+
+    REQUIRE(geom.faces().size() == 1);
+    REQUIRE(geom.vertex_positions()[1] == glm::vec3(1.0f, 0.0f, 0.0f));
+}
+
+// --------------------------------------------------------------------------
+// Formats the previous parser did not support
+// --------------------------------------------------------------------------
+TEST_CASE("OBJ parser supports position and normal only face vertices", "[obj]")
+{
+    constexpr std::string_view obj = "v 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 0 1\nf 1//1 2//1 3//1\n";
+
+    const geometry::geometry geom = parse(obj);
+
+    REQUIRE(geom.faces().size() == 1);
+    REQUIRE(geom.vertex_normals().size() == 3);
+    REQUIRE(geom.vertex_normals()[2] == glm::vec3(0.0f, 0.0f, 1.0f));
+    REQUIRE(geom.vertex_uvs()[2] == glm::vec2(0.0f, 0.0f));
+}
+
+TEST_CASE("OBJ parser resolves negative indices", "[obj]")
+{
+    constexpr std::string_view relative = "v 0 0 0\nv 1 0 0\nv 0 1 0\nf -3 -2 -1\nv 0 0 1\nf -4 -3 -1\n";
+    constexpr std::string_view absolute = "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\nv 0 0 1\nf 1 2 4\n";
+
+    require_identical(parse(relative), parse(absolute));
+}
+
+TEST_CASE("OBJ parser skips faces with invalid indices", "[obj]")
+{
+    constexpr std::string_view obj = "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 4\nf 1 2 3\nf 0 1 2\n";
+
+    REQUIRE(parse(obj).faces().size() == 1);
+}
+
+// --------------------------------------------------------------------------
+// Submeshes, faces are grouped by "usemtl" and "g"
+// --------------------------------------------------------------------------
+TEST_CASE("OBJ parser splits faces into submeshes", "[obj]")
+{
+    constexpr std::string_view obj =
+        "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+        "f 1 2 3\n"                                 // no material or group
+        "g body\nusemtl skin\n"
+        "f 1 2 3 4\n"
+        "usemtl skin\n"                             // same material again, extends the previous submesh
+        "f 1 3 4\n"
+        "usemtl cloth\nusemtl metal\n"              // no faces for "cloth"
+        "f 1 2 3\n"
+        "g head\n"
+        "f 1 2 3\nf 0 1 2\n"                       // invalid face, does not extend the submesh
+        "usemtl skin\n"
+        "f 2 3 4\n";
+
+    const geometry::geometry geom = parse(obj);
+
+    const std::vector<geometry::submesh>& submeshes = geom.submeshes();
+    REQUIRE(submeshes.size() == 5);
+
+    auto require_submesh = [&submeshes](u64 index, std::string_view material, std::string_view group, u64 first_index, u64 index_count)
+    {
+        INFO("submesh: " << index);
+
+        REQUIRE(submeshes[index].material == material);
+        REQUIRE(submeshes[index].group == group);
+        REQUIRE(submeshes[index].first_index == first_index);
+        REQUIRE(submeshes[index].index_count == index_count);
+    };
+
+    require_submesh(0, "", "", 0, 3);
+    require_submesh(1, "skin", "body", 3, 9);
+    require_submesh(2, "metal", "body", 12, 3);
+    require_submesh(3, "metal", "head", 15, 3);
+    require_submesh(4, "skin", "head", 18, 3);
+
+    REQUIRE(geom.index_count() == 21);
+
+    // Vertices are only shared within a material
+    REQUIRE(geom.vertex_positions().size() == 3 + 4 + 3);
+}
+
+TEST_CASE("OBJ parser submeshes tile the faces", "[obj]")
+{
+    const std::string obj = make_grid_obj(16, true, true, 3);
+
+    const geometry::geometry geom = parse(obj);
+
+    REQUIRE(geom.submeshes().size() > 1);
+
+    u64 next_index = 0;
+    for (const geometry::submesh& submesh : geom.submeshes())
+    {
+        REQUIRE(submesh.first_index == next_index);
+        REQUIRE(submesh.index_count > 0);
+        REQUIRE(submesh.index_count % 3 == 0);
+
+        next_index += submesh.index_count;
+    }
+
+    REQUIRE(next_index == geom.index_count());
+}
+
+// --------------------------------------------------------------------------
+// Multi threaded parsing, every chunk count has to produce the sequential result
+// --------------------------------------------------------------------------
+TEST_CASE("OBJ parser produces identical results on multiple threads", "[obj]")
+{
+    const std::string obj = make_grid_obj(64, true, true, 5);
+
+    const geometry::geometry expected = parse(obj, 1);
+
+    for (u32 thread_count : { 2u, 3u, 7u, 16u, 1000u })
+    {
+        INFO("thread count: " << thread_count);
+
+        const geometry::geometry actual = parse(obj, thread_count);
+
+        require_identical(actual, expected);
+    }
+}
+
+TEST_CASE("OBJ parser resolves relative indices across chunks", "[obj]")
+{
+    // Every quad declares its own vertices and references them relatively, materials only change every few quads
+    std::string obj;
+    for (s32 i = 0; i < 500; ++i)
+    {
+        if (i % 7 == 0) obj += "usemtl material_" + std::to_string(i % 3) + "\n";
+
+        obj += "v " + std::to_string(i) + " 0 0\nv " + std::to_string(i + 1) + " 0 0\n";
+        obj += "v " + std::to_string(i + 1) + " 1 0\nv " + std::to_string(i) + " 1 0\n";
+        obj += "vt 0 0\nvn 0 0 1\n";
+        obj += "f -4/-1/-1 -3/-1/-1 -2/-1/-1 -1/-1/-1\n";
+        obj += "f 1 2 " + std::to_string(4 * (i + 1) + 1) + "\n"; // forward reference, always invalid
+    }
+
+    const geometry::geometry expected = parse(obj, 1);
+    REQUIRE(expected.faces().size() == 1000);
+
+    for (u32 thread_count : { 2u, 5u, 13u, 64u })
+    {
+        INFO("thread count: " << thread_count);
+
+        const geometry::geometry actual = parse(obj, thread_count);
+
+        require_identical(actual, expected);
+    }
+}
+
+// --------------------------------------------------------------------------
+// Benchmark, run with the "[!benchmark]" tag
+// --------------------------------------------------------------------------
+TEST_CASE("Parsing a 10M face OBJ", "[!benchmark][obj]")
+{
+    // 2237 * 2237 quads, each quad is split into 2 triangles
+    const std::string obj = make_grid_obj(2237, true, true, 11);
+
+    BENCHMARK("parse_obj, 1 thread")
+    {
+        return parse(obj, 1).faces().size();
+    };
+
+    BENCHMARK("parse_obj, all threads")
+    {
+        return parse(obj, 0).faces().size();
+    };
+}
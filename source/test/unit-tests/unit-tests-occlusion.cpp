@@ -0,0 +1,192 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "geometry/geometry_occlusion_buffer.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+#include <cmath>
+
+using namespace ppp;
+
+// Camera at z = 10 looking down the negative z axis
+static glm::mat4 make_view_proj()
+{
+    const glm::mat4 proj = glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 100.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    return proj * view;
+}
+
+// Quad in the xy plane, made out of two triangles
+static void rasterize_wall(geometry::occlusion_buffer& buffer, const glm::mat4& view_proj, const glm::vec3& center, f32 half_width, f32 half_height)
+{
+    const std::vector<glm::vec3> positions =
+    {
+        center + glm::vec3(-half_width, -half_height, 0.0f),
+        center + glm::vec3( half_width, -half_height, 0.0f),
+        center + glm::vec3( half_width,  half_height, 0.0f),
+        center + glm::vec3(-half_width,  half_height, 0.0f)
+    };
+
+    const std::vector<render::face> faces = { {{ 0, 1, 2 }}, {{ 0, 2, 3 }} };
+
+    buffer.rasterize(positions.data(), faces.data(), faces.size(), view_proj);
+}
+
+static geometry::bounding_box make_box(const glm::vec3& center, f32 half_size)
+{
+    geometry::bounding_box box;
+    box.min = center - glm::vec3(half_size);
+    box.max = center + glm::vec3(half_size);
+    box.size = glm::vec3(half_size * 2.0f);
+    box.offset = center;
+    return box;
+}
+
+// --------------------------------------------------------------------------
+// Tests for the occlusion buffer
+// --------------------------------------------------------------------------
+TEST_CASE("Empty occlusion buffer hides nothing", "[occlusion]")
+{
+    geometry::occlusion_buffer buffer;
+
+    REQUIRE(buffer.empty());
+    REQUIRE_FALSE(buffer.is_occluded(make_box(glm::vec3(0.0f, 0.0f, -50.0f), 1.0f), make_view_proj()));
+}
+
+TEST_CASE("Wall hides boxes behind it", "[occlusion]")
+{
+    const glm::mat4 view_proj = make_view_proj();
+
+    geometry::occlusion_buffer buffer;
+    rasterize_wall(buffer, view_proj, glm::vec3(0.0f), 4.0f, 2.0f);
+
+    REQUIRE_FALSE(buffer.empty());
+
+    // behind the wall
+    REQUIRE(buffer.is_occluded(make_box(glm::vec3(0.0f, 0.0f, -5.0f), 1.0f), view_proj));
+    REQUIRE(buffer.is_occluded(make_box(glm::vec3(1.0f, 0.5f, -20.0f), 1.0f), view_proj));
+    // in front of the wall
+    REQUIRE_FALSE(buffer.is_occluded(make_box(glm::vec3(0.0f, 0.0f, 5.0f), 1.0f), view_proj));
+    // intersecting the wall
+    REQUIRE_FALSE(buffer.is_occluded(make_box(glm::vec3(0.0f, 0.0f, 0.0f), 0.5f), view_proj));
+    // behind the wall but sticking out to the side
+    REQUIRE_FALSE(buffer.is_occluded(make_box(glm::vec3(5.0f, 0.0f, -5.0f), 1.0f), view_proj));
+    // reaching behind the camera
+    REQUIRE_FALSE(buffer.is_occluded(make_box(glm::vec3(0.0f, 0.0f, 0.0f), 20.0f), view_proj));
+}
+
+TEST_CASE("Large boxes are tested on a coarse level of the hierarchy", "[occlusion]")
+{
+    const glm::mat4 view_proj = make_view_proj();
+
+    geometry::occlusion_buffer buffer;
+    rasterize_wall(buffer, view_proj, glm::vec3(0.0f), 50.0f, 50.0f);
+
+    // covers most of the screen
+    REQUIRE(buffer.is_occluded(make_box(glm::vec3(0.0f, 0.0f, -20.0f), 8.0f), view_proj));
+}
+
+TEST_CASE("Several occluders hide a box none of them covers alone", "[occlusion]")
+{
+    const glm::mat4 view_proj = make_view_proj();
+
+    geometry::occlusion_buffer buffer;
+    rasterize_wall(buffer, view_proj, glm::vec3(-2.0f, 0.0f, 0.0f), 2.0f, 2.0f);
+
+    const geometry::bounding_box box = make_box(glm::vec3(0.0f, 0.0f, -5.0f), 1.0f);
+    REQUIRE_FALSE(buffer.is_occluded(box, view_proj));
+
+    rasterize_wall(buffer, view_proj, glm::vec3(2.0f, 0.0f, 0.0f), 2.0f, 2.0f);
+    REQUIRE(buffer.is_occluded(box, view_proj));
+}
+
+TEST_CASE("Occlusion buffer ignores triangles that miss pixel centers", "[occlusion]")
+{
+    // Identity projection, screen space is [-1, 1] on both axes
+    geometry::occlusion_buffer buffer(16, 16);
+
+    // Covers the lower left corner of the pixel at (8, 8)
+    const std::vector<glm::vec3> positions =
+    {
+        glm::vec3(0.0f, 0.0f, 0.0f),
+        glm::vec3(0.1f, 0.0f, 0.0f),
+        glm::vec3(0.0f, 0.1f, 0.0f)
+    };
+    const std::vector<render::face> faces = { {{ 0, 1, 2 }} };
+
+    buffer.rasterize(positions.data(), faces.data(), faces.size(), glm::mat4(1.0f));
+
+    for (s32 y = 0; y < buffer.height(); ++y)
+    {
+        for (s32 x = 0; x < buffer.width(); ++x)
+        {
+            REQUIRE(buffer.depth(x, y) == 1.0f);
+        }
+    }
+
+    buffer.clear();
+    REQUIRE(buffer.empty());
+}
+
+TEST_CASE("Only the part of a scene behind the occluder is hidden", "[occlusion]")
+{
+    const glm::mat4 view_proj = make_view_proj();
+
+    geometry::occlusion_buffer buffer;
+    rasterize_wall(buffer, view_proj, glm::vec3(0.0f), 6.0f, 6.0f);
+
+    // Row of small boxes far behind the wall, the wall covers x in [-18, 18] at this depth
+    s32 occluded_count = 0;
+    for (s32 i = -20; i <= 20; ++i)
+    {
+        const geometry::bounding_box box = make_box(glm::vec3(i * 2.0f, 0.0f, -20.0f), 0.25f);
+        const bool occluded = buffer.is_occluded(box, view_proj);
+
+        if (std::abs(i * 2.0f) > 18.0f)
+        {
+            REQUIRE_FALSE(occluded);
+        }
+
+        occluded_count += occluded ? 1 : 0;
+    }
+
+    REQUIRE(occluded_count >= 15);
+}
+
+TEST_CASE("Occluders in front of the near plane hide nothing", "[occlusion]")
+{
+    // The near plane of the camera is at z = 9.9
+    const glm::mat4 view_proj = make_view_proj();
+
+    const geometry::bounding_box box = make_box(glm::vec3(0.0f, -4.4f, -12.0f), 0.5f);
+
+    SECTION("between the camera and the near plane")
+    {
+        geometry::occlusion_buffer buffer;
+        rasterize_wall(buffer, view_proj, glm::vec3(0.0f, 0.0f, 9.95f), 1.0f, 1.0f);
+
+        REQUIRE(buffer.empty());
+        REQUIRE_FALSE(buffer.is_occluded(box, view_proj));
+    }
+
+    SECTION("crossing the near plane")
+    {
+        // Tilted towards the camera, the lower edge is in front of the near plane where it covers the box
+        const std::vector<glm::vec3> positions =
+        {
+            glm::vec3(-4.0f, -0.02f, 9.95f),
+            glm::vec3( 4.0f, -0.02f, 9.95f),
+            glm::vec3( 4.0f,  0.02f, 9.0f),
+            glm::vec3(-4.0f,  0.02f, 9.0f)
+        };
+        const std::vector<render::face> faces = { {{ 0, 1, 2 }}, {{ 0, 2, 3 }} };
+
+        geometry::occlusion_buffer buffer;
+        buffer.rasterize(positions.data(), faces.data(), faces.size(), view_proj);
+
+        REQUIRE_FALSE(buffer.is_occluded(box, view_proj));
+    }
+}
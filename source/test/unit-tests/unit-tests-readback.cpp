@@ -0,0 +1,193 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_session.hpp>
+#include "structure.h"
+
+#include "render/render_readback.h"
+
+#include "helpers/mock_library.h"
+
+#include <algorithm>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    ppp::headless();
+
+    return Catch::Session().run(argc, argv);
+}
+
+using namespace ppp;
+
+struct delivered_read
+{
+    s32 width = 0;
+    s32 height = 0;
+    u8 value = 0;
+    bool uniform = false;
+};
+
+static render::readback::readback_callback record_into(std::vector<delivered_read>& reads)
+{
+    return [&reads](const u8* pixels, s32 width, s32 height)
+    {
+        const u64 size = static_cast<u64>(width) * height * 4;
+
+        reads.push_back({ width, height, pixels[0], std::all_of(pixels, pixels + size, [pixels](u8 p) { return p == pixels[0]; }) });
+    };
+}
+
+// One frame of the renderer, the read of this frame sees `value` in the framebuffer
+static void run_frame(u8 value, bool gpu_done = true)
+{
+    render::readback::update();
+
+    mock_library().set_read_pixels_value(value);
+    render::readback::flush();
+
+    if (gpu_done)
+    {
+        mock_library().signal_fences();
+    }
+}
+
+// --------------------------------------------------------------------------
+// Tests for the readback ring
+// --------------------------------------------------------------------------
+TEST_CASE("Reads are delivered two frames after they were requested", "[readback]")
+{
+    mock_library().signal_fences();
+
+    std::vector<delivered_read> reads;
+
+    // Frame 0
+    render::readback::update();
+    const u32 id = render::readback::request(0, 0, 16, 8, record_into(reads));
+    mock_library().set_read_pixels_value(42);
+    render::readback::flush();
+    mock_library().signal_fences();
+
+    REQUIRE(render::readback::is_pending(id));
+
+    // Frame 1, the GPU is done but the read is not handed out yet
+    run_frame(0);
+    REQUIRE(reads.empty());
+
+    // Frame 2
+    run_frame(0);
+    REQUIRE(reads.size() == 1);
+    REQUIRE(reads[0].width == 16);
+    REQUIRE(reads[0].height == 8);
+    REQUIRE(reads[0].value == 42);
+    REQUIRE(reads[0].uniform);
+    REQUIRE_FALSE(render::readback::is_pending(id));
+
+    render::readback::terminate();
+}
+
+TEST_CASE("Reads wait for their fence instead of stalling", "[readback]")
+{
+    mock_library().signal_fences();
+
+    std::vector<delivered_read> reads;
+
+    render::readback::update();
+    render::readback::request(0, 0, 4, 4, record_into(reads));
+    mock_library().set_read_pixels_value(7);
+    render::readback::flush();
+
+    // The GPU is slow, frames keep rendering without the read
+    for (s32 frame = 0; frame < 5; ++frame)
+    {
+        run_frame(0, false);
+    }
+    REQUIRE(reads.empty());
+
+    mock_library().signal_fences();
+    render::readback::update();
+
+    REQUIRE(reads.size() == 1);
+    REQUIRE(reads[0].value == 7);
+
+    render::readback::terminate();
+}
+
+TEST_CASE("A read every frame reuses a ring of pixel buffers", "[readback]")
+{
+    mock_library().signal_fences();
+
+    std::vector<delivered_read> reads;
+
+    for (s32 frame = 0; frame < 20; ++frame)
+    {
+        render::readback::update();
+        render::readback::request(0, 0, 8, 8, record_into(reads));
+
+        mock_library().set_read_pixels_value(static_cast<u8>(frame));
+        render::readback::flush();
+        mock_library().signal_fences();
+    }
+
+    REQUIRE(render::readback::buffer_count() == render::readback::frame_latency);
+
+    // Every frame is delivered once, in order, with its own pixels
+    REQUIRE(reads.size() == 20 - render::readback::frame_latency);
+    for (u64 i = 0; i < reads.size(); ++i)
+    {
+        REQUIRE(reads[i].value == i);
+        REQUIRE(reads[i].uniform);
+    }
+
+    render::readback::terminate();
+}
+
+TEST_CASE("Several reads in a frame are delivered in request order", "[readback]")
+{
+    mock_library().signal_fences();
+
+    std::vector<u32> order;
+
+    render::readback::update();
+    const u32 first = render::readback::request(0, 0, 2, 2, [&order](const u8*, s32, s32) { order.push_back(1); });
+    const u32 second = render::readback::request(0, 0, 64, 32, [&order](const u8*, s32 width, s32) { order.push_back(width == 64 ? 2 : 0); });
+    const u32 empty = render::readback::request(0, 0, 0, 32, [&order](const u8*, s32, s32) { order.push_back(0); });
+    render::readback::flush();
+    mock_library().signal_fences();
+
+    REQUIRE(first != 0);
+    REQUIRE(second != 0);
+    REQUIRE(empty == 0);
+    REQUIRE(render::readback::buffer_count() == 2);
+
+    run_frame(0);
+    run_frame(0);
+
+    REQUIRE(order == std::vector<u32>{ 1, 2 });
+
+    render::readback::terminate();
+}
+
+TEST_CASE("Finishing delivers every read right away", "[readback]")
+{
+    mock_library().signal_fences();
+
+    std::vector<delivered_read> reads;
+
+    render::readback::update();
+    render::readback::request(0, 0, 4, 4, record_into(reads));
+    mock_library().set_read_pixels_value(1);
+    render::readback::flush();
+
+    // Requested but not copied yet
+    render::readback::update();
+    render::readback::request(0, 0, 4, 4, record_into(reads));
+    mock_library().set_read_pixels_value(2);
+
+    render::readback::finish();
+
+    REQUIRE(reads.size() == 2);
+    REQUIRE(reads[0].value == 1);
+    REQUIRE(reads[1].value == 2);
+    REQUIRE(render::readback::buffer_count() == 2);
+
+    render::readback::terminate();
+}
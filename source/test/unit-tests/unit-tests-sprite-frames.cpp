@@ -0,0 +1,86 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include "util/sprite_frames.h"
+#include "render/render_item.h"
+
+using namespace ppp;
+
+static void require_uv(const glm::vec2& actual, const glm::vec2& expected)
+{
+    REQUIRE(actual.x == Catch::Approx(expected.x));
+    REQUIRE(actual.y == Catch::Approx(expected.y));
+}
+
+// --------------------------------------------------------------------------
+// Frames
+// --------------------------------------------------------------------------
+TEST_CASE("Only whole frames are counted", "[sprite_frames]")
+{
+    REQUIRE(sprite_frames::frame_count(128, 64, 32, 32) == 8);
+    REQUIRE(sprite_frames::frame_count(130, 70, 32, 32) == 8);
+    REQUIRE(sprite_frames::frame_count(16, 16, 32, 32) == 0);
+    REQUIRE(sprite_frames::frame_count(128, 64, 0, 32) == 0);
+}
+
+TEST_CASE("Frames are numbered row by row and wrap around", "[sprite_frames]")
+{
+    // 4 columns, 2 rows, the last cell is not used
+    constexpr s32 count = 7;
+
+    const sprite_frames::frame_rect first = sprite_frames::frame(128, 32, 16, count, 0);
+    REQUIRE(first.x == 0);
+    REQUIRE(first.y == 0);
+    REQUIRE(first.width == 32);
+    REQUIRE(first.height == 16);
+
+    const sprite_frames::frame_rect fifth = sprite_frames::frame(128, 32, 16, count, 5);
+    REQUIRE(fifth.x == 32);
+    REQUIRE(fifth.y == 16);
+
+    const sprite_frames::frame_rect wrapped = sprite_frames::frame(128, 32, 16, count, count + 5);
+    REQUIRE(wrapped.x == fifth.x);
+    REQUIRE(wrapped.y == fifth.y);
+
+    const sprite_frames::frame_rect last = sprite_frames::frame(128, 32, 16, count, -1);
+    REQUIRE(last.x == 64);
+    REQUIRE(last.y == 16);
+
+    REQUIRE(sprite_frames::frame(128, 32, 16, 0, 3).width == 0);
+    REQUIRE(sprite_frames::frame(16, 32, 16, count, 3).width == 0);
+}
+
+// --------------------------------------------------------------------------
+// Uvs
+// --------------------------------------------------------------------------
+TEST_CASE("The whole image keeps the uvs of the quad", "[sprite_frames]")
+{
+    const glm::vec4 source = sprite_frames::source_rect(64, 32, 0.0f, 0.0f, 64.0f, 32.0f);
+    const glm::vec4 uv_rect = sprite_frames::uv_rect(glm::vec2(0.0f), glm::vec2(1.0f), source);
+
+    REQUIRE(uv_rect == render::full_uv_rect());
+}
+
+TEST_CASE("A part of an image maps the quad onto that part", "[sprite_frames]")
+{
+    const glm::vec4 source = sprite_frames::source_rect(64, 32, 16.0f, 8.0f, 32.0f, 16.0f);
+    const glm::vec4 uv_rect = sprite_frames::uv_rect(glm::vec2(0.0f), glm::vec2(1.0f), source);
+
+    require_uv(render::transform_uv(uv_rect, glm::vec2(0.0f, 0.0f)), glm::vec2(0.25f, 0.25f));
+    require_uv(render::transform_uv(uv_rect, glm::vec2(1.0f, 1.0f)), glm::vec2(0.75f, 0.75f));
+    require_uv(render::transform_uv(uv_rect, glm::vec2(1.0f, 0.0f)), glm::vec2(0.75f, 0.25f));
+}
+
+TEST_CASE("A part of an image in an atlas stays inside its area of the page", "[sprite_frames]")
+{
+    // The image covers [0.5, 0.75] x [0.25, 0.5] of the page, the quad of the image already has those uvs
+    const glm::vec2 uv_min(0.5f, 0.25f);
+    const glm::vec2 uv_max(0.75f, 0.5f);
+
+    // Right half, bottom half of the image
+    const glm::vec4 source = sprite_frames::source_rect(32, 32, 16.0f, 16.0f, 16.0f, 16.0f);
+    const glm::vec4 uv_rect = sprite_frames::uv_rect(uv_min, uv_max, source);
+
+    require_uv(render::transform_uv(uv_rect, uv_min), glm::vec2(0.625f, 0.375f));
+    require_uv(render::transform_uv(uv_rect, uv_max), uv_max);
+}
@@ -0,0 +1,202 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_session.hpp>
+#include "structure.h"
+
+#include "render/render_batch.h"
+#include "render/render_instance.h"
+#include "render/helpers/render_vertex_layouts.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    ppp::headless();
+
+    return Catch::Session().run(argc, argv);
+}
+
+using namespace ppp;
+
+// Two quads next to each other, the second quad ( faces 2 and 3 ) is the submesh
+class two_quads_item : public render::irender_item
+{
+public:
+    two_quads_item(u32 first_index, u32 index_count)
+        : m_first_index(first_index)
+        , m_index_count(index_count)
+    {
+        for (s32 quad = 0; quad < 2; ++quad)
+        {
+            const f32 x = static_cast<f32>(quad * 2);
+
+            m_positions.push_back(glm::vec3(x, 0.0f, 0.0f));
+            m_positions.push_back(glm::vec3(x + 1.0f, 0.0f, 0.0f));
+            m_positions.push_back(glm::vec3(x + 1.0f, 1.0f, 0.0f));
+            m_positions.push_back(glm::vec3(x, 1.0f, 0.0f));
+
+            const render::index base = static_cast<render::index>(quad * 4);
+            m_faces.push_back({ { base + 0, base + 1, base + 2 } });
+            m_faces.push_back({ { base + 0, base + 2, base + 3 } });
+        }
+
+        m_normals.assign(m_positions.size(), glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+
+    bool has_smooth_normals() const override { return false; }
+    bool has_textures() const override { return false; }
+    bool cast_shadows() const override { return false; }
+
+    u32 vertex_count() const override { return static_cast<u32>(m_positions.size()); }
+    u32 index_count() const override { return m_index_count; }
+
+    const std::vector<glm::vec3>& vertex_positions() const override { return m_positions; }
+    const std::vector<glm::vec3>& vertex_normals() const override { return m_normals; }
+    const std::vector<glm::vec2>& vertex_uvs() const override { return m_uvs; }
+
+    const std::vector<render::face>& faces() const override { return m_faces; }
+
+    const u64 geometry_id() const override { return 42; }
+    const u64 material_id() const override { return 0; }
+
+    const resources::imaterial* material() const override { return nullptr; }
+
+    u32 first_index() const override { return m_first_index; }
+
+private:
+    u32 m_first_index;
+    u32 m_index_count;
+
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::vec3> m_normals;
+    std::vector<glm::vec2> m_uvs;
+    std::vector<render::face> m_faces;
+};
+
+// --------------------------------------------------------------------------
+// Tests for drawing submeshes
+// --------------------------------------------------------------------------
+TEST_CASE("Batches only copy the vertices a submesh references", "[submesh]")
+{
+    const auto& layout = render::pos_norm_col_layout();
+
+    render::batch_drawing_data drawing_data(64, 64, layout.data(), layout.size());
+
+    const two_quads_item submesh(6, 6);
+    drawing_data.append(&submesh, glm::vec4(1.0f), glm::mat4(1.0f));
+
+    const render::batch* batch = drawing_data.first_batch();
+    REQUIRE(batch != nullptr);
+
+    REQUIRE(batch->active_vertex_count() == 4);
+    REQUIRE(batch->active_index_count() == 6);
+
+    // The indices point at the compacted vertices, the first of them is the first vertex of the second quad
+    const render::index* indices = static_cast<const render::index*>(batch->indices());
+    for (u32 i = 0; i < batch->active_index_count(); ++i)
+    {
+        REQUIRE(indices[i] < 4);
+    }
+
+    REQUIRE(static_cast<const glm::vec3*>(batch->vertices())[0] == glm::vec3(2.0f, 0.0f, 0.0f));
+
+    // The whole geometry still copies every vertex
+    const two_quads_item whole(0, 12);
+    drawing_data.append(&whole, glm::vec4(1.0f), glm::mat4(1.0f));
+
+    REQUIRE(batch->active_vertex_count() == 4 + 8);
+    REQUIRE(batch->active_index_count() == 6 + 12);
+
+    drawing_data.release();
+}
+
+TEST_CASE("Submeshes of a geometry share one instance", "[submesh]")
+{
+    const auto& layout = render::pos_norm_layout();
+
+    render::instance_drawing_data drawing_data(layout.data(), static_cast<u32>(layout.size()));
+
+    const two_quads_item first(0, 6);
+    const two_quads_item second(6, 6);
+
+    drawing_data.append(&first, glm::vec4(1.0f), glm::mat4(1.0f));
+    drawing_data.append(&second, glm::vec4(1.0f), glm::mat4(1.0f));
+    drawing_data.append(&second, glm::vec4(1.0f), glm::mat4(1.0f));
+
+    const render::instance* inst = drawing_data.first_instance();
+    REQUIRE(inst != nullptr);
+    REQUIRE(drawing_data.next_instance() == nullptr);
+
+    // The vertices and faces of the geometry are uploaded once, every submesh draws its own range of them
+    REQUIRE(inst->active_vertex_count() == 8);
+    REQUIRE(inst->active_index_count() == 12);
+    REQUIRE(inst->range_count() == 2);
+    REQUIRE(inst->has_data());
+
+    drawing_data.release();
+}
+
+// The whole of both quads drawn from a part of the texture
+class atlas_region_item : public two_quads_item
+{
+public:
+    atlas_region_item(const glm::vec4& uv_rect)
+        : two_quads_item(0, 12)
+        , m_uv_rect(uv_rect)
+    {}
+
+    glm::vec4 uv_rect() const override { return m_uv_rect; }
+
+private:
+    glm::vec4 m_uv_rect;
+};
+
+TEST_CASE("Items drawing other parts of their texture share one instance", "[submesh]")
+{
+    const auto& layout = render::pos_norm_layout();
+
+    render::instance_drawing_data drawing_data(layout.data(), static_cast<u32>(layout.size()));
+
+    const atlas_region_item left(glm::vec4(0.0f, 0.0f, 0.5f, 1.0f));
+    const atlas_region_item right(glm::vec4(0.5f, 0.0f, 0.5f, 1.0f));
+
+    drawing_data.append(&left, glm::vec4(1.0f), glm::mat4(1.0f));
+    drawing_data.append(&right, glm::vec4(1.0f), glm::mat4(1.0f));
+
+    // The uv rect is part of the instance data, the geometry is uploaded once
+    const render::instance* inst = drawing_data.first_instance();
+    REQUIRE(inst != nullptr);
+    REQUIRE(drawing_data.next_instance() == nullptr);
+
+    REQUIRE(inst->active_vertex_count() == 8);
+    REQUIRE(inst->range_count() == 1);
+
+    drawing_data.release();
+}
+
+TEST_CASE("Releasing the instance of a geometry frees its buffers", "[submesh]")
+{
+    const auto& layout = render::pos_norm_layout();
+
+    render::instance_drawing_data drawing_data(layout.data(), static_cast<u32>(layout.size()));
+
+    const two_quads_item whole(0, 12);
+    drawing_data.append(&whole, glm::vec4(1.0f), glm::mat4(1.0f));
+
+    REQUIRE(drawing_data.first_instance() != nullptr);
+
+    // Other geometry ids leave the instance alone
+    drawing_data.release_instance(7);
+    REQUIRE(drawing_data.first_instance() != nullptr);
+
+    drawing_data.release_instance(whole.geometry_id());
+    REQUIRE(drawing_data.first_instance() == nullptr);
+    REQUIRE_FALSE(drawing_data.has_drawing_data());
+
+    // Drawing the geometry again creates a new instance
+    drawing_data.append(&whole, glm::vec4(1.0f), glm::mat4(1.0f));
+    REQUIRE(drawing_data.first_instance() != nullptr);
+    REQUIRE(drawing_data.first_instance()->active_vertex_count() == 8);
+
+    drawing_data.release();
+}
@@ -0,0 +1,210 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_session.hpp>
+#include "structure.h"
+
+#include "resources/texture_atlas.h"
+#include "resources/texture_pool.h"
+
+#include "helpers/mock_library.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    ppp::headless();
+
+    return Catch::Session().run(argc, argv);
+}
+
+using namespace ppp;
+
+static bool overlaps(const texture_atlas::atlas_rect& a, const texture_atlas::atlas_rect& b)
+{
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+static void require_disjoint(const std::vector<texture_atlas::atlas_rect>& rects, s32 width, s32 height)
+{
+    u64 outside = 0;
+    u64 overlapping = 0;
+
+    for (u64 i = 0; i < rects.size(); ++i)
+    {
+        if (rects[i].x < 0 || rects[i].y < 0 || rects[i].x + rects[i].width > width || rects[i].y + rects[i].height > height)
+        {
+            ++outside;
+        }
+
+        for (u64 j = i + 1; j < rects.size(); ++j)
+        {
+            overlapping += overlaps(rects[i], rects[j]) ? 1 : 0;
+        }
+    }
+
+    REQUIRE(outside == 0);
+    REQUIRE(overlapping == 0);
+}
+
+// Images are added with made up ids, only the atlas pages are real textures
+static texture_pool::image make_image(s32 id, s32 width, s32 height, s32 channels, u8 value)
+{
+    texture_pool::image img;
+
+    img.image_id = id;
+    img.width = width;
+    img.height = height;
+    img.channels = channels;
+    img.data = static_cast<u8*>(malloc(width * height * channels));
+
+    memset(img.data, value, width * height * channels);
+
+    return img;
+}
+
+// --------------------------------------------------------------------------
+// Tests for the skyline packer
+// --------------------------------------------------------------------------
+TEST_CASE("Skyline packer places rectangles without overlap", "[texture_atlas]")
+{
+    texture_atlas::skyline_packer packer(256, 256);
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<s32> size(1, 40);
+
+    std::vector<texture_atlas::atlas_rect> rects;
+
+    texture_atlas::atlas_rect rect;
+    while (packer.pack(size(rng), size(rng), rect))
+    {
+        rects.push_back(rect);
+    }
+
+    require_disjoint(rects, 256, 256);
+
+    // Random sizes still fill most of the page before it runs out of room
+    s64 area = 0;
+    for (const auto& r : rects)
+    {
+        area += r.width * r.height;
+    }
+
+    REQUIRE(area > 256 * 256 / 2);
+}
+
+TEST_CASE("Skyline packer fills a page with equal tiles", "[texture_atlas]")
+{
+    texture_atlas::skyline_packer packer(128, 128);
+
+    std::vector<texture_atlas::atlas_rect> rects;
+
+    texture_atlas::atlas_rect rect;
+    while (packer.pack(32, 32, rect))
+    {
+        rects.push_back(rect);
+    }
+
+    REQUIRE(rects.size() == 16);
+    require_disjoint(rects, 128, 128);
+
+    packer.reset();
+
+    REQUIRE(packer.pack(128, 128, rect));
+    REQUIRE_FALSE(packer.pack(1, 1, rect));
+}
+
+// --------------------------------------------------------------------------
+// Tests for the atlas pages
+// --------------------------------------------------------------------------
+TEST_CASE("Small images share atlas pages", "[texture_atlas]")
+{
+    constexpr s32 image_count = 300;
+
+    std::vector<texture_pool::image> images;
+    for (s32 i = 0; i < image_count; ++i)
+    {
+        images.push_back(make_image(1000 + i, 8 + i % 25, 8 + i % 17, 1 + i % 4, static_cast<u8>(i)));
+    }
+
+    mock_library().reset_upload_stats();
+
+    for (const auto& img : images)
+    {
+        REQUIRE(texture_atlas::add_image(img));
+    }
+
+    // One upload per image, the pages are created empty
+    REQUIRE(texture_atlas::page_count() == 1);
+    REQUIRE(mock_library().upload_stats().texture_uploads == image_count);
+
+    std::vector<texture_atlas::atlas_rect> padded_rects;
+    for (const auto& img : images)
+    {
+        const texture_atlas::atlas_entry* entry = texture_atlas::find(img.image_id);
+        REQUIRE(entry != nullptr);
+
+        // Every image is in the first page, the page is addressed by its index and not by an image id
+        REQUIRE(entry->page_index == 0);
+        REQUIRE(entry->page_texture_id != 0);
+
+        REQUIRE(entry->rect.width == img.width);
+        REQUIRE(entry->rect.height == img.height);
+
+        REQUIRE(entry->uv_min.x * texture_atlas::page_size == entry->rect.x);
+        REQUIRE(entry->uv_max.y * texture_atlas::page_size == entry->rect.y + entry->rect.height);
+
+        padded_rects.push_back({ entry->rect.x - texture_atlas::padding, entry->rect.y - texture_atlas::padding, entry->rect.width + 2 * texture_atlas::padding, entry->rect.height + 2 * texture_atlas::padding });
+    }
+
+    require_disjoint(padded_rects, texture_atlas::page_size, texture_atlas::page_size);
+
+    SECTION("large images are not packed")
+    {
+        texture_pool::image large = make_image(1, texture_atlas::max_image_size + 1, 4, 4, 0);
+
+        REQUIRE_FALSE(texture_atlas::add_image(large));
+        REQUIRE(texture_atlas::find(1) == nullptr);
+
+        free(large.data);
+    }
+
+    SECTION("an image that changes size moves within the atlas")
+    {
+        texture_pool::image& img = images[0];
+
+        free(img.data);
+        img = make_image(img.image_id, 64, 64, 4, 0);
+
+        texture_atlas::update_image(img);
+
+        REQUIRE(texture_atlas::find(img.image_id)->rect.width == 64);
+    }
+
+    SECTION("a page is reused once it is empty")
+    {
+        for (const auto& img : images)
+        {
+            texture_atlas::remove_image(img.image_id);
+        }
+
+        REQUIRE(texture_atlas::find(images[0].image_id) == nullptr);
+
+        texture_pool::image full = make_image(1, texture_atlas::max_image_size, texture_atlas::max_image_size, 4, 0);
+
+        REQUIRE(texture_atlas::add_image(full));
+        REQUIRE(texture_atlas::find(1)->rect.x == texture_atlas::padding);
+        REQUIRE(texture_atlas::find(1)->rect.y == texture_atlas::padding);
+        REQUIRE(texture_atlas::page_count() == 1);
+
+        free(full.data);
+    }
+
+    for (auto& img : images)
+    {
+        free(img.data);
+    }
+
+    texture_atlas::terminate();
+}
@@ -0,0 +1,335 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "resources/texture_compression.h"
+#include "resources/texture_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace ppp;
+
+static const render::image_compression_type all_compressions[] =
+{
+    render::image_compression_type::BC1,
+    render::image_compression_type::BC3,
+    render::image_compression_type::BC5,
+    render::image_compression_type::BC7
+};
+
+// Smooth gradients with a few hard edges, the size is not a multiple of the block size on purpose
+static texture_compression::rgba_image make_test_image(s32 width = 37, s32 height = 21)
+{
+    texture_compression::rgba_image image;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(static_cast<u64>(width) * height * 4);
+
+    for (s32 y = 0; y < height; ++y)
+    {
+        for (s32 x = 0; x < width; ++x)
+        {
+            u8* texel = &image.pixels[(static_cast<u64>(y) * width + x) * 4];
+
+            texel[0] = static_cast<u8>(x * 255 / (width - 1));
+            texel[1] = static_cast<u8>(y * 255 / (height - 1));
+            texel[2] = static_cast<u8>(((x / 8) + (y / 8)) % 2 == 0 ? 40 : 200);
+            texel[3] = static_cast<u8>(255 - (x + y) * 255 / (width + height - 2));
+        }
+    }
+
+    return image;
+}
+
+// Peak signal to noise ratio over the first `channels` channels
+static f64 psnr(const texture_compression::rgba_image& a, const texture_compression::rgba_image& b, s32 channels)
+{
+    f64 error = 0.0;
+    u64 count = 0;
+
+    for (u64 i = 0; i < a.pixels.size(); i += 4)
+    {
+        for (s32 c = 0; c < channels; ++c)
+        {
+            const f64 d = static_cast<f64>(a.pixels[i + c]) - static_cast<f64>(b.pixels[i + c]);
+            error += d * d;
+            ++count;
+        }
+    }
+
+    if (error == 0.0)
+    {
+        return std::numeric_limits<f64>::infinity();
+    }
+
+    return 10.0 * std::log10(255.0 * 255.0 / (error / count));
+}
+
+static std::string cache_file(std::string_view name)
+{
+    return (std::filesystem::temp_directory_path() / name).string() + ".ktx2";
+}
+
+// --------------------------------------------------------------------------
+// Tests for the block encoders
+// --------------------------------------------------------------------------
+TEST_CASE("Compressed images decode within the quality bound of their format", "[texture_compression]")
+{
+    const texture_compression::rgba_image image = make_test_image();
+
+    struct expectation
+    {
+        render::image_compression_type compression;
+        s32 channels;
+        f64 min_psnr;
+    };
+
+    const expectation expectations[] =
+    {
+        { render::image_compression_type::BC1, 3, 30.0 },
+        { render::image_compression_type::BC3, 4, 30.0 },
+        { render::image_compression_type::BC5, 2, 40.0 },
+        { render::image_compression_type::BC7, 4, 34.0 }
+    };
+
+    for (const expectation& e : expectations)
+    {
+        const std::vector<u8> data = texture_compression::encode(image, e.compression);
+
+        // 10x6 blocks
+        REQUIRE(data.size() == 60 * texture_compression::block_size(e.compression));
+        REQUIRE(data.size() == texture_compression::compressed_size(e.compression, image.width, image.height));
+
+        const texture_compression::rgba_image decoded = texture_compression::decode(data.data(), image.width, image.height, e.compression);
+
+        REQUIRE(decoded.width == image.width);
+        REQUIRE(decoded.height == image.height);
+        REQUIRE(psnr(image, decoded, e.channels) > e.min_psnr);
+    }
+}
+
+TEST_CASE("Compression does not depend on the thread count", "[texture_compression]")
+{
+    const texture_compression::rgba_image image = make_test_image(131, 67);
+
+    for (render::image_compression_type compression : all_compressions)
+    {
+        REQUIRE(texture_compression::encode(image, compression, 1) == texture_compression::encode(image, compression, 4));
+    }
+}
+
+TEST_CASE("Uniform images survive compression", "[texture_compression]")
+{
+    texture_compression::rgba_image image;
+    image.width = 8;
+    image.height = 8;
+    image.pixels.assign(8 * 8 * 4, 0);
+
+    for (u64 i = 0; i < image.pixels.size(); i += 4)
+    {
+        image.pixels[i + 0] = 200;
+        image.pixels[i + 1] = 100;
+        image.pixels[i + 2] = 0;
+        image.pixels[i + 3] = 255;
+    }
+
+    const auto bc5 = texture_compression::encode(image, render::image_compression_type::BC5);
+    REQUIRE(psnr(image, texture_compression::decode(bc5.data(), 8, 8, render::image_compression_type::BC5), 2) == std::numeric_limits<f64>::infinity());
+
+    // BC7 end points share a p-bit across channels, mixed parities can be off by one
+    const auto bc7 = texture_compression::encode(image, render::image_compression_type::BC7);
+    const auto bc7_decoded = texture_compression::decode(bc7.data(), 8, 8, render::image_compression_type::BC7);
+    for (u64 i = 0; i < image.pixels.size(); ++i)
+    {
+        REQUIRE(std::abs(static_cast<s32>(image.pixels[i]) - static_cast<s32>(bc7_decoded.pixels[i])) <= 1);
+    }
+
+    // BC1 end points are stored as 5:6:5
+    const auto bc1 = texture_compression::encode(image, render::image_compression_type::BC1);
+    REQUIRE(psnr(image, texture_compression::decode(bc1.data(), 8, 8, render::image_compression_type::BC1), 3) > 40.0);
+}
+
+TEST_CASE("Channels that are missing from an image are filled like the GPU samples them", "[texture_compression]")
+{
+    const u8 pixels[] = { 10, 20, 30, 40 };
+
+    const texture_compression::rgba_image single = texture_compression::to_rgba(pixels, 4, 1, 1);
+    REQUIRE(single.pixels == std::vector<u8>{ 10, 0, 0, 255, 20, 0, 0, 255, 30, 0, 0, 255, 40, 0, 0, 255 });
+
+    const texture_compression::rgba_image dual = texture_compression::to_rgba(pixels, 2, 1, 2);
+    REQUIRE(dual.pixels == std::vector<u8>{ 10, 20, 0, 255, 30, 40, 0, 255 });
+}
+
+// --------------------------------------------------------------------------
+// Tests for mip generation
+// --------------------------------------------------------------------------
+TEST_CASE("Mip chains halve down to a single texel", "[texture_compression]")
+{
+    const texture_compression::rgba_image image = make_test_image();
+
+    for (auto filter : { texture_compression::mip_filter_type::BOX, texture_compression::mip_filter_type::KAISER })
+    {
+        const auto levels = texture_compression::generate_mips(image, filter);
+
+        const s32 expected[][2] = { { 37, 21 }, { 18, 10 }, { 9, 5 }, { 4, 2 }, { 2, 1 }, { 1, 1 } };
+
+        REQUIRE(levels.size() == 6);
+        for (u64 i = 0; i < levels.size(); ++i)
+        {
+            REQUIRE(levels[i].width == expected[i][0]);
+            REQUIRE(levels[i].height == expected[i][1]);
+            REQUIRE(levels[i].pixels.size() == static_cast<u64>(expected[i][0]) * expected[i][1] * 4);
+        }
+
+        REQUIRE(levels[0].pixels == image.pixels);
+    }
+}
+
+TEST_CASE("Mip filters keep uniform images and average colors", "[texture_compression]")
+{
+    texture_compression::rgba_image uniform;
+    uniform.width = 16;
+    uniform.height = 16;
+    uniform.pixels.assign(16 * 16 * 4, 77);
+
+    // Alternating black and white columns
+    texture_compression::rgba_image stripes;
+    stripes.width = 16;
+    stripes.height = 16;
+    stripes.pixels.resize(16 * 16 * 4);
+    for (u64 i = 0; i < 16 * 16; ++i)
+    {
+        const u8 value = (i % 2) == 0 ? 0 : 255;
+        std::fill(&stripes.pixels[i * 4], &stripes.pixels[i * 4] + 4, value);
+    }
+
+    for (auto filter : { texture_compression::mip_filter_type::BOX, texture_compression::mip_filter_type::KAISER })
+    {
+        for (const auto& level : texture_compression::generate_mips(uniform, filter))
+        {
+            REQUIRE(std::all_of(level.pixels.begin(), level.pixels.end(), [](u8 v) { return v == 77; }));
+        }
+
+        // Edge texels are clamped, the filter is only symmetric away from the edges
+        const auto levels = texture_compression::generate_mips(stripes, filter);
+        for (s32 y = 0; y < levels[1].height; ++y)
+        {
+            for (s32 x = 2; x < levels[1].width - 2; ++x)
+            {
+                REQUIRE(std::abs(static_cast<s32>(levels[1].pixels[(y * levels[1].width + x) * 4]) - 128) <= 2);
+            }
+        }
+    }
+}
+
+TEST_CASE("Compressed textures contain every mip level", "[texture_compression]")
+{
+    const texture_compression::rgba_image image = make_test_image(64, 32);
+
+    const auto texture = texture_compression::compress(image, render::image_compression_type::BC1, texture_compression::mip_filter_type::BOX);
+
+    REQUIRE(texture.width == 64);
+    REQUIRE(texture.height == 32);
+    REQUIRE(texture.levels.size() == 7);
+
+    // 64x32, 32x16, 16x8, 8x4, 4x2, 2x1 and 1x1 texels
+    const u64 expected_blocks[] = { 128, 32, 8, 2, 1, 1, 1 };
+    for (u64 i = 0; i < texture.levels.size(); ++i)
+    {
+        REQUIRE(texture.levels[i].size() == expected_blocks[i] * 8);
+    }
+
+    // Half the size of an RGB8 texture, a quarter of RGBA8
+    REQUIRE(texture.levels[0].size() * 8 == image.pixels.size());
+}
+
+// --------------------------------------------------------------------------
+// Tests for the KTX2 cache
+// --------------------------------------------------------------------------
+TEST_CASE("Texture cache round trips cooked textures", "[texture_compression]")
+{
+    const texture_compression::rgba_image image = make_test_image();
+    const auto filter = texture_compression::mip_filter_type::KAISER;
+
+    const fileio::file_stamp stamp = { 1234, 42 };
+    const u64 source_hash = 0xfeedull;
+
+    for (render::image_compression_type compression : all_compressions)
+    {
+        const std::string path = cache_file("ppp_texture_cache_" + std::to_string(static_cast<s32>(compression)));
+
+        const auto texture = texture_compression::compress(image, compression, filter);
+        REQUIRE(texture_cache::write(path, texture, filter, stamp, source_hash));
+
+        std::ifstream file(path, std::ios::binary);
+        char identifier[12] = {};
+        file.read(identifier, sizeof(identifier));
+        REQUIRE(std::string(identifier + 1, 6) == "KTX 20");
+
+        texture_compression::compressed_texture loaded;
+        u64 loaded_hash = 0;
+        REQUIRE(texture_cache::read(path, compression, filter, stamp, nullptr, &loaded, &loaded_hash));
+
+        REQUIRE(loaded.compression == compression);
+        REQUIRE(loaded.width == texture.width);
+        REQUIRE(loaded.height == texture.height);
+        REQUIRE(loaded.levels == texture.levels);
+        REQUIRE(loaded_hash == source_hash);
+    }
+}
+
+TEST_CASE("Texture cache detects stale and mismatching files", "[texture_compression]")
+{
+    const texture_compression::rgba_image image = make_test_image();
+    const auto compression = render::image_compression_type::BC3;
+    const auto filter = texture_compression::mip_filter_type::BOX;
+
+    const fileio::file_stamp stamp = { 1234, 42 };
+    const u64 source_hash = 0xfeedull;
+
+    const std::string path = cache_file("ppp_texture_cache_stale");
+    REQUIRE(texture_cache::write(path, texture_compression::compress(image, compression, filter), filter, stamp, source_hash));
+
+    texture_compression::compressed_texture loaded;
+
+    SECTION("a different source size is stale")
+    {
+        REQUIRE_FALSE(texture_cache::read(path, compression, filter, { 1235, 42 }, nullptr, &loaded));
+    }
+
+    SECTION("a different write time is only stale when the contents changed")
+    {
+        s32 hash_calls = 0;
+
+        REQUIRE_FALSE(texture_cache::read(path, compression, filter, { 1234, 43 }, [&hash_calls]() { ++hash_calls; return 0xbeefull; }, &loaded));
+        REQUIRE(texture_cache::read(path, compression, filter, { 1234, 43 }, [&hash_calls]() { ++hash_calls; return 0xfeedull; }, &loaded));
+        REQUIRE(hash_calls == 2);
+
+        // The new write time is stored, the source is not hashed again
+        REQUIRE(texture_cache::read(path, compression, filter, { 1234, 43 }, [&hash_calls]() { ++hash_calls; return 0xfeedull; }, &loaded));
+        REQUIRE(hash_calls == 2);
+    }
+
+    SECTION("a different compression or mip filter is a miss")
+    {
+        REQUIRE_FALSE(texture_cache::read(path, render::image_compression_type::BC7, filter, stamp, nullptr, &loaded));
+        REQUIRE_FALSE(texture_cache::read(path, compression, texture_compression::mip_filter_type::KAISER, stamp, nullptr, &loaded));
+    }
+
+    SECTION("a truncated file is rejected")
+    {
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+
+        REQUIRE_FALSE(texture_cache::read(path, compression, filter, stamp, nullptr, &loaded));
+    }
+
+    SECTION("every compression has its own cache file")
+    {
+        REQUIRE(texture_cache::cache_path("image.png", render::image_compression_type::BC1) == "image.png.bc1.ktx2");
+        REQUIRE(texture_cache::cache_path("image.png", render::image_compression_type::BC7) == "image.png.bc7.ktx2");
+    }
+}
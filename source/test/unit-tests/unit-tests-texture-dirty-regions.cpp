@@ -0,0 +1,201 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_session.hpp>
+#include "structure.h"
+
+#include "resources/texture_dirty_regions.h"
+#include "resources/texture_pool.h"
+
+#include "helpers/mock_library.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    ppp::headless();
+
+    return Catch::Session().run(argc, argv);
+}
+
+using namespace ppp;
+
+static bool same_region(const texture_dirty_regions::region& r, s32 x, s32 y, s32 width, s32 height)
+{
+    return r.x == x && r.y == y && r.width == width && r.height == height;
+}
+
+// --------------------------------------------------------------------------
+// Tests for merging dirty regions
+// --------------------------------------------------------------------------
+TEST_CASE("Dirty regions cover the written tiles", "[texture_dirty_regions]")
+{
+    constexpr s32 width = 256;
+    constexpr s32 height = 256;
+
+    std::vector<texture_dirty_regions::region> written;
+
+    SECTION("nothing written has no regions")
+    {
+        REQUIRE(texture_dirty_regions::merge(written, width, height).empty());
+    }
+
+    SECTION("a single pixel dirties its tile")
+    {
+        written.push_back({ 70, 40, 1, 1 });
+
+        const auto regions = texture_dirty_regions::merge(written, width, height);
+
+        REQUIRE(regions.size() == 1);
+        REQUIRE(same_region(regions[0], 64, 32, 32, 32));
+    }
+
+    SECTION("an area crossing tile borders dirties every tile it touches")
+    {
+        written.push_back({ 30, 30, 4, 4 });
+
+        const auto regions = texture_dirty_regions::merge(written, width, height);
+
+        REQUIRE(regions.size() == 1);
+        REQUIRE(same_region(regions[0], 0, 0, 64, 64));
+    }
+
+    SECTION("neighbouring tiles in a row are merged")
+    {
+        written.push_back({ 0, 0, 1, 1 });
+        written.push_back({ 40, 10, 1, 1 });
+        written.push_back({ 200, 0, 1, 1 });
+
+        const auto regions = texture_dirty_regions::merge(written, width, height);
+
+        REQUIRE(regions.size() == 2);
+        REQUIRE(same_region(regions[0], 0, 0, 64, 32));
+        REQUIRE(same_region(regions[1], 192, 0, 32, 32));
+    }
+
+    SECTION("tiles with the same span are merged across rows")
+    {
+        for (s32 y = 0; y < 96; y += 8)
+        {
+            written.push_back({ 100, y, 1, 1 });
+        }
+
+        const auto regions = texture_dirty_regions::merge(written, width, height);
+
+        REQUIRE(regions.size() == 1);
+        REQUIRE(same_region(regions[0], 96, 0, 32, 96));
+    }
+
+    SECTION("most of the image written is a single upload")
+    {
+        written.push_back({ 0, 0, width, 224 });
+
+        const auto regions = texture_dirty_regions::merge(written, width, height);
+
+        REQUIRE(regions.size() == 1);
+        REQUIRE(same_region(regions[0], 0, 0, width, height));
+    }
+}
+
+TEST_CASE("Dirty regions are clipped to the image", "[texture_dirty_regions]")
+{
+    constexpr s32 width = 100;
+    constexpr s32 height = 70;
+
+    const std::vector<texture_dirty_regions::region> written = { { 99, 69, 10, 10 }, { -20, -20, 5, 5 } };
+
+    const auto regions = texture_dirty_regions::merge(written, width, height);
+
+    REQUIRE(regions.size() == 1);
+    REQUIRE(same_region(regions[0], 96, 64, 4, 6));
+}
+
+// --------------------------------------------------------------------------
+// Tests for uploading pixels
+// --------------------------------------------------------------------------
+TEST_CASE("Updating pixels only uploads the recorded tiles", "[texture_dirty_regions]")
+{
+    constexpr s32 width = 1024;
+    constexpr s32 height = 1024;
+    constexpr s32 channels = 4;
+    constexpr u64 size = static_cast<u64>(width) * height * channels;
+
+    texture_pool::image img;
+    img.texture_id = 3;
+    img.width = width;
+    img.height = height;
+    img.channels = channels;
+    img.data = static_cast<u8*>(malloc(size));
+    memset(img.data, 0, size);
+
+    const s32 id = texture_pool::add_new_image(img);
+
+    u8* pixels = texture_pool::load_active_pixels(id);
+    REQUIRE(pixels != nullptr);
+
+    mock_library().reset_upload_stats();
+
+    SECTION("pixels without recorded regions upload the whole image")
+    {
+        memset(pixels, 128, size);
+
+        texture_pool::update_active_pixels(id);
+
+        REQUIRE(mock_library().upload_stats().texture_uploads == 1);
+        REQUIRE(mock_library().upload_stats().texture_bytes == size);
+        REQUIRE(memcmp(texture_pool::image_at_id(id)->data, pixels, size) == 0);
+    }
+
+    SECTION("a few recorded pixels upload a single tile")
+    {
+        pixels[(500 * width + 500) * channels + 0] = 255;
+        pixels[(501 * width + 501) * channels + 1] = 255;
+        pixels[(510 * width + 505) * channels + 2] = 255;
+
+        texture_pool::mark_active_pixels_dirty(500, 500, 1, 1);
+        texture_pool::mark_active_pixels_dirty(501, 501, 1, 1);
+        texture_pool::mark_active_pixels_dirty(505, 510, 1, 1);
+
+        texture_pool::update_active_pixels(id);
+
+        REQUIRE(mock_library().upload_stats().texture_uploads == 1);
+        REQUIRE(mock_library().upload_stats().texture_bytes == 32 * 32 * channels);
+
+        // The image keeps the edited pixels
+        REQUIRE(memcmp(texture_pool::image_at_id(id)->data, pixels, size) == 0);
+    }
+
+    SECTION("recorded regions are forgotten after the update")
+    {
+        texture_pool::mark_active_pixels_dirty(0, 0, 1, 1);
+        texture_pool::update_active_pixels(id);
+
+        texture_pool::update_active_pixels(id);
+
+        REQUIRE(mock_library().upload_stats().texture_uploads == 2);
+        REQUIRE(mock_library().upload_stats().texture_bytes == 32 * 32 * channels + size);
+    }
+
+    SECTION("loading pixels again forgets the recorded regions")
+    {
+        texture_pool::mark_active_pixels_dirty(0, 0, 1, 1);
+
+        pixels = texture_pool::load_active_pixels(id);
+        texture_pool::update_active_pixels(id);
+
+        REQUIRE(mock_library().upload_stats().texture_bytes == size);
+    }
+
+    SECTION("an explicit region is uploaded as is and clipped to the image")
+    {
+        pixels[(1000 * width + 1000) * channels] = 255;
+
+        texture_pool::update_active_pixels(id, 990, 995, 100, 100);
+
+        REQUIRE(mock_library().upload_stats().texture_uploads == 1);
+        REQUIRE(mock_library().upload_stats().texture_bytes == 34 * 29 * channels);
+        REQUIRE(texture_pool::image_at_id(id)->data[(1000 * width + 1000) * channels] == 255);
+    }
+
+    texture_pool::remove_image(id);
+}
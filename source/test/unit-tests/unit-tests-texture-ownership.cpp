@@ -0,0 +1,146 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_session.hpp>
+#include "structure.h"
+
+#include "resources/texture_pool.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    ppp::headless();
+
+    return Catch::Session().run(argc, argv);
+}
+
+using namespace ppp;
+
+static texture_pool::image make_image(u32 texture_id, s32 width, s32 height, u8* data, texture_pool::pixel_ownership ownership)
+{
+    texture_pool::image img;
+
+    img.texture_id = texture_id;
+    img.width = width;
+    img.height = height;
+    img.channels = 4;
+    img.data = data;
+    img.ownership = ownership;
+
+    return img;
+}
+
+// --------------------------------------------------------------------------
+// Tests for pixel ownership in the texture pool
+// --------------------------------------------------------------------------
+TEST_CASE("Adopted pixels are used without a copy and released through their deleter", "[texture_pool]")
+{
+    constexpr u32 texture_id = 5;
+    constexpr s32 width = 64;
+    constexpr s32 height = 32;
+
+    u8* pixels = new u8[width * height * 4];
+    memset(pixels, 7, width * height * 4);
+
+    s32 deleted = 0;
+
+    const texture_pool::pixel_memory before = texture_pool::pixel_memory_usage();
+
+    texture_pool::image img = make_image(texture_id, width, height, pixels, texture_pool::pixel_ownership::ADOPTED);
+    img.deleter = [&deleted](u8* data) { ++deleted; delete[] data; };
+
+    const s32 id = texture_pool::add_new_image(img);
+
+    // The pool points at the caller's memory, nothing was allocated by the engine
+    REQUIRE(texture_pool::image_at_id(id)->data == pixels);
+    REQUIRE(texture_pool::image_at_id(id)->ownership == texture_pool::pixel_ownership::ADOPTED);
+
+    const texture_pool::pixel_memory during = texture_pool::pixel_memory_usage();
+    REQUIRE(during.owned == before.owned);
+    REQUIRE(during.adopted == before.adopted + width * height * 4);
+
+    REQUIRE(deleted == 0);
+
+    texture_pool::remove_image(id);
+
+    REQUIRE(deleted == 1);
+    REQUIRE(texture_pool::pixel_memory_usage().adopted == before.adopted);
+
+    // Removing again does not release twice
+    texture_pool::remove_image(id);
+    REQUIRE(deleted == 1);
+}
+
+TEST_CASE("Borrowed pixels are never released by the pool", "[texture_pool]")
+{
+    constexpr u32 texture_id = 6;
+    constexpr s32 width = 16;
+    constexpr s32 height = 16;
+
+    std::vector<u8> pixels(width * height * 4, 42);
+
+    const s32 id = texture_pool::add_new_image(make_image(texture_id, width, height, pixels.data(), texture_pool::pixel_ownership::BORROWED));
+
+    REQUIRE(texture_pool::image_at_id(id)->data == pixels.data());
+    REQUIRE(texture_pool::pixel_memory_usage().borrowed == width * height * 4);
+
+    // Edits of the image go straight to the caller's memory
+    u8* active = texture_pool::load_active_pixels(id);
+    REQUIRE(active != nullptr);
+    REQUIRE(active != pixels.data());
+    active[0] = 1;
+
+    texture_pool::update_active_pixels(id, 0, 0, 1, 1);
+    REQUIRE(pixels[0] == 1);
+
+    texture_pool::remove_image(id);
+
+    REQUIRE(texture_pool::pixel_memory_usage().borrowed == 0);
+    REQUIRE(pixels[1] == 42);
+}
+
+TEST_CASE("Replacing an image releases the previous pixels by their ownership", "[texture_pool]")
+{
+    constexpr u32 texture_id = 7;
+    constexpr s32 width = 8;
+    constexpr s32 height = 8;
+
+    s32 deleted = 0;
+
+    texture_pool::image adopted = make_image(texture_id, width, height, new u8[width * height * 4], texture_pool::pixel_ownership::ADOPTED);
+    adopted.deleter = [&deleted](u8* data) { ++deleted; delete[] data; };
+
+    const s32 id = texture_pool::add_new_image(adopted);
+
+    u8* owned = static_cast<u8*>(calloc(width * height * 4, 1));
+    texture_pool::image replacement = make_image(texture_id, width, height, owned, texture_pool::pixel_ownership::OWNED);
+    replacement.image_id = id;
+
+    REQUIRE(texture_pool::add_new_image(replacement) == id);
+
+    REQUIRE(deleted == 1);
+    REQUIRE(texture_pool::image_at_id(id)->data == owned);
+    REQUIRE(texture_pool::pixel_memory_usage().adopted == 0);
+
+    texture_pool::remove_image(id);
+}
+
+TEST_CASE("Releasing pixels resets the ownership", "[texture_pool]")
+{
+    s32 deleted = 0;
+
+    texture_pool::image img = make_image(0, 4, 4, new u8[4 * 4 * 4], texture_pool::pixel_ownership::ADOPTED);
+    img.deleter = [&deleted](u8* data) { ++deleted; delete[] data; };
+
+    texture_pool::release_pixels(img);
+
+    REQUIRE(deleted == 1);
+    REQUIRE(img.data == nullptr);
+    REQUIRE(img.ownership == texture_pool::pixel_ownership::OWNED);
+    REQUIRE_FALSE(img.deleter);
+
+    // Nothing is left to release
+    texture_pool::release_pixels(img);
+    REQUIRE(deleted == 1);
+}
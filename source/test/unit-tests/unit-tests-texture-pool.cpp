@@ -0,0 +1,182 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "resources/texture_pool.h"
+
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace ppp;
+
+// Images are added with made up texture names, the pool itself never talks to the renderer
+static texture_pool::image make_image(u32 texture_id, std::string_view path = {})
+{
+    texture_pool::image img;
+
+    img.texture_id = texture_id;
+    img.width = 1;
+    img.height = 1;
+    img.channels = 4;
+    img.data = static_cast<u8*>(malloc(4));
+
+    if (!path.empty())
+    {
+        img.file_path = string::store_sid(path);
+    }
+
+    return img;
+}
+
+TEST_CASE("Texture pool finds images by id and path", "[texture_pool]")
+{
+    const s32 a = texture_pool::add_new_image(make_image(3, "images/a.png"));
+    const s32 b = texture_pool::add_new_image(make_image(7));
+    const s32 c = texture_pool::add_new_image(make_image(8));
+
+    REQUIRE(a != b);
+    REQUIRE(b != c);
+
+    REQUIRE(texture_pool::has_image(a));
+    REQUIRE(texture_pool::has_image(b));
+    REQUIRE(texture_pool::has_image(c));
+    REQUIRE_FALSE(texture_pool::has_image(0));
+    REQUIRE_FALSE(texture_pool::has_image(-1));
+    REQUIRE_FALSE(texture_pool::has_image(1000));
+
+    REQUIRE(texture_pool::image_at_id(a)->image_id == a);
+    REQUIRE(texture_pool::image_at_id(a)->texture_id == 3);
+    // Images without a path are kept apart from each other
+    REQUIRE(texture_pool::image_at_id(b)->texture_id == 7);
+    REQUIRE(texture_pool::image_at_id(c)->texture_id == 8);
+    REQUIRE(texture_pool::image_at_id(1000) == nullptr);
+
+    REQUIRE(texture_pool::has_image(string::store_sid("images/a.png")));
+    REQUIRE(texture_pool::image_at_path(string::store_sid("images/a.png"))->image_id == a);
+    REQUIRE(texture_pool::image_at_path(string::store_sid("images/b.png")) == nullptr);
+
+    texture_pool::terminate();
+}
+
+TEST_CASE("Texture pool reuses released slots with a new generation", "[texture_pool]")
+{
+    const s32 first = texture_pool::add_new_image(make_image(5, "images/a.png"));
+
+    const u32 first_generation = texture_pool::image_generation(first);
+    REQUIRE(first_generation != 0);
+
+    texture_pool::remove_image(first);
+
+    REQUIRE_FALSE(texture_pool::has_image(first));
+    REQUIRE_FALSE(texture_pool::has_image(string::store_sid("images/a.png")));
+    REQUIRE(texture_pool::image_generation(first) != first_generation);
+
+    // The slot is handed out again, the id of the removed image does not resolve to the new one
+    const s32 second = texture_pool::add_new_image(make_image(5, "images/b.png"));
+
+    REQUIRE(second != first);
+    REQUIRE(texture_pool::all_images().size() == 1);
+    REQUIRE(texture_pool::has_image(second));
+    REQUIRE_FALSE(texture_pool::has_image(first));
+    REQUIRE(texture_pool::image_at_id(first) == nullptr);
+    REQUIRE(texture_pool::image_at_path(string::store_sid("images/b.png"))->image_id == second);
+
+    // Removing through the old id leaves the new image alone
+    texture_pool::remove_image(first);
+    REQUIRE(texture_pool::has_image(second));
+
+    // Unknown ids have no generation and are ignored
+    REQUIRE(texture_pool::image_generation(500) == 0);
+    texture_pool::remove_image(500);
+
+    texture_pool::terminate();
+}
+
+TEST_CASE("Texture pool slots do not depend on the texture name", "[texture_pool]")
+{
+    // Drivers are free to hand out large texture names, the pool only grows with the number of images
+    const s32 id = texture_pool::add_new_image(make_image(0x7FFFFFF0u));
+
+    REQUIRE(texture_pool::all_images().size() == 1);
+    REQUIRE(texture_pool::image_at_id(id)->texture_id == 0x7FFFFFF0u);
+
+    texture_pool::terminate();
+}
+
+TEST_CASE("Texture pool replaces an image that is added with its own id", "[texture_pool]")
+{
+    const s32 id = texture_pool::add_new_image(make_image(2, "images/a.png"));
+
+    texture_pool::image replacement = make_image(4, "images/a.png");
+    replacement.image_id = id;
+
+    REQUIRE(texture_pool::add_new_image(replacement) == id);
+    REQUIRE(texture_pool::all_images().size() == 1);
+    REQUIRE(texture_pool::image_at_id(id)->texture_id == 4);
+    REQUIRE(texture_pool::image_at_path(string::store_sid("images/a.png"))->image_id == id);
+
+    texture_pool::terminate();
+}
+
+// --------------------------------------------------------------------------
+// Benchmark, run with the "[!benchmark]" tag
+// --------------------------------------------------------------------------
+TEST_CASE("Drawing 10k images a frame from a pool of 5k while images are loaded and unloaded", "[!benchmark][texture_pool]")
+{
+    constexpr s32 pool_size = 5000;
+    constexpr s32 draw_count = 10000;
+    constexpr s32 churn_count = 50;
+
+    std::vector<s32> ids(pool_size);
+    for (s32 i = 0; i < pool_size; ++i)
+    {
+        ids[i] = texture_pool::add_new_image(make_image(static_cast<u32>(i + 1), "images/" + std::to_string(i) + ".png"));
+    }
+
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<s32> pick(0, pool_size - 1);
+
+    std::vector<s32> draws(draw_count);
+    for (s32& draw : draws)
+    {
+        draw = pick(generator);
+    }
+
+    std::vector<s32> churn(churn_count);
+    for (s32& index : churn)
+    {
+        index = pick(generator);
+    }
+
+    // Every frame a few images are unloaded and loaded again before the draws resolve their ids to texture names,
+    // the same work `draw_image` does through the residency and the texture cache
+    BENCHMARK("frame")
+    {
+        for (s32 index : churn)
+        {
+            texture_pool::remove_image(ids[index]);
+            ids[index] = texture_pool::add_new_image(make_image(static_cast<u32>(index + 1)));
+        }
+
+        u64 bound = 0;
+        for (s32 index : draws)
+        {
+            const s32 id = ids[index];
+
+            texture_pool::mark_used(id);
+
+            const texture_pool::image* img = texture_pool::image_at_id(id);
+            if (img != nullptr)
+            {
+                bound += img->texture_id;
+            }
+        }
+
+        texture_pool::next_frame();
+
+        return bound;
+    };
+
+    texture_pool::terminate();
+}
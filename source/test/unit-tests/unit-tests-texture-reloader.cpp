@@ -0,0 +1,143 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_session.hpp>
+#include "structure.h"
+
+#include "resources/texture_pool.h"
+#include "resources/texture_reloader.h"
+#include "resources/image_decoder.h"
+
+#include "helpers/mock_library.h"
+
+#include "fileio/vfs.h"
+
+#include <stb/stb_image_write.h>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    ppp::headless();
+
+    return Catch::Session().run(argc, argv);
+}
+
+using namespace ppp;
+
+static constexpr s32 image_count = 4;
+
+static std::filesystem::path image_directory()
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "ppp_texture_reloader";
+    std::filesystem::create_directories(directory);
+
+    vfs::add_wildcard(string::store_sid("reload:"), directory.generic_string());
+
+    return directory;
+}
+
+static std::string image_filename(s32 index)
+{
+    return "image_" + std::to_string(index) + ".png";
+}
+
+// Writes a 4x4 RGBA image filled with `value`
+static void write_png(s32 index, u8 value)
+{
+    std::vector<u8> pixels(4 * 4 * 4, value);
+
+    const std::string path = (image_directory() / image_filename(index)).string();
+
+    REQUIRE(stbi_write_png(path.c_str(), 4, 4, 4, pixels.data(), 4 * 4) != 0);
+}
+
+// Moves the write time of a file forward, file systems do not always record a change within the same second
+static void touch(s32 index)
+{
+    const std::filesystem::path path = image_directory() / image_filename(index);
+
+    std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::hours(1));
+}
+
+// Decodes every image and adds it to the pool with a made up texture id
+static std::vector<s32> load_images()
+{
+    std::vector<s32> ids;
+    for (s32 i = 0; i < image_count; ++i)
+    {
+        write_png(i, static_cast<u8>(i * 10));
+
+        const std::string path = "reload:/" + image_filename(i);
+
+        texture_pool::image img = image_decoder::decode(vfs::resolve_path(path));
+        REQUIRE(img.data != nullptr);
+        REQUIRE(img.stamp.valid());
+
+        img.file_path = string::store_sid(path);
+
+        ids.push_back(texture_pool::add_new_image(img));
+    }
+
+    return ids;
+}
+
+TEST_CASE("Reloading only uploads images whose file changed", "[texture_reloader]")
+{
+    const std::vector<s32> ids = load_images();
+
+    SECTION("unchanged files are skipped")
+    {
+        mock_library().reset_upload_stats();
+
+        const texture_reloader::reload_result result = texture_reloader::reload();
+
+        REQUIRE(result.reloaded == 0);
+        REQUIRE(result.skipped == image_count);
+        REQUIRE(mock_library().upload_stats().texture_uploads == 0);
+    }
+
+    SECTION("an edited file is uploaded again")
+    {
+        write_png(2, 200);
+        touch(2);
+
+        mock_library().reset_upload_stats();
+
+        const texture_reloader::reload_result result = texture_reloader::reload();
+
+        REQUIRE(result.reloaded == 1);
+        REQUIRE(result.skipped == image_count - 1);
+        REQUIRE(mock_library().upload_stats().texture_uploads == 1);
+        REQUIRE(mock_library().upload_stats().texture_bytes == 4 * 4 * 4);
+
+        REQUIRE(texture_pool::image_at_id(ids[2])->data[0] == 200);
+        REQUIRE(texture_pool::image_at_id(ids[0])->data[0] == 0);
+
+        // The new stamp is recorded, reloading again does nothing
+        mock_library().reset_upload_stats();
+
+        REQUIRE(texture_reloader::reload().reloaded == 0);
+        REQUIRE(mock_library().upload_stats().texture_uploads == 0);
+    }
+
+    SECTION("a touched file with the same contents is skipped")
+    {
+        touch(1);
+
+        mock_library().reset_upload_stats();
+
+        const texture_reloader::reload_result result = texture_reloader::reload();
+
+        REQUIRE(result.reloaded == 0);
+        REQUIRE(result.skipped == image_count);
+        REQUIRE(mock_library().upload_stats().texture_uploads == 0);
+
+        // The contents were compared once, afterwards the stamp matches again
+        const auto stamp = fileio::read_file_stamp((image_directory() / image_filename(1)).string());
+        REQUIRE(texture_pool::image_at_id(ids[1])->stamp == stamp);
+    }
+
+    texture_pool::terminate();
+}
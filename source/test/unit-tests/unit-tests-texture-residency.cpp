@@ -0,0 +1,292 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_session.hpp>
+#include "structure.h"
+
+#include "resources/texture_pool.h"
+#include "resources/texture_residency.h"
+#include "resources/image_decoder.h"
+#include "resources/material_pool.h"
+
+#include "helpers/mock_library.h"
+
+#include "fileio/vfs.h"
+
+#include <stb/stb_image_write.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    ppp::headless();
+
+    return Catch::Session().run(argc, argv);
+}
+
+using namespace ppp;
+
+static constexpr s32 image_count = 4;
+static constexpr s32 image_size = 16;
+static constexpr u64 image_bytes = image_size * image_size * 4;
+
+static std::filesystem::path image_directory()
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "ppp_texture_residency";
+    std::filesystem::create_directories(directory);
+
+    vfs::add_wildcard(string::store_sid("residency:"), directory.generic_string());
+
+    return directory;
+}
+
+// Writes and decodes an image filled with `value`, returns the id of the image in the pool
+static s32 load_image(s32 index, u8 value)
+{
+    const std::string filename = "image_" + std::to_string(index) + ".png";
+
+    std::vector<u8> pixels(image_bytes, value);
+
+    const std::string path = (image_directory() / filename).string();
+    REQUIRE(stbi_write_png(path.c_str(), image_size, image_size, 4, pixels.data(), image_size * 4) != 0);
+
+    const std::string vfs_path = "residency:/" + filename;
+
+    texture_pool::image img = image_decoder::decode(vfs::resolve_path(vfs_path));
+    REQUIRE(img.data != nullptr);
+
+    img.file_path = string::store_sid(vfs_path);
+    // Made up texture name, every image needs its own to be bound to a shader
+    img.texture_id = 100 + index;
+
+    return texture_pool::add_new_image(img);
+}
+
+// The files are named after `first_index` so every test decodes its own
+static std::vector<s32> load_images(s32 first_index)
+{
+    std::vector<s32> ids;
+    for (s32 i = 0; i < image_count; ++i)
+    {
+        ids.push_back(load_image(first_index + i, static_cast<u8>(10 * (i + 1))));
+    }
+
+    return ids;
+}
+
+static void remove_images(const std::vector<s32>& ids)
+{
+    for (s32 id : ids)
+    {
+        texture_pool::remove_image(id);
+    }
+
+    texture_residency::set_budget({});
+}
+
+// --------------------------------------------------------------------------
+// Tests for the texture memory budget
+// --------------------------------------------------------------------------
+TEST_CASE("Memory of the pool is accounted per image", "[texture_residency]")
+{
+    constexpr s32 first_index = 1;
+
+    const texture_residency::residency_statistics before = texture_residency::statistics();
+
+    const std::vector<s32> ids = load_images(first_index);
+
+    const texture_residency::residency_statistics stats = texture_residency::statistics();
+
+    REQUIRE(stats.cpu_bytes == before.cpu_bytes + image_count * image_bytes);
+    REQUIRE(stats.gpu_bytes == before.gpu_bytes + image_count * image_bytes);
+    REQUIRE(stats.resident == before.resident + image_count);
+    REQUIRE(stats.evicted == 0);
+
+    // Without a budget nothing is evicted
+    for (s32 frame = 0; frame < 5; ++frame)
+    {
+        texture_residency::end_frame();
+    }
+
+    REQUIRE(texture_residency::statistics().evicted == 0);
+
+    remove_images(ids);
+}
+
+TEST_CASE("The least recently used images are evicted to meet the budget", "[texture_residency]")
+{
+    constexpr s32 first_index = 10;
+
+    const std::vector<s32> ids = load_images(first_index);
+
+    const u64 evictions = texture_residency::statistics().evictions;
+    const u64 other_bytes = texture_residency::statistics().gpu_bytes - image_count * image_bytes;
+
+    // The first image was used longest ago, the last two are used in the current frame
+    REQUIRE(texture_residency::touch(ids[0]));
+    texture_residency::end_frame();
+    REQUIRE(texture_residency::touch(ids[1]));
+    texture_residency::end_frame();
+    REQUIRE(texture_residency::touch(ids[2]));
+    REQUIRE(texture_residency::touch(ids[3]));
+
+    // Room for two of the images
+    texture_residency::set_budget({ 0, other_bytes + 2 * image_bytes });
+
+    texture_residency::end_frame();
+
+    REQUIRE_FALSE(texture_residency::is_resident(ids[0]));
+    REQUIRE_FALSE(texture_residency::is_resident(ids[1]));
+    REQUIRE(texture_residency::is_resident(ids[2]));
+    REQUIRE(texture_residency::is_resident(ids[3]));
+
+    const texture_residency::residency_statistics stats = texture_residency::statistics();
+
+    REQUIRE(stats.evicted == 2);
+    REQUIRE(stats.evictions == evictions + 2);
+    REQUIRE(stats.gpu_bytes <= stats.budget.gpu_bytes);
+
+    // An evicted image keeps its id but none of its pixels
+    REQUIRE(texture_pool::has_image(ids[0]));
+    REQUIRE(texture_pool::image_at_id(ids[0])->data == nullptr);
+
+    remove_images(ids);
+}
+
+TEST_CASE("Images bound to a shader are not evicted", "[texture_residency]")
+{
+    constexpr s32 first_index = 15;
+
+    const std::vector<s32> ids = load_images(first_index);
+
+    const u64 other_bytes = texture_residency::statistics().gpu_bytes - image_count * image_bytes;
+    const string::string_id shader_tag = string::store_sid("residency_shader");
+
+    // Bound once and drawn every frame afterwards without touching the image again
+    material_pool::texture_cache::add_image(shader_tag, texture_pool::image_at_id(ids[0])->texture_id);
+
+    texture_residency::end_frame();
+
+    // Room for the bound image only
+    texture_residency::set_budget({ 0, other_bytes + image_bytes });
+
+    texture_residency::end_frame();
+
+    REQUIRE(texture_residency::is_resident(ids[0]));
+    REQUIRE_FALSE(texture_residency::is_resident(ids[1]));
+
+    // Once the textures of the shader are reset the image is evicted like any other
+    material_pool::texture_cache::reset_images(shader_tag);
+
+    // Less room than a single image, a budget of 0 is unlimited
+    texture_residency::set_budget({ 0, other_bytes + image_bytes / 2 });
+
+    texture_residency::end_frame();
+
+    REQUIRE_FALSE(texture_residency::is_resident(ids[0]));
+
+    remove_images(ids);
+}
+
+TEST_CASE("Evicted images are loaded again when they are used", "[texture_residency]")
+{
+    constexpr s32 first_index = 20;
+
+    const std::vector<s32> ids = load_images(first_index);
+
+    REQUIRE(texture_residency::evict(ids[1]));
+    REQUIRE_FALSE(texture_residency::evict(ids[1]));
+
+    const u64 reloads = texture_residency::statistics().reloads;
+
+    mock_library().reset_upload_stats();
+
+    REQUIRE(texture_residency::touch(ids[1]));
+
+    REQUIRE(texture_residency::is_resident(ids[1]));
+    REQUIRE(texture_residency::statistics().reloads == reloads + 1);
+
+    // A single full upload of the decoded file
+    REQUIRE(mock_library().upload_stats().texture_uploads == 1);
+    REQUIRE(mock_library().upload_stats().texture_bytes == image_bytes);
+
+    const texture_pool::image* img = texture_pool::image_at_id(ids[1]);
+    REQUIRE(img->data != nullptr);
+    REQUIRE(img->width == image_size);
+    REQUIRE(img->data[0] == 20);
+
+    // Touching a resident image uploads nothing
+    REQUIRE(texture_residency::touch(ids[1]));
+    REQUIRE(mock_library().upload_stats().texture_uploads == 1);
+
+    remove_images(ids);
+}
+
+TEST_CASE("Images used this frame are kept even over budget", "[texture_residency]")
+{
+    constexpr s32 first_index = 30;
+
+    const std::vector<s32> ids = load_images(first_index);
+
+    texture_residency::set_budget({ 1, 1 });
+
+    for (s32 i = 0; i < image_count; ++i)
+    {
+        texture_residency::touch(ids[i]);
+    }
+
+    texture_residency::enforce_budget();
+
+    for (s32 i = 0; i < image_count; ++i)
+    {
+        REQUIRE(texture_residency::is_resident(ids[i]));
+    }
+
+    // Once the frame is over they are no longer protected
+    texture_residency::end_frame();
+    texture_residency::end_frame();
+
+    for (s32 i = 0; i < image_count; ++i)
+    {
+        REQUIRE_FALSE(texture_residency::is_resident(ids[i]));
+    }
+
+    remove_images(ids);
+}
+
+TEST_CASE("Only unedited images loaded from a file can be evicted", "[texture_residency]")
+{
+    constexpr s32 first_index = 40;
+
+    const std::vector<s32> ids = load_images(first_index);
+
+    // Edited pixels can not be loaded from the file again
+    texture_pool::mark_edited(ids[0]);
+    REQUIRE_FALSE(texture_residency::is_evictable(ids[0]));
+
+    // Pixels without a file
+    std::vector<u8> borrowed(image_bytes, 1);
+
+    texture_pool::image created;
+    created.width = image_size;
+    created.height = image_size;
+    created.channels = 4;
+    created.data = borrowed.data();
+    created.ownership = texture_pool::pixel_ownership::BORROWED;
+
+    created.image_id = texture_pool::add_new_image(created);
+
+    REQUIRE_FALSE(texture_residency::is_evictable(created.image_id));
+    REQUIRE(texture_residency::is_evictable(ids[1]));
+
+    texture_residency::set_budget({ 1, 1 });
+    texture_residency::end_frame();
+    texture_residency::end_frame();
+
+    REQUIRE(texture_residency::is_resident(ids[0]));
+    REQUIRE(texture_residency::is_resident(created.image_id));
+    REQUIRE_FALSE(texture_residency::is_resident(ids[1]));
+
+    texture_pool::remove_image(created.image_id);
+    remove_images(ids);
+}